@@ -63,6 +63,10 @@ const char kEnablePropertyTreeVerification[] =
 // Disable partial swap which is needed for some OpenGL drivers / emulators.
 const char kUIDisablePartialSwap[] = "ui-disable-partial-swap";
 
+// Number of worker threads the software renderer rasters tiles of the root
+// render pass on. 0 draws it serially.
+const char kNumSoftwareRasterThreads[] = "num-software-raster-threads";
+
 // Enables the GPU benchmarking extension
 const char kEnableGpuBenchmarking[] = "enable-gpu-benchmarking";
 
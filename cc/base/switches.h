@@ -32,6 +32,7 @@ extern const char kEnablePropertyTreeVerification[];
 
 // Switches for both the renderer and ui compositors.
 extern const char kUIDisablePartialSwap[];
+extern const char kNumSoftwareRasterThreads[];
 extern const char kEnableGpuBenchmarking[];
 
 // Debug visualizations.
@@ -398,14 +398,16 @@ void CreateTestYUVVideoDrawQuad_Solid(
 typedef ::testing::Types<GLRenderer,
                          SoftwareRenderer,
                          GLRendererWithExpandedViewport,
-                         SoftwareRendererWithExpandedViewport> RendererTypes;
+                         SoftwareRendererWithExpandedViewport,
+                         SoftwareRendererWithTiledRaster> RendererTypes;
 TYPED_TEST_CASE(RendererPixelTest, RendererTypes);
 
 template <typename RendererType>
 class SoftwareRendererPixelTest : public RendererPixelTest<RendererType> {};
 
-typedef ::testing::Types<SoftwareRenderer, SoftwareRendererWithExpandedViewport>
-    SoftwareRendererTypes;
+typedef ::testing::Types<SoftwareRenderer,
+                         SoftwareRendererWithExpandedViewport,
+                         SoftwareRendererWithTiledRaster> SoftwareRendererTypes;
 TYPED_TEST_CASE(SoftwareRendererPixelTest, SoftwareRendererTypes);
 
 template <typename RendererType>
@@ -437,6 +439,14 @@ bool FuzzyForSoftwareOnlyPixelComparator<
   return fuzzy_.Compare(actual_bmp, expected_bmp);
 }
 
+template <>
+bool FuzzyForSoftwareOnlyPixelComparator<
+    SoftwareRendererWithTiledRaster>::Compare(
+    const SkBitmap& actual_bmp,
+    const SkBitmap& expected_bmp) const {
+  return fuzzy_.Compare(actual_bmp, expected_bmp);
+}
+
 template<typename RendererType>
 bool FuzzyForSoftwareOnlyPixelComparator<RendererType>::Compare(
     const SkBitmap& actual_bmp,
@@ -668,8 +678,9 @@ template <typename TypeParam>
 class IntersectingQuadSoftwareTest
     : public IntersectingQuadPixelTest<TypeParam> {};
 
-typedef ::testing::Types<SoftwareRenderer, SoftwareRendererWithExpandedViewport>
-    SoftwareRendererTypes;
+typedef ::testing::Types<SoftwareRenderer,
+                         SoftwareRendererWithExpandedViewport,
+                         SoftwareRendererWithTiledRaster> SoftwareRendererTypes;
 typedef ::testing::Types<GLRenderer, GLRendererWithExpandedViewport>
     GLRendererTypes;
 
@@ -1555,7 +1566,9 @@ class RendererPixelTestWithBackgroundFilter
   gfx::Rect filter_pass_content_rect_;
 };
 
-typedef ::testing::Types<GLRenderer, SoftwareRenderer>
+typedef ::testing::Types<GLRenderer,
+                         SoftwareRenderer,
+                         SoftwareRendererWithTiledRaster>
     BackgroundFilterRendererTypes;
 TYPED_TEST_CASE(RendererPixelTestWithBackgroundFilter,
                 BackgroundFilterRendererTypes);
@@ -2050,6 +2063,11 @@ bool IsSoftwareRenderer<SoftwareRendererWithExpandedViewport>() {
   return true;
 }
 
+template <>
+bool IsSoftwareRenderer<SoftwareRendererWithTiledRaster>() {
+  return true;
+}
+
 // If we disable image filtering, then a 2x2 bitmap should appear as four
 // huge sharp squares.
 TYPED_TEST(SoftwareRendererPixelTest, PictureDrawQuadDisableImageFiltering) {
@@ -20,7 +20,9 @@ RendererSettings::RendererSettings()
       refresh_rate(60.0),
       highp_threshold_min(0),
       use_rgba_4444_textures(false),
-      texture_id_allocation_chunk_size(64) {
+      texture_id_allocation_chunk_size(64),
+      num_software_raster_threads(0),
+      software_raster_tile_size(256) {
 }
 
 RendererSettings::~RendererSettings() {
@@ -24,6 +24,11 @@ class RendererSettings {
   int highp_threshold_min;
   bool use_rgba_4444_textures;
   size_t texture_id_allocation_chunk_size;
+  // When non-zero, the software renderer records the root render pass and
+  // rasterizes it in tiles of |software_raster_tile_size| pixels on this many
+  // worker threads in addition to the compositor thread.
+  int num_software_raster_threads;
+  int software_raster_tile_size;
 };
 
 }  // namespace cc
@@ -4,8 +4,15 @@
 
 #include "cc/output/software_renderer.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/threading/worker_pool.h"
 #include "base/trace_event/trace_event.h"
+#include "cc/base/completion_event.h"
 #include "cc/base/math_util.h"
+#include "cc/base/scoped_ptr_vector.h"
 #include "cc/output/compositor_frame.h"
 #include "cc/output/compositor_frame_ack.h"
 #include "cc/output/compositor_frame_metadata.h"
@@ -20,10 +27,13 @@
 #include "cc/quads/texture_draw_quad.h"
 #include "cc/quads/tile_draw_quad.h"
 #include "skia/ext/opacity_draw_filter.h"
+#include "third_party/skia/include/core/SkBBHFactory.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkColor.h"
 #include "third_party/skia/include/core/SkImageFilter.h"
 #include "third_party/skia/include/core/SkMatrix.h"
+#include "third_party/skia/include/core/SkPicture.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
 #include "third_party/skia/include/core/SkPoint.h"
 #include "third_party/skia/include/core/SkShader.h"
 #include "third_party/skia/include/effects/SkLayerRasterizer.h"
@@ -59,6 +69,29 @@ static SkShader::TileMode WrapModeToTileMode(GLint wrap_mode) {
   return SkShader::kClamp_TileMode;
 }
 
+// Plays |picture| back into every |stride|th tile of |target|, starting at
+// |first_tile|. Each tile gets its own canvas over a subset of |target|'s
+// pixels, so tiles can be drawn concurrently without overlapping writes.
+void RasterizeTiles(const SkPicture* picture,
+                    const SkBitmap* target,
+                    const std::vector<gfx::Rect>* tiles,
+                    size_t first_tile,
+                    size_t stride,
+                    CompletionEvent* completion) {
+  TRACE_EVENT0("cc", "SoftwareRenderer::RasterizeTiles");
+  for (size_t i = first_tile; i < tiles->size(); i += stride) {
+    const gfx::Rect& tile = (*tiles)[i];
+    SkBitmap tile_bitmap;
+    if (!target->extractSubset(&tile_bitmap, gfx::RectToSkIRect(tile)))
+      continue;
+    SkCanvas canvas(tile_bitmap);
+    canvas.translate(-SkIntToScalar(tile.x()), -SkIntToScalar(tile.y()));
+    canvas.drawPicture(picture);
+  }
+  if (completion)
+    completion->Signal();
+}
+
 }  // anonymous namespace
 
 scoped_ptr<SoftwareRenderer> SoftwareRenderer::Create(
@@ -107,6 +140,8 @@ void SoftwareRenderer::BeginDrawingFrame(DrawingFrame* frame) {
 
 void SoftwareRenderer::FinishDrawingFrame(DrawingFrame* frame) {
   TRACE_EVENT0("cc", "SoftwareRenderer::FinishDrawingFrame");
+  if (root_recorder_)
+    RasterizeRootRecording();
   current_framebuffer_lock_ = nullptr;
   current_framebuffer_canvas_.clear();
   current_canvas_ = NULL;
@@ -151,9 +186,76 @@ void SoftwareRenderer::Finish() {}
 
 void SoftwareRenderer::BindFramebufferToOutputSurface(DrawingFrame* frame) {
   DCHECK(!output_surface_->HasExternalStencilTest());
+  if (root_recorder_)
+    RasterizeRootRecording();
   current_framebuffer_lock_ = nullptr;
   current_framebuffer_canvas_.clear();
   current_canvas_ = root_canvas_;
+
+  if (settings_->num_software_raster_threads > 0) {
+    // Record the root pass so that it can be rasterized in parallel tiles once
+    // all of its quads have been issued. The R-tree lets each tile skip the
+    // draws that don't intersect it.
+    SkISize size = root_canvas_->getDeviceSize();
+    SkRTreeFactory factory;
+    root_recorder_.reset(new SkPictureRecorder);
+    current_canvas_ = root_recorder_->beginRecording(
+        SkRect::MakeWH(size.width(), size.height()), &factory);
+  }
+}
+
+void SoftwareRenderer::RasterizeRootRecording() {
+  TRACE_EVENT0("cc", "SoftwareRenderer::RasterizeRootRecording");
+  DCHECK(root_recorder_);
+  skia::RefPtr<SkPicture> picture =
+      skia::AdoptRef(root_recorder_->endRecording());
+  root_recorder_ = nullptr;
+  current_canvas_ = root_canvas_;
+
+  // Tiles write straight into the pixels backing |root_canvas_|. If those
+  // aren't directly addressable, draw the recording on this thread instead.
+  SkImageInfo info;
+  size_t row_bytes = 0;
+  SkIPoint origin = SkIPoint::Make(0, 0);
+  void* pixels = root_canvas_->accessTopLayerPixels(&info, &row_bytes, &origin);
+  SkBitmap target;
+  if (!pixels || !origin.isZero() ||
+      !root_canvas_->getTotalMatrix().isIdentity() ||
+      !target.installPixels(info, pixels, row_bytes)) {
+    root_canvas_->drawPicture(picture.get());
+    return;
+  }
+
+  int tile_size = std::max(settings_->software_raster_tile_size, 1);
+  std::vector<gfx::Rect> tiles;
+  for (int y = 0; y < info.height(); y += tile_size) {
+    for (int x = 0; x < info.width(); x += tile_size) {
+      tiles.push_back(gfx::IntersectRects(
+          gfx::Rect(x, y, tile_size, tile_size),
+          gfx::Rect(info.width(), info.height())));
+    }
+  }
+  if (tiles.empty())
+    return;
+
+  // This thread takes a share of the tiles too, so only hand out as many
+  // worker tasks as there are tiles left for them.
+  size_t num_workers =
+      std::min(static_cast<size_t>(settings_->num_software_raster_threads),
+               tiles.size() - 1);
+  size_t stride = num_workers + 1;
+  ScopedPtrVector<CompletionEvent> completions;
+  for (size_t i = 0; i < num_workers; ++i) {
+    completions.push_back(make_scoped_ptr(new CompletionEvent));
+    base::Closure task =
+        base::Bind(&RasterizeTiles, picture.get(), &target, &tiles, i + 1,
+                   stride, completions.back());
+    if (!base::WorkerPool::PostTask(FROM_HERE, task, false))
+      task.Run();
+  }
+  RasterizeTiles(picture.get(), &target, &tiles, 0, stride, NULL);
+  for (size_t i = 0; i < completions.size(); ++i)
+    completions[i]->Wait();
 }
 
 bool SoftwareRenderer::BindFramebufferToTexture(
@@ -161,6 +263,8 @@ bool SoftwareRenderer::BindFramebufferToTexture(
     const ScopedResource* texture,
     const gfx::Rect& target_rect) {
   DCHECK(texture->id());
+  if (root_recorder_)
+    RasterizeRootRecording();
 
   // Explicitly release lock, otherwise we can crash when try to lock
   // same texture again.
@@ -588,6 +692,10 @@ void SoftwareRenderer::DrawUnsupportedQuad(const DrawingFrame* frame,
 void SoftwareRenderer::CopyCurrentRenderPassToBitmap(
     DrawingFrame* frame,
     scoped_ptr<CopyOutputRequest> request) {
+  // The root pass has to be rasterized before it can be read back.
+  if (root_recorder_)
+    RasterizeRootRecording();
+
   gfx::Rect copy_rect = frame->current_render_pass->output_rect;
   if (request->has_area())
     copy_rect.Intersect(request->area());
@@ -9,6 +9,8 @@
 #include "cc/output/compositor_frame.h"
 #include "cc/output/direct_renderer.h"
 
+class SkPictureRecorder;
+
 namespace cc {
 
 class OutputSurface;
@@ -74,6 +76,10 @@ class SoftwareRenderer : public DirectRenderer {
   void ClearCanvas(SkColor color);
   void ClearFramebuffer(DrawingFrame* frame);
   void SetClipRect(const gfx::Rect& rect);
+  // Ends the recording of the root render pass started by
+  // BindFramebufferToOutputSurface() and rasterizes it into |root_canvas_|,
+  // splitting the canvas into tiles that are drawn in parallel.
+  void RasterizeRootRecording();
   bool IsSoftwareResource(ResourceProvider::ResourceId resource_id) const;
 
   void DrawCheckerboardQuad(const DrawingFrame* frame,
@@ -105,6 +111,8 @@ class SoftwareRenderer : public DirectRenderer {
   scoped_ptr<ResourceProvider::ScopedWriteLockSoftware>
       current_framebuffer_lock_;
   skia::RefPtr<SkCanvas> current_framebuffer_canvas_;
+  // Only set while the root render pass is being recorded for tiled raster.
+  scoped_ptr<SkPictureRecorder> root_recorder_;
   scoped_ptr<SoftwareFrameData> current_frame_data_;
 
   DISALLOW_COPY_AND_ASSIGN(SoftwareRenderer);
@@ -4,15 +4,27 @@
 
 #include "cc/resources/texture_compressor.h"
 
+#include "base/cpu.h"
 #include "base/logging.h"
+#include "build/build_config.h"
 #include "cc/resources/texture_compressor_etc1.h"
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "cc/resources/texture_compressor_etc1_sse.h"
+#endif
+
 namespace cc {
 
 scoped_ptr<TextureCompressor> TextureCompressor::Create(Format format) {
   switch (format) {
-    case kFormatETC1:
+    case kFormatETC1: {
+#if defined(ARCH_CPU_X86_FAMILY)
+      base::CPU cpu;
+      if (cpu.has_sse2())
+        return make_scoped_ptr(new TextureCompressorETC1SSE());
+#endif
       return make_scoped_ptr(new TextureCompressorETC1());
+    }
   }
 
   NOTREACHED();
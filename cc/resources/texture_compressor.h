@@ -33,10 +33,18 @@ class TextureCompressor {
                         int height,
                         Quality quality) = 0;
 
+  // Sets the number of threads, including the calling one, that Compress() may
+  // split large images across. Defaults to 1.
+  void set_num_threads(int num_threads) { num_threads_ = num_threads; }
+
  protected:
-  TextureCompressor() {}
+  TextureCompressor() : num_threads_(1) {}
+
+  int num_threads() const { return num_threads_; }
 
  private:
+  int num_threads_;
+
   DISALLOW_COPY_AND_ASSIGN(TextureCompressor);
 };
 
@@ -8,9 +8,15 @@
 #include "cc/resources/texture_compressor_etc1.h"
 
 #include <string.h>
+#include <algorithm>
 #include <limits>
 
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/threading/worker_pool.h"
+#include "base/trace_event/trace_event.h"
+#include "cc/base/completion_event.h"
+#include "cc/base/scoped_ptr_vector.h"
 
 // Defining the following macro will cause the error metric function to weigh
 // each color channel differently depending on how the human eye can perceive
@@ -20,6 +26,9 @@
 
 namespace {
 
+// The smallest number of block rows worth handing to another thread.
+const int kMinBlockRowsPerTask = 16;
+
 template <typename T>
 inline T clamp(T val, T min, T max) {
   return val < min ? min : (val > max ? max : val);
@@ -238,11 +247,12 @@ void GetAverageColor(const Color* src, float* avg_color) {
   avg_color[2] = static_cast<float>(sum_r) * kInv8;
 }
 
-void ComputeLuminance(uint8_t* block,
-                      const Color* src,
-                      const Color& base,
-                      int sub_block_id,
-                      const uint8_t* idx_to_num_tab) {
+uint8_t SearchLuminance(const uint8_t* src_bgra,
+                        const uint8_t* base_bgra,
+                        uint8_t* mod_idx) {
+  const Color* src = reinterpret_cast<const Color*>(src_bgra);
+  const Color& base = *reinterpret_cast<const Color*>(base_bgra);
+
   uint32_t best_tbl_err = std::numeric_limits<uint32_t>::max();
   uint8_t best_tbl_idx = 0;
   uint8_t best_mod_idx[8][8];  // [table][texel]
@@ -291,12 +301,27 @@ void ComputeLuminance(uint8_t* block,
     }
   }
 
+  memcpy(mod_idx, best_mod_idx[best_tbl_idx], 8);
+  return best_tbl_idx;
+}
+
+void ComputeLuminance(uint8_t* block,
+                      const Color* src,
+                      const Color& base,
+                      int sub_block_id,
+                      const uint8_t* idx_to_num_tab,
+                      cc::TextureCompressorETC1::LuminanceSearch search) {
+  uint8_t best_mod_idx[8];
+  uint8_t best_tbl_idx =
+      search(reinterpret_cast<const uint8_t*>(src),
+             reinterpret_cast<const uint8_t*>(&base), best_mod_idx);
+
   WriteCodewordTable(block, sub_block_id, best_tbl_idx);
 
   uint32_t pix_data = 0;
 
   for (unsigned int i = 0; i < 8; ++i) {
-    uint8_t mod_idx = best_mod_idx[best_tbl_idx][i];
+    uint8_t mod_idx = best_mod_idx[i];
     uint8_t pix_idx = g_mod_to_pix[mod_idx];
 
     uint32_t lsb = pix_idx & 0x1;
@@ -383,7 +408,10 @@ bool TryCompressSolidBlock(uint8_t* dst, const Color* src) {
   return true;
 }
 
-void CompressBlock(uint8_t* dst, const Color* ver_src, const Color* hor_src) {
+void CompressBlock(uint8_t* dst,
+                   const Color* ver_src,
+                   const Color* hor_src,
+                   cc::TextureCompressorETC1::LuminanceSearch search) {
   if (TryCompressSolidBlock(dst, ver_src))
     return;
 
@@ -452,29 +480,30 @@ void CompressBlock(uint8_t* dst, const Color* ver_src, const Color* hor_src) {
   // Compute luminance for the first sub block.
   ComputeLuminance(dst, sub_block_src[sub_block_off_0],
                    sub_block_avg[sub_block_off_0], 0,
-                   g_idx_to_num[sub_block_off_0]);
+                   g_idx_to_num[sub_block_off_0], search);
   // Compute luminance for the second sub block.
   ComputeLuminance(dst, sub_block_src[sub_block_off_1],
                    sub_block_avg[sub_block_off_1], 1,
-                   g_idx_to_num[sub_block_off_1]);
+                   g_idx_to_num[sub_block_off_1], search);
 }
 
-}  // namespace
-
-namespace cc {
-
-void TextureCompressorETC1::Compress(const uint8_t* src,
-                                     uint8_t* dst,
-                                     int width,
-                                     int height,
-                                     Quality quality) {
-  DCHECK(width >= 4 && (width & 3) == 0);
-  DCHECK(height >= 4 && (height & 3) == 0);
+// Compresses the rows of 4x4 blocks in [first_block_row, last_block_row).
+void CompressBlockRows(const uint8_t* src,
+                       uint8_t* dst,
+                       int width,
+                       int first_block_row,
+                       int last_block_row,
+                       cc::TextureCompressorETC1::LuminanceSearch search,
+                       cc::CompletionEvent* completion) {
+  TRACE_EVENT0("cc", "TextureCompressorETC1::CompressBlockRows");
+  src += first_block_row * width * 4 * 4;
+  dst += first_block_row * (width / 4) * 8;
 
   Color ver_blocks[16];
   Color hor_blocks[16];
 
-  for (int y = 0; y < height; y += 4, src += width * 4 * 4) {
+  for (int y = first_block_row; y < last_block_row;
+       ++y, src += width * 4 * 4) {
     for (int x = 0; x < width; x += 4, dst += 8) {
       const Color* row0 = reinterpret_cast<const Color*>(src + x * 4);
       const Color* row1 = row0 + width;
@@ -495,9 +524,58 @@ void TextureCompressorETC1::Compress(const uint8_t* src,
       memcpy(hor_blocks + 8, row2, 16);
       memcpy(hor_blocks + 12, row3, 16);
 
-      CompressBlock(dst, ver_blocks, hor_blocks);
+      CompressBlock(dst, ver_blocks, hor_blocks, search);
     }
   }
+
+  if (completion)
+    completion->Signal();
+}
+
+}  // namespace
+
+namespace cc {
+
+TextureCompressorETC1::TextureCompressorETC1()
+    : luminance_search_(&SearchLuminance) {
+}
+
+TextureCompressorETC1::TextureCompressorETC1(LuminanceSearch luminance_search)
+    : luminance_search_(luminance_search) {
+}
+
+void TextureCompressorETC1::Compress(const uint8_t* src,
+                                     uint8_t* dst,
+                                     int width,
+                                     int height,
+                                     Quality quality) {
+  DCHECK(width >= 4 && (width & 3) == 0);
+  DCHECK(height >= 4 && (height & 3) == 0);
+
+  // Blocks are independent, so the image is split into bands of block rows
+  // that are compressed concurrently. Small images aren't worth the overhead.
+  int block_rows = height / 4;
+  int num_tasks = std::min(num_threads(), block_rows / kMinBlockRowsPerTask);
+  if (num_tasks <= 1) {
+    CompressBlockRows(src, dst, width, 0, block_rows, luminance_search_,
+                      NULL);
+    return;
+  }
+
+  ScopedPtrVector<CompletionEvent> completions;
+  for (int i = 1; i < num_tasks; ++i) {
+    completions.push_back(make_scoped_ptr(new CompletionEvent));
+    base::Closure task = base::Bind(
+        &CompressBlockRows, src, dst, width, i * block_rows / num_tasks,
+        (i + 1) * block_rows / num_tasks, luminance_search_,
+        completions.back());
+    if (!base::WorkerPool::PostTask(FROM_HERE, task, false))
+      task.Run();
+  }
+  CompressBlockRows(src, dst, width, 0, block_rows / num_tasks,
+                    luminance_search_, NULL);
+  for (size_t i = 0; i < completions.size(); ++i)
+    completions[i]->Wait();
 }
 
 }  // namespace cc
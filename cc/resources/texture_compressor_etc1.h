@@ -11,7 +11,14 @@ namespace cc {
 
 class TextureCompressorETC1 : public TextureCompressor {
  public:
-  TextureCompressorETC1() {}
+  // Finds the codeword table that best approximates the eight BGRA texels at
+  // |src| when applied to the BGRA color at |base|. Returns the index of the
+  // table and writes the best modifier index for each texel to |mod_idx|.
+  typedef uint8_t (*LuminanceSearch)(const uint8_t* src,
+                                     const uint8_t* base,
+                                     uint8_t* mod_idx);
+
+  TextureCompressorETC1();
 
   // Compress a texture using ETC1. Note that the |quality| parameter is
   // ignored. The current implementation does not support different quality
@@ -22,7 +29,14 @@ class TextureCompressorETC1 : public TextureCompressor {
                 int height,
                 Quality quality) override;
 
+ protected:
+  // Used by subclasses that provide a faster implementation of the luminance
+  // search, which is where most of the compression time is spent.
+  explicit TextureCompressorETC1(LuminanceSearch luminance_search);
+
  private:
+  LuminanceSearch luminance_search_;
+
   DISALLOW_COPY_AND_ASSIGN(TextureCompressorETC1);
 };
 
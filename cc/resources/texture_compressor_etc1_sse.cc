@@ -0,0 +1,126 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/resources/texture_compressor_etc1_sse.h"
+
+#include <emmintrin.h>
+
+namespace {
+
+// Same as the codeword tables in texture_compressor_etc1.cc.
+// See: Table 3.17.2
+const int16_t g_codeword_tables[8][4] = {{-8, -2, 2, 8},
+                                         {-17, -5, 5, 17},
+                                         {-29, -9, 9, 29},
+                                         {-42, -13, 13, 42},
+                                         {-60, -18, 18, 60},
+                                         {-80, -24, 24, 80},
+                                         {-106, -33, 33, 106},
+                                         {-183, -47, 47, 183}};
+
+inline int16_t ClampToByte(int value) {
+  return static_cast<int16_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Returns |a| where |mask| is set and |b| elsewhere.
+inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Returns the sum of the four 32-bit lanes of |v|.
+inline int HorizontalSum(__m128i v) {
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(v);
+}
+
+// Vectorized version of SearchLuminance() in texture_compressor_etc1.cc. The
+// eight texels are split into one vector of 16-bit values per channel, so the
+// error of a candidate color is computed for the whole sub block at once.
+// Modifiers and tables are compared in the same order and with the same
+// tie-breaking as the scalar version, so the results are identical.
+uint8_t SearchLuminanceSSE2(const uint8_t* src,
+                            const uint8_t* base,
+                            uint8_t* mod_idx) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i byte_mask = _mm_set1_epi32(0xff);
+
+  // Texels are stored as BGRA, so blue is in the low byte of each 32-bit lane.
+  __m128i texels_lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  __m128i texels_hi =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+  __m128i src_b = _mm_packs_epi32(_mm_and_si128(texels_lo, byte_mask),
+                                  _mm_and_si128(texels_hi, byte_mask));
+  __m128i src_g =
+      _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(texels_lo, 8), byte_mask),
+                      _mm_and_si128(_mm_srli_epi32(texels_hi, 8), byte_mask));
+  __m128i src_r =
+      _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(texels_lo, 16), byte_mask),
+                      _mm_and_si128(_mm_srli_epi32(texels_hi, 16), byte_mask));
+
+  int best_tbl_err = 0x7fffffff;
+  uint8_t best_tbl_idx = 0;
+
+  for (int tbl_idx = 0; tbl_idx < 8; ++tbl_idx) {
+    // Errors are at most 3 * 255^2, so they fit comfortably in signed 32-bit
+    // lanes and the signed compare below is safe.
+    __m128i best_err_lo = _mm_set1_epi32(0x7fffffff);
+    __m128i best_err_hi = best_err_lo;
+    __m128i best_mod_lo = zero;
+    __m128i best_mod_hi = zero;
+
+    for (int mod = 0; mod < 4; ++mod) {
+      int lum = g_codeword_tables[tbl_idx][mod];
+      __m128i delta_b =
+          _mm_sub_epi16(src_b, _mm_set1_epi16(ClampToByte(base[0] + lum)));
+      __m128i delta_g =
+          _mm_sub_epi16(src_g, _mm_set1_epi16(ClampToByte(base[1] + lum)));
+      __m128i delta_r =
+          _mm_sub_epi16(src_r, _mm_set1_epi16(ClampToByte(base[2] + lum)));
+
+      // Interleaving blue with green lets one multiply-add produce
+      // b^2 + g^2 for four texels in 32-bit lanes.
+      __m128i bg_lo = _mm_unpacklo_epi16(delta_b, delta_g);
+      __m128i bg_hi = _mm_unpackhi_epi16(delta_b, delta_g);
+      __m128i r_lo = _mm_unpacklo_epi16(delta_r, zero);
+      __m128i r_hi = _mm_unpackhi_epi16(delta_r, zero);
+      __m128i err_lo = _mm_add_epi32(_mm_madd_epi16(bg_lo, bg_lo),
+                                     _mm_madd_epi16(r_lo, r_lo));
+      __m128i err_hi = _mm_add_epi32(_mm_madd_epi16(bg_hi, bg_hi),
+                                     _mm_madd_epi16(r_hi, r_hi));
+
+      __m128i better_lo = _mm_cmplt_epi32(err_lo, best_err_lo);
+      __m128i better_hi = _mm_cmplt_epi32(err_hi, best_err_hi);
+      __m128i mod_vec = _mm_set1_epi32(mod);
+      best_err_lo = Select(better_lo, err_lo, best_err_lo);
+      best_err_hi = Select(better_hi, err_hi, best_err_hi);
+      best_mod_lo = Select(better_lo, mod_vec, best_mod_lo);
+      best_mod_hi = Select(better_hi, mod_vec, best_mod_hi);
+    }
+
+    int tbl_err = HorizontalSum(_mm_add_epi32(best_err_lo, best_err_hi));
+    if (tbl_err < best_tbl_err) {
+      best_tbl_err = tbl_err;
+      best_tbl_idx = static_cast<uint8_t>(tbl_idx);
+      __m128i mods = _mm_packus_epi16(
+          _mm_packs_epi32(best_mod_lo, best_mod_hi), zero);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(mod_idx), mods);
+
+      if (tbl_err == 0)
+        break;  // We cannot do any better than this.
+    }
+  }
+
+  return best_tbl_idx;
+}
+
+}  // namespace
+
+namespace cc {
+
+TextureCompressorETC1SSE::TextureCompressorETC1SSE()
+    : TextureCompressorETC1(&SearchLuminanceSSE2) {
+}
+
+}  // namespace cc
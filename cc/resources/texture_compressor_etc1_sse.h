@@ -0,0 +1,25 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_RESOURCES_TEXTURE_COMPRESSOR_ETC1_SSE_H_
+#define CC_RESOURCES_TEXTURE_COMPRESSOR_ETC1_SSE_H_
+
+#include "cc/resources/texture_compressor_etc1.h"
+
+namespace cc {
+
+// ETC1 compressor that uses SSE2 to evaluate the luminance modifiers of all
+// texels in a sub block at once. Produces exactly the same output as
+// TextureCompressorETC1.
+class TextureCompressorETC1SSE : public TextureCompressorETC1 {
+ public:
+  TextureCompressorETC1SSE();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TextureCompressorETC1SSE);
+};
+
+}  // namespace cc
+
+#endif  // CC_RESOURCES_TEXTURE_COMPRESSOR_ETC1_SSE_H_
@@ -0,0 +1,78 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/resources/texture_compressor_etc1.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "base/cpu.h"
+#include "cc/resources/texture_compressor_etc1_sse.h"
+#endif
+
+namespace cc {
+namespace {
+
+const int kImageWidth = 256;
+const int kImageHeight = 256;
+const int kImageSizeInBytes = kImageWidth * kImageHeight * 4;
+const int kCompressedSizeInBytes = kImageWidth * kImageHeight / 2;
+
+// Fills |image| with noise from a fixed seed so that every block exercises the
+// full luminance search.
+void FillWithNoise(std::vector<uint8_t>* image) {
+  uint32_t state = 12345;
+  for (size_t i = 0; i < image->size(); ++i) {
+    state = state * 1103515245 + 12345;
+    (*image)[i] = static_cast<uint8_t>(state >> 16);
+  }
+}
+
+std::vector<uint8_t> Compress(TextureCompressor* compressor,
+                              const std::vector<uint8_t>& src) {
+  std::vector<uint8_t> dst(kCompressedSizeInBytes);
+  compressor->Compress(&src[0], &dst[0], kImageWidth, kImageHeight,
+                       TextureCompressor::kQualityHigh);
+  return dst;
+}
+
+TEST(TextureCompressorETC1Test, ThreadedMatchesSingleThreaded) {
+  std::vector<uint8_t> src(kImageSizeInBytes);
+  FillWithNoise(&src);
+
+  TextureCompressorETC1 compressor;
+  std::vector<uint8_t> expected = Compress(&compressor, src);
+
+  compressor.set_num_threads(4);
+  EXPECT_EQ(expected, Compress(&compressor, src));
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+TEST(TextureCompressorETC1Test, SSEMatchesScalar) {
+  if (!base::CPU().has_sse2())
+    return;
+
+  std::vector<uint8_t> src(kImageSizeInBytes);
+  FillWithNoise(&src);
+
+  TextureCompressorETC1 scalar_compressor;
+  TextureCompressorETC1SSE sse_compressor;
+  EXPECT_EQ(Compress(&scalar_compressor, src), Compress(&sse_compressor, src));
+
+  // Solid and smooth images take the early-out paths of the search.
+  std::fill(src.begin(), src.end(), 0x80);
+  EXPECT_EQ(Compress(&scalar_compressor, src), Compress(&sse_compressor, src));
+
+  for (int i = 0; i < kImageSizeInBytes; ++i)
+    src[i] = static_cast<uint8_t>((i / 4) % kImageWidth);
+  EXPECT_EQ(Compress(&scalar_compressor, src), Compress(&sse_compressor, src));
+}
+#endif
+
+}  // namespace
+}  // namespace cc
@@ -19,6 +19,8 @@ const int kImageWidth = 256;
 const int kImageHeight = 256;
 const int kImageSizeInBytes = kImageWidth * kImageHeight * 4;
 
+const int kThreads = 4;
+
 const TextureCompressor::Quality kQualities[] = {
     TextureCompressor::kQualityLow,
     TextureCompressor::kQualityMedium,
@@ -71,6 +73,11 @@ class TextureCompressorPerfTest
     std::string str = FormatName(GetParam()) + " " + QualityName(quality);
     perf_test::PrintResult("Compress256x256", name, str, timer_.MsPerLap(),
                            "us", true);
+
+    double megapixels_per_second = kImageWidth * kImageHeight *
+                                   timer_.LapsPerSecond() / (1000.0 * 1000.0);
+    perf_test::PrintResult("Compress256x256Throughput", name, str,
+                           megapixels_per_second, "MPix/s", true);
   }
 
  protected:
@@ -88,6 +95,15 @@ TEST_P(TextureCompressorPerfTest, Compress256x256Image) {
     RunTest("Image", quality);
 }
 
+TEST_P(TextureCompressorPerfTest, Compress256x256ImageThreaded) {
+  for (int i = 0; i < kImageSizeInBytes; ++i)
+    src_[i] = i % 256;
+
+  compressor_->set_num_threads(kThreads);
+  for (auto& quality : kQualities)
+    RunTest("ImageThreaded", quality);
+}
+
 TEST_P(TextureCompressorPerfTest, Compress256x256SolidImage) {
   memset(src_, 0, kImageSizeInBytes);
 
@@ -72,6 +72,13 @@ SurfaceAggregator::ClipData SurfaceAggregator::CalculateClipRect(
   return out_clip;
 }
 
+struct SurfaceAggregator::CachedSurfaceFrame {
+  explicit CachedSurfaceFrame(int frame_index) : frame_index(frame_index) {}
+
+  int frame_index;
+  RenderPassList render_pass_list;
+};
+
 class SurfaceAggregator::RenderPassIdAllocator {
  public:
   explicit RenderPassIdAllocator(int* next_index) : next_index_(next_index) {}
@@ -144,36 +151,50 @@ static ResourceProvider::ResourceId ResourceRemapHelper(
   return remapped_id;
 }
 
-bool SurfaceAggregator::TakeResources(Surface* surface,
-                                      const DelegatedFrameData* frame_data,
-                                      RenderPassList* render_pass_list) {
-  RenderPass::CopyAll(frame_data->render_pass_list, render_pass_list);
-  if (!provider_)  // TODO(jamesr): hack for unit tests that don't set up rp
-    return false;
-
-  int child_id = ChildIdForSurface(surface);
-  if (surface->factory())
-    surface->factory()->RefResources(frame_data->resource_list);
-  provider_->ReceiveFromChild(child_id, frame_data->resource_list);
-
-  typedef ResourceProvider::ResourceIdArray IdArray;
-  IdArray referenced_resources;
-
-  bool invalid_frame = false;
-  DrawQuad::ResourceIteratorCallback remap =
-      base::Bind(&ResourceRemapHelper,
-                 &invalid_frame,
-                 provider_->GetChildToParentMap(child_id),
-                 &referenced_resources);
-  for (const auto& render_pass : *render_pass_list) {
-    for (const auto& quad : render_pass->quad_list)
-      quad->IterateResources(remap);
-  }
+const RenderPassList* SurfaceAggregator::TakeResources(
+    Surface* surface,
+    const DelegatedFrameData* frame_data) {
+  // Empty frames don't advance the frame index, so only non-empty frames can
+  // be identified by it.
+  CachedSurfaceFrame* cached = surface_frame_cache_.get(surface->surface_id());
+  if (cached && cached->frame_index == surface->frame_index() &&
+      !frame_data->render_pass_list.empty())
+    return &cached->render_pass_list;
+
+  scoped_ptr<CachedSurfaceFrame> entry(
+      new CachedSurfaceFrame(surface->frame_index()));
+  RenderPass::CopyAll(frame_data->render_pass_list, &entry->render_pass_list);
+  if (provider_) {  // TODO(jamesr): hack for unit tests that don't set up rp
+    int child_id = ChildIdForSurface(surface);
+    if (surface->factory())
+      surface->factory()->RefResources(frame_data->resource_list);
+    provider_->ReceiveFromChild(child_id, frame_data->resource_list);
+
+    typedef ResourceProvider::ResourceIdArray IdArray;
+    IdArray referenced_resources;
+
+    bool invalid_frame = false;
+    DrawQuad::ResourceIteratorCallback remap =
+        base::Bind(&ResourceRemapHelper,
+                   &invalid_frame,
+                   provider_->GetChildToParentMap(child_id),
+                   &referenced_resources);
+    for (const auto& render_pass : entry->render_pass_list) {
+      for (const auto& quad : render_pass->quad_list)
+        quad->IterateResources(remap);
+    }
+
+    if (invalid_frame) {
+      surface_frame_cache_.erase(surface->surface_id());
+      return NULL;
+    }
 
-  if (!invalid_frame)
     provider_->DeclareUsedResourcesFromChild(child_id, referenced_resources);
+  }
 
-  return invalid_frame;
+  const RenderPassList* render_pass_list = &entry->render_pass_list;
+  surface_frame_cache_.set(surface->surface_id(), entry.Pass());
+  return render_pass_list;
 }
 
 gfx::Rect SurfaceAggregator::DamageRectForSurface(const Surface* surface,
@@ -200,6 +221,7 @@ void SurfaceAggregator::HandleSurfaceQuad(
   Surface* surface = manager_->GetSurfaceForId(surface_id);
   if (!surface) {
     contained_surfaces_[surface_id] = 0;
+    surface_frame_cache_.erase(surface_id);
     return;
   }
   contained_surfaces_[surface_id] = surface->frame_index();
@@ -213,9 +235,8 @@ void SurfaceAggregator::HandleSurfaceQuad(
   std::multimap<RenderPassId, CopyOutputRequest*> copy_requests;
   surface->TakeCopyOutputRequests(&copy_requests);
 
-  RenderPassList render_pass_list;
-  bool invalid_frame = TakeResources(surface, frame_data, &render_pass_list);
-  if (invalid_frame) {
+  const RenderPassList* render_pass_list = TakeResources(surface, frame_data);
+  if (!render_pass_list) {
     for (auto& request : copy_requests) {
       request.second->SendEmptyResult();
       delete request.second;
@@ -228,8 +249,8 @@ void SurfaceAggregator::HandleSurfaceQuad(
   bool merge_pass = surface_quad->opacity() == 1.f && copy_requests.empty();
 
   gfx::Rect surface_damage = DamageRectForSurface(
-      surface, *render_pass_list.back(), surface_quad->visible_rect);
-  const RenderPassList& referenced_passes = render_pass_list;
+      surface, *render_pass_list->back(), surface_quad->visible_rect);
+  const RenderPassList& referenced_passes = *render_pass_list;
   size_t passes_to_copy =
       merge_pass ? referenced_passes.size() - 1 : referenced_passes.size();
   for (size_t j = 0; j < passes_to_copy; ++j) {
@@ -266,7 +287,7 @@ void SurfaceAggregator::HandleSurfaceQuad(
     dest_pass_list_->push_back(copy_pass.Pass());
   }
 
-  const RenderPass& last_pass = *render_pass_list.back();
+  const RenderPass& last_pass = *render_pass_list->back();
   if (merge_pass) {
     // TODO(jamesr): Clean up last pass special casing.
     const QuadList& quads = last_pass.quad_list;
@@ -399,18 +420,18 @@ void SurfaceAggregator::CopyQuadsToPass(
 
 void SurfaceAggregator::CopyPasses(const DelegatedFrameData* frame_data,
                                    Surface* surface) {
-  RenderPassList source_pass_list;
-
   // The root surface is allowed to have copy output requests, so grab them
   // off its render passes.
   std::multimap<RenderPassId, CopyOutputRequest*> copy_requests;
   surface->TakeCopyOutputRequests(&copy_requests);
 
-  bool invalid_frame = TakeResources(surface, frame_data, &source_pass_list);
-  DCHECK(!invalid_frame);
+  const RenderPassList* source_pass_list = TakeResources(surface, frame_data);
+  DCHECK(source_pass_list);
+  if (!source_pass_list)
+    return;
 
-  for (size_t i = 0; i < source_pass_list.size(); ++i) {
-    const RenderPass& source = *source_pass_list[i];
+  for (size_t i = 0; i < source_pass_list->size(); ++i) {
+    const RenderPass& source = *(*source_pass_list)[i];
 
     size_t sqs_size = source.shared_quad_state_list.size();
     size_t dq_size = source.quad_list.size();
@@ -422,7 +443,7 @@ void SurfaceAggregator::CopyPasses(const DelegatedFrameData* frame_data,
         RemapPassId(source.id, surface->surface_id());
 
     gfx::Rect damage_rect =
-        (i < source_pass_list.size() - 1)
+        (i < source_pass_list->size() - 1)
             ? gfx::Rect()
             : DamageRectForSurface(surface, source, source.output_rect);
     copy_pass->SetAll(remapped_pass_id, source.output_rect, damage_rect,
@@ -440,6 +461,7 @@ void SurfaceAggregator::CopyPasses(const DelegatedFrameData* frame_data,
 void SurfaceAggregator::RemoveUnreferencedChildren() {
   for (const auto& surface : previous_contained_surfaces_) {
     if (!contained_surfaces_.count(surface.first)) {
+      surface_frame_cache_.erase(surface.first);
       SurfaceToResourceChildIdMap::iterator it =
           surface_id_to_resource_child_id_.find(surface.first);
       if (it != surface_id_to_resource_child_id_.end()) {
@@ -501,6 +523,7 @@ scoped_ptr<CompositorFrame> SurfaceAggregator::Aggregate(SurfaceId surface_id) {
 }
 
 void SurfaceAggregator::ReleaseResources(SurfaceId surface_id) {
+  surface_frame_cache_.erase(surface_id);
   SurfaceToResourceChildIdMap::iterator it =
       surface_id_to_resource_child_id_.find(surface_id);
   if (it != surface_id_to_resource_child_id_.end()) {
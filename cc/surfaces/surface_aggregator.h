@@ -74,9 +74,12 @@ class CC_SURFACES_EXPORT SurfaceAggregator {
   // referenced from the ResourceProvider.
   void RemoveUnreferencedChildren();
 
-  bool TakeResources(Surface* surface,
-                     const DelegatedFrameData* frame_data,
-                     RenderPassList* render_pass_list);
+  // Returns the render passes of |surface|'s current frame with resource ids
+  // remapped into the parent's namespace, or NULL if the frame references
+  // resources the child didn't send. The returned list is owned by
+  // |surface_frame_cache_|.
+  const RenderPassList* TakeResources(Surface* surface,
+                                      const DelegatedFrameData* frame_data);
   int ChildIdForSurface(Surface* surface);
   gfx::Rect DamageRectForSurface(const Surface* surface,
                                  const RenderPass& source,
@@ -94,6 +97,15 @@ class CC_SURFACES_EXPORT SurfaceAggregator {
   typedef base::hash_map<SurfaceId, int> SurfaceToResourceChildIdMap;
   SurfaceToResourceChildIdMap surface_id_to_resource_child_id_;
 
+  // Remapped copies of the render passes most recently taken from each
+  // surface. A surface whose frame hasn't changed since the last aggregation
+  // reuses its entry instead of being copied and having its resources received
+  // from the child again.
+  struct CachedSurfaceFrame;
+  typedef base::ScopedPtrHashMap<SurfaceId, CachedSurfaceFrame>
+      SurfaceFrameCache;
+  SurfaceFrameCache surface_frame_cache_;
+
   // The following state is only valid for the duration of one Aggregate call
   // and is only stored on the class to avoid having to pass through every
   // function call.
@@ -1390,6 +1390,53 @@ TEST_F(SurfaceAggregatorWithResourcesTest, TakeInvalidResources) {
   factory.Destroy(surface_id);
 }
 
+// Aggregating a surface whose frame hasn't changed should reuse the remapped
+// passes from the previous aggregation, and a new frame should replace them.
+TEST_F(SurfaceAggregatorWithResourcesTest, UnchangedSurfaceReused) {
+  ResourceTrackingSurfaceFactoryClient client;
+  SurfaceFactory factory(&manager_, &client);
+  SurfaceId surface_id(7u);
+  factory.Create(surface_id);
+
+  ResourceProvider::ResourceId ids[] = {11, 12, 13};
+  SubmitFrameWithResources(ids, arraysize(ids), &factory, surface_id);
+
+  scoped_ptr<CompositorFrame> frame = aggregator_->Aggregate(surface_id);
+  ASSERT_TRUE(frame);
+  scoped_ptr<CompositorFrame> second_frame =
+      aggregator_->Aggregate(surface_id);
+  ASSERT_TRUE(second_frame);
+
+  const QuadList& quads =
+      frame->delegated_frame_data->render_pass_list.back()->quad_list;
+  const QuadList& second_quads =
+      second_frame->delegated_frame_data->render_pass_list.back()->quad_list;
+  ASSERT_EQ(arraysize(ids), quads.size());
+  ASSERT_EQ(arraysize(ids), second_quads.size());
+  for (size_t i = 0; i < arraysize(ids); ++i) {
+    EXPECT_EQ(TextureDrawQuad::MaterialCast(quads.ElementAt(i))->resource_id,
+              TextureDrawQuad::MaterialCast(second_quads.ElementAt(i))
+                  ->resource_id);
+  }
+  EXPECT_EQ(3u, resource_provider_->num_resources());
+  EXPECT_TRUE(client.returned_resources().empty());
+
+  ResourceProvider::ResourceId ids2[] = {14, 15};
+  SubmitFrameWithResources(ids2, arraysize(ids2), &factory, surface_id);
+
+  frame = aggregator_->Aggregate(surface_id);
+  ASSERT_TRUE(frame);
+  EXPECT_EQ(arraysize(ids2),
+            frame->delegated_frame_data->render_pass_list.back()
+                ->quad_list.size());
+
+  // The resources from the first frame were only received once, so they're
+  // all returned as soon as the new frame is aggregated.
+  ASSERT_EQ(3u, client.returned_resources().size());
+  EXPECT_EQ(2u, resource_provider_->num_resources());
+  factory.Destroy(surface_id);
+}
+
 TEST_F(SurfaceAggregatorWithResourcesTest, TwoSurfaces) {
   ResourceTrackingSurfaceFactoryClient client;
   SurfaceFactory factory(&manager_, &client);
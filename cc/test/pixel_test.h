@@ -121,6 +121,16 @@ class SoftwareRendererWithExpandedViewport : public SoftwareRenderer {
       : SoftwareRenderer(client, settings, output_surface, resource_provider) {}
 };
 
+// A software renderer that rasterizes the root render pass in parallel tiles.
+class SoftwareRendererWithTiledRaster : public SoftwareRenderer {
+ public:
+  SoftwareRendererWithTiledRaster(RendererClient* client,
+                                  const RendererSettings* settings,
+                                  OutputSurface* output_surface,
+                                  ResourceProvider* resource_provider)
+      : SoftwareRenderer(client, settings, output_surface, resource_provider) {}
+};
+
 class GLRendererWithFlippedSurface : public GLRenderer {
  public:
   GLRendererWithFlippedSurface(RendererClient* client,
@@ -166,6 +176,15 @@ inline void RendererPixelTest<SoftwareRendererWithExpandedViewport>::SetUp() {
   ForceViewportOffset(gfx::Vector2d(10, 20));
 }
 
+template <>
+inline void RendererPixelTest<SoftwareRendererWithTiledRaster>::SetUp() {
+  // Use tiles that don't divide the viewport evenly so that edge tiles are
+  // exercised too.
+  settings_.renderer_settings.num_software_raster_threads = 3;
+  settings_.renderer_settings.software_raster_tile_size = 48;
+  SetUpSoftwareRenderer();
+}
+
 typedef RendererPixelTest<GLRenderer> GLRendererPixelTest;
 typedef RendererPixelTest<SoftwareRenderer> SoftwareRendererPixelTest;
 
@@ -6,6 +6,8 @@
 
 #include "gpu/command_buffer/client/cmd_buffer_helper.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/time/time.h"
 #include "gpu/command_buffer/common/command_buffer.h"
@@ -23,6 +25,7 @@ CommandBufferHelper::CommandBufferHelper(CommandBuffer* command_buffer)
       token_(0),
       put_(0),
       last_put_sent_(0),
+      idle_flush_limit_(0),
 #if defined(CMD_HELPER_PERIODIC_FLUSH_CHECK)
       commands_issued_(0),
 #endif
@@ -64,9 +67,9 @@ void CommandBufferHelper::CalcImmediateEntries(int waiting_count) {
 
   // Limit entry count to force early flushing.
   if (flush_automatically_) {
-    int32 limit =
-        total_entry_count_ /
-        ((curr_get == last_put_sent_) ? kAutoFlushSmall : kAutoFlushBig);
+    int32 limit = (curr_get == last_put_sent_)
+                      ? idle_flush_limit_
+                      : total_entry_count_ / kAutoFlushBig;
 
     int32 pending =
         (put_ + total_entry_count_ - last_put_sent_) % total_entry_count_;
@@ -85,6 +88,19 @@ void CommandBufferHelper::CalcImmediateEntries(int waiting_count) {
   }
 }
 
+// If the service has already consumed everything flushed so far it is starved
+// for work, so hand it smaller batches sooner. If it is still busy, let the
+// batches grow to save on flushes.
+void CommandBufferHelper::UpdateIdleFlushLimit() {
+  if (get_offset() == last_put_sent_) {
+    int32 min_limit = std::max(total_entry_count_ / kAutoFlushMin, 1);
+    idle_flush_limit_ = std::max(idle_flush_limit_ / 2, min_limit);
+  } else {
+    idle_flush_limit_ =
+        std::min(idle_flush_limit_ * 2, total_entry_count_ / kAutoFlushBig);
+  }
+}
+
 bool CommandBufferHelper::AllocateRingBuffer() {
   if (!usable()) {
     return false;
@@ -107,6 +123,7 @@ bool CommandBufferHelper::AllocateRingBuffer() {
   command_buffer_->SetGetBuffer(id);
   entries_ = static_cast<CommandBufferEntry*>(ring_buffer_->memory());
   total_entry_count_ = ring_buffer_size_ / sizeof(CommandBufferEntry);
+  idle_flush_limit_ = total_entry_count_ / kAutoFlushSmall;
   // Call to SetGetBuffer(id) above resets get and put offsets to 0.
   // No need to query it through IPC.
   put_ = 0;
@@ -141,6 +158,7 @@ bool CommandBufferHelper::WaitForGetOffsetInRange(int32 start, int32 end) {
   if (!usable()) {
     return false;
   }
+  ++stats_.round_trips;
   command_buffer_->WaitForGetOffsetInRange(start, end);
   return command_buffer_->GetLastError() == gpu::error::kNoError;
 }
@@ -151,6 +169,13 @@ void CommandBufferHelper::Flush() {
     put_ = 0;
 
   if (usable()) {
+    if (HaveRingBuffer() && put_ != last_put_sent_) {
+      int32 pending =
+          (put_ + total_entry_count_ - last_put_sent_) % total_entry_count_;
+      ++stats_.flushes;
+      stats_.bytes_flushed += pending * sizeof(CommandBufferEntry);
+      UpdateIdleFlushLimit();
+    }
     last_flush_time_ = base::TimeTicks::Now();
     last_put_sent_ = put_;
     command_buffer_->Flush(put_);
@@ -242,6 +267,7 @@ void CommandBufferHelper::WaitForToken(int32 token) {
   if (last_token_read() >= token)
     return;
   Flush();
+  ++stats_.round_trips;
   command_buffer_->WaitForTokenInRange(token, token_);
 }
 
@@ -27,6 +27,7 @@ const int kPeriodicFlushDelayInMicroseconds =
 
 const int kAutoFlushSmall = 16;  // 1/16 of the buffer
 const int kAutoFlushBig = 2;     // 1/2 of the buffer
+const int kAutoFlushMin = 64;    // 1/64 of the buffer
 
 // Command buffer helper class. This class simplifies ring buffer management:
 // it will allocate the buffer, give it to the buffer interface, and let the
@@ -45,6 +46,19 @@ const int kAutoFlushBig = 2;     // 1/2 of the buffer
 //                              // commands have been executed.
 class GPU_EXPORT CommandBufferHelper {
  public:
+  // Counters describing the traffic between the helper and the service. They
+  // accumulate until ResetStats() is called, e.g. once per frame.
+  struct Stats {
+    Stats() : flushes(0), round_trips(0), bytes_flushed(0) {}
+
+    // Number of flushes that handed new commands to the service.
+    uint32 flushes;
+    // Number of times the client blocked waiting on the service.
+    uint32 round_trips;
+    // Number of command bytes handed to the service.
+    uint64 bytes_flushed;
+  };
+
   explicit CommandBufferHelper(CommandBuffer* command_buffer);
   virtual ~CommandBufferHelper();
 
@@ -283,6 +297,9 @@ class GPU_EXPORT CommandBufferHelper {
 
   uint32 flush_generation() const { return flush_generation_; }
 
+  const Stats& stats() const { return stats_; }
+  void ResetStats() { stats_ = Stats(); }
+
   void FreeRingBuffer();
 
   bool HaveRingBuffer() const {
@@ -305,6 +322,9 @@ class GPU_EXPORT CommandBufferHelper {
   }
 
   void CalcImmediateEntries(int waiting_count);
+  // Adapts |idle_flush_limit_| to how quickly the service drains the
+  // commands flushed so far. Called before each flush that sends commands.
+  void UpdateIdleFlushLimit();
   bool AllocateRingBuffer();
   void FreeResources();
 
@@ -329,6 +349,11 @@ class GPU_EXPORT CommandBufferHelper {
   int32 last_put_sent_;
   int32 last_barrier_put_sent_;
 
+  // Number of pending entries after which commands are automatically flushed
+  // while the service is idle. Between kAutoFlushMin and kAutoFlushBig of the
+  // buffer.
+  int32 idle_flush_limit_;
+
 #if defined(CMD_HELPER_PERIODIC_FLUSH_CHECK)
   int commands_issued_;
 #endif
@@ -343,6 +368,8 @@ class GPU_EXPORT CommandBufferHelper {
   // Can be used to track when prior commands have been flushed.
   uint32 flush_generation_;
 
+  Stats stats_;
+
   friend class CommandBufferHelperTest;
   DISALLOW_COPY_AND_ASSIGN(CommandBufferHelper);
 };
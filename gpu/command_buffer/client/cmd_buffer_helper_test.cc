@@ -4,6 +4,7 @@
 
 // Tests for the Command Buffer Helper.
 
+#include <algorithm>
 #include <list>
 
 #include "base/bind.h"
@@ -128,6 +129,8 @@ class CommandBufferHelperTest : public testing::Test {
 
   int32 ImmediateEntryCount() const { return helper_->immediate_entry_count_; }
 
+  int32 IdleFlushLimit() const { return helper_->idle_flush_limit_; }
+
   // Adds a command to the buffer through the helper, while adding it as an
   // expected call on the API mock.
   void AddCommandWithExpect(error::Error _return,
@@ -769,4 +772,81 @@ TEST_F(CommandBufferHelperTest, TestOrderingBarrierToCommandBuffer) {
   EXPECT_EQ(flush_count3, flush_count2 + 1);
 }
 
+// Checks that the helper counts flushes, round trips and flushed bytes.
+TEST_F(CommandBufferHelperTest, TestStats) {
+  // Explicit flushing only.
+  helper_->SetAutomaticFlushes(false);
+  helper_->ResetStats();
+
+  AddUniqueCommandWithExpect(error::kNoError, 2);
+  helper_->Flush();
+  EXPECT_EQ(1u, helper_->stats().flushes);
+  EXPECT_EQ(0u, helper_->stats().round_trips);
+  EXPECT_EQ(2 * sizeof(CommandBufferEntry), helper_->stats().bytes_flushed);
+
+  // Flushing without new commands doesn't count.
+  helper_->Flush();
+  EXPECT_EQ(1u, helper_->stats().flushes);
+
+  // Finish flushes and waits for the service.
+  command_buffer_->LockFlush();
+  AddUniqueCommandWithExpect(error::kNoError, 3);
+  helper_->Finish();
+  EXPECT_EQ(2u, helper_->stats().flushes);
+  EXPECT_EQ(1u, helper_->stats().round_trips);
+  EXPECT_EQ(5 * sizeof(CommandBufferEntry), helper_->stats().bytes_flushed);
+
+  // Nothing to wait for.
+  helper_->Finish();
+  EXPECT_EQ(1u, helper_->stats().round_trips);
+
+  helper_->ResetStats();
+  EXPECT_EQ(0u, helper_->stats().flushes);
+  EXPECT_EQ(0u, helper_->stats().round_trips);
+  EXPECT_EQ(0u, helper_->stats().bytes_flushed);
+
+  // Check that the commands did happen.
+  Mock::VerifyAndClearExpectations(api_mock_.get());
+
+  // Check the error status.
+  EXPECT_EQ(error::kNoError, GetError());
+}
+
+// Checks that the idle flush limit shrinks while the service keeps up with
+// the flushed commands, and grows back when it falls behind.
+TEST_F(CommandBufferHelperTest, TestIdleFlushLimitAdapts) {
+  // Explicit flushing only, so that only the flushes below adapt the limit.
+  helper_->SetAutomaticFlushes(false);
+  const int32 initial_limit = kTotalNumCommandEntries / kAutoFlushSmall;
+  const int32 min_limit = std::max(kTotalNumCommandEntries / kAutoFlushMin, 1);
+  EXPECT_EQ(initial_limit, IdleFlushLimit());
+
+  // The service processes each flush right away, so it is always idle when
+  // the next flush happens.
+  AddUniqueCommandWithExpect(error::kNoError, 2);
+  helper_->Flush();
+  EXPECT_EQ(std::max(initial_limit / 2, min_limit), IdleFlushLimit());
+  for (int i = 0; i < 8; ++i) {
+    AddUniqueCommandWithExpect(error::kNoError, 2);
+    helper_->Flush();
+  }
+  EXPECT_EQ(min_limit, IdleFlushLimit());
+
+  // The service doesn't get to the first flush before the second one.
+  command_buffer_->LockFlush();
+  AddUniqueCommandWithExpect(error::kNoError, 2);
+  helper_->Flush();
+  EXPECT_EQ(min_limit, IdleFlushLimit());
+  AddUniqueCommandWithExpect(error::kNoError, 2);
+  helper_->Flush();
+  EXPECT_EQ(2 * min_limit, IdleFlushLimit());
+
+  helper_->Finish();
+  // Check that the commands did happen.
+  Mock::VerifyAndClearExpectations(api_mock_.get());
+
+  // Check the error status.
+  EXPECT_EQ(error::kNoError, GetError());
+}
+
 }  // namespace gpu
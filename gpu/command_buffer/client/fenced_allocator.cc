@@ -39,23 +39,21 @@ FencedAllocator::FencedAllocator(unsigned int size,
       poll_callback_(poll_callback),
       bytes_in_use_(0) {
   Block block = { FREE, 0, RoundDown(size), kUnusedToken };
-  blocks_.push_back(block);
+  blocks_.insert(std::make_pair(block.offset, block));
+  AddFreeBlock(block);
 }
 
 FencedAllocator::~FencedAllocator() {
   // Free blocks pending tokens.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    if (blocks_[i].state == FREE_PENDING_TOKEN) {
-      i = WaitForTokenAndFreeBlock(i);
-    }
-  }
+  while (!pending_blocks_.empty())
+    WaitForTokenAndFreeBlock(GetBlockByOffset(*pending_blocks_.begin()));
 
   DCHECK_EQ(blocks_.size(), 1u);
-  DCHECK_EQ(blocks_[0].state, FREE);
+  DCHECK_EQ(blocks_.begin()->second.state, FREE);
 }
 
 // Looks for a non-allocated block that is big enough. Search in the FREE
-// blocks first (for direct usage), first-fit, then in the FREE_PENDING_TOKEN
+// blocks first (for direct usage), best-fit, then in the FREE_PENDING_TOKEN
 // blocks, waiting for them. The current implementation isn't smart about
 // optimizing what to wait for, just looks inside the block in order (first-fit
 // as well).
@@ -69,22 +67,20 @@ FencedAllocator::Offset FencedAllocator::Alloc(unsigned int size) {
   // Round up the allocation size to ensure alignment.
   size = RoundUp(size);
 
-  // Try first to allocate in a free block.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
-    if (block.state == FREE && block.size >= size) {
-      return AllocInBlock(i, size);
-    }
-  }
+  // Try first to allocate in the smallest free block that fits.
+  FreeBlockSet::iterator free_it =
+      free_blocks_.lower_bound(std::make_pair(size, static_cast<Offset>(0)));
+  if (free_it != free_blocks_.end())
+    return AllocInBlock(GetBlockByOffset(free_it->second), size);
 
   // No free block is available. Look for blocks pending tokens, and wait for
-  // them to be re-usable.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    if (blocks_[i].state != FREE_PENDING_TOKEN)
-      continue;
-    i = WaitForTokenAndFreeBlock(i);
-    if (blocks_[i].size >= size)
-      return AllocInBlock(i, size);
+  // them to be re-usable. Collapsing only merges FREE neighbours, so the
+  // remaining pending blocks are still visited in offset order.
+  while (!pending_blocks_.empty()) {
+    BlockIterator block =
+        WaitForTokenAndFreeBlock(GetBlockByOffset(*pending_blocks_.begin()));
+    if (block->second.size >= size)
+      return AllocInBlock(block, size);
   }
   return kInvalidOffset;
 }
@@ -92,38 +88,32 @@ FencedAllocator::Offset FencedAllocator::Alloc(unsigned int size) {
 // Looks for the corresponding block, mark it FREE, and collapse it if
 // necessary.
 void FencedAllocator::Free(FencedAllocator::Offset offset) {
-  BlockIndex index = GetBlockByOffset(offset);
-  DCHECK_NE(blocks_[index].state, FREE);
-  Block &block = blocks_[index];
+  BlockIterator block = GetBlockByOffset(offset);
+  DCHECK_NE(block->second.state, FREE);
 
-  if (block.state == IN_USE)
-    bytes_in_use_ -= block.size;
+  if (block->second.state == IN_USE)
+    bytes_in_use_ -= block->second.size;
+  else
+    pending_blocks_.erase(offset);
 
-  block.state = FREE;
-  CollapseFreeBlock(index);
+  CollapseFreeBlock(block);
 }
 
 // Looks for the corresponding block, mark it FREE_PENDING_TOKEN.
 void FencedAllocator::FreePendingToken(
     FencedAllocator::Offset offset, int32 token) {
-  BlockIndex index = GetBlockByOffset(offset);
-  Block &block = blocks_[index];
-  if (block.state == IN_USE)
-    bytes_in_use_ -= block.size;
-  block.state = FREE_PENDING_TOKEN;
-  block.token = token;
+  BlockIterator block = GetBlockByOffset(offset);
+  if (block->second.state == IN_USE)
+    bytes_in_use_ -= block->second.size;
+  block->second.state = FREE_PENDING_TOKEN;
+  block->second.token = token;
+  pending_blocks_.insert(offset);
 }
 
 // Gets the max of the size of the blocks marked as free.
 unsigned int FencedAllocator::GetLargestFreeSize() {
   FreeUnused();
-  unsigned int max_size = 0;
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
-    if (block.state == FREE)
-      max_size = std::max(max_size, block.size);
-  }
-  return max_size;
+  return free_blocks_.empty() ? 0 : free_blocks_.rbegin()->first;
 }
 
 // Gets the size of the largest segment of blocks that are either FREE or
@@ -131,8 +121,9 @@ unsigned int FencedAllocator::GetLargestFreeSize() {
 unsigned int FencedAllocator::GetLargestFreeOrPendingSize() {
   unsigned int max_size = 0;
   unsigned int current_size = 0;
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
+  for (Container::const_iterator it = blocks_.begin(); it != blocks_.end();
+       ++it) {
+    const Block& block = it->second;
     if (block.state == IN_USE) {
       max_size = std::max(max_size, current_size);
       current_size = 0;
@@ -148,11 +139,30 @@ unsigned int FencedAllocator::GetLargestFreeOrPendingSize() {
 // - there is at least one block.
 // - there are no contiguous FREE blocks (they should have been collapsed).
 // - the successive offsets match the block sizes, and they are in order.
+// - exactly the FREE blocks are in the size index, and exactly the
+//   FREE_PENDING_TOKEN blocks are in the pending set.
 bool FencedAllocator::CheckConsistency() {
   if (blocks_.size() < 1) return false;
-  for (unsigned int i = 0; i < blocks_.size() - 1; ++i) {
-    Block &current = blocks_[i];
-    Block &next = blocks_[i + 1];
+  size_t free_count = 0;
+  size_t pending_count = 0;
+  for (Container::const_iterator it = blocks_.begin(); it != blocks_.end();
+       ++it) {
+    const Block& current = it->second;
+    if (it->first != current.offset)
+      return false;
+    if (current.state == FREE) {
+      ++free_count;
+      if (!free_blocks_.count(std::make_pair(current.size, current.offset)))
+        return false;
+    } else if (current.state == FREE_PENDING_TOKEN) {
+      ++pending_count;
+      if (!pending_blocks_.count(current.offset))
+        return false;
+    }
+    Container::const_iterator next_it = it;
+    if (++next_it == blocks_.end())
+      break;
+    const Block& next = next_it->second;
     // This test is NOT included in the next one, because offset is unsigned.
     if (next.offset <= current.offset)
       return false;
@@ -161,45 +171,60 @@ bool FencedAllocator::CheckConsistency() {
     if (current.state == FREE && next.state == FREE)
       return false;
   }
-  return true;
+  return free_count == free_blocks_.size() &&
+         pending_count == pending_blocks_.size();
 }
 
 // Returns false if all blocks are actually FREE, in which
 // case they would be coalesced into one block, true otherwise.
 bool FencedAllocator::InUse() {
-  return blocks_.size() != 1 || blocks_[0].state != FREE;
+  return blocks_.size() != 1 || blocks_.begin()->second.state != FREE;
+}
+
+void FencedAllocator::AddFreeBlock(const Block& block) {
+  DCHECK_EQ(block.state, FREE);
+  free_blocks_.insert(std::make_pair(block.size, block.offset));
+}
+
+void FencedAllocator::RemoveFreeBlock(const Block& block) {
+  DCHECK_EQ(block.state, FREE);
+  size_t erased = free_blocks_.erase(std::make_pair(block.size, block.offset));
+  DCHECK_EQ(erased, 1u);
 }
 
 // Collapse the block to the next one, then to the previous one. Provided the
 // structure is consistent, those are the only blocks eligible for collapse.
-FencedAllocator::BlockIndex FencedAllocator::CollapseFreeBlock(
-    BlockIndex index) {
-  if (index + 1 < blocks_.size()) {
-    Block &next = blocks_[index + 1];
-    if (next.state == FREE) {
-      blocks_[index].size += next.size;
-      blocks_.erase(blocks_.begin() + index + 1);
-    }
+FencedAllocator::BlockIterator FencedAllocator::CollapseFreeBlock(
+    BlockIterator block) {
+  block->second.state = FREE;
+  BlockIterator next = block;
+  ++next;
+  if (next != blocks_.end() && next->second.state == FREE) {
+    RemoveFreeBlock(next->second);
+    block->second.size += next->second.size;
+    blocks_.erase(next);
   }
-  if (index > 0) {
-    Block &prev = blocks_[index - 1];
-    if (prev.state == FREE) {
-      prev.size += blocks_[index].size;
-      blocks_.erase(blocks_.begin() + index);
-      --index;
+  if (block != blocks_.begin()) {
+    BlockIterator prev = block;
+    --prev;
+    if (prev->second.state == FREE) {
+      RemoveFreeBlock(prev->second);
+      prev->second.size += block->second.size;
+      blocks_.erase(block);
+      block = prev;
     }
   }
-  return index;
+  AddFreeBlock(block->second);
+  return block;
 }
 
 // Waits for the block's token, then mark the block as free, then collapse it.
-FencedAllocator::BlockIndex FencedAllocator::WaitForTokenAndFreeBlock(
-    BlockIndex index) {
-  Block &block = blocks_[index];
-  DCHECK_EQ(block.state, FREE_PENDING_TOKEN);
-  helper_->WaitForToken(block.token);
-  block.state = FREE;
-  return CollapseFreeBlock(index);
+FencedAllocator::BlockIterator FencedAllocator::WaitForTokenAndFreeBlock(
+    BlockIterator block) {
+  DCHECK_EQ(block->second.state, FREE_PENDING_TOKEN);
+  helper_->WaitForToken(block->second.token);
+  pending_blocks_.erase(block->first);
+  return CollapseFreeBlock(block);
 }
 
 // Frees any blocks pending a token for which the token has been read.
@@ -207,46 +232,45 @@ void FencedAllocator::FreeUnused() {
   // Free any potential blocks that has its lifetime handled outside.
   poll_callback_.Run();
 
-  for (unsigned int i = 0; i < blocks_.size();) {
-    Block& block = blocks_[i];
-    if (block.state == FREE_PENDING_TOKEN &&
-        helper_->HasTokenPassed(block.token)) {
-      block.state = FREE;
-      i = CollapseFreeBlock(i);
+  // Only pending blocks are visited. Collapsing never removes a pending block,
+  // so the remaining entries of |pending_blocks_| stay valid.
+  for (PendingBlockSet::iterator it = pending_blocks_.begin();
+       it != pending_blocks_.end();) {
+    BlockIterator block = GetBlockByOffset(*it);
+    if (helper_->HasTokenPassed(block->second.token)) {
+      pending_blocks_.erase(it++);
+      CollapseFreeBlock(block);
     } else {
-      ++i;
+      ++it;
     }
   }
 }
 
 // If the block is exactly the requested size, simply mark it IN_USE, otherwise
 // split it and mark the first one (of the requested size) IN_USE.
-FencedAllocator::Offset FencedAllocator::AllocInBlock(BlockIndex index,
+FencedAllocator::Offset FencedAllocator::AllocInBlock(BlockIterator block,
                                                       unsigned int size) {
-  Block &block = blocks_[index];
-  DCHECK_GE(block.size, size);
-  DCHECK_EQ(block.state, FREE);
-  Offset offset = block.offset;
+  DCHECK_GE(block->second.size, size);
+  RemoveFreeBlock(block->second);
+  Offset offset = block->first;
   bytes_in_use_ += size;
-  if (block.size == size) {
-    block.state = IN_USE;
-    return offset;
+  if (block->second.size != size) {
+    Block newblock = {
+        FREE, offset + size, block->second.size - size, kUnusedToken};
+    block->second.size = size;
+    blocks_.insert(++BlockIterator(block),
+                   std::make_pair(newblock.offset, newblock));
+    AddFreeBlock(newblock);
   }
-  Block newblock = { FREE, offset + size, block.size - size, kUnusedToken};
-  block.state = IN_USE;
-  block.size = size;
-  // this is the last thing being done because it may invalidate block;
-  blocks_.insert(blocks_.begin() + index + 1, newblock);
+  block->second.state = IN_USE;
   return offset;
 }
 
-// The blocks are in offset order, so we can do a binary search.
-FencedAllocator::BlockIndex FencedAllocator::GetBlockByOffset(Offset offset) {
-  Block templ = { IN_USE, offset, 0, kUnusedToken };
-  Container::iterator it = std::lower_bound(blocks_.begin(), blocks_.end(),
-                                            templ, OffsetCmp());
-  DCHECK(it != blocks_.end() && it->offset == offset);
-  return it-blocks_.begin();
+FencedAllocator::BlockIterator FencedAllocator::GetBlockByOffset(
+    Offset offset) {
+  BlockIterator it = blocks_.find(offset);
+  DCHECK(it != blocks_.end());
+  return it;
 }
 
 }  // namespace gpu
@@ -9,7 +9,9 @@
 
 #include <stdint.h>
 
-#include <vector>
+#include <map>
+#include <set>
+#include <utility>
 
 #include "base/bind.h"
 #include "base/logging.h"
@@ -109,42 +111,47 @@ class GPU_EXPORT FencedAllocator {
     int32_t token;  // token to wait for in the FREE_PENDING_TOKEN case.
   };
 
-  // Comparison functor for memory block sorting.
-  class OffsetCmp {
-   public:
-    bool operator() (const Block &left, const Block &right) {
-      return left.offset < right.offset;
-    }
-  };
+  // All blocks, keyed by offset. Iterators stay valid across insertions and
+  // across erasure of other blocks, so they are used as block handles.
+  typedef std::map<Offset, Block> Container;
+  typedef Container::iterator BlockIterator;
+
+  // FREE blocks ordered by (size, offset), so that the smallest block that
+  // fits a request (the lowest one among equals) is found in O(log n).
+  typedef std::set<std::pair<unsigned int, Offset> > FreeBlockSet;
 
-  typedef std::vector<Block> Container;
-  typedef unsigned int BlockIndex;
+  // Offsets of the FREE_PENDING_TOKEN blocks, in offset order.
+  typedef std::set<Offset> PendingBlockSet;
 
   static const int32_t kUnusedToken = 0;
 
-  // Gets the index of a memory block, given its offset.
-  BlockIndex GetBlockByOffset(Offset offset);
+  // Gets a memory block, given its offset.
+  BlockIterator GetBlockByOffset(Offset offset);
+
+  // Adds/removes a FREE block to/from the size index.
+  void AddFreeBlock(const Block& block);
+  void RemoveFreeBlock(const Block& block);
 
-  // Collapse a free block with its neighbours if they are free. Returns the
-  // index of the collapsed block.
-  // NOTE: this will invalidate block indices.
-  BlockIndex CollapseFreeBlock(BlockIndex index);
+  // Marks a block FREE, collapses it with its neighbours if they are free and
+  // indexes the result. Returns the collapsed block.
+  // NOTE: this will invalidate iterators to the neighbouring blocks.
+  BlockIterator CollapseFreeBlock(BlockIterator block);
 
   // Waits for a FREE_PENDING_TOKEN block to be usable, and free it. Returns
-  // the new index of that block (since it may have been collapsed).
-  // NOTE: this will invalidate block indices.
-  BlockIndex WaitForTokenAndFreeBlock(BlockIndex index);
+  // the resulting block (since it may have been collapsed).
+  // NOTE: this will invalidate iterators to the neighbouring blocks.
+  BlockIterator WaitForTokenAndFreeBlock(BlockIterator block);
 
   // Allocates a block of memory inside a given block, splitting it in two
   // (unless that block is of the exact requested size).
-  // NOTE: this will invalidate block indices.
-  // Returns the offset of the allocated block (NOTE: this is different from
-  // the other functions that return a block index).
-  Offset AllocInBlock(BlockIndex index, unsigned int size);
+  // Returns the offset of the allocated block.
+  Offset AllocInBlock(BlockIterator block, unsigned int size);
 
   CommandBufferHelper *helper_;
   base::Closure poll_callback_;
   Container blocks_;
+  FreeBlockSet free_blocks_;
+  PendingBlockSet pending_blocks_;
   size_t bytes_in_use_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(FencedAllocator);
@@ -0,0 +1,136 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains the microbenchmarks for the FencedAllocator class.
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+#include "gpu/command_buffer/client/client_test_helper.h"
+#include "gpu/command_buffer/client/cmd_buffer_helper.h"
+#include "gpu/command_buffer/client/fenced_allocator.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace gpu {
+namespace {
+
+const unsigned int kCommandBufferSize = 64 * 1024;
+const unsigned int kBufferSize = 16 * 1024 * 1024;
+const unsigned int kMaxAllocSize = 4096;
+const int kIterations = 200000;
+const int kFreeUnusedInterval = 64;
+
+void EmptyPoll() {
+}
+
+class FencedAllocatorPerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    command_buffer_.reset(new testing::NiceMock<MockClientCommandBuffer>());
+    helper_.reset(new CommandBufferHelper(command_buffer_.get()));
+    ASSERT_TRUE(helper_->Initialize(kCommandBufferSize));
+    allocator_.reset(new FencedAllocator(kBufferSize, helper_.get(),
+                                         base::Bind(&EmptyPoll)));
+    seed_ = 1;
+  }
+
+  void TearDown() override {
+    allocator_.reset();
+    helper_.reset();
+    command_buffer_.reset();
+  }
+
+  // Deterministic pseudo-random allocation sizes, so runs are comparable.
+  unsigned int NextSize() {
+    seed_ = seed_ * 1103515245u + 12345u;
+    return 1 + (seed_ >> 16) % kMaxAllocSize;
+  }
+
+  // Keeps |live_count| allocations alive, retiring the oldest one for each new
+  // allocation, the way transfer buffer uploads cycle through the allocator.
+  void RunChurn(const std::string& name, size_t live_count, bool pending) {
+    std::deque<FencedAllocator::Offset> live;
+    for (size_t i = 0; i < live_count; ++i) {
+      FencedAllocator::Offset offset = allocator_->Alloc(NextSize());
+      ASSERT_NE(FencedAllocator::kInvalidOffset, offset);
+      live.push_back(offset);
+    }
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kIterations; ++i) {
+      if (pending)
+        allocator_->FreePendingToken(live.front(), helper_->InsertToken());
+      else
+        allocator_->Free(live.front());
+      live.pop_front();
+      if (pending && i % kFreeUnusedInterval == 0)
+        allocator_->FreeUnused();
+      FencedAllocator::Offset offset = allocator_->Alloc(NextSize());
+      ASSERT_NE(FencedAllocator::kInvalidOffset, offset);
+      live.push_back(offset);
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    EXPECT_TRUE(allocator_->CheckConsistency());
+    while (!live.empty()) {
+      allocator_->Free(live.front());
+      live.pop_front();
+    }
+
+    perf_test::PrintResult(
+        "fenced_allocator", "", name,
+        elapsed.InNanoseconds() / static_cast<double>(kIterations), "ns/op",
+        true);
+  }
+
+  scoped_ptr<MockClientCommandBuffer> command_buffer_;
+  scoped_ptr<CommandBufferHelper> helper_;
+  scoped_ptr<FencedAllocator> allocator_;
+  unsigned int seed_;
+};
+
+TEST_F(FencedAllocatorPerfTest, AllocFree) {
+  RunChurn("alloc_free_256_live", 256, false);
+}
+
+TEST_F(FencedAllocatorPerfTest, AllocFreeManyLive) {
+  RunChurn("alloc_free_4096_live", 4096, false);
+}
+
+TEST_F(FencedAllocatorPerfTest, AllocFreePendingToken) {
+  RunChurn("alloc_free_pending_token_4096_live", 4096, true);
+}
+
+TEST_F(FencedAllocatorPerfTest, GetLargestFreeSize) {
+  std::deque<FencedAllocator::Offset> live;
+  for (int i = 0; i < 4096; ++i)
+    live.push_back(allocator_->Alloc(NextSize()));
+  // Punch holes so that there are many free blocks to consider.
+  for (size_t i = 0; i < live.size(); i += 2)
+    allocator_->Free(live[i]);
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  unsigned int largest = 0;
+  for (int i = 0; i < kIterations; ++i)
+    largest = std::max(largest, allocator_->GetLargestFreeSize());
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  EXPECT_LT(0u, largest);
+
+  for (size_t i = 1; i < live.size(); i += 2)
+    allocator_->Free(live[i]);
+
+  perf_test::PrintResult(
+      "fenced_allocator", "", "get_largest_free_size",
+      elapsed.InNanoseconds() / static_cast<double>(kIterations), "ns/op",
+      true);
+}
+
+}  // namespace
+}  // namespace gpu
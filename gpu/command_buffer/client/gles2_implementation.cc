@@ -725,7 +725,50 @@ bool GLES2Implementation::GetFloatvHelper(GLenum pname, GLfloat* params) {
 }
 
 bool GLES2Implementation::GetIntegervHelper(GLenum pname, GLint* params) {
-  return GetHelper(pname, params);
+  if (GetHelper(pname, params))
+    return true;
+  return GetImmutableIntegervHelper(pname, params);
+}
+
+// State that can't change over the lifetime of the context is queried from
+// the service once and then answered from |static_state_|, saving a round
+// trip per query.
+bool GLES2Implementation::GetImmutableIntegervHelper(
+    GLenum pname, GLint* params) {
+  switch (pname) {
+    case GL_ALIASED_LINE_WIDTH_RANGE:
+    case GL_ALIASED_POINT_SIZE_RANGE:
+    case GL_COMPRESSED_TEXTURE_FORMATS:
+    case GL_MAX_VIEWPORT_DIMS:
+    case GL_SHADER_BINARY_FORMATS:
+    case GL_SHADER_COMPILER:
+    case GL_SUBPIXEL_BITS:
+      break;
+    default:
+      return false;
+  }
+
+  GLStaticState::IntegervMap::const_iterator it =
+      static_state_.integervs.find(pname);
+  if (it == static_state_.integervs.end()) {
+    typedef cmds::GetIntegerv::Result Result;
+    Result* result = GetResultAs<Result*>();
+    if (!result) {
+      return false;
+    }
+    result->SetNumResults(0);
+    helper_->GetIntegerv(pname, GetResultShmId(), GetResultShmOffset());
+    WaitForCmd();
+    // Don't cache failures; the caller queries again and reports the error.
+    if (result->GetNumResults() <= 0) {
+      return false;
+    }
+    std::vector<GLint> values(
+        result->GetData(), result->GetData() + result->GetNumResults());
+    it = static_state_.integervs.insert(std::make_pair(pname, values)).first;
+  }
+  std::copy(it->second.begin(), it->second.end(), params);
+  return true;
 }
 
 bool GLES2Implementation::GetInternalformativHelper(
@@ -923,6 +966,7 @@ void GLES2Implementation::SwapBuffers() {
   swap_buffers_tokens_.push(helper_->InsertToken());
   helper_->SwapBuffers();
   helper_->CommandBufferHelper::Flush();
+  TraceFrameStats();
   // Wait if we added too many swap buffers. Add 1 to kMaxSwapBuffers to
   // compensate for TODO above.
   if (swap_buffers_tokens_.size() > kMaxSwapBuffers + 1) {
@@ -931,6 +975,16 @@ void GLES2Implementation::SwapBuffers() {
   }
 }
 
+void GLES2Implementation::TraceFrameStats() {
+  const CommandBufferHelper::Stats& stats = helper_->stats();
+  TRACE_COUNTER_ID2("gpu", "GLES2Implementation::FrameStats", this,
+                    "flushes", stats.flushes,
+                    "round_trips", stats.round_trips);
+  TRACE_COUNTER_ID1("gpu", "GLES2Implementation::FrameBytesFlushed", this,
+                    stats.bytes_flushed);
+  helper_->ResetStats();
+}
+
 void GLES2Implementation::SwapInterval(int interval) {
   GPU_CLIENT_SINGLE_THREAD_CHECK();
   GPU_CLIENT_LOG("[" << GetLogPrefix() << "] glSwapInterval("
@@ -4154,6 +4208,7 @@ void GLES2Implementation::PostSubBufferCHROMIUM(
   swap_buffers_tokens_.push(helper_->InsertToken());
   helper_->PostSubBufferCHROMIUM(x, y, width, height);
   helper_->CommandBufferHelper::Flush();
+  TraceFrameStats();
   if (swap_buffers_tokens_.size() > kMaxSwapBuffers + 1) {
     helper_->WaitForToken(swap_buffers_tokens_.front());
     swap_buffers_tokens_.pop();
@@ -142,6 +142,11 @@ class GLES2_IMPL_EXPORT GLES2Implementation
                      cmds::GetShaderPrecisionFormat::Result>
         ShaderPrecisionMap;
     ShaderPrecisionMap shader_precisions;
+
+    // Results of glGetIntegerv for state that is fixed for the lifetime of
+    // the context, see GetImmutableIntegervHelper().
+    typedef std::map<GLenum, std::vector<GLint> > IntegervMap;
+    IntegervMap integervs;
   };
 
   // The maxiumum result size from simple GL get commands.
@@ -567,6 +572,7 @@ class GLES2_IMPL_EXPORT GLES2Implementation
   bool GetFramebufferAttachmentParameterivHelper(
       GLenum target, GLenum attachment, GLenum pname, GLint* params);
   bool GetIntegervHelper(GLenum pname, GLint* params);
+  bool GetImmutableIntegervHelper(GLenum pname, GLint* params);
   bool GetInternalformativHelper(
       GLenum target, GLenum format, GLenum pname, GLsizei bufSize,
       GLint* params);
@@ -595,6 +601,10 @@ class GLES2_IMPL_EXPORT GLES2Implementation
 
   void FinishHelper();
 
+  // Reports the command buffer traffic since the previous frame to tracing,
+  // then starts counting the next frame.
+  void TraceFrameStats();
+
   void RunIfContextNotLost(const base::Closure& callback);
 
   // Validate if an offset is valid, i.e., non-negative and fit into 32-bit.
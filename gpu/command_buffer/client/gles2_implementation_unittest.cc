@@ -2209,6 +2209,39 @@ TEST_F(GLES2ImplementationTest, GetIntegerCacheWrite) {
   EXPECT_EQ(static_cast<GLenum>(GL_NO_ERROR), gl_->GetError());
 }
 
+TEST_F(GLES2ImplementationTest, GetIntegerImmutableCache) {
+  struct Cmds {
+    cmds::GetIntegerv cmd;
+  };
+  struct MaxViewportDimsResult {
+    int32 num_results;
+    GLint dims[2];
+  };
+
+  // The first query goes to the service.
+  Cmds expected;
+  ExpectedMemoryInfo result1 =
+      GetExpectedResultMemory(sizeof(MaxViewportDimsResult));
+  expected.cmd.Init(GL_MAX_VIEWPORT_DIMS, result1.id, result1.offset);
+  MaxViewportDimsResult server_result = {2, {4096, 2048}};
+  EXPECT_CALL(*command_buffer(), OnFlush())
+      .WillOnce(SetMemory(result1.ptr, server_result))
+      .RetiresOnSaturation();
+  GLint dims1[2] = {-1, -1};
+  gl_->GetIntegerv(GL_MAX_VIEWPORT_DIMS, dims1);
+  EXPECT_EQ(0, memcmp(&expected, commands_, sizeof(expected)));
+  EXPECT_EQ(4096, dims1[0]);
+  EXPECT_EQ(2048, dims1[1]);
+
+  // Later queries are answered from the cache, without a round trip.
+  const void* commands = GetPut();
+  GLint dims2[2] = {-1, -1};
+  gl_->GetIntegerv(GL_MAX_VIEWPORT_DIMS, dims2);
+  EXPECT_EQ(commands, GetPut());
+  EXPECT_EQ(4096, dims2[0]);
+  EXPECT_EQ(2048, dims2[1]);
+}
+
 static bool CheckRect(
     int width, int height, GLenum format, GLenum type, int alignment,
     bool flip_y, const uint8* r1, const uint8* r2) {
@@ -95,6 +95,7 @@ void* MappedMemoryManager::Alloc(
   MemoryChunk* mc = new MemoryChunk(id, shm, helper_, poll_callback_);
   allocated_memory_ += mc->GetSize();
   chunks_.push_back(mc);
+  chunks_by_address_[mc->GetBase()] = mc;
   void* mem = mc->Alloc(size);
   DCHECK(mem);
   *shm_id = mc->shm_id();
@@ -103,25 +104,21 @@ void* MappedMemoryManager::Alloc(
 }
 
 void MappedMemoryManager::Free(void* pointer) {
-  for (size_t ii = 0; ii < chunks_.size(); ++ii) {
-    MemoryChunk* chunk = chunks_[ii];
-    if (chunk->IsInChunk(pointer)) {
-      chunk->Free(pointer);
-      return;
-    }
+  MemoryChunk* chunk = GetChunkForPointer(pointer);
+  if (!chunk) {
+    NOTREACHED();
+    return;
   }
-  NOTREACHED();
+  chunk->Free(pointer);
 }
 
 void MappedMemoryManager::FreePendingToken(void* pointer, int32 token) {
-  for (size_t ii = 0; ii < chunks_.size(); ++ii) {
-    MemoryChunk* chunk = chunks_[ii];
-    if (chunk->IsInChunk(pointer)) {
-      chunk->FreePendingToken(pointer, token);
-      return;
-    }
+  MemoryChunk* chunk = GetChunkForPointer(pointer);
+  if (!chunk) {
+    NOTREACHED();
+    return;
   }
-  NOTREACHED();
+  chunk->FreePendingToken(pointer, token);
 }
 
 void MappedMemoryManager::FreeUnused() {
@@ -133,6 +130,7 @@ void MappedMemoryManager::FreeUnused() {
     if (!chunk->InUse()) {
       cmd_buf->DestroyTransferBuffer(chunk->shm_id());
       allocated_memory_ -= chunk->GetSize();
+      chunks_by_address_.erase(chunk->GetBase());
       iter = chunks_.erase(iter);
     } else {
       ++iter;
@@ -140,4 +138,13 @@ void MappedMemoryManager::FreeUnused() {
   }
 }
 
+MemoryChunk* MappedMemoryManager::GetChunkForPointer(void* pointer) {
+  // Find the last chunk starting at or before |pointer|.
+  MemoryChunkMap::iterator it = chunks_by_address_.upper_bound(pointer);
+  if (it == chunks_by_address_.begin())
+    return NULL;
+  --it;
+  return it->second->IsInChunk(pointer) ? it->second : NULL;
+}
+
 }  // namespace gpu
@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include <map>
+
 #include "base/bind.h"
 #include "base/macros.h"
 #include "base/memory/scoped_vector.h"
@@ -91,6 +93,11 @@ class GPU_EXPORT MemoryChunk {
     allocator_.FreeUnused();
   }
 
+  // Gets the address of the start of this chunk.
+  const void* GetBase() const {
+    return shm_->memory();
+  }
+
   // Returns true if pointer is in the range of this block.
   bool IsInChunk(void* pointer) const {
     return pointer >= shm_->memory() &&
@@ -187,12 +194,19 @@ class GPU_EXPORT MappedMemoryManager {
 
  private:
   typedef ScopedVector<MemoryChunk> MemoryChunkVector;
+  // Chunks keyed by their base address, to find the owner of a pointer in
+  // O(log n).
+  typedef std::map<const void*, MemoryChunk*> MemoryChunkMap;
+
+  // Returns the chunk containing |pointer|, or NULL if there is none.
+  MemoryChunk* GetChunkForPointer(void* pointer);
 
   // size a chunk is rounded up to.
   unsigned int chunk_size_multiple_;
   CommandBufferHelper* helper_;
   base::Closure poll_callback_;
   MemoryChunkVector chunks_;
+  MemoryChunkMap chunks_by_address_;
   size_t allocated_memory_;
   size_t max_free_bytes_;
 
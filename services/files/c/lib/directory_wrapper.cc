@@ -83,7 +83,10 @@ std::unique_ptr<FDImpl> DirectoryWrapper::Open(const char* path,
   if (!errno_setter.Set(ErrorToErrno(error)))
     return nullptr;
   // C++11, why don't you have make_unique?
-  return std::unique_ptr<FDImpl>(new FileFDImpl(errno_impl_, file.Pass()));
+  return std::unique_ptr<FDImpl>(
+      new FileFDImpl(errno_impl_, file.Pass(),
+                     (oflag & MOJIO_O_ACCMODE) == MOJIO_O_RDONLY,
+                     file_options_));
 }
 
 bool DirectoryWrapper::Chdir(const char* path) {
@@ -9,12 +9,12 @@
 
 #include "mojo/public/c/system/macros.h"
 #include "mojo/services/files/public/interfaces/directory.mojom.h"
+#include "services/files/c/lib/file_fd_impl.h"
 #include "services/files/c/mojio_sys_types.h"
 
 namespace mojio {
 
 class ErrnoImpl;
-class FDImpl;
 
 // TODO(vtl): Probably this should be made into an implementation of |FDImpl|
 // (with additional methods) and renamed |DirectoryFDImpl|, to support opening
@@ -29,12 +29,18 @@ class DirectoryWrapper {
 
   // TODO(vtl): MkDir(), etc.
 
+  // Buffering options for files subsequently opened using |Open()|.
+  void set_file_options(const FileFDImpl::Options& file_options) {
+    file_options_ = file_options;
+  }
+
   // Mostly for tests:
   mojo::files::DirectoryPtr& directory() { return directory_; }
 
  private:
   ErrnoImpl* const errno_impl_;
   mojo::files::DirectoryPtr directory_;
+  FileFDImpl::Options file_options_;
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(DirectoryWrapper);
 };
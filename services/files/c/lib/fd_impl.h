@@ -31,6 +31,7 @@ class FDImpl {
   // <unistd.h>:
   virtual bool Close() = 0;  // May be called only at most once.
   virtual std::unique_ptr<FDImpl> Dup() = 0;
+  virtual bool Fsync() = 0;
   virtual bool Ftruncate(mojio_off_t length) = 0;
   virtual mojio_off_t Lseek(mojio_off_t offset, int whence) = 0;
   virtual mojio_ssize_t Read(void* buf, size_t count) = 0;
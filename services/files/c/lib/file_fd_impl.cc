@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <string.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "mojo/public/cpp/bindings/interface_request.h"
@@ -19,22 +20,55 @@
 
 namespace mojio {
 
+FileFDImpl::Options::Options()
+    : read_ahead_size(0),
+      write_behind_size(0),
+      map_read_only(false) {
+}
+
 FileFDImpl::FileFDImpl(ErrnoImpl* errno_impl, mojo::files::FilePtr file)
-    : FDImpl(errno_impl), file_(file.Pass()) {
+    : FileFDImpl(errno_impl, file.Pass(), false, Options()) {
+}
+
+FileFDImpl::FileFDImpl(ErrnoImpl* errno_impl,
+                       mojo::files::FilePtr file,
+                       bool read_only,
+                       const Options& options)
+    : FDImpl(errno_impl),
+      file_(file.Pass()),
+      read_only_(read_only),
+      options_(options),
+      read_buffer_offset_(0),
+      mapped_(false),
+      map_disabled_(false),
+      mapped_data_(nullptr),
+      mapped_size_(0),
+      mapped_position_(0) {
   MOJO_DCHECK(file_);
 }
 
 FileFDImpl::~FileFDImpl() {
+  // Try not to lose buffered writes if we weren't closed. (There's no one to
+  // report an error to.)
+  FlushWriteBuffer();
+  if (mapped_)
+    mojo::UnmapBuffer(const_cast<uint8_t*>(mapped_data_));
 }
 
 bool FileFDImpl::Close() {
   ErrnoImpl::Setter errno_setter(errno_impl());
   MOJO_DCHECK(file_);
 
+  int sync_error = Sync();
+  // Even if that failed, we're not going to try again.
+  write_buffer_.clear();
+
   mojo::files::Error error = mojo::files::ERROR_INTERNAL;
   file_->Close(Capture(&error));
   if (!file_.WaitForIncomingMethodCall())
     return errno_setter.Set(ESTALE);
+  if (!errno_setter.Set(sync_error))
+    return false;
   return errno_setter.Set(ErrorToErrno(error));
 }
 
@@ -42,6 +76,10 @@ std::unique_ptr<FDImpl> FileFDImpl::Dup() {
   ErrnoImpl::Setter errno_setter(errno_impl());
   MOJO_DCHECK(file_);
 
+  // The new FD shares the file position, so it had better be right.
+  if (!errno_setter.Set(Sync()))
+    return nullptr;
+
   mojo::files::FilePtr new_file;
   mojo::files::Error error = mojo::files::ERROR_INTERNAL;
   file_->Dup(mojo::GetProxy(&new_file), Capture(&error));
@@ -52,7 +90,17 @@ std::unique_ptr<FDImpl> FileFDImpl::Dup() {
   if (!errno_setter.Set(ErrorToErrno(error)))
     return nullptr;
   // C++11, why don't you have make_unique?
-  return std::unique_ptr<FDImpl>(new FileFDImpl(errno_impl(), new_file.Pass()));
+  return std::unique_ptr<FDImpl>(
+      new FileFDImpl(errno_impl(), new_file.Pass(), read_only_, options_));
+}
+
+bool FileFDImpl::Fsync() {
+  ErrnoImpl::Setter errno_setter(errno_impl());
+  MOJO_DCHECK(file_);
+
+  // TODO(vtl): The files service has no way of syncing to disk, so this only
+  // pushes out our own buffered data.
+  return errno_setter.Set(FlushWriteBuffer());
 }
 
 bool FileFDImpl::Ftruncate(mojio_off_t length) {
@@ -62,6 +110,9 @@ bool FileFDImpl::Ftruncate(mojio_off_t length) {
   if (length < 0)
     return errno_setter.Set(EINVAL);
 
+  if (!errno_setter.Set(Sync()))
+    return false;
+
   mojo::files::Error error = mojo::files::ERROR_INTERNAL;
   file_->Truncate(static_cast<int64_t>(length), Capture(&error));
   if (!file_.WaitForIncomingMethodCall())
@@ -89,6 +140,47 @@ mojio_off_t FileFDImpl::Lseek(mojio_off_t offset, int whence) {
       return -1;
   }
 
+  if (mapped_) {
+    // We have the whole file, so we don't need to ask the service.
+    int64_t position;
+    switch (mojo_whence) {
+      case mojo::files::WHENCE_FROM_START:
+        position = 0;
+        break;
+      case mojo::files::WHENCE_FROM_CURRENT:
+        position = mapped_position_;
+        break;
+      default:
+        position = mapped_size_;
+        break;
+    }
+    if (offset > 0 && position > std::numeric_limits<mojio_off_t>::max() -
+                                     static_cast<int64_t>(offset)) {
+      errno_setter.Set(EOVERFLOW);
+      return -1;
+    }
+    position += static_cast<int64_t>(offset);
+    if (position < 0) {
+      errno_setter.Set(EINVAL);
+      return -1;
+    }
+    mapped_position_ = position;
+    return static_cast<mojio_off_t>(position);
+  }
+
+  if (!errno_setter.Set(FlushWriteBuffer()))
+    return -1;
+  // Rather than seeking back over the unread read-ahead data and then seeking
+  // again, fold the two together.
+  if (mojo_whence == mojo::files::WHENCE_FROM_CURRENT) {
+    offset -= static_cast<mojio_off_t>(read_buffer_.size() -
+                                       read_buffer_offset_);
+    read_buffer_.clear();
+    read_buffer_offset_ = 0;
+  } else if (!errno_setter.Set(DiscardReadBuffer())) {
+    return -1;
+  }
+
   mojo::files::Error error = mojo::files::ERROR_INTERNAL;
   int64_t position = -1;
   file_->Seek(static_cast<int64_t>(offset), mojo_whence,
@@ -137,27 +229,67 @@ mojio_ssize_t FileFDImpl::Read(void* buf, size_t count) {
     return -1;
   }
 
-  mojo::files::Error error = mojo::files::ERROR_INTERNAL;
-  mojo::Array<uint8_t> bytes_read;
-  file_->Read(static_cast<uint32_t>(count), 0, mojo::files::WHENCE_FROM_CURRENT,
-              Capture(&error, &bytes_read));
-  if (!file_.WaitForIncomingMethodCall()) {
-    errno_setter.Set(ESTALE);
+  if (!errno_setter.Set(MaybeMap()))
     return -1;
+  if (mapped_) {
+    if (mapped_position_ >= mapped_size_)
+      return 0;
+    size_t num_bytes = static_cast<size_t>(
+        std::min(static_cast<int64_t>(count), mapped_size_ - mapped_position_));
+    memcpy(buf, mapped_data_ + mapped_position_, num_bytes);
+    mapped_position_ += static_cast<int64_t>(num_bytes);
+    return static_cast<mojio_ssize_t>(num_bytes);
   }
-  if (!errno_setter.Set(ErrorToErrno(error)))
-    return -1;
-  if (bytes_read.size() > count) {
-    // Service misbehaved.
-    MOJO_LOG(ERROR) << "Read() read more than requested";
-    // TODO(vtl): Is there a better error code for this?
-    errno_setter.Set(EIO);
+
+  if (!errno_setter.Set(FlushWriteBuffer()))
     return -1;
+
+  uint8_t* bytes = static_cast<uint8_t*>(buf);
+  size_t num_bytes_copied = 0;
+  bool at_end = false;
+  while (num_bytes_copied < count) {
+    if (read_buffer_offset_ < read_buffer_.size()) {
+      size_t num_bytes = std::min(count - num_bytes_copied,
+                                  read_buffer_.size() - read_buffer_offset_);
+      memcpy(bytes + num_bytes_copied, &read_buffer_[read_buffer_offset_],
+             num_bytes);
+      read_buffer_offset_ += num_bytes;
+      num_bytes_copied += num_bytes;
+      continue;
+    }
+    if (at_end)
+      break;
+
+    read_buffer_.clear();
+    read_buffer_offset_ = 0;
+    size_t num_bytes_remaining = count - num_bytes_copied;
+    size_t num_bytes_read = 0;
+    int error;
+    if (num_bytes_remaining >= options_.read_ahead_size) {
+      // Large reads go directly into the caller's buffer.
+      error = ReadFromFile(bytes + num_bytes_copied, num_bytes_remaining,
+                           &num_bytes_read);
+      if (!error)
+        num_bytes_copied += num_bytes_read;
+      at_end = true;
+    } else {
+      read_buffer_.resize(options_.read_ahead_size);
+      error = ReadFromFile(&read_buffer_[0], read_buffer_.size(),
+                           &num_bytes_read);
+      read_buffer_.resize(error ? 0 : num_bytes_read);
+      // A short read means we're at the end of the file (for now).
+      at_end = (num_bytes_read < options_.read_ahead_size);
+    }
+    if (error) {
+      // Report the error only if we have nothing else to report.
+      if (num_bytes_copied > 0)
+        break;
+      errno_setter.Set(error);
+      return -1;
+    }
   }
 
-  if (bytes_read.size() > 0)
-    memcpy(buf, &bytes_read[0], bytes_read.size());
-  return static_cast<mojio_ssize_t>(bytes_read.size());
+  return static_cast<mojio_ssize_t>(num_bytes_copied);
 }
 
 mojio_ssize_t FileFDImpl::Write(const void* buf, size_t count) {
@@ -179,30 +311,27 @@ mojio_ssize_t FileFDImpl::Write(const void* buf, size_t count) {
     return -1;
   }
 
-  // TODO(vtl): Is there a more natural (or efficient) way to do this?
-  mojo::Array<uint8_t> bytes_to_write(count);
-  if (count > 0)
-    memcpy(&bytes_to_write[0], buf, count);
-
-  mojo::files::Error error = mojo::files::ERROR_INTERNAL;
-  uint32_t num_bytes_written = 0;
-  file_->Write(bytes_to_write.Pass(), 0, mojo::files::WHENCE_FROM_CURRENT,
-               Capture(&error, &num_bytes_written));
-  if (!file_.WaitForIncomingMethodCall()) {
-    errno_setter.Set(ESTALE);
+  if (!errno_setter.Set(DiscardReadBuffer()))
     return -1;
-  }
-  if (!errno_setter.Set(ErrorToErrno(error)))
+  if (!errno_setter.Set(Unmap()))
     return -1;
 
-  if (num_bytes_written > count) {
-    // Service misbehaved.
-    MOJO_LOG(ERROR) << "Write() wrote than requested";
-    // TODO(vtl): Is there a better error code for this?
-    errno_setter.Set(EIO);
-    return -1;
+  if (count < options_.write_behind_size) {
+    if (write_buffer_.size() + count > options_.write_behind_size) {
+      if (!errno_setter.Set(FlushWriteBuffer()))
+        return -1;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(buf);
+    write_buffer_.insert(write_buffer_.end(), bytes, bytes + count);
+    return static_cast<mojio_ssize_t>(count);
   }
 
+  // Large writes go directly to the file (after anything buffered).
+  if (!errno_setter.Set(FlushWriteBuffer()))
+    return -1;
+  size_t num_bytes_written = 0;
+  if (!errno_setter.Set(WriteToFile(buf, count, &num_bytes_written)))
+    return -1;
   return static_cast<mojio_ssize_t>(num_bytes_written);
 }
 
@@ -215,6 +344,10 @@ bool FileFDImpl::Fstat(struct mojio_stat* buf) {
     return false;
   }
 
+  // Make sure the size includes anything we've buffered.
+  if (!errno_setter.Set(FlushWriteBuffer()))
+    return false;
+
   mojo::files::FileInformationPtr file_info;
   mojo::files::Error error = mojo::files::ERROR_INTERNAL;
   file_->Stat(Capture(&error, &file_info));
@@ -280,4 +413,176 @@ bool FileFDImpl::Fstat(struct mojio_stat* buf) {
   return true;
 }
 
+int FileFDImpl::FlushWriteBuffer() {
+  if (write_buffer_.empty())
+    return 0;
+
+  int error = WriteAll(&write_buffer_[0], write_buffer_.size());
+  // Drop the data even on failure (there's no good way to recover).
+  write_buffer_.clear();
+  return error;
+}
+
+int FileFDImpl::DiscardReadBuffer() {
+  size_t num_bytes_unread = read_buffer_.size() - read_buffer_offset_;
+  read_buffer_.clear();
+  read_buffer_offset_ = 0;
+  if (!num_bytes_unread)
+    return 0;
+
+  mojo::files::Error error = mojo::files::ERROR_INTERNAL;
+  int64_t position = -1;
+  file_->Seek(-static_cast<int64_t>(num_bytes_unread),
+              mojo::files::WHENCE_FROM_CURRENT, Capture(&error, &position));
+  if (!file_.WaitForIncomingMethodCall())
+    return ESTALE;
+  return ErrorToErrno(error);
+}
+
+int FileFDImpl::Unmap() {
+  if (!mapped_)
+    return 0;
+
+  mojo::UnmapBuffer(const_cast<uint8_t*>(mapped_data_));
+  mapped_buffer_.reset();
+  mapped_ = false;
+  mapped_data_ = nullptr;
+
+  mojo::files::Error error = mojo::files::ERROR_INTERNAL;
+  int64_t position = -1;
+  file_->Seek(mapped_position_, mojo::files::WHENCE_FROM_START,
+              Capture(&error, &position));
+  if (!file_.WaitForIncomingMethodCall())
+    return ESTALE;
+  return ErrorToErrno(error);
+}
+
+int FileFDImpl::Sync() {
+  int flush_error = FlushWriteBuffer();
+  int discard_error = DiscardReadBuffer();
+  int unmap_error = Unmap();
+  if (flush_error)
+    return flush_error;
+  return discard_error ? discard_error : unmap_error;
+}
+
+int FileFDImpl::MaybeMap() {
+  if (mapped_ || map_disabled_ || !read_only_ || !options_.map_read_only)
+    return 0;
+  // Whatever happens, only try once.
+  map_disabled_ = true;
+
+  // Read-only, so there can't be any buffered writes.
+  MOJO_DCHECK(write_buffer_.empty());
+  if (read_buffer_offset_ < read_buffer_.size())
+    return 0;  // Don't bother if we've already started reading ahead.
+
+  mojo::files::Error error = mojo::files::ERROR_INTERNAL;
+  int64_t position = -1;
+  file_->Tell(Capture(&error, &position));
+  if (!file_.WaitForIncomingMethodCall())
+    return ESTALE;
+  if (error != mojo::files::ERROR_OK || position < 0)
+    return 0;
+
+  error = mojo::files::ERROR_INTERNAL;
+  mojo::files::FileInformationPtr file_info;
+  file_->Stat(Capture(&error, &file_info));
+  if (!file_.WaitForIncomingMethodCall())
+    return ESTALE;
+  if (error != mojo::files::ERROR_OK || !file_info || file_info->size <= 0)
+    return 0;
+
+  error = mojo::files::ERROR_INTERNAL;
+  mojo::ScopedSharedBufferHandle buffer;
+  file_->AsBuffer(Capture(&error, &buffer));
+  if (!file_.WaitForIncomingMethodCall())
+    return ESTALE;
+  if (error != mojo::files::ERROR_OK || !buffer.is_valid())
+    return 0;
+
+  // If the file changed size in the meantime, this may fail (in which case we
+  // just won't map).
+  void* data = nullptr;
+  if (mojo::MapBuffer(buffer.get(), 0, static_cast<uint64_t>(file_info->size),
+                      &data, MOJO_MAP_BUFFER_FLAG_NONE) != MOJO_RESULT_OK)
+    return 0;
+
+  read_buffer_.clear();
+  read_buffer_offset_ = 0;
+  mapped_ = true;
+  mapped_buffer_ = buffer.Pass();
+  mapped_data_ = static_cast<const uint8_t*>(data);
+  mapped_size_ = file_info->size;
+  mapped_position_ = position;
+  return 0;
+}
+
+int FileFDImpl::ReadFromFile(void* buf,
+                             size_t count,
+                             size_t* num_bytes_read) {
+  mojo::files::Error error = mojo::files::ERROR_INTERNAL;
+  mojo::Array<uint8_t> bytes_read;
+  file_->Read(static_cast<uint32_t>(count), 0, mojo::files::WHENCE_FROM_CURRENT,
+              Capture(&error, &bytes_read));
+  if (!file_.WaitForIncomingMethodCall())
+    return ESTALE;
+  if (int errno_value = ErrorToErrno(error))
+    return errno_value;
+  if (bytes_read.size() > count) {
+    // Service misbehaved.
+    MOJO_LOG(ERROR) << "Read() read more than requested";
+    // TODO(vtl): Is there a better error code for this?
+    return EIO;
+  }
+
+  if (bytes_read.size() > 0)
+    memcpy(buf, &bytes_read[0], bytes_read.size());
+  *num_bytes_read = bytes_read.size();
+  return 0;
+}
+
+int FileFDImpl::WriteToFile(const void* buf,
+                            size_t count,
+                            size_t* num_bytes_written) {
+  // TODO(vtl): Is there a more natural (or efficient) way to do this?
+  mojo::Array<uint8_t> bytes_to_write(count);
+  if (count > 0)
+    memcpy(&bytes_to_write[0], buf, count);
+
+  mojo::files::Error error = mojo::files::ERROR_INTERNAL;
+  uint32_t num_bytes = 0;
+  file_->Write(bytes_to_write.Pass(), 0, mojo::files::WHENCE_FROM_CURRENT,
+               Capture(&error, &num_bytes));
+  if (!file_.WaitForIncomingMethodCall())
+    return ESTALE;
+  if (int errno_value = ErrorToErrno(error))
+    return errno_value;
+
+  if (num_bytes > count) {
+    // Service misbehaved.
+    MOJO_LOG(ERROR) << "Write() wrote than requested";
+    // TODO(vtl): Is there a better error code for this?
+    return EIO;
+  }
+
+  *num_bytes_written = num_bytes;
+  return 0;
+}
+
+int FileFDImpl::WriteAll(const void* buf, size_t count) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(buf);
+  size_t num_bytes_written = 0;
+  while (num_bytes_written < count) {
+    size_t num_bytes = 0;
+    if (int error = WriteToFile(bytes + num_bytes_written,
+                                count - num_bytes_written, &num_bytes))
+      return error;
+    if (!num_bytes)
+      return EIO;  // No progress; don't loop forever.
+    num_bytes_written += num_bytes;
+  }
+  return 0;
+}
+
 }  // namespace mojio
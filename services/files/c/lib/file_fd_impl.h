@@ -5,21 +5,65 @@
 #ifndef SERVICES_FILES_C_LIB_FILE_FD_IMPL_H_
 #define SERVICES_FILES_C_LIB_FILE_FD_IMPL_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
 #include "mojo/public/c/system/macros.h"
+#include "mojo/public/cpp/system/buffer.h"
 #include "mojo/services/files/public/interfaces/file.mojom.h"
 #include "services/files/c/lib/fd_impl.h"
 #include "services/files/c/mojio_sys_types.h"
 
 namespace mojio {
 
+// |FDImpl| for (regular) files. To avoid a round trip to the files service for
+// every small read/write, it may buffer:
+//   - Reads: up to |Options::read_ahead_size| bytes are read at a time, and
+//     later reads are satisfied from that buffer.
+//   - Writes: writes smaller than |Options::write_behind_size| are collected
+//     and sent together. Note that buffered data is only visible to other
+//     handles on the same file once flushed (by |Fsync()|, |Close()|,
+//     |Lseek()|, |Dup()|, |Ftruncate()|, or |Fstat()|, by a read, or once the
+//     buffer fills up), and that errors writing buffered data are reported by
+//     the call that flushes it.
+//   - Read-only files (if |Options::map_read_only| is set): the whole file is
+//     fetched once as a shared buffer (see |File::AsBuffer()|), and
+//     reads/seeks are done locally. This is a snapshot of the file; changes
+//     made to the file via other handles won't be seen.
+// The file position seen by other handles sharing it (via |Dup()|) is only
+// brought up to date when the buffers are flushed. So all buffering is off by
+// default, and should only be turned on for files whose position isn't shared.
 class FileFDImpl : public FDImpl {
  public:
+  struct Options {
+    // Default options: no read-ahead, write-behind, or mapping.
+    Options();
+
+    // Read-ahead buffer size; 0 disables read-ahead. (This is a trade-off
+    // between the number of round trips and the amount of data read
+    // unnecessarily; 16KB is a reasonable size.)
+    size_t read_ahead_size;
+    // Write-behind buffer size; 0 disables write-behind.
+    size_t write_behind_size;
+    // If set (and the file is read-only), use |File::AsBuffer()|.
+    bool map_read_only;
+  };
+
+  // Uses the default |Options|.
   FileFDImpl(ErrnoImpl* errno_impl, mojo::files::FilePtr file);
+  // |read_only| should be set if |file| was opened for reading only.
+  FileFDImpl(ErrnoImpl* errno_impl,
+             mojo::files::FilePtr file,
+             bool read_only,
+             const Options& options);
   ~FileFDImpl() override;
 
   // |FDImpl| implementation:
   bool Close() override;
   std::unique_ptr<FDImpl> Dup() override;
+  bool Fsync() override;
   bool Ftruncate(mojio_off_t length) override;
   mojio_off_t Lseek(mojio_off_t offset, int whence) override;
   mojio_ssize_t Read(void* buf, size_t count) override;
@@ -27,7 +71,53 @@ class FileFDImpl : public FDImpl {
   bool Fstat(struct mojio_stat* buf) override;
 
  private:
+  // Helpers: these return 0 on success or an errno value on failure (and don't
+  // touch "errno" themselves).
+
+  // Writes out the write-behind buffer (if any).
+  int FlushWriteBuffer();
+  // Discards any read-ahead data, moving the file position back to where the
+  // caller thinks it is.
+  int DiscardReadBuffer();
+  // Unmaps the file (if mapped), moving the file position to where the caller
+  // thinks it is.
+  int Unmap();
+  // All of the above: brings the file (and its position) up to date.
+  int Sync();
+  // Maps the file, if we're supposed to (and haven't already). Returns 0 (and
+  // leaves the file unmapped) if mapping isn't possible.
+  int MaybeMap();
+
+  // Do (unbuffered) |File::Read()|/|File::Write()|s from/at the current
+  // position. |WriteAll()| retries until everything is written.
+  int ReadFromFile(void* buf, size_t count, size_t* num_bytes_read);
+  int WriteToFile(const void* buf, size_t count, size_t* num_bytes_written);
+  int WriteAll(const void* buf, size_t count);
+
   mojo::files::FilePtr file_;
+  const bool read_only_;
+  const Options options_;
+
+  // Read-ahead data; the file position is at the end of |read_buffer_|, while
+  // the caller's position is at |read_buffer_offset_|.
+  std::vector<uint8_t> read_buffer_;
+  size_t read_buffer_offset_;
+
+  // Write-behind data; the caller's position is |write_buffer_.size()| past the
+  // file position. (At most one of |read_buffer_| and |write_buffer_| is
+  // nonempty.)
+  std::vector<uint8_t> write_buffer_;
+
+  // If mapped, the caller's position is |mapped_position_|. (The file position
+  // is stale.)
+  bool mapped_;
+  // Set once we've tried to map the file (and either failed or later unmapped
+  // it), so that we don't (re)fetch the whole file again.
+  bool map_disabled_;
+  mojo::ScopedSharedBufferHandle mapped_buffer_;
+  const uint8_t* mapped_data_;
+  int64_t mapped_size_;
+  int64_t mapped_position_;
 
   MOJO_DISALLOW_COPY_AND_ASSIGN(FileFDImpl);
 };
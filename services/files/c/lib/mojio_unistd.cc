@@ -43,6 +43,14 @@ int DupImpl(int fd) {
   return singletons::GetFDTable()->Add(std::move(new_fd_impl));
 }
 
+int FsyncImpl(int fd) {
+  FDImpl* fd_impl = singletons::GetFDTable()->Get(fd);
+  if (!fd_impl)
+    return -1;
+
+  return fd_impl->Fsync() ? 0 : -1;
+}
+
 int FtruncateImpl(int fd, mojio_off_t length) {
   FDImpl* fd_impl = singletons::GetFDTable()->Get(fd);
   if (!fd_impl)
@@ -92,6 +100,10 @@ int mojio_dup(int fd) {
   return mojio::DupImpl(fd);
 }
 
+int mojio_fsync(int fd) {
+  return mojio::FsyncImpl(fd);
+}
+
 int mojio_ftruncate(int fd, mojio_off_t length) {
   return mojio::FtruncateImpl(fd, length);
 }
@@ -76,7 +76,7 @@ extern "C" {
 //   int fexecve(int, char* const [], char* const []);
 //   pid_t fork(void);
 //   long fpathconf(int, int);
-//   [FSC] int fsync(int);
+//   [DONE] int fsync(int);
 //   [DONE] int ftruncate(int, off_t);
 //   char* getcwd(char*, size_t);
 //   gid_t getegid(void);
@@ -137,6 +137,7 @@ extern "C" {
 int mojio_chdir(const char* path);
 int mojio_close(int fd);
 int mojio_dup(int fd);
+int mojio_fsync(int fd);
 int mojio_ftruncate(int fd, mojio_off_t length);
 mojio_off_t mojio_lseek(int fd, mojio_off_t offset, int whence);
 mojio_ssize_t mojio_read(int fd, void* buf, size_t count);
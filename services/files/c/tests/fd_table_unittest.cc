@@ -23,6 +23,7 @@ class TestFDImpl : public FDImpl {
   // |FDImpl| implementation:
   bool Close() override { return false; }
   std::unique_ptr<FDImpl> Dup() override { return nullptr; }
+  bool Fsync() override { return false; }
   bool Ftruncate(mojio_off_t) override { return false; }
   mojio_off_t Lseek(mojio_off_t, int) override { return -1; }
   mojio_ssize_t Read(void*, size_t) override { return -1; }
@@ -207,6 +207,170 @@ TEST_F(FileFDImplTest, Write) {
   EXPECT_EQ(EINVAL, errno_impl.Get());
 }
 
+TEST_F(FileFDImplTest, ReadAhead) {
+  test::CreateTestFileAt(&directory(), "my_file", 1000);
+
+  test::MockErrnoImpl errno_impl(kLastErrorSentinel);
+  FileFDImpl::Options options;
+  options.read_ahead_size = 100;
+  FileFDImpl ffdi(&errno_impl, test::OpenFileAt(&directory(), "my_file",
+                                                mojo::files::kOpenFlagRead),
+                  true, options);
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+
+  // Lots of small reads (some of which straddle the read-ahead buffer).
+  unsigned char buffer[1000] = {};
+  for (size_t i = 0; i < 30; i++) {
+    errno_impl.Reset(kLastErrorSentinel);
+    EXPECT_EQ(7, ffdi.Read(buffer, 7));
+    EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+    for (size_t j = 0; j < 7; j++)
+      EXPECT_EQ(static_cast<unsigned char>(i * 7 + j), buffer[j]) << i << j;
+  }
+
+  // The position should be where we think it is, not where the service is.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(210, ffdi.Lseek(0, MOJIO_SEEK_CUR));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(205, ffdi.Lseek(-5, MOJIO_SEEK_CUR));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+
+  // A large read (bigger than the read-ahead buffer) that hits the end.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(795, ffdi.Read(buffer, sizeof(buffer)));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  for (size_t i = 0; i < 795; i++)
+    EXPECT_EQ(static_cast<unsigned char>(205 + i), buffer[i]) << i;
+
+  // A duped FD should see the same position.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(10, ffdi.Lseek(10, MOJIO_SEEK_SET));
+  EXPECT_EQ(3, ffdi.Read(buffer, 3));
+  std::unique_ptr<FDImpl> duped_ffdi = ffdi.Dup();
+  EXPECT_TRUE(duped_ffdi);
+  EXPECT_EQ(13, duped_ffdi->Lseek(0, MOJIO_SEEK_CUR));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+}
+
+TEST_F(FileFDImplTest, DefaultOptionsDontBuffer) {
+  test::CreateTestFileAt(&directory(), "my_file", 1000);
+
+  test::MockErrnoImpl errno_impl(kLastErrorSentinel);
+  FileFDImpl ffdi(&errno_impl, test::OpenFileAt(&directory(), "my_file",
+                                                mojo::files::kOpenFlagRead));
+  std::unique_ptr<FDImpl> duped_ffdi = ffdi.Dup();
+  EXPECT_TRUE(duped_ffdi);
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+
+  // A read on one FD should move the position the other one sees by exactly
+  // the number of bytes read.
+  errno_impl.Reset(kLastErrorSentinel);
+  unsigned char buffer[10] = {};
+  EXPECT_EQ(3, ffdi.Read(buffer, 3));
+  EXPECT_EQ(3, duped_ffdi->Lseek(0, MOJIO_SEEK_CUR));
+  EXPECT_EQ(2, duped_ffdi->Read(buffer, 2));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  for (size_t i = 0; i < 2; i++)
+    EXPECT_EQ(static_cast<unsigned char>(3 + i), buffer[i]) << i;
+  EXPECT_EQ(5, ffdi.Lseek(0, MOJIO_SEEK_CUR));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+}
+
+TEST_F(FileFDImplTest, WriteBehind) {
+  test::MockErrnoImpl errno_impl(kLastErrorSentinel);
+  FileFDImpl::Options options;
+  options.write_behind_size = 100;
+  FileFDImpl ffdi(&errno_impl,
+                  test::OpenFileAt(&directory(), "my_file",
+                                   mojo::files::kOpenFlagWrite |
+                                       mojo::files::kOpenFlagCreate |
+                                       mojo::files::kOpenFlagExclusive),
+                  false, options);
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+
+  errno_impl.Reset(kLastErrorSentinel);
+  const char kHello[] = {'h', 'e', 'l', 'l', 'o', ' '};
+  EXPECT_EQ(static_cast<mojio_off_t>(sizeof(kHello)),
+            ffdi.Write(kHello, sizeof(kHello)));
+  const char kMojio[] = {'m', 'o', 'j', 'i', 'o'};
+  EXPECT_EQ(static_cast<mojio_off_t>(sizeof(kMojio)),
+            ffdi.Write(kMojio, sizeof(kMojio)));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+
+  // Nothing should have been written yet.
+  EXPECT_EQ(std::string(), test::GetFileContents(&directory(), "my_file"));
+
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_TRUE(ffdi.Fsync());
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  EXPECT_EQ(std::string("hello mojio"),
+            test::GetFileContents(&directory(), "my_file"));
+
+  // Seeking should also flush (and account for buffered data).
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(static_cast<mojio_off_t>(sizeof(kHello)),
+            ffdi.Write(kHello, sizeof(kHello)));
+  EXPECT_EQ(17, ffdi.Lseek(0, MOJIO_SEEK_CUR));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  EXPECT_EQ(std::string("hello mojiohello "),
+            test::GetFileContents(&directory(), "my_file"));
+
+  // As should closing.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(static_cast<mojio_off_t>(sizeof(kMojio)),
+            ffdi.Write(kMojio, sizeof(kMojio)));
+  EXPECT_TRUE(ffdi.Close());
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  EXPECT_EQ(std::string("hello mojiohello mojio"),
+            test::GetFileContents(&directory(), "my_file"));
+}
+
+TEST_F(FileFDImplTest, MappedRead) {
+  test::CreateTestFileAt(&directory(), "my_file", 1000);
+
+  test::MockErrnoImpl errno_impl(kLastErrorSentinel);
+  FileFDImpl::Options options;
+  options.map_read_only = true;
+  FileFDImpl ffdi(&errno_impl, test::OpenFileAt(&directory(), "my_file",
+                                                mojo::files::kOpenFlagRead),
+                  true, options);
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(100, ffdi.Lseek(100, MOJIO_SEEK_SET));
+  unsigned char buffer[1000] = {};
+  EXPECT_EQ(23, ffdi.Read(buffer, 23));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  for (size_t i = 0; i < 23; i++)
+    EXPECT_EQ(static_cast<unsigned char>(100 + i), buffer[i]) << i;
+
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(990, ffdi.Lseek(-10, MOJIO_SEEK_END));
+  EXPECT_EQ(10, ffdi.Read(buffer, sizeof(buffer)));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+  for (size_t i = 0; i < 10; i++)
+    EXPECT_EQ(static_cast<unsigned char>(990 + i), buffer[i]) << i;
+
+  // At the end.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(0, ffdi.Read(buffer, sizeof(buffer)));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+
+  // Invalid seek.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(-1, ffdi.Lseek(-1, MOJIO_SEEK_SET));
+  EXPECT_EQ(EINVAL, errno_impl.Get());
+
+  // Dup()ing should bring the real file position up to date.
+  errno_impl.Reset(kLastErrorSentinel);
+  EXPECT_EQ(5, ffdi.Lseek(5, MOJIO_SEEK_SET));
+  std::unique_ptr<FDImpl> duped_ffdi = ffdi.Dup();
+  EXPECT_TRUE(duped_ffdi);
+  EXPECT_EQ(5, duped_ffdi->Lseek(0, MOJIO_SEEK_CUR));
+  EXPECT_EQ(kLastErrorSentinel, errno_impl.Get());  // No error.
+}
+
 TEST_F(FileFDImplTest, Fstat) {
   test::CreateTestFileAt(&directory(), "my_file_0", 0);
   test::CreateTestFileAt(&directory(), "my_file_1", 512);
@@ -12,10 +12,15 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "base/bind.h"
 #include "base/files/scoped_temp_dir.h"
+#include "base/location.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/posix/eintr_wrapper.h"
+#include "base/sequenced_task_runner.h"
+#include "base/task_runner_util.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "build/build_config.h"
 #include "services/files/file_impl.h"
 #include "services/files/shared_impl.h"
@@ -92,40 +97,39 @@ Error ValidateDeleteFlags(uint32_t delete_flags) {
   return ERROR_OK;
 }
 
-}  // namespace
+// Blocking implementations, run on the directory's I/O task runner (see
+// file_impl.cc).
 
-DirectoryImpl::DirectoryImpl(InterfaceRequest<Directory> request,
-                             base::ScopedFD dir_fd,
-                             scoped_ptr<base::ScopedTempDir> temp_dir)
-    : binding_(this, request.Pass()),
-      dir_fd_(dir_fd.Pass()),
-      temp_dir_(temp_dir.Pass()) {
-  DCHECK(dir_fd_.is_valid());
-}
+// Used to close the FD and delete the temporary directory (if any) on the I/O
+// task runner when the |DirectoryImpl| is destroyed.
+void CloseDirectoryOnIOThread(base::ScopedFD dir_fd,
+                              scoped_ptr<base::ScopedTempDir> temp_dir) {}
 
-DirectoryImpl::~DirectoryImpl() {
-}
+struct ReadResult {
+  ReadResult() : error(ERROR_INTERNAL) {}
 
-void DirectoryImpl::Read(const ReadCallback& callback) {
-  static const size_t kMaxReadCount = 1000;
+  Error error;
+  Array<DirectoryEntryPtr> directory_contents;
+};
 
-  DCHECK(dir_fd_.is_valid());
+void ReadOnIOThread(int dir_fd, ReadResult* result) {
+  static const size_t kMaxReadCount = 1000;
 
   // |fdopendir()| takes ownership of the FD (giving it to the |DIR| --
   // |closedir()| will close the FD)), so we need to |dup()| ours.
-  base::ScopedFD fd(dup(dir_fd_.get()));
+  base::ScopedFD fd(dup(dir_fd));
   if (!fd.is_valid()) {
-    callback.Run(ErrnoToError(errno), Array<DirectoryEntryPtr>());
+    result->error = ErrnoToError(errno);
     return;
   }
 
   ScopedDIR dir(fdopendir(fd.release()));
   if (!dir) {
-    callback.Run(ErrnoToError(errno), Array<DirectoryEntryPtr>());
+    result->error = ErrnoToError(errno);
     return;
   }
 
-  Array<DirectoryEntryPtr> result(0);
+  Array<DirectoryEntryPtr> contents(0);
 
 // Warning: This is not portable (per POSIX.1 -- |buffer| may not be large
 // enough), but it's fine for Linux.
@@ -137,7 +141,7 @@ void DirectoryImpl::Read(const ReadCallback& callback) {
     struct dirent* entry = nullptr;
     if (int error = readdir_r(dir.get(), &buffer, &entry)) {
       // |error| is effectively an errno (for |readdir_r()|), AFAICT.
-      callback.Run(ErrnoToError(error), Array<DirectoryEntryPtr>());
+      result->error = ErrnoToError(error);
       return;
     }
 
@@ -147,7 +151,8 @@ void DirectoryImpl::Read(const ReadCallback& callback) {
     n++;
     if (n > kMaxReadCount) {
       LOG(WARNING) << "Directory contents truncated";
-      callback.Run(ERROR_OUT_OF_RANGE, result.Pass());
+      result->error = ERROR_OUT_OF_RANGE;
+      result->directory_contents = contents.Pass();
       return;
     }
 
@@ -164,25 +169,163 @@ void DirectoryImpl::Read(const ReadCallback& callback) {
         break;
     }
     e->name = String(entry->d_name);
-    result.push_back(e.Pass());
+    contents.push_back(e.Pass());
+  }
+
+  result->error = ERROR_OK;
+  result->directory_contents = contents.Pass();
+}
+
+void RunReadCallback(const Directory::ReadCallback& callback,
+                     ReadResult* result) {
+  callback.Run(result->error, result->directory_contents.Pass());
+}
+
+// For |OpenFile()| and |OpenDirectory()|.
+struct OpenResult {
+  OpenResult() : error(ERROR_INTERNAL) {}
+
+  Error error;
+  base::ScopedFD fd;
+};
+
+void OpenFileOnIOThread(int dir_fd,
+                        const std::string& path,
+                        int flags,
+                        OpenResult* result) {
+  result->fd.reset(HANDLE_EINTR(openat(dir_fd, path.c_str(), flags, 0600)));
+  result->error = result->fd.is_valid() ? ERROR_OK : ErrnoToError(errno);
+}
+
+void OpenDirectoryOnIOThread(int dir_fd,
+                             const std::string& path,
+                             uint32_t open_flags,
+                             OpenResult* result) {
+  if ((open_flags & kOpenFlagCreate)) {
+    if (mkdirat(dir_fd, path.c_str(), 0700) != 0) {
+      // Allow |EEXIST| if |kOpenFlagExclusive| is not set. Note, however, that
+      // it does not guarantee that |path| is a directory.
+      // TODO(vtl): Hrm, ponder if we should check that |path| is a directory.
+      if (errno != EEXIST || !(open_flags & kOpenFlagExclusive)) {
+        result->error = ErrnoToError(errno);
+        return;
+      }
+    }
+  }
+
+  result->fd.reset(HANDLE_EINTR(openat(dir_fd, path.c_str(), O_DIRECTORY, 0)));
+  result->error = result->fd.is_valid() ? ERROR_OK : ErrnoToError(errno);
+}
+
+void OnFileOpened(scoped_refptr<base::SequencedWorkerPool> worker_pool,
+                  InterfaceRequest<File> file,
+                  const Directory::OpenFileCallback& callback,
+                  OpenResult* result) {
+  if (result->error != ERROR_OK) {
+    callback.Run(result->error);
+    return;
+  }
+
+  // Each file gets its own sequence, so that operations on different files
+  // may run concurrently.
+  if (file.is_pending()) {
+    new FileImpl(
+        file.Pass(), result->fd.Pass(),
+        worker_pool->GetSequencedTaskRunner(worker_pool->GetSequenceToken()));
+  }
+  callback.Run(ERROR_OK);
+}
+
+void OnDirectoryOpened(scoped_refptr<base::SequencedWorkerPool> worker_pool,
+                       InterfaceRequest<Directory> directory,
+                       const Directory::OpenDirectoryCallback& callback,
+                       OpenResult* result) {
+  if (result->error != ERROR_OK) {
+    callback.Run(result->error);
+    return;
   }
 
-  callback.Run(ERROR_OK, result.Pass());
+  if (directory.is_pending()) {
+    new DirectoryImpl(directory.Pass(), result->fd.Pass(), nullptr,
+                      worker_pool);
+  }
+  callback.Run(ERROR_OK);
+}
+
+Error RenameOnIOThread(int dir_fd,
+                       const std::string& path,
+                       const std::string& new_path) {
+  if (renameat(dir_fd, path.c_str(), dir_fd, new_path.c_str()))
+    return ErrnoToError(errno);
+  return ERROR_OK;
+}
+
+Error DeleteOnIOThread(int dir_fd,
+                       const std::string& path,
+                       uint32_t delete_flags) {
+  // First try deleting it as a file, unless we're told to do directory-only.
+  if (!(delete_flags & kDeleteFlagDirectoryOnly)) {
+    if (unlinkat(dir_fd, path.c_str(), 0) == 0)
+      return ERROR_OK;
+
+    // If file-only, don't continue.
+    if ((delete_flags & kDeleteFlagFileOnly))
+      return ErrnoToError(errno);
+  }
+
+  // Try deleting it as a directory.
+  if (unlinkat(dir_fd, path.c_str(), AT_REMOVEDIR) == 0)
+    return ERROR_OK;
+
+  return ErrnoToError(errno);
+}
+
+}  // namespace
+
+DirectoryImpl::DirectoryImpl(
+    InterfaceRequest<Directory> request,
+    base::ScopedFD dir_fd,
+    scoped_ptr<base::ScopedTempDir> temp_dir,
+    scoped_refptr<base::SequencedWorkerPool> worker_pool)
+    : binding_(this, request.Pass()),
+      dir_fd_(dir_fd.Pass()),
+      temp_dir_(temp_dir.Pass()),
+      worker_pool_(worker_pool),
+      io_task_runner_(worker_pool_->GetSequencedTaskRunner(
+          worker_pool_->GetSequenceToken())) {
+  DCHECK(dir_fd_.is_valid());
+}
+
+DirectoryImpl::~DirectoryImpl() {
+  // Close the FD (and delete the temporary directory) after any operations that
+  // are still pending.
+  io_task_runner_->PostTask(
+      FROM_HERE, base::Bind(&CloseDirectoryOnIOThread, base::Passed(&dir_fd_),
+                            base::Passed(&temp_dir_)));
+}
+
+void DirectoryImpl::Read(const ReadCallback& callback) {
+  DCHECK(dir_fd_.is_valid());
+
+  ReadResult* result = new ReadResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&ReadOnIOThread, dir_fd_.get(), result),
+      base::Bind(&RunReadCallback, callback, base::Owned(result)));
 }
 
 void DirectoryImpl::Stat(const StatCallback& callback) {
   DCHECK(dir_fd_.is_valid());
-  StatFD(dir_fd_.get(), FILE_TYPE_DIRECTORY, callback);
+  PostStatFD(io_task_runner_, dir_fd_.get(), FILE_TYPE_DIRECTORY, callback);
 }
 
 void DirectoryImpl::Touch(TimespecOrNowPtr atime,
                           TimespecOrNowPtr mtime,
                           const TouchCallback& callback) {
   DCHECK(dir_fd_.is_valid());
-  TouchFD(dir_fd_.get(), atime.Pass(), mtime.Pass(), callback);
+  PostTouchFD(io_task_runner_, dir_fd_.get(), atime.Pass(), mtime.Pass(),
+              callback);
 }
 
-// TODO(vtl): Move the implementation to a thread pool.
 void DirectoryImpl::OpenFile(const String& path,
                              InterfaceRequest<File> file,
                              uint32_t open_flags,
@@ -216,16 +359,12 @@ void DirectoryImpl::OpenFile(const String& path,
   if ((open_flags & kOpenFlagTruncate))
     flags |= O_TRUNC;
 
-  base::ScopedFD file_fd(
-      HANDLE_EINTR(openat(dir_fd_.get(), path.get().c_str(), flags, 0600)));
-  if (!file_fd.is_valid()) {
-    callback.Run(ErrnoToError(errno));
-    return;
-  }
-
-  if (file.is_pending())
-    new FileImpl(file.Pass(), file_fd.Pass());
-  callback.Run(ERROR_OK);
+  OpenResult* result = new OpenResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&OpenFileOnIOThread, dir_fd_.get(), path.get(),
+                            flags, result),
+      base::Bind(&OnFileOpened, worker_pool_,
+                 base::Passed(&file), callback, base::Owned(result)));
 }
 
 void DirectoryImpl::OpenDirectory(const String& path,
@@ -253,28 +392,12 @@ void DirectoryImpl::OpenDirectory(const String& path,
     return;
   }
 
-  if ((open_flags & kOpenFlagCreate)) {
-    if (mkdirat(dir_fd_.get(), path.get().c_str(), 0700) != 0) {
-      // Allow |EEXIST| if |kOpenFlagExclusive| is not set. Note, however, that
-      // it does not guarantee that |path| is a directory.
-      // TODO(vtl): Hrm, ponder if we should check that |path| is a directory.
-      if (errno != EEXIST || !(open_flags & kOpenFlagExclusive)) {
-        callback.Run(ErrnoToError(errno));
-        return;
-      }
-    }
-  }
-
-  base::ScopedFD new_dir_fd(
-      HANDLE_EINTR(openat(dir_fd_.get(), path.get().c_str(), O_DIRECTORY, 0)));
-  if (!new_dir_fd.is_valid()) {
-    callback.Run(ErrnoToError(errno));
-    return;
-  }
-
-  if (directory.is_pending())
-    new DirectoryImpl(directory.Pass(), new_dir_fd.Pass(), nullptr);
-  callback.Run(ERROR_OK);
+  OpenResult* result = new OpenResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&OpenDirectoryOnIOThread, dir_fd_.get(),
+                            path.get(), open_flags, result),
+      base::Bind(&OnDirectoryOpened, worker_pool_,
+                 base::Passed(&directory), callback, base::Owned(result)));
 }
 
 void DirectoryImpl::Rename(const String& path,
@@ -294,13 +417,10 @@ void DirectoryImpl::Rename(const String& path,
   }
   // TODO(vtl): See TODOs about |path| in OpenFile().
 
-  if (renameat(dir_fd_.get(), path.get().c_str(), dir_fd_.get(),
-               new_path.get().c_str())) {
-    callback.Run(ErrnoToError(errno));
-    return;
-  }
-
-  callback.Run(ERROR_OK);
+  base::PostTaskAndReplyWithResult(
+      io_task_runner_.get(), FROM_HERE,
+      base::Bind(&RenameOnIOThread, dir_fd_.get(), path.get(), new_path.get()),
+      base::Bind(&RunErrorCallback, callback));
 }
 
 void DirectoryImpl::Delete(const String& path,
@@ -326,27 +446,10 @@ void DirectoryImpl::Delete(const String& path,
     return;
   }
 
-  // First try deleting it as a file, unless we're told to do directory-only.
-  if (!(delete_flags & kDeleteFlagDirectoryOnly)) {
-    if (unlinkat(dir_fd_.get(), path.get().c_str(), 0) == 0) {
-      callback.Run(ERROR_OK);
-      return;
-    }
-
-    // If file-only, don't continue.
-    if ((delete_flags & kDeleteFlagFileOnly)) {
-      callback.Run(ErrnoToError(errno));
-      return;
-    }
-  }
-
-  // Try deleting it as a directory.
-  if (unlinkat(dir_fd_.get(), path.get().c_str(), AT_REMOVEDIR) == 0) {
-    callback.Run(ERROR_OK);
-    return;
-  }
-
-  callback.Run(ErrnoToError(errno));
+  base::PostTaskAndReplyWithResult(
+      io_task_runner_.get(), FROM_HERE,
+      base::Bind(&DeleteOnIOThread, dir_fd_.get(), path.get(), delete_flags),
+      base::Bind(&RunErrorCallback, callback));
 }
 
 }  // namespace files
@@ -7,6 +7,7 @@
 
 #include "base/files/scoped_file.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "mojo/public/cpp/bindings/interface_request.h"
 #include "mojo/public/cpp/bindings/strong_binding.h"
@@ -14,18 +15,23 @@
 
 namespace base {
 class ScopedTempDir;
+class SequencedTaskRunner;
+class SequencedWorkerPool;
 }  // namespace base
 
 namespace mojo {
 namespace files {
 
+// Blocking operations on the directory are done in order on a sequence in
+// |worker_pool|; files and directories opened from it get their own sequences.
 class DirectoryImpl : public Directory {
  public:
   // Set |temp_dir| only if there's a temporary directory that should be deleted
   // when this object is destroyed.
   DirectoryImpl(InterfaceRequest<Directory> request,
                 base::ScopedFD dir_fd,
-                scoped_ptr<base::ScopedTempDir> temp_dir);
+                scoped_ptr<base::ScopedTempDir> temp_dir,
+                scoped_refptr<base::SequencedWorkerPool> worker_pool);
   ~DirectoryImpl() override;
 
   // |Directory| implementation:
@@ -53,6 +59,8 @@ class DirectoryImpl : public Directory {
   StrongBinding<Directory> binding_;
   base::ScopedFD dir_fd_;
   scoped_ptr<base::ScopedTempDir> temp_dir_;
+  scoped_refptr<base::SequencedWorkerPool> worker_pool_;
+  scoped_refptr<base::SequencedTaskRunner> io_task_runner_;
 
   DISALLOW_COPY_AND_ASSIGN(DirectoryImpl);
 };
@@ -12,9 +12,15 @@
 
 #include <limits>
 
+#include "base/bind.h"
 #include "base/files/scoped_file.h"
+#include "base/location.h"
 #include "base/logging.h"
 #include "base/posix/eintr_wrapper.h"
+#include "base/sequenced_task_runner.h"
+#include "base/task_runner_util.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "services/files/file_stream.h"
 #include "services/files/shared_impl.h"
 #include "services/files/util.h"
 
@@ -26,39 +32,314 @@ namespace files {
 
 const size_t kMaxReadSize = 1 * 1024 * 1024;  // 1 MB.
 
-FileImpl::FileImpl(InterfaceRequest<File> request, base::ScopedFD file_fd)
-    : binding_(this, request.Pass()), file_fd_(file_fd.Pass()) {
-  DCHECK(file_fd_.is_valid());
-}
+namespace {
 
-FileImpl::~FileImpl() {
-}
+// Blocking implementations, run on the file's I/O task runner. Results that
+// can't simply be returned are filled into a result struct, which is then
+// passed (on the main thread) to a function that runs the callback.
 
-void FileImpl::Close(const CloseCallback& callback) {
-  if (!file_fd_.is_valid()) {
-    callback.Run(ERROR_CLOSED);
-    return;
-  }
-  int fd_to_try_to_close = file_fd_.release();
+Error CloseOnIOThread(int fd) {
   // POSIX.1 (2013) leaves the validity of the FD undefined on EINTR and EIO. On
   // Linux, the FD is always invalidated, so we'll pretend that the close
   // succeeded. (On other Unixes, the situation may be different and possibly
   // totally broken; see crbug.com/269623.)
-  if (IGNORE_EINTR(close(fd_to_try_to_close)) != 0) {
+  if (IGNORE_EINTR(close(fd)) != 0) {
     // Save errno, since we do a few things and we don't want it trampled.
     int error = errno;
     CHECK_NE(error, EBADF);   // This should never happen.
     DCHECK_NE(error, EINTR);  // We already ignored EINTR.
     // I don't know what Linux does on EIO (or any other errors) -- POSIX leaves
     // it undefined -- so report the error and hope that the FD was invalidated.
-    callback.Run(ErrnoToError(error));
+    return ErrnoToError(error);
+  }
+  return ERROR_OK;
+}
+
+// Used to close the FD (on the I/O task runner) if the |FileImpl| is destroyed
+// without having been closed.
+void DeleteFDOnIOThread(base::ScopedFD fd) {}
+
+struct ReadResult {
+  ReadResult() : error(ERROR_INTERNAL) {}
+
+  Error error;
+  Array<uint8_t> bytes_read;
+};
+
+void ReadOnIOThread(int fd,
+                    uint32_t num_bytes_to_read,
+                    int64_t offset,
+                    Whence whence,
+                    ReadResult* result) {
+  Array<uint8_t> bytes_read(num_bytes_to_read);
+  void* buf = (num_bytes_to_read > 0) ? &bytes_read.front() : nullptr;
+  ssize_t num_bytes_read;
+  if (whence == WHENCE_FROM_START) {
+    // Use |pread()|, which is atomic and doesn't change the file position.
+    if (offset < 0) {
+      result->error = ERROR_INVALID_ARGUMENT;
+      return;
+    }
+    num_bytes_read = HANDLE_EINTR(
+        pread(fd, buf, num_bytes_to_read, static_cast<off_t>(offset)));
+  } else {
+    // TODO(vtl): Possibly, at least sometimes we should not change the file
+    // position. See TODO in file.mojom.
+    if ((offset != 0 || whence != WHENCE_FROM_CURRENT) &&
+        lseek(fd, static_cast<off_t>(offset), WhenceToStandardWhence(whence)) <
+            0) {
+      result->error = ErrnoToError(errno);
+      return;
+    }
+    num_bytes_read = HANDLE_EINTR(read(fd, buf, num_bytes_to_read));
+  }
+  if (num_bytes_read < 0) {
+    result->error = ErrnoToError(errno);
     return;
   }
 
-  callback.Run(ERROR_OK);
+  DCHECK_LE(static_cast<size_t>(num_bytes_read), num_bytes_to_read);
+  bytes_read.resize(static_cast<size_t>(num_bytes_read));
+  result->error = ERROR_OK;
+  result->bytes_read = bytes_read.Pass();
+}
+
+void RunReadCallback(const File::ReadCallback& callback, ReadResult* result) {
+  callback.Run(result->error, result->bytes_read.Pass());
+}
+
+struct WriteResult {
+  WriteResult() : error(ERROR_INTERNAL), num_bytes_written(0) {}
+
+  Error error;
+  uint32_t num_bytes_written;
+};
+
+void WriteOnIOThread(int fd,
+                     Array<uint8_t> bytes_to_write,
+                     int64_t offset,
+                     Whence whence,
+                     WriteResult* result) {
+  const void* buf =
+      (bytes_to_write.size() > 0) ? &bytes_to_write.front() : nullptr;
+  ssize_t num_bytes_written;
+  if (whence == WHENCE_FROM_START) {
+    // Use |pwrite()|, which is atomic and doesn't change the file position.
+    if (offset < 0) {
+      result->error = ERROR_INVALID_ARGUMENT;
+      return;
+    }
+    num_bytes_written = HANDLE_EINTR(pwrite(fd, buf, bytes_to_write.size(),
+                                            static_cast<off_t>(offset)));
+  } else {
+    // TODO(vtl): Possibly, at least sometimes we should not change the file
+    // position. See TODO in file.mojom.
+    if ((offset != 0 || whence != WHENCE_FROM_CURRENT) &&
+        lseek(fd, static_cast<off_t>(offset), WhenceToStandardWhence(whence)) <
+            0) {
+      result->error = ErrnoToError(errno);
+      return;
+    }
+    num_bytes_written = HANDLE_EINTR(write(fd, buf, bytes_to_write.size()));
+  }
+  if (num_bytes_written < 0) {
+    result->error = ErrnoToError(errno);
+    return;
+  }
+
+  DCHECK_LE(static_cast<size_t>(num_bytes_written),
+            std::numeric_limits<uint32_t>::max());
+  result->error = ERROR_OK;
+  result->num_bytes_written = static_cast<uint32_t>(num_bytes_written);
+}
+
+void RunWriteCallback(const File::WriteCallback& callback,
+                      WriteResult* result) {
+  callback.Run(result->error, result->num_bytes_written);
+}
+
+// For |ReadToStream()| and |WriteFromStream()|: resolves the starting position
+// and gets a separate FD for the stream (since the copy may outlive the
+// |FileImpl|).
+struct StreamResult {
+  StreamResult() : error(ERROR_INTERNAL), position(0) {}
+
+  Error error;
+  int64_t position;
+  base::ScopedFD stream_fd;
+};
+
+void PrepareStreamOnIOThread(int fd,
+                             int64_t offset,
+                             Whence whence,
+                             StreamResult* result) {
+  result->error = GetAbsolutePosition(fd, offset, whence, &result->position);
+  if (result->error != ERROR_OK)
+    return;
+
+  result->stream_fd.reset(dup(fd));
+  if (!result->stream_fd.is_valid())
+    result->error = ErrnoToError(errno);
+}
+
+void StartReadToStream(ScopedDataPipeProducerHandle source,
+                       int64_t num_bytes_to_read,
+                       scoped_refptr<base::TaskRunner> io_task_runner,
+                       const File::ReadToStreamCallback& callback,
+                       StreamResult* result) {
+  if (result->error != ERROR_OK) {
+    callback.Run(result->error);
+    return;
+  }
+  // A negative |num_bytes_to_read| means "read to the end of the file".
+  CopyFileToDataPipe(result->stream_fd.Pass(), result->position,
+                     num_bytes_to_read, source.Pass(), io_task_runner,
+                     callback);
+}
+
+void StartWriteFromStream(ScopedDataPipeConsumerHandle sink,
+                          scoped_refptr<base::TaskRunner> io_task_runner,
+                          const File::WriteFromStreamCallback& callback,
+                          StreamResult* result) {
+  if (result->error != ERROR_OK) {
+    callback.Run(result->error);
+    return;
+  }
+  CopyDataPipeToFile(sink.Pass(), result->stream_fd.Pass(), result->position,
+                     io_task_runner, callback);
+}
+
+struct SeekResult {
+  SeekResult() : error(ERROR_INTERNAL), position(0) {}
+
+  Error error;
+  int64_t position;
+};
+
+void SeekOnIOThread(int fd, int64_t offset, Whence whence, SeekResult* result) {
+  off_t position =
+      lseek(fd, static_cast<off_t>(offset), WhenceToStandardWhence(whence));
+  if (position < 0) {
+    result->error = ErrnoToError(errno);
+    return;
+  }
+  result->error = ERROR_OK;
+  result->position = static_cast<int64_t>(position);
+}
+
+void RunSeekCallback(const File::SeekCallback& callback, SeekResult* result) {
+  callback.Run(result->error, result->position);
+}
+
+Error TruncateOnIOThread(int fd, int64_t size) {
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    return ErrnoToError(errno);
+  return ERROR_OK;
+}
+
+struct AsBufferResult {
+  AsBufferResult() : error(ERROR_INTERNAL) {}
+
+  Error error;
+  ScopedSharedBufferHandle buffer;
+};
+
+void AsBufferOnIOThread(int fd, AsBufferResult* result) {
+  // TODO(vtl): Ideally we'd hand out a mapping of the file itself (so that
+  // changes would be reflected both ways), but we have no way of wrapping an FD
+  // (or mapping) in a shared buffer handle from here. So, for now, this is a
+  // snapshot of the file's contents, read directly into the buffer's mapping
+  // (without an intermediate copy).
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    result->error = ErrnoToError(errno);
+    return;
+  }
+  if (st.st_size == 0) {
+    // Shared buffers can't be empty.
+    result->error = ERROR_OK;
+    return;
+  }
+  uint64_t size = static_cast<uint64_t>(st.st_size);
+  if (size > std::numeric_limits<size_t>::max()) {
+    result->error = ERROR_OUT_OF_RANGE;
+    return;
+  }
+
+  ScopedSharedBufferHandle buffer;
+  if (CreateSharedBuffer(nullptr, size, &buffer) != MOJO_RESULT_OK) {
+    result->error = ERROR_UNAVAILABLE;
+    return;
+  }
+  void* pointer = nullptr;
+  if (MapBuffer(buffer.get(), 0, size, &pointer, MOJO_MAP_BUFFER_FLAG_NONE) !=
+      MOJO_RESULT_OK) {
+    result->error = ERROR_UNAVAILABLE;
+    return;
+  }
+
+  // Use |pread()|, so that the file position is unaffected. If the file shrinks
+  // in the meantime, the rest of the buffer stays zero-filled.
+  char* bytes = static_cast<char*>(pointer);
+  size_t num_bytes_read = 0;
+  while (num_bytes_read < size) {
+    ssize_t rv = HANDLE_EINTR(pread(fd, bytes + num_bytes_read,
+                                    static_cast<size_t>(size) - num_bytes_read,
+                                    static_cast<off_t>(num_bytes_read)));
+    if (rv < 0) {
+      int error = errno;
+      UnmapBuffer(pointer);
+      result->error = ErrnoToError(error);
+      return;
+    }
+    if (rv == 0)
+      break;
+    num_bytes_read += static_cast<size_t>(rv);
+  }
+  UnmapBuffer(pointer);
+
+  result->error = ERROR_OK;
+  result->buffer = buffer.Pass();
+}
+
+void RunAsBufferCallback(const File::AsBufferCallback& callback,
+                         AsBufferResult* result) {
+  callback.Run(result->error, result->buffer.Pass());
+}
+
+}  // namespace
+
+FileImpl::FileImpl(InterfaceRequest<File> request,
+                   base::ScopedFD file_fd,
+                   scoped_refptr<base::SequencedTaskRunner> io_task_runner)
+    : binding_(this, request.Pass()),
+      file_fd_(file_fd.Pass()),
+      io_task_runner_(io_task_runner) {
+  DCHECK(file_fd_.is_valid());
+  DCHECK(io_task_runner_);
+}
+
+FileImpl::~FileImpl() {
+  // Close the FD after any operations that are still pending.
+  if (file_fd_.is_valid()) {
+    io_task_runner_->PostTask(
+        FROM_HERE, base::Bind(&DeleteFDOnIOThread, base::Passed(&file_fd_)));
+  }
+}
+
+void FileImpl::Close(const CloseCallback& callback) {
+  if (!file_fd_.is_valid()) {
+    callback.Run(ERROR_CLOSED);
+    return;
+  }
+  // Any further operations will fail with |ERROR_CLOSED|, but ones that are
+  // already pending will run (on the I/O task runner) before the close.
+  base::PostTaskAndReplyWithResult(
+      io_task_runner_.get(), FROM_HERE,
+      base::Bind(&CloseOnIOThread, file_fd_.release()),
+      base::Bind(&RunErrorCallback, callback));
 }
 
-// TODO(vtl): Move the implementation to a thread pool.
 void FileImpl::Read(uint32_t num_bytes_to_read,
                     int64_t offset,
                     Whence whence,
@@ -80,34 +361,13 @@ void FileImpl::Read(uint32_t num_bytes_to_read,
     return;
   }
 
-  if (offset != 0 || whence != WHENCE_FROM_CURRENT) {
-    // TODO(vtl): Use |pread()| below in the |WHENCE_FROM_START| case. This
-    // implementation is obviously not atomic. (If someone seeks simultaneously,
-    // we'll end up writing somewhere else. Or, well, we would if we were
-    // multithreaded.) Maybe we should do an |ftell()| and always use |pread()|.
-    // TODO(vtl): Possibly, at least sometimes we should not change the file
-    // position. See TODO in file.mojom.
-    if (lseek(file_fd_.get(), static_cast<off_t>(offset),
-              WhenceToStandardWhence(whence)) < 0) {
-      callback.Run(ErrnoToError(errno), Array<uint8_t>());
-      return;
-    }
-  }
-
-  Array<uint8_t> bytes_read(num_bytes_to_read);
-  ssize_t num_bytes_read = HANDLE_EINTR(
-      read(file_fd_.get(), &bytes_read.front(), num_bytes_to_read));
-  if (num_bytes_read < 0) {
-    callback.Run(ErrnoToError(errno), Array<uint8_t>());
-    return;
-  }
-
-  DCHECK_LE(static_cast<size_t>(num_bytes_read), num_bytes_to_read);
-  bytes_read.resize(static_cast<size_t>(num_bytes_read));
-  callback.Run(ERROR_OK, bytes_read.Pass());
+  ReadResult* result = new ReadResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&ReadOnIOThread, file_fd_.get(), num_bytes_to_read,
+                            offset, whence, result),
+      base::Bind(&RunReadCallback, callback, base::Owned(result)));
 }
 
-// TODO(vtl): Move the implementation to a thread pool.
 void FileImpl::Write(Array<uint8_t> bytes_to_write,
                      int64_t offset,
                      Whence whence,
@@ -134,33 +394,12 @@ void FileImpl::Write(Array<uint8_t> bytes_to_write,
     return;
   }
 
-  if (offset != 0 || whence != WHENCE_FROM_CURRENT) {
-    // TODO(vtl): Use |pwrite()| below in the |WHENCE_FROM_START| case. This
-    // implementation is obviously not atomic. (If someone seeks simultaneously,
-    // we'll end up writing somewhere else. Or, well, we would if we were
-    // multithreaded.) Maybe we should do an |ftell()| and always use
-    // |pwrite()|.
-    // TODO(vtl): Possibly, at least sometimes we should not change the file
-    // position. See TODO in file.mojom.
-    if (lseek(file_fd_.get(), static_cast<off_t>(offset),
-              WhenceToStandardWhence(whence)) < 0) {
-      callback.Run(ErrnoToError(errno), 0);
-      return;
-    }
-  }
-
-  const void* buf =
-      (bytes_to_write.size() > 0) ? &bytes_to_write.front() : nullptr;
-  ssize_t num_bytes_written =
-      HANDLE_EINTR(write(file_fd_.get(), buf, bytes_to_write.size()));
-  if (num_bytes_written < 0) {
-    callback.Run(ErrnoToError(errno), 0);
-    return;
-  }
-
-  DCHECK_LE(static_cast<size_t>(num_bytes_written),
-            std::numeric_limits<uint32_t>::max());
-  callback.Run(ERROR_OK, static_cast<uint32_t>(num_bytes_written));
+  WriteResult* result = new WriteResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&WriteOnIOThread, file_fd_.get(),
+                 base::Passed(&bytes_to_write), offset, whence, result),
+      base::Bind(&RunWriteCallback, callback, base::Owned(result)));
 }
 
 void FileImpl::ReadToStream(ScopedDataPipeProducerHandle source,
@@ -181,9 +420,14 @@ void FileImpl::ReadToStream(ScopedDataPipeProducerHandle source,
     return;
   }
 
-  // TODO(vtl): FIXME soon
-  NOTIMPLEMENTED();
-  callback.Run(ERROR_UNIMPLEMENTED);
+  // The copy only does positional reads (on a separate FD), so the file
+  // position is unchanged.
+  StreamResult* result = new StreamResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&PrepareStreamOnIOThread, file_fd_.get(), offset,
+                            whence, result),
+      base::Bind(&StartReadToStream, base::Passed(&source), num_bytes_to_read,
+                 io_task_runner_, callback, base::Owned(result)));
 }
 
 void FileImpl::WriteFromStream(ScopedDataPipeConsumerHandle sink,
@@ -203,9 +447,15 @@ void FileImpl::WriteFromStream(ScopedDataPipeConsumerHandle sink,
     return;
   }
 
-  // TODO(vtl): FIXME soon
-  NOTIMPLEMENTED();
-  callback.Run(ERROR_UNIMPLEMENTED);
+  // As in |ReadToStream()|: positional writes on a separate FD.
+  // TODO(vtl): On Linux, |pwrite()| ignores the position (and appends) if the
+  // file was opened with |O_APPEND|.
+  StreamResult* result = new StreamResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&PrepareStreamOnIOThread, file_fd_.get(), offset,
+                            whence, result),
+      base::Bind(&StartWriteFromStream, base::Passed(&sink), io_task_runner_,
+                 callback, base::Owned(result)));
 }
 
 void FileImpl::Tell(const TellCallback& callback) {
@@ -228,14 +478,11 @@ void FileImpl::Seek(int64_t offset,
     return;
   }
 
-  off_t position = lseek(file_fd_.get(), static_cast<off_t>(offset),
-                         WhenceToStandardWhence(whence));
-  if (position < 0) {
-    callback.Run(ErrnoToError(errno), 0);
-    return;
-  }
-
-  callback.Run(ERROR_OK, static_cast<int64>(position));
+  SeekResult* result = new SeekResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&SeekOnIOThread, file_fd_.get(), offset, whence, result),
+      base::Bind(&RunSeekCallback, callback, base::Owned(result)));
 }
 
 void FileImpl::Stat(const StatCallback& callback) {
@@ -243,7 +490,7 @@ void FileImpl::Stat(const StatCallback& callback) {
     callback.Run(ERROR_CLOSED, nullptr);
     return;
   }
-  StatFD(file_fd_.get(), FILE_TYPE_REGULAR_FILE, callback);
+  PostStatFD(io_task_runner_, file_fd_.get(), FILE_TYPE_REGULAR_FILE, callback);
 }
 
 void FileImpl::Truncate(int64_t size, const TruncateCallback& callback) {
@@ -260,12 +507,10 @@ void FileImpl::Truncate(int64_t size, const TruncateCallback& callback) {
     return;
   }
 
-  if (ftruncate(file_fd_.get(), static_cast<off_t>(size)) != 0) {
-    callback.Run(ErrnoToError(errno));
-    return;
-  }
-
-  callback.Run(ERROR_OK);
+  base::PostTaskAndReplyWithResult(
+      io_task_runner_.get(), FROM_HERE,
+      base::Bind(&TruncateOnIOThread, file_fd_.get(), size),
+      base::Bind(&RunErrorCallback, callback));
 }
 
 void FileImpl::Touch(TimespecOrNowPtr atime,
@@ -275,7 +520,8 @@ void FileImpl::Touch(TimespecOrNowPtr atime,
     callback.Run(ERROR_CLOSED);
     return;
   }
-  TouchFD(file_fd_.get(), atime.Pass(), mtime.Pass(), callback);
+  PostTouchFD(io_task_runner_, file_fd_.get(), atime.Pass(), mtime.Pass(),
+              callback);
 }
 
 void FileImpl::Dup(InterfaceRequest<File> file, const DupCallback& callback) {
@@ -290,7 +536,10 @@ void FileImpl::Dup(InterfaceRequest<File> file, const DupCallback& callback) {
     return;
   }
 
-  new FileImpl(file.Pass(), file_fd.Pass());
+  // The new |FileImpl| shares the file description (including the file
+  // position), so it also shares our I/O task runner to keep operations on the
+  // two ordered.
+  new FileImpl(file.Pass(), file_fd.Pass(), io_task_runner_);
   callback.Run(ERROR_OK);
 }
 
@@ -313,9 +562,10 @@ void FileImpl::AsBuffer(const AsBufferCallback& callback) {
     return;
   }
 
-  // TODO(vtl): FIXME soon
-  NOTIMPLEMENTED();
-  callback.Run(ERROR_UNIMPLEMENTED, ScopedSharedBufferHandle());
+  AsBufferResult* result = new AsBufferResult();
+  io_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&AsBufferOnIOThread, file_fd_.get(), result),
+      base::Bind(&RunAsBufferCallback, callback, base::Owned(result)));
 }
 
 void FileImpl::Ioctl(uint32_t request,
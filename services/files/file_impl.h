@@ -7,17 +7,27 @@
 
 #include "base/files/scoped_file.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "mojo/public/cpp/bindings/interface_request.h"
 #include "mojo/public/cpp/bindings/strong_binding.h"
 #include "mojo/services/files/public/interfaces/directory.mojom.h"
 
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
 namespace mojo {
 namespace files {
 
+// Blocking operations on the file are done on |io_task_runner| (which is
+// typically a sequence in a worker pool), so that they don't hold up other
+// clients; since it's sequenced, they're still done in the order requested.
 class FileImpl : public File {
  public:
   // TODO(vtl): Will need more for, e.g., |Reopen()|.
-  FileImpl(InterfaceRequest<File> request, base::ScopedFD file_fd);
+  FileImpl(InterfaceRequest<File> request,
+           base::ScopedFD file_fd,
+           scoped_refptr<base::SequencedTaskRunner> io_task_runner);
   ~FileImpl() override;
 
   // |File| implementation:
@@ -60,6 +70,7 @@ class FileImpl : public File {
  private:
   StrongBinding<File> binding_;
   base::ScopedFD file_fd_;
+  scoped_refptr<base::SequencedTaskRunner> io_task_runner_;
 
   DISALLOW_COPY_AND_ASSIGN(FileImpl);
 };
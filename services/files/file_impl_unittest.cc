@@ -2,10 +2,14 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
 #include <vector>
 
 #include "mojo/public/cpp/bindings/interface_request.h"
 #include "mojo/public/cpp/bindings/type_converter.h"
+#include "mojo/public/cpp/system/buffer.h"
+#include "mojo/public/cpp/system/data_pipe.h"
 #include "services/files/files_test_base.h"
 
 namespace mojo {
@@ -386,6 +390,247 @@ TEST_F(FileImplTest, Truncate) {
   EXPECT_EQ(kTruncatedSize, file_info->size);
 }
 
+TEST_F(FileImplTest, PositionalReadWrite) {
+  DirectoryPtr directory;
+  GetTemporaryRoot(&directory);
+  Error error;
+
+  // Create my_file.
+  FilePtr file;
+  error = ERROR_INTERNAL;
+  directory->OpenFile("my_file", GetProxy(&file),
+                      kOpenFlagRead | kOpenFlagWrite | kOpenFlagCreate,
+                      Capture(&error));
+  ASSERT_TRUE(directory.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+
+  // Issue a bunch of operations without waiting for replies; they should still
+  // be done in order.
+  std::vector<uint8_t> bytes_to_write(10, 'a');
+  Error write1_error = ERROR_INTERNAL;
+  uint32_t write1_num_bytes_written = 0;
+  file->Write(Array<uint8_t>::From(bytes_to_write), 0, WHENCE_FROM_CURRENT,
+              Capture(&write1_error, &write1_num_bytes_written));
+  // This write is positional, so it shouldn't change the file position.
+  bytes_to_write.assign(3, 'b');
+  Error write2_error = ERROR_INTERNAL;
+  uint32_t write2_num_bytes_written = 0;
+  file->Write(Array<uint8_t>::From(bytes_to_write), 2, WHENCE_FROM_START,
+              Capture(&write2_error, &write2_num_bytes_written));
+  Error tell_error = ERROR_INTERNAL;
+  int64_t position = -1;
+  file->Tell(Capture(&tell_error, &position));
+  // So is this read.
+  Error read_error = ERROR_INTERNAL;
+  Array<uint8_t> bytes_read;
+  file->Read(100, 0, WHENCE_FROM_START, Capture(&read_error, &bytes_read));
+  Error tell2_error = ERROR_INTERNAL;
+  int64_t position2 = -1;
+  file->Tell(Capture(&tell2_error, &position2));
+
+  for (int i = 0; i < 5; i++)
+    ASSERT_TRUE(file.WaitForIncomingMethodCall());
+
+  EXPECT_EQ(ERROR_OK, write1_error);
+  EXPECT_EQ(10u, write1_num_bytes_written);
+  EXPECT_EQ(ERROR_OK, write2_error);
+  EXPECT_EQ(3u, write2_num_bytes_written);
+  EXPECT_EQ(ERROR_OK, tell_error);
+  EXPECT_EQ(10, position);
+  EXPECT_EQ(ERROR_OK, read_error);
+  ASSERT_EQ(10u, bytes_read.size());
+  EXPECT_EQ(static_cast<uint8_t>('a'), bytes_read[1]);
+  EXPECT_EQ(static_cast<uint8_t>('b'), bytes_read[2]);
+  EXPECT_EQ(static_cast<uint8_t>('b'), bytes_read[4]);
+  EXPECT_EQ(static_cast<uint8_t>('a'), bytes_read[5]);
+  EXPECT_EQ(ERROR_OK, tell2_error);
+  EXPECT_EQ(10, position2);
+}
+
+TEST_F(FileImplTest, ReadToStream) {
+  DirectoryPtr directory;
+  GetTemporaryRoot(&directory);
+  Error error;
+
+  // Create my_file.
+  FilePtr file;
+  error = ERROR_INTERNAL;
+  directory->OpenFile("my_file", GetProxy(&file),
+                      kOpenFlagRead | kOpenFlagWrite | kOpenFlagCreate,
+                      Capture(&error));
+  ASSERT_TRUE(directory.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+
+  // Write to it.
+  const char kHello[] = "hello world";
+  const uint32_t kHelloSize = static_cast<uint32_t>(strlen(kHello));
+  std::vector<uint8_t> bytes_to_write(kHello, kHello + kHelloSize);
+  error = ERROR_INTERNAL;
+  uint32_t num_bytes_written = 0;
+  file->Write(Array<uint8_t>::From(bytes_to_write), 0, WHENCE_FROM_CURRENT,
+              Capture(&error, &num_bytes_written));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+  EXPECT_EQ(kHelloSize, num_bytes_written);
+
+  // Read "world" (to the end of the file) to a data pipe.
+  {
+    DataPipe data_pipe;
+    error = ERROR_INTERNAL;
+    file->ReadToStream(data_pipe.producer_handle.Pass(), 6, WHENCE_FROM_START,
+                       -1, Capture(&error));
+    ASSERT_TRUE(file.WaitForIncomingMethodCall());
+    EXPECT_EQ(ERROR_OK, error);
+
+    char buffer[5] = {};
+    uint32_t num_bytes = 5u;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              ReadDataRaw(data_pipe.consumer_handle.get(), buffer, &num_bytes,
+                          MOJO_READ_DATA_FLAG_ALL_OR_NONE));
+    EXPECT_EQ(0, memcmp(buffer, "world", 5));
+  }
+
+  // Read "hello" (a limited number of bytes) to a data pipe.
+  {
+    DataPipe data_pipe;
+    error = ERROR_INTERNAL;
+    file->ReadToStream(data_pipe.producer_handle.Pass(), 0, WHENCE_FROM_START,
+                       5, Capture(&error));
+    ASSERT_TRUE(file.WaitForIncomingMethodCall());
+    EXPECT_EQ(ERROR_OK, error);
+
+    char buffer[5] = {};
+    uint32_t num_bytes = 5u;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              ReadDataRaw(data_pipe.consumer_handle.get(), buffer, &num_bytes,
+                          MOJO_READ_DATA_FLAG_ALL_OR_NONE));
+    EXPECT_EQ(0, memcmp(buffer, "hello", 5));
+    // Nothing more should have been written.
+    num_bytes = 0u;
+    EXPECT_EQ(MOJO_RESULT_OK,
+              ReadDataRaw(data_pipe.consumer_handle.get(), nullptr, &num_bytes,
+                          MOJO_READ_DATA_FLAG_QUERY));
+    EXPECT_EQ(0u, num_bytes);
+  }
+
+  // The file position should be unaffected.
+  error = ERROR_INTERNAL;
+  int64_t position = -1;
+  file->Tell(Capture(&error, &position));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+  EXPECT_EQ(static_cast<int64_t>(kHelloSize), position);
+
+  // Reading from before the start of the file is invalid.
+  {
+    DataPipe data_pipe;
+    error = ERROR_INTERNAL;
+    file->ReadToStream(data_pipe.producer_handle.Pass(), -1, WHENCE_FROM_START,
+                       -1, Capture(&error));
+    ASSERT_TRUE(file.WaitForIncomingMethodCall());
+    EXPECT_EQ(ERROR_INVALID_ARGUMENT, error);
+  }
+}
+
+TEST_F(FileImplTest, WriteFromStream) {
+  DirectoryPtr directory;
+  GetTemporaryRoot(&directory);
+  Error error;
+
+  // Create my_file.
+  FilePtr file;
+  error = ERROR_INTERNAL;
+  directory->OpenFile("my_file", GetProxy(&file),
+                      kOpenFlagRead | kOpenFlagWrite | kOpenFlagCreate,
+                      Capture(&error));
+  ASSERT_TRUE(directory.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+
+  // Write some data to a data pipe, and close the producer.
+  const char kHello[] = "hello world";
+  const uint32_t kHelloSize = static_cast<uint32_t>(strlen(kHello));
+  DataPipe data_pipe;
+  uint32_t num_bytes = kHelloSize;
+  EXPECT_EQ(MOJO_RESULT_OK,
+            WriteDataRaw(data_pipe.producer_handle.get(), kHello, &num_bytes,
+                         MOJO_WRITE_DATA_FLAG_ALL_OR_NONE));
+  data_pipe.producer_handle.reset();
+
+  // Write it to the file (after a 3-byte hole).
+  error = ERROR_INTERNAL;
+  file->WriteFromStream(data_pipe.consumer_handle.Pass(), 3, WHENCE_FROM_START,
+                        Capture(&error));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+
+  // Stat it.
+  error = ERROR_INTERNAL;
+  FileInformationPtr file_info;
+  file->Stat(Capture(&error, &file_info));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+  ASSERT_FALSE(file_info.is_null());
+  EXPECT_EQ(static_cast<int64_t>(3 + kHelloSize), file_info->size);
+
+  // Read it back.
+  Array<uint8_t> bytes_read;
+  error = ERROR_INTERNAL;
+  file->Read(kHelloSize, 3, WHENCE_FROM_START, Capture(&error, &bytes_read));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+  ASSERT_EQ(kHelloSize, bytes_read.size());
+  EXPECT_EQ(0, memcmp(&bytes_read.front(), kHello, kHelloSize));
+}
+
+TEST_F(FileImplTest, AsBuffer) {
+  DirectoryPtr directory;
+  GetTemporaryRoot(&directory);
+  Error error;
+
+  // Create my_file.
+  FilePtr file;
+  error = ERROR_INTERNAL;
+  directory->OpenFile("my_file", GetProxy(&file),
+                      kOpenFlagRead | kOpenFlagWrite | kOpenFlagCreate,
+                      Capture(&error));
+  ASSERT_TRUE(directory.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+
+  // An empty file gives a null buffer.
+  ScopedSharedBufferHandle buffer;
+  error = ERROR_INTERNAL;
+  file->AsBuffer(Capture(&error, &buffer));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+  EXPECT_FALSE(buffer.is_valid());
+
+  // Write to it.
+  const uint32_t kSize = 10000;
+  std::vector<uint8_t> bytes_to_write(kSize);
+  for (uint32_t i = 0; i < kSize; i++)
+    bytes_to_write[i] = static_cast<uint8_t>(i * 7);
+  error = ERROR_INTERNAL;
+  uint32_t num_bytes_written = 0;
+  file->Write(Array<uint8_t>::From(bytes_to_write), 0, WHENCE_FROM_CURRENT,
+              Capture(&error, &num_bytes_written));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+  EXPECT_EQ(kSize, num_bytes_written);
+
+  // Get it as a buffer.
+  error = ERROR_INTERNAL;
+  file->AsBuffer(Capture(&error, &buffer));
+  ASSERT_TRUE(file.WaitForIncomingMethodCall());
+  EXPECT_EQ(ERROR_OK, error);
+  ASSERT_TRUE(buffer.is_valid());
+
+  void* pointer = nullptr;
+  ASSERT_EQ(MOJO_RESULT_OK, MapBuffer(buffer.get(), 0, kSize, &pointer,
+                                      MOJO_MAP_BUFFER_FLAG_NONE));
+  EXPECT_EQ(0, memcmp(pointer, &bytes_to_write[0], kSize));
+  EXPECT_EQ(MOJO_RESULT_OK, UnmapBuffer(pointer));
+}
+
 TEST_F(FileImplTest, Ioctl) {
   DirectoryPtr directory;
   GetTemporaryRoot(&directory);
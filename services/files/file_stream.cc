@@ -0,0 +1,329 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/files/file_stream.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <limits>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/task_runner.h"
+#include "mojo/common/handle_watcher.h"
+#include "services/files/util.h"
+
+namespace mojo {
+namespace files {
+
+namespace {
+
+// Result of a positional read or write done on the I/O task runner.
+struct IOResult {
+  IOResult() : num_bytes(0), error(0) {}
+
+  // Number of bytes read/written, or -1 on error.
+  ssize_t num_bytes;
+  // The |errno| value, if |num_bytes| is -1.
+  int error;
+};
+
+void PReadOnIOThread(int fd,
+                     void* buffer,
+                     size_t num_bytes,
+                     int64_t position,
+                     IOResult* result) {
+  result->num_bytes = HANDLE_EINTR(
+      pread(fd, buffer, num_bytes, static_cast<off_t>(position)));
+  if (result->num_bytes < 0)
+    result->error = errno;
+}
+
+// Unlike |PReadOnIOThread()|, this writes everything (unless there's an error).
+void PWriteAllOnIOThread(int fd,
+                         const void* buffer,
+                         size_t num_bytes,
+                         int64_t position,
+                         IOResult* result) {
+  const char* bytes = static_cast<const char*>(buffer);
+  size_t num_bytes_written = 0;
+  while (num_bytes_written < num_bytes) {
+    ssize_t rv = HANDLE_EINTR(
+        pwrite(fd, bytes + num_bytes_written, num_bytes - num_bytes_written,
+               static_cast<off_t>(position + num_bytes_written)));
+    if (rv < 0) {
+      result->num_bytes = -1;
+      result->error = errno;
+      return;
+    }
+    num_bytes_written += static_cast<size_t>(rv);
+  }
+  result->num_bytes = static_cast<ssize_t>(num_bytes_written);
+}
+
+// Copies from a file to a data pipe. Owns itself; deletes itself after running
+// the callback.
+class FileToDataPipeCopier {
+ public:
+  FileToDataPipeCopier(base::ScopedFD fd,
+                       int64_t position,
+                       int64_t num_bytes,
+                       ScopedDataPipeProducerHandle destination,
+                       scoped_refptr<base::TaskRunner> io_task_runner,
+                       const FileStreamCallback& callback)
+      : fd_(fd.Pass()),
+        position_(position),
+        num_bytes_remaining_(num_bytes),
+        destination_(destination.Pass()),
+        io_task_runner_(io_task_runner),
+        callback_(callback) {}
+
+  void CopyAvailable() {
+    if (num_bytes_remaining_ == 0) {
+      Finish(ERROR_OK);
+      return;
+    }
+
+    void* buffer = nullptr;
+    uint32_t buffer_num_bytes = 0;
+    MojoResult result = BeginWriteDataRaw(destination_.get(), &buffer,
+                                          &buffer_num_bytes,
+                                          MOJO_WRITE_DATA_FLAG_NONE);
+    if (result == MOJO_RESULT_SHOULD_WAIT) {
+      handle_watcher_.Start(
+          destination_.get(), MOJO_HANDLE_SIGNAL_WRITABLE,
+          MOJO_DEADLINE_INDEFINITE,
+          base::Bind(&FileToDataPipeCopier::OnReady, base::Unretained(this)));
+      return;
+    }
+    if (result != MOJO_RESULT_OK) {
+      // The consumer went away before we were done.
+      Finish(ERROR_CLOSED);
+      return;
+    }
+
+    size_t num_bytes_to_read = buffer_num_bytes;
+    if (num_bytes_remaining_ > 0 &&
+        static_cast<uint64_t>(num_bytes_remaining_) < num_bytes_to_read)
+      num_bytes_to_read = static_cast<size_t>(num_bytes_remaining_);
+    // Read directly into the data pipe's buffer; the two-phase write stays open
+    // until the read completes.
+    IOResult* io_result = new IOResult();
+    io_task_runner_->PostTaskAndReply(
+        FROM_HERE, base::Bind(&PReadOnIOThread, fd_.get(), buffer,
+                              num_bytes_to_read, position_, io_result),
+        base::Bind(&FileToDataPipeCopier::OnReadDone, base::Unretained(this),
+                   base::Owned(io_result)));
+  }
+
+ private:
+  ~FileToDataPipeCopier() {}
+
+  void OnReady(MojoResult result) {
+    if (result != MOJO_RESULT_OK &&
+        result != MOJO_RESULT_FAILED_PRECONDITION) {
+      Finish(ERROR_UNAVAILABLE);
+      return;
+    }
+    // On |MOJO_RESULT_FAILED_PRECONDITION|, |BeginWriteDataRaw()| will report
+    // the closed consumer.
+    CopyAvailable();
+  }
+
+  void OnReadDone(IOResult* io_result) {
+    if (io_result->num_bytes < 0) {
+      EndWriteDataRaw(destination_.get(), 0);
+      Finish(ErrnoToError(io_result->error));
+      return;
+    }
+    EndWriteDataRaw(destination_.get(),
+                    static_cast<uint32_t>(io_result->num_bytes));
+    if (io_result->num_bytes == 0) {
+      // End of file.
+      Finish(ERROR_OK);
+      return;
+    }
+
+    position_ += io_result->num_bytes;
+    if (num_bytes_remaining_ > 0)
+      num_bytes_remaining_ -= io_result->num_bytes;
+    CopyAvailable();
+  }
+
+  void Finish(Error error) {
+    callback_.Run(error);
+    delete this;
+  }
+
+  base::ScopedFD fd_;
+  int64_t position_;
+  int64_t num_bytes_remaining_;
+  ScopedDataPipeProducerHandle destination_;
+  scoped_refptr<base::TaskRunner> io_task_runner_;
+  FileStreamCallback callback_;
+  common::HandleWatcher handle_watcher_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileToDataPipeCopier);
+};
+
+// Copies from a data pipe to a file. Owns itself; deletes itself after running
+// the callback.
+class DataPipeToFileCopier {
+ public:
+  DataPipeToFileCopier(ScopedDataPipeConsumerHandle source,
+                       base::ScopedFD fd,
+                       int64_t position,
+                       scoped_refptr<base::TaskRunner> io_task_runner,
+                       const FileStreamCallback& callback)
+      : source_(source.Pass()),
+        fd_(fd.Pass()),
+        position_(position),
+        io_task_runner_(io_task_runner),
+        callback_(callback) {}
+
+  void CopyAvailable() {
+    const void* buffer = nullptr;
+    uint32_t buffer_num_bytes = 0;
+    MojoResult result = BeginReadDataRaw(
+        source_.get(), &buffer, &buffer_num_bytes, MOJO_READ_DATA_FLAG_NONE);
+    if (result == MOJO_RESULT_SHOULD_WAIT) {
+      handle_watcher_.Start(
+          source_.get(), MOJO_HANDLE_SIGNAL_READABLE, MOJO_DEADLINE_INDEFINITE,
+          base::Bind(&DataPipeToFileCopier::OnReady, base::Unretained(this)));
+      return;
+    }
+    if (result == MOJO_RESULT_FAILED_PRECONDITION) {
+      // The producer was closed and everything has been consumed.
+      Finish(ERROR_OK);
+      return;
+    }
+    if (result != MOJO_RESULT_OK) {
+      Finish(ERROR_INTERNAL);
+      return;
+    }
+
+    // Write directly from the data pipe's buffer; the two-phase read stays open
+    // until the write completes.
+    IOResult* io_result = new IOResult();
+    io_task_runner_->PostTaskAndReply(
+        FROM_HERE, base::Bind(&PWriteAllOnIOThread, fd_.get(), buffer,
+                              buffer_num_bytes, position_, io_result),
+        base::Bind(&DataPipeToFileCopier::OnWriteDone, base::Unretained(this),
+                   buffer_num_bytes, base::Owned(io_result)));
+  }
+
+ private:
+  ~DataPipeToFileCopier() {}
+
+  void OnReady(MojoResult result) {
+    if (result != MOJO_RESULT_OK &&
+        result != MOJO_RESULT_FAILED_PRECONDITION) {
+      Finish(ERROR_UNAVAILABLE);
+      return;
+    }
+    CopyAvailable();
+  }
+
+  void OnWriteDone(uint32_t num_bytes, IOResult* io_result) {
+    if (io_result->num_bytes < 0) {
+      EndReadDataRaw(source_.get(), 0);
+      Finish(ErrnoToError(io_result->error));
+      return;
+    }
+    DCHECK_EQ(static_cast<ssize_t>(num_bytes), io_result->num_bytes);
+    EndReadDataRaw(source_.get(), num_bytes);
+    position_ += num_bytes;
+    CopyAvailable();
+  }
+
+  void Finish(Error error) {
+    callback_.Run(error);
+    delete this;
+  }
+
+  ScopedDataPipeConsumerHandle source_;
+  base::ScopedFD fd_;
+  int64_t position_;
+  scoped_refptr<base::TaskRunner> io_task_runner_;
+  FileStreamCallback callback_;
+  common::HandleWatcher handle_watcher_;
+
+  DISALLOW_COPY_AND_ASSIGN(DataPipeToFileCopier);
+};
+
+}  // namespace
+
+Error GetAbsolutePosition(int fd,
+                          int64_t offset,
+                          Whence whence,
+                          int64_t* position) {
+  DCHECK(position);
+
+  int64_t base = 0;
+  switch (whence) {
+    case WHENCE_FROM_START:
+      break;
+    case WHENCE_FROM_CURRENT: {
+      off_t current = lseek(fd, 0, SEEK_CUR);
+      if (current < 0)
+        return ErrnoToError(errno);
+      base = static_cast<int64_t>(current);
+      break;
+    }
+    case WHENCE_FROM_END: {
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+        return ErrnoToError(errno);
+      base = static_cast<int64_t>(st.st_size);
+      break;
+    }
+    default:
+      return ERROR_UNIMPLEMENTED;
+  }
+
+  // Both are valid offsets, so this can only overflow (and only positively) if
+  // |offset| is positive.
+  if (offset > 0 && base > std::numeric_limits<int64_t>::max() - offset)
+    return ERROR_OUT_OF_RANGE;
+  if (base + offset < 0)
+    return ERROR_INVALID_ARGUMENT;
+  if (Error error = IsOffsetValid(base + offset))
+    return error;
+
+  *position = base + offset;
+  return ERROR_OK;
+}
+
+void CopyFileToDataPipe(base::ScopedFD fd,
+                        int64_t position,
+                        int64_t num_bytes,
+                        ScopedDataPipeProducerHandle destination,
+                        scoped_refptr<base::TaskRunner> io_task_runner,
+                        const FileStreamCallback& callback) {
+  DCHECK(fd.is_valid());
+  DCHECK_GE(position, 0);
+  (new FileToDataPipeCopier(fd.Pass(), position, num_bytes,
+                            destination.Pass(), io_task_runner, callback))
+      ->CopyAvailable();
+}
+
+void CopyDataPipeToFile(ScopedDataPipeConsumerHandle source,
+                        base::ScopedFD fd,
+                        int64_t position,
+                        scoped_refptr<base::TaskRunner> io_task_runner,
+                        const FileStreamCallback& callback) {
+  DCHECK(fd.is_valid());
+  DCHECK_GE(position, 0);
+  (new DataPipeToFileCopier(source.Pass(), fd.Pass(), position, io_task_runner,
+                            callback))->CopyAvailable();
+}
+
+}  // namespace files
+}  // namespace mojo
@@ -0,0 +1,66 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Helpers for moving file data through data pipes, used by |FileImpl|'s
+// |ReadToStream()| and |WriteFromStream()|.
+
+#ifndef SERVICES_FILES_FILE_STREAM_H_
+#define SERVICES_FILES_FILE_STREAM_H_
+
+#include <stdint.h>
+
+#include "base/files/scoped_file.h"
+#include "base/memory/ref_counted.h"
+#include "mojo/public/cpp/bindings/callback.h"
+#include "mojo/public/cpp/system/data_pipe.h"
+#include "mojo/services/files/public/interfaces/types.mojom.h"
+
+namespace base {
+class TaskRunner;
+}  // namespace base
+
+namespace mojo {
+namespace files {
+
+// Resolves |offset|/|whence| to an absolute position in the given FD (which
+// must be valid), without changing the FD's file position. (On failure,
+// returns |ERROR_INVALID_ARGUMENT| if the position would be negative, or the
+// error from looking up the current position or size.)
+Error GetAbsolutePosition(int fd,
+                          int64_t offset,
+                          Whence whence,
+                          int64_t* position);
+
+using FileStreamCallback = Callback<void(Error)>;
+
+// Asynchronously copies up to |num_bytes| bytes (or all bytes up to the end of
+// the file, if |num_bytes| is negative) starting at |position| in |fd| to
+// |destination|. Data is read directly into |destination|'s buffers (using
+// two-phase writes) with positional reads, so |fd|'s file position is neither
+// used nor changed. The reads themselves are done on |io_task_runner|.
+// |callback| is run once all data has been copied (or the end of the file was
+// reached), or with an error if reading fails or the consumer goes away early.
+// Must be called on a thread with a message loop.
+void CopyFileToDataPipe(base::ScopedFD fd,
+                        int64_t position,
+                        int64_t num_bytes,
+                        ScopedDataPipeProducerHandle destination,
+                        scoped_refptr<base::TaskRunner> io_task_runner,
+                        const FileStreamCallback& callback);
+
+// Asynchronously copies everything from |source| to |fd|, starting at
+// |position|, using positional writes directly from |source|'s buffers (using
+// two-phase reads); the writes are done on |io_task_runner|. |callback| is run
+// once the producer has been closed and all its data has been written, or with
+// an error if writing fails. Must be called on a thread with a message loop.
+void CopyDataPipeToFile(ScopedDataPipeConsumerHandle source,
+                        base::ScopedFD fd,
+                        int64_t position,
+                        scoped_refptr<base::TaskRunner> io_task_runner,
+                        const FileStreamCallback& callback);
+
+}  // namespace files
+}  // namespace mojo
+
+#endif  // SERVICES_FILES_FILE_STREAM_H_
@@ -16,6 +16,7 @@
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/posix/eintr_wrapper.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "services/files/directory_impl.h"
 
 namespace mojo {
@@ -52,8 +53,9 @@ base::ScopedFD OpenMojoDebugDirectory() {
 }  // namespace
 
 FilesImpl::FilesImpl(ApplicationConnection* connection,
-                     InterfaceRequest<Files> request)
-    : binding_(this, request.Pass()) {
+                     InterfaceRequest<Files> request,
+                     scoped_refptr<base::SequencedWorkerPool> worker_pool)
+    : binding_(this, request.Pass()), worker_pool_(worker_pool) {
   // TODO(vtl): record other app's URL
 }
 
@@ -91,7 +93,8 @@ void FilesImpl::OpenFileSystem(FileSystem file_system,
       return;
   }
 
-  new DirectoryImpl(directory.Pass(), dir_fd.Pass(), temp_dir.Pass());
+  new DirectoryImpl(directory.Pass(), dir_fd.Pass(), temp_dir.Pass(),
+                    worker_pool_);
   callback.Run(ERROR_OK);
 }
 
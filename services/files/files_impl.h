@@ -6,10 +6,15 @@
 #define SERVICES_FILES_FILES_IMPL_H_
 
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "mojo/public/cpp/bindings/interface_request.h"
 #include "mojo/public/cpp/bindings/strong_binding.h"
 #include "mojo/services/files/public/interfaces/files.mojom.h"
 
+namespace base {
+class SequencedWorkerPool;
+}  // namespace base
+
 namespace mojo {
 
 class ApplicationConnection;
@@ -18,7 +23,10 @@ namespace files {
 
 class FilesImpl : public Files {
  public:
-  FilesImpl(ApplicationConnection* connection, InterfaceRequest<Files> request);
+  // |worker_pool| is used to run blocking file operations.
+  FilesImpl(ApplicationConnection* connection,
+            InterfaceRequest<Files> request,
+            scoped_refptr<base::SequencedWorkerPool> worker_pool);
   ~FilesImpl() override;
 
   // |Files| implementation:
@@ -28,6 +36,7 @@ class FilesImpl : public Files {
 
  private:
   StrongBinding<Files> binding_;
+  scoped_refptr<base::SequencedWorkerPool> worker_pool_;
 
   DISALLOW_COPY_AND_ASSIGN(FilesImpl);
 };
@@ -3,6 +3,8 @@
 // found in the LICENSE file.
 
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "mojo/application/application_runner_chromium.h"
 #include "mojo/public/c/system/main.h"
 #include "mojo/public/cpp/application/application_connection.h"
@@ -14,10 +16,16 @@
 namespace mojo {
 namespace files {
 
+// Maximum number of threads used for blocking file operations. (Operations on
+// any single file or directory are still done in order.)
+const size_t kMaxWorkerThreads = 4;
+
 class FilesApp : public ApplicationDelegate, public InterfaceFactory<Files> {
  public:
-  FilesApp() {}
-  ~FilesApp() override {}
+  FilesApp()
+      : worker_pool_(
+            new base::SequencedWorkerPool(kMaxWorkerThreads, "FilesWorker")) {}
+  ~FilesApp() override { worker_pool_->Shutdown(); }
 
  private:
   // |ApplicationDelegate| override:
@@ -29,9 +37,11 @@ class FilesApp : public ApplicationDelegate, public InterfaceFactory<Files> {
   // |InterfaceFactory<Files>| implementation:
   void Create(ApplicationConnection* connection,
               InterfaceRequest<Files> request) override {
-    new FilesImpl(connection, request.Pass());
+    new FilesImpl(connection, request.Pass(), worker_pool_);
   }
 
+  scoped_refptr<base::SequencedWorkerPool> worker_pool_;
+
   DISALLOW_COPY_AND_ASSIGN(FilesApp);
 };
 
@@ -10,71 +10,110 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "base/bind.h"
+#include "base/location.h"
 #include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/task_runner_util.h"
 #include "services/files/futimens.h"
 #include "services/files/util.h"
 
 namespace mojo {
 namespace files {
 
-void StatFD(int fd, FileType type, const StatFDCallback& callback) {
+namespace {
+
+struct StatFDResult {
+  StatFDResult() : error(ERROR_INTERNAL) {}
+
+  Error error;
+  FileInformationPtr file_info;
+};
+
+void StatFDOnIOThread(int fd, FileType type, StatFDResult* result) {
+  result->error = StatFD(fd, type, &result->file_info);
+}
+
+void RunStatFDCallback(const StatFDCallback& callback, StatFDResult* result) {
+  callback.Run(result->error, result->file_info.Pass());
+}
+
+}  // namespace
+
+Error StatFD(int fd, FileType type, FileInformationPtr* file_info) {
   DCHECK_NE(fd, -1);
+  DCHECK(file_info);
 
   struct stat buf;
-  if (fstat(fd, &buf) != 0) {
-    callback.Run(ErrnoToError(errno), nullptr);
-    return;
-  }
+  if (fstat(fd, &buf) != 0)
+    return ErrnoToError(errno);
 
-  FileInformationPtr file_info(FileInformation::New());
-  file_info->type = type;
+  FileInformationPtr info(FileInformation::New());
+  info->type = type;
   // Only fill in |size| for files.
   if (S_ISREG(buf.st_mode)) {
-    file_info->size = static_cast<int64_t>(buf.st_size);
+    info->size = static_cast<int64_t>(buf.st_size);
   } else {
     LOG_IF(WARNING, !S_ISDIR(buf.st_mode))
         << "Unexpected fstat() of special file";
-    file_info->size = 0;
+    info->size = 0;
   }
-  file_info->atime = Timespec::New();
-  file_info->mtime = Timespec::New();
+  info->atime = Timespec::New();
+  info->mtime = Timespec::New();
 #if defined(OS_ANDROID)
-  file_info->atime->seconds = static_cast<int64_t>(buf.st_atime);
-  file_info->atime->nanoseconds = static_cast<int32_t>(buf.st_atime_nsec);
-  file_info->mtime->seconds = static_cast<int64_t>(buf.st_mtime);
-  file_info->mtime->nanoseconds = static_cast<int32_t>(buf.st_mtime_nsec);
+  info->atime->seconds = static_cast<int64_t>(buf.st_atime);
+  info->atime->nanoseconds = static_cast<int32_t>(buf.st_atime_nsec);
+  info->mtime->seconds = static_cast<int64_t>(buf.st_mtime);
+  info->mtime->nanoseconds = static_cast<int32_t>(buf.st_mtime_nsec);
 #else
-  file_info->atime->seconds = static_cast<int64_t>(buf.st_atim.tv_sec);
-  file_info->atime->nanoseconds = static_cast<int32_t>(buf.st_atim.tv_nsec);
-  file_info->mtime->seconds = static_cast<int64_t>(buf.st_mtim.tv_sec);
-  file_info->mtime->nanoseconds = static_cast<int32_t>(buf.st_mtim.tv_nsec);
+  info->atime->seconds = static_cast<int64_t>(buf.st_atim.tv_sec);
+  info->atime->nanoseconds = static_cast<int32_t>(buf.st_atim.tv_nsec);
+  info->mtime->seconds = static_cast<int64_t>(buf.st_mtim.tv_sec);
+  info->mtime->nanoseconds = static_cast<int32_t>(buf.st_mtim.tv_nsec);
 #endif
 
-  callback.Run(ERROR_OK, file_info.Pass());
+  *file_info = info.Pass();
+  return ERROR_OK;
 }
 
-void TouchFD(int fd,
-             TimespecOrNowPtr atime,
-             TimespecOrNowPtr mtime,
-             const TouchFDCallback& callback) {
+Error TouchFD(int fd, TimespecOrNowPtr atime, TimespecOrNowPtr mtime) {
   DCHECK_NE(fd, -1);
 
   struct timespec times[2];
-  if (Error error = TimespecOrNowToStandardTimespec(atime.get(), &times[0])) {
-    callback.Run(error);
-    return;
-  }
-  if (Error error = TimespecOrNowToStandardTimespec(mtime.get(), &times[1])) {
-    callback.Run(error);
-    return;
-  }
+  if (Error error = TimespecOrNowToStandardTimespec(atime.get(), &times[0]))
+    return error;
+  if (Error error = TimespecOrNowToStandardTimespec(mtime.get(), &times[1]))
+    return error;
 
-  if (futimens(fd, times) != 0) {
-    callback.Run(ErrnoToError(errno));
-    return;
-  }
+  if (futimens(fd, times) != 0)
+    return ErrnoToError(errno);
+
+  return ERROR_OK;
+}
+
+void PostStatFD(scoped_refptr<base::TaskRunner> io_task_runner,
+                int fd,
+                FileType type,
+                const StatFDCallback& callback) {
+  StatFDResult* result = new StatFDResult();
+  io_task_runner->PostTaskAndReply(
+      FROM_HERE, base::Bind(&StatFDOnIOThread, fd, type, result),
+      base::Bind(&RunStatFDCallback, callback, base::Owned(result)));
+}
+
+void PostTouchFD(scoped_refptr<base::TaskRunner> io_task_runner,
+                 int fd,
+                 TimespecOrNowPtr atime,
+                 TimespecOrNowPtr mtime,
+                 const TouchFDCallback& callback) {
+  base::PostTaskAndReplyWithResult(
+      io_task_runner.get(), FROM_HERE,
+      base::Bind(&TouchFD, fd, base::Passed(&atime), base::Passed(&mtime)),
+      base::Bind(&RunErrorCallback, callback));
+}
 
-  callback.Run(ERROR_OK);
+void RunErrorCallback(const ErrorCallback& callback, Error error) {
+  callback.Run(error);
 }
 
 }  // namespace files
@@ -8,24 +8,48 @@
 #ifndef SERVICES_FILES_SHARED_IMPL_H_
 #define SERVICES_FILES_SHARED_IMPL_H_
 
+#include "base/memory/ref_counted.h"
 #include "mojo/public/cpp/bindings/callback.h"
 #include "mojo/services/files/public/interfaces/types.mojom.h"
 
+namespace base {
+class TaskRunner;
+}  // namespace base
+
 namespace mojo {
 namespace files {
 
-// Stats the given FD (which must be valid), calling |callback| appropriately.
-// The type in the |FileInformation| given to the callback will be assigned from
-// |type|.
+// Blocking implementations. These may be run on any thread.
+
+// Stats the given FD (which must be valid). On success, sets |*file_info|, with
+// its type assigned from |type|.
+Error StatFD(int fd, FileType type, FileInformationPtr* file_info);
+
+// Touches the given FD (which must be valid).
+Error TouchFD(int fd, TimespecOrNowPtr atime, TimespecOrNowPtr mtime);
+
+// Asynchronous versions of the above: these run the blocking implementation on
+// |io_task_runner| and then run |callback| on the calling thread (which must
+// have a message loop). The FD must remain valid until the operation has run;
+// usually |io_task_runner| is the sequence that will eventually close it.
+
 using StatFDCallback = Callback<void(Error, FileInformationPtr)>;
-void StatFD(int fd, FileType type, const StatFDCallback& callback);
+void PostStatFD(scoped_refptr<base::TaskRunner> io_task_runner,
+                int fd,
+                FileType type,
+                const StatFDCallback& callback);
 
-// Touches the given FD (which must be valid), calling |callback| appropriately.
 using TouchFDCallback = Callback<void(Error)>;
-void TouchFD(int fd,
-             TimespecOrNowPtr atime,
-             TimespecOrNowPtr mtime,
-             const TouchFDCallback& callback);
+void PostTouchFD(scoped_refptr<base::TaskRunner> io_task_runner,
+                 int fd,
+                 TimespecOrNowPtr atime,
+                 TimespecOrNowPtr mtime,
+                 const TouchFDCallback& callback);
+
+// Runs |callback| with |error|; useful as the reply to an |Error|-returning
+// task posted with |base::PostTaskAndReplyWithResult()|.
+using ErrorCallback = Callback<void(Error)>;
+void RunErrorCallback(const ErrorCallback& callback, Error error);
 
 }  // namespace files
 }  // namespace mojo
@@ -4,10 +4,16 @@
 
 #include "services/http_server/connection.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/format_macros.h"
+#include "base/logging.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/stringprintf.h"
+#include "mojo/services/http_server/public/cpp/http_server_util.h"
 
 namespace http_server {
 namespace {
@@ -29,6 +35,9 @@ const char* GetHttpReasonPhrase(uint32_t code_in) {
 
 }  // namespace
 
+// static
+const size_t Connection::kMaxPipelinedRequests;
+
 Connection::Connection(mojo::TCPConnectedSocketPtr conn,
                        mojo::ScopedDataPipeProducerHandle sender,
                        mojo::ScopedDataPipeConsumerHandle receiver,
@@ -36,32 +45,121 @@ Connection::Connection(mojo::TCPConnectedSocketPtr conn,
     : connection_(conn.Pass()),
       sender_(sender.Pass()),
       receiver_(receiver.Pass()),
-      request_waiter_(
-          receiver_.get(),
-          MOJO_HANDLE_SIGNAL_READABLE,
-          base::Bind(&Connection::OnRequestDataReady, base::Unretained(this))),
-      content_length_(0),
+      receiver_closed_(false),
       handle_request_callback_(callback),
-      response_offset_(0) {
+      next_request_id_(0),
+      next_response_id_(0),
+      sending_response_(false),
+      response_headers_offset_(0),
+      content_length_(0),
+      weak_ptr_factory_(this) {
+  WaitForRequestData();
 }
 
 Connection::~Connection() {
 }
 
-void Connection::SendResponse(HttpResponsePtr response) {
+void Connection::ReadMore() {
+  while (!receiver_closed_ &&
+         pending_keep_alive_.size() < kMaxPipelinedRequests) {
+    const void* buffer = nullptr;
+    uint32_t num_bytes = 0;
+    MojoResult result = BeginReadDataRaw(receiver_.get(), &buffer, &num_bytes,
+                                         MOJO_READ_DATA_FLAG_NONE);
+    if (result == MOJO_RESULT_SHOULD_WAIT) {
+      WaitForRequestData();
+      return;
+    }
+    if (result != MOJO_RESULT_OK) {
+      // The client has closed its end.
+      receiver_closed_ = true;
+      break;
+    }
+
+    // Parse straight out of the pipe's buffer. Anything after the end of a
+    // request is left in the pipe for the next go around.
+    size_t num_bytes_consumed = 0;
+    HttpRequestParser::ParseResult parse_result = request_parser_.ProcessChunk(
+        base::StringPiece(static_cast<const char*>(buffer), num_bytes),
+        &num_bytes_consumed);
+    EndReadDataRaw(receiver_.get(), static_cast<uint32_t>(num_bytes_consumed));
+
+    if (parse_result == HttpRequestParser::PARSE_ERROR) {
+      // We can't find the start of the next request, so this is the last one.
+      receiver_closed_ = true;
+      uint32_t request_id = next_request_id_++;
+      pending_keep_alive_.push_back(false);
+      SendResponse(request_id, CreateHttpResponse(400, "Bad request\n"));
+      return;
+    }
+
+    if (parse_result == HttpRequestParser::ACCEPTED) {
+      uint32_t request_id = next_request_id_++;
+      bool keep_alive = request_parser_.keep_alive();
+      pending_keep_alive_.push_back(keep_alive);
+      if (!keep_alive)
+        receiver_closed_ = true;
+      // Note: |SendResponse()| never sends synchronously, so this can't delete
+      // |this|.
+      handle_request_callback_.Run(
+          request_parser_.GetRequest(),
+          base::Bind(&Connection::SendResponse, weak_ptr_factory_.GetWeakPtr(),
+                     request_id));
+    }
+  }
+
+  // If the pipeline is full, reading will resume once a response is sent.
+  // Otherwise we're done reading, and are only waiting for responses.
+  if (receiver_closed_ && pending_keep_alive_.empty()) {
+    DCHECK(!sending_response_);
+    delete this;
+  }
+}
+
+void Connection::OnRequestDataReady(MojoResult result) {
+  // If the client closed its end, |ReadMore()| will find out.
+  ReadMore();
+}
+
+void Connection::WaitForRequestData() {
+  request_waiter_.reset(new mojo::AsyncWaiter(
+      receiver_.get(), MOJO_HANDLE_SIGNAL_READABLE,
+      base::Bind(&Connection::OnRequestDataReady, base::Unretained(this))));
+}
+
+void Connection::SendResponse(uint32_t request_id, HttpResponsePtr response) {
+  DCHECK_GE(request_id, next_response_id_);
+  DCHECK_LT(request_id, next_request_id_);
+  DCHECK(ready_responses_.find(request_id) == ready_responses_.end());
+  ready_responses_[request_id] = response.Pass();
+
+  // Start writing (asynchronously) if this is the response we're waiting for.
+  if (!sending_response_ && request_id == next_response_id_)
+    WaitForSender();
+}
+
+void Connection::StartResponse(HttpResponsePtr response) {
+  DCHECK(!sending_response_);
+  DCHECK(!pending_keep_alive_.empty());
+
   std::string http_reason_phrase(GetHttpReasonPhrase(response->status_code));
 
+  response_headers_.clear();
+  response_headers_offset_ = 0;
   // TODO: should we send http/1.0 for http/1.0.requests?
-  base::StringAppendF(&response_, "HTTP/1.1 %d %s\r\n", response->status_code,
-                      http_reason_phrase.c_str());
-  base::StringAppendF(&response_, "Connection: close\r\n");
-
-  content_length_ = response->content_length;
-  if (content_length_) {
-    base::StringAppendF(&response_, "Content-Length: %" PRIuS "\r\n",
-                        static_cast<size_t>(content_length_));
-  }
-  base::StringAppendF(&response_, "Content-Type: %s\r\n",
+  base::StringAppendF(&response_headers_, "HTTP/1.1 %d %s\r\n",
+                      response->status_code, http_reason_phrase.c_str());
+  base::StringAppendF(
+      &response_headers_, "Connection: %s\r\n",
+      pending_keep_alive_.front() ? "keep-alive" : "close");
+
+  // Always send the length (even if zero), since the client can't use the
+  // end of the connection to find the end of the body.
+  DCHECK_GE(response->content_length, 0);
+  content_length_ = std::max(response->content_length, static_cast<int64_t>(0));
+  base::StringAppendF(&response_headers_, "Content-Length: %" PRId64 "\r\n",
+                      content_length_);
+  base::StringAppendF(&response_headers_, "Content-Type: %s\r\n",
                       response->content_type.data());
   for (auto it = response->custom_headers.begin();
        it != response->custom_headers.end(); ++it) {
@@ -69,103 +167,116 @@ void Connection::SendResponse(HttpResponsePtr response) {
     const std::string& header_value = it.GetValue();
     DCHECK(header_value.find_first_of("\n\r") == std::string::npos)
         << "Malformed header value.";
-    base::StringAppendF(&response_, "%s: %s\r\n", header_name.c_str(),
+    base::StringAppendF(&response_headers_, "%s: %s\r\n", header_name.c_str(),
                         header_value.c_str());
   }
-  base::StringAppendF(&response_, "\r\n");
+  base::StringAppendF(&response_headers_, "\r\n");
 
   content_ = response->body.Pass();
-  WriteMore();
+  sending_response_ = true;
 }
 
-void Connection::OnRequestDataReady(MojoResult result) {
-  uint32_t num_bytes = 0;
-  result =
-      ReadDataRaw(receiver_.get(), NULL, &num_bytes, MOJO_READ_DATA_FLAG_QUERY);
-  if (!num_bytes)
-    return;
+void Connection::WriteMore() {
+  while (true) {
+    if (!sending_response_) {
+      auto it = ready_responses_.find(next_response_id_);
+      if (it == ready_responses_.end())
+        return;
+      HttpResponsePtr response = it->second.Pass();
+      ready_responses_.erase(it);
+      StartResponse(response.Pass());
+    }
 
-  scoped_ptr<uint8_t[]> buffer(new uint8_t[num_bytes]);
-  result = ReadDataRaw(receiver_.get(), buffer.get(), &num_bytes,
-                       MOJO_READ_DATA_FLAG_ALL_OR_NONE);
+    uint32_t response_bytes_available = static_cast<uint32_t>(
+        response_headers_.size() - response_headers_offset_);
+    if (response_bytes_available) {
+      MojoResult result = WriteDataRaw(
+          sender_.get(), &response_headers_[response_headers_offset_],
+          &response_bytes_available, MOJO_WRITE_DATA_FLAG_NONE);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        WaitForSender();
+        return;
+      } else if (result != MOJO_RESULT_OK) {
+        LOG(ERROR) << "Error writing to pipe " << result;
+        delete this;
+        return;
+      }
 
-  request_parser_.ProcessChunk(
-      base::StringPiece(reinterpret_cast<char*>(buffer.get()), num_bytes));
-  if (request_parser_.ParseRequest() == HttpRequestParser::ACCEPTED) {
-    handle_request_callback_.Run(this, request_parser_.GetRequest());
+      response_headers_offset_ += response_bytes_available;
+      continue;
+    }
+
+    if (!WriteBody())
+      return;
+    if (!FinishResponse())
+      return;
   }
 }
 
-void Connection::WriteMore() {
-  uint32_t response_bytes_available =
-      static_cast<uint32_t>(response_.size() - response_offset_);
-  if (response_bytes_available) {
-    MojoResult result =
-        WriteDataRaw(sender_.get(), &response_[response_offset_],
-                     &response_bytes_available, 0);
+bool Connection::WriteBody() {
+  while (content_length_ > 0) {
+    const void* source = nullptr;
+    uint32_t source_num_bytes = 0;
+    MojoResult result = BeginReadDataRaw(content_.get(), &source,
+                                         &source_num_bytes,
+                                         MOJO_READ_DATA_FLAG_NONE);
     if (result == MOJO_RESULT_SHOULD_WAIT) {
-      sender_waiter_.reset(new mojo::AsyncWaiter(
-          sender_.get(), MOJO_HANDLE_SIGNAL_WRITABLE,
-          base::Bind(&Connection::OnSenderReady, base::Unretained(this))));
-      return;
-    } else if (result != MOJO_RESULT_OK) {
-      LOG(ERROR) << "Error writing to pipe " << result;
+      // Producer isn't ready yet. Wait for it.
+      response_receiver_waiter_.reset(new mojo::AsyncWaiter(
+          content_.get(), MOJO_HANDLE_SIGNAL_READABLE,
+          base::Bind(&Connection::OnResponseDataReady,
+                     base::Unretained(this))));
+      return false;
+    }
+    if (result != MOJO_RESULT_OK) {
+      // The body ended early (or there was none), so the client can't find the
+      // end of this response. The connection can't be used any further.
+      LOG(ERROR) << "Response body shorter than its Content-Length";
       delete this;
-      return;
+      return false;
     }
 
-    response_offset_ += response_bytes_available;
-  }
-
-  if (response_offset_ != response_.size()) {
-    // We have more data left in response_. Write more asynchronously.
-    sender_waiter_.reset(new mojo::AsyncWaiter(
-        sender_.get(), MOJO_HANDLE_SIGNAL_WRITABLE,
-        base::Bind(&Connection::OnSenderReady, base::Unretained(this))));
-    return;
-  }
-
-  // response_ is all sent, and there's no more data so we're done.
-  if (!content_length_) {
-    delete this;
-    return;
-  }
+    void* destination = nullptr;
+    uint32_t destination_num_bytes = 0;
+    result = BeginWriteDataRaw(sender_.get(), &destination,
+                               &destination_num_bytes,
+                               MOJO_WRITE_DATA_FLAG_NONE);
+    if (result != MOJO_RESULT_OK) {
+      EndReadDataRaw(content_.get(), 0);
+      if (result == MOJO_RESULT_SHOULD_WAIT) {
+        WaitForSender();
+        return false;
+      }
+      LOG(ERROR) << "Error writing to pipe " << result;
+      delete this;
+      return false;
+    }
 
-  // Copy data from the handler's pipe to response_.
-  const uint32_t kMaxChunkSize = 1024 * 1024;
-
-  uint32_t num_bytes_available = 0;
-  MojoResult result = ReadDataRaw(content_.get(), NULL, &num_bytes_available,
-                                  MOJO_READ_DATA_FLAG_QUERY);
-  if (result == MOJO_RESULT_SHOULD_WAIT) {
-    // Producer isn't ready yet. Wait for it.
-    response_receiver_waiter_.reset(new mojo::AsyncWaiter(
-        content_.get(), MOJO_HANDLE_SIGNAL_READABLE,
-        base::Bind(&Connection::OnResponseDataReady, base::Unretained(this))));
-    return;
+    uint32_t num_bytes = std::min(source_num_bytes, destination_num_bytes);
+    if (static_cast<int64_t>(num_bytes) > content_length_)
+      num_bytes = static_cast<uint32_t>(content_length_);
+    memcpy(destination, source, num_bytes);
+    EndWriteDataRaw(sender_.get(), num_bytes);
+    EndReadDataRaw(content_.get(), num_bytes);
+    content_length_ -= num_bytes;
   }
+  return true;
+}
 
-  DCHECK_EQ(result, MOJO_RESULT_OK);
-  num_bytes_available = std::min(num_bytes_available, kMaxChunkSize);
-
-  response_.resize(num_bytes_available);
-  response_offset_ = 0;
-  content_length_ -= num_bytes_available;
-
-  result = ReadDataRaw(content_.get(), &response_[0], &num_bytes_available,
-                       MOJO_READ_DATA_FLAG_ALL_OR_NONE);
-  DCHECK_EQ(result, MOJO_RESULT_OK);
+void Connection::WaitForSender() {
   sender_waiter_.reset(new mojo::AsyncWaiter(
       sender_.get(), MOJO_HANDLE_SIGNAL_WRITABLE,
       base::Bind(&Connection::OnSenderReady, base::Unretained(this))));
 }
 
 void Connection::OnResponseDataReady(MojoResult result) {
-  if (result != MOJO_RESULT_OK) {
+  if (result != MOJO_RESULT_OK && result != MOJO_RESULT_FAILED_PRECONDITION) {
     LOG(ERROR) << "Error waiting to read data " << result;
     delete this;
     return;
   }
+  // On |MOJO_RESULT_FAILED_PRECONDITION|, |WriteBody()| will find that the
+  // body ended early.
   WriteMore();
 }
 
@@ -178,4 +289,28 @@ void Connection::OnSenderReady(MojoResult result) {
   WriteMore();
 }
 
+bool Connection::FinishResponse() {
+  DCHECK(sending_response_);
+  DCHECK(!pending_keep_alive_.empty());
+
+  sending_response_ = false;
+  response_headers_.clear();
+  response_headers_offset_ = 0;
+  content_.reset();
+
+  bool keep_alive = pending_keep_alive_.front();
+  pending_keep_alive_.pop_front();
+  next_response_id_++;
+
+  if (!keep_alive || (receiver_closed_ && pending_keep_alive_.empty())) {
+    delete this;
+    return false;
+  }
+
+  // There's room in the pipeline for another request.
+  if (!receiver_closed_)
+    WaitForRequestData();
+  return true;
+}
+
 }  // namespace http_server
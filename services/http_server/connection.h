@@ -5,8 +5,16 @@
 #ifndef SERVICES_HTTP_SERVER_CONNECTION_H_
 #define SERVICES_HTTP_SERVER_CONNECTION_H_
 
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <string>
+
 #include "base/callback.h"
+#include "base/macros.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
 #include "mojo/public/cpp/environment/async_waiter.h"
 #include "mojo/public/cpp/system/data_pipe.h"
 #include "mojo/services/http_server/public/interfaces/http_request.mojom.h"
@@ -18,11 +26,24 @@ namespace http_server {
 
 // Represents one connection to a client. This connection will manage its own
 // lifetime and will delete itself when the connection is closed.
+//
+// Connections are persistent (unless the client asks otherwise) and requests
+// may be pipelined: up to |kMaxPipelinedRequests| requests are handed out
+// before their responses are sent, and the responses are sent in request
+// order.
 class Connection {
  public:
-  // Callback called when a request is parsed. Response should be sent
-  // using Connection::SendResponse() on the |connection| argument.
-  typedef base::Callback<void(Connection*, HttpRequestPtr)> Callback;
+  // Callback used to send the response to a request. It may be run at most
+  // once, and does nothing if the connection has gone away in the meantime.
+  typedef base::Callback<void(HttpResponsePtr)> ResponseCallback;
+
+  // Callback called when a request is parsed. Response should be sent using
+  // the given |ResponseCallback|.
+  typedef base::Callback<void(HttpRequestPtr, const ResponseCallback&)>
+      Callback;
+
+  // Maximum number of requests awaiting responses at any one time.
+  static const size_t kMaxPipelinedRequests = 16;
 
   Connection(mojo::TCPConnectedSocketPtr conn,
              mojo::ScopedDataPipeProducerHandle sender,
@@ -31,26 +52,82 @@ class Connection {
 
   ~Connection();
 
-  void SendResponse(HttpResponsePtr response);
-
  private:
+  // Parses and dispatches requests from the request data currently available
+  // (directly from the receiver's buffer), until more data is needed or too
+  // many requests are pending.
+  void ReadMore();
+
   // Called when we have more data available from the request.
   void OnRequestDataReady(MojoResult result);
 
+  // (Re)starts waiting for the receiver to be readable.
+  void WaitForRequestData();
+
+  // Queues the response to the request with the given |request_id|.
+  void SendResponse(uint32_t request_id, HttpResponsePtr response);
+
+  // Starts sending the response |response|: formats its headers and takes its
+  // body.
+  void StartResponse(HttpResponsePtr response);
+
+  // Writes as much of the pending response(s) as possible.
   void WriteMore();
 
+  // Writes body data directly from the handler's pipe into the sender's pipe
+  // (using two-phase reads/writes, so without intermediate buffers). Returns
+  // true once the whole body has been written, and false if it had to wait (or
+  // the connection was closed).
+  bool WriteBody();
+
+  // (Re)starts waiting for the sender to be writable.
+  void WaitForSender();
+
   void OnResponseDataReady(MojoResult result);
 
   void OnSenderReady(MojoResult result);
 
+  // Called once the current response has been completely sent. Returns false
+  // if the connection was closed (and |this| deleted).
+  bool FinishResponse();
+
   mojo::TCPConnectedSocketPtr connection_;
   mojo::ScopedDataPipeProducerHandle sender_;
   mojo::ScopedDataPipeConsumerHandle receiver_;
 
   // Used to wait for the request data.
-  mojo::AsyncWaiter request_waiter_;
+  scoped_ptr<mojo::AsyncWaiter> request_waiter_;
+
+  // Set once the client has closed its end (or a request asked for the
+  // connection to be closed, or we failed to parse a request); no more
+  // requests will be read.
+  bool receiver_closed_;
+
+  HttpRequestParser request_parser_;
 
-  int content_length_;
+  // Callback to run once all of the request has been read.
+  const Callback handle_request_callback_;
+
+  // ID to give the next request dispatched.
+  uint32_t next_request_id_;
+  // ID of the request whose response is to be sent next.
+  uint32_t next_response_id_;
+  // For each request without a (completely sent) response, in order, whether
+  // the connection should be kept alive after the response.
+  std::deque<bool> pending_keep_alive_;
+  // Responses that are ready but can't be sent yet (since responses to earlier
+  // requests haven't been sent), keyed by request ID.
+  std::map<uint32_t, HttpResponsePtr> ready_responses_;
+
+  // Whether we're in the middle of sending a response.
+  bool sending_response_;
+
+  // Headers of the current response, and how much of them has been written.
+  std::string response_headers_;
+  size_t response_headers_offset_;
+
+  // Body of the current response, and how much of it remains to be written.
+  int64_t content_length_;
   mojo::ScopedDataPipeConsumerHandle content_;
 
   // Used to wait for the response data to send.
@@ -59,15 +136,9 @@ class Connection {
   // Used to wait for the sender to be ready to accept more data.
   scoped_ptr<mojo::AsyncWaiter> sender_waiter_;
 
-  HttpRequestParser request_parser_;
-
-  // Callback to run once all of the request has been read.
-  const Callback handle_request_callback_;
+  base::WeakPtrFactory<Connection> weak_ptr_factory_;
 
-  // Contains response data to write to the pipe. Initially it is the headers,
-  // and then when they're written it contains chunks of the body.
-  std::string response_;
-  size_t response_offset_;
+  DISALLOW_COPY_AND_ASSIGN(Connection);
 };
 
 }  // namespace http_server
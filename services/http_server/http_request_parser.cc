@@ -5,6 +5,7 @@
 #include "services/http_server/http_request_parser.h"
 
 #include <algorithm>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/strings/string_number_conversions.h"
@@ -16,120 +17,198 @@ namespace http_server {
 
 namespace {
 
-size_t kRequestSizeLimit = 64 * 1024 * 1024;  // 64 mb.
+const size_t kRequestSizeLimit = 64 * 1024 * 1024;  // 64 mb.
+// Limit on the size of the request line and headers (which we buffer).
+const size_t kHeadersSizeLimit = 64 * 1024;  // 64 kb.
 
 // Helper function used to trim tokens in http request headers.
-std::string Trim(const std::string& value) {
-  std::string result;
-  base::TrimString(value, " \t", &result);
-  return result;
+base::StringPiece Trim(base::StringPiece value) {
+  while (!value.empty() && (value[0] == ' ' || value[0] == '\t'))
+    value.remove_prefix(1);
+  while (!value.empty() &&
+         (value[value.size() - 1] == ' ' || value[value.size() - 1] == '\t'))
+    value.remove_suffix(1);
+  return value;
+}
+
+// Looks up a header by (case-insensitive) name. Returns null if not present.
+const mojo::String* FindHeader(const mojo::Map<mojo::String, mojo::String>& map,
+                               const char* lowercase_name) {
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    if (base::LowerCaseEqualsASCII(it.GetKey().get(), lowercase_name))
+      return &it.GetValue();
+  }
+  return nullptr;
 }
 
 }  // namespace
 
 HttpRequestParser::HttpRequestParser()
     : http_request_(HttpRequest::New()),
-      buffer_position_(0),
-      state_(STATE_HEADERS),
+      state_(STATE_REQUEST_LINE),
+      header_bytes_(0),
+      is_http_1_1_(false),
+      keep_alive_(false),
       remaining_content_bytes_(0) {
 }
 
 HttpRequestParser::~HttpRequestParser() {
 }
 
-void HttpRequestParser::ProcessChunk(const base::StringPiece& data) {
-  data.AppendToString(&buffer_);
-  DCHECK_LE(buffer_.size() + data.size(), kRequestSizeLimit) <<
-      "The HTTP request is too large.";
+HttpRequestParser::ParseResult HttpRequestParser::ProcessChunk(
+    const base::StringPiece& data,
+    size_t* num_bytes_consumed) {
+  DCHECK(num_bytes_consumed);
+  DCHECK_NE(STATE_ACCEPTED, state_);
+  DCHECK_NE(STATE_ERROR, state_);
+
+  size_t position = 0;
+  while (position < data.size()) {
+    if (state_ == STATE_CONTENT) {
+      size_t num_bytes = 0;
+      ParseResult result = ParseContent(data.substr(position), &num_bytes);
+      position += num_bytes;
+      if (result != WAITING) {
+        *num_bytes_consumed = position;
+        return result;
+      }
+      continue;
+    }
+
+    size_t eoln_position = data.find('\n', position);
+    size_t line_end =
+        eoln_position == base::StringPiece::npos ? data.size() : eoln_position;
+    header_bytes_ += line_end - position;
+    if (header_bytes_ > kHeadersSizeLimit) {
+      LOG(ERROR) << "HTTP request headers are too large.";
+      state_ = STATE_ERROR;
+      *num_bytes_consumed = position;
+      return PARSE_ERROR;
+    }
+
+    if (eoln_position == base::StringPiece::npos) {
+      // Keep the partial line until the rest of it arrives.
+      data.substr(position).AppendToString(&partial_line_);
+      position = data.size();
+      break;
+    }
+
+    base::StringPiece line = data.substr(position, line_end - position);
+    if (!partial_line_.empty()) {
+      line.AppendToString(&partial_line_);
+      line = partial_line_;
+    }
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.remove_suffix(1);
+    position = eoln_position + 1;
+
+    ParseResult result = ParseLine(line);
+    partial_line_.clear();
+    if (result != WAITING) {
+      *num_bytes_consumed = position;
+      return result;
+    }
+  }
+
+  *num_bytes_consumed = position;
+  return WAITING;
 }
 
-std::string HttpRequestParser::ShiftLine() {
-  size_t eoln_position = buffer_.find("\r\n", buffer_position_);
-  DCHECK_NE(std::string::npos, eoln_position);
-  const int line_length = eoln_position - buffer_position_;
-  std::string result = buffer_.substr(buffer_position_, line_length);
-  buffer_position_ += line_length + 2;
-  return result;
+HttpRequestParser::ParseResult HttpRequestParser::ParseLine(
+    const base::StringPiece& line) {
+  if (state_ == STATE_REQUEST_LINE) {
+    // Be lenient about empty lines between (pipelined) requests.
+    if (line.empty())
+      return WAITING;
+    return ParseRequestLine(line);
+  }
+
+  DCHECK_EQ(STATE_HEADERS, state_);
+  if (line.empty())
+    return FinishHeaders();
+  return ParseHeaderLine(line);
 }
 
-HttpRequestParser::ParseResult HttpRequestParser::ParseRequest() {
-  DCHECK_NE(STATE_ACCEPTED, state_);
-  // Parse the request from beginning. However, entire request may not be
-  // available in the buffer.
-  if (state_ == STATE_HEADERS) {
-    ParseResult parse_result = ParseHeaders();
-    if (parse_result == ACCEPTED || parse_result == PARSE_ERROR)
-      return parse_result;
+HttpRequestParser::ParseResult HttpRequestParser::ParseRequestLine(
+    const base::StringPiece& line) {
+  std::vector<std::string> tokens;
+  base::SplitString(line.as_string(), ' ', &tokens);
+  if (tokens.size() != 3u) {
+    LOG(ERROR) << "Malformed request line: " << line;
+    state_ = STATE_ERROR;
+    return PARSE_ERROR;
   }
-  // This should not be 'else if' of the previous block, as |state_| can be
-  // changed in ParseHeaders().
-  if (state_ == STATE_CONTENT) {
-    if (ParseContent() == ACCEPTED)
-      return ACCEPTED;
+
+  // Method.
+  http_request_->method = tokens[0];
+  // Address.
+  // Don't build an absolute URL as the parser does not know (should not
+  // know) anything about the server address.
+  http_request_->relative_url = tokens[1];
+  // Protocol.
+  const std::string protocol = base::StringToLowerASCII(tokens[2]);
+  if (protocol != "http/1.0" && protocol != "http/1.1") {
+    LOG(ERROR) << "Protocol not supported: " << protocol;
+    state_ = STATE_ERROR;
+    return PARSE_ERROR;
   }
+  is_http_1_1_ = (protocol == "http/1.1");
+
+  state_ = STATE_HEADERS;
   return WAITING;
 }
 
-HttpRequestParser::ParseResult HttpRequestParser::ParseHeaders() {
-  // Check if the all request headers are available.
-  if (buffer_.find("\r\n\r\n", buffer_position_) == std::string::npos)
+HttpRequestParser::ParseResult HttpRequestParser::ParseHeaderLine(
+    const base::StringPiece& line) {
+  if (line[0] == ' ' || line[0] == '\t') {
+    // Continuation of the previous multi-line header.
+    if (header_name_.empty()) {
+      LOG(ERROR) << "Header continuation without a header.";
+      state_ = STATE_ERROR;
+      return PARSE_ERROR;
+    }
+    std::string old_value = http_request_->headers[header_name_];
+    http_request_->headers[header_name_] =
+        old_value + " " + Trim(line.substr(1)).as_string();
     return WAITING;
+  }
 
-  // Parse request's the first header line.
-  // Request main main header, eg. GET /foobar.html HTTP/1.1
-  {
-    const std::string header_line = ShiftLine();
-    std::vector<std::string> header_line_tokens;
-    base::SplitString(header_line, ' ', &header_line_tokens);
-    DCHECK_EQ(3u, header_line_tokens.size());
-    // Method.
-    http_request_->method = header_line_tokens[0];
-    // Address.
-    // Don't build an absolute URL as the parser does not know (should not
-    // know) anything about the server address.
-    http_request_->relative_url = header_line_tokens[1];
-    // Protocol.
-    const std::string protocol =
-        base::StringToLowerASCII(header_line_tokens[2]);
-    CHECK(protocol == "http/1.0" || protocol == "http/1.1") <<
-        "Protocol not supported: " << protocol;
+  // New header.
+  size_t delimiter_pos = line.find(':');
+  if (delimiter_pos == base::StringPiece::npos) {
+    LOG(ERROR) << "Syntax error in header: " << line;
+    state_ = STATE_ERROR;
+    return PARSE_ERROR;
   }
+  header_name_ = Trim(line.substr(0, delimiter_pos)).as_string();
+  http_request_->headers[header_name_] =
+      Trim(line.substr(delimiter_pos + 1)).as_string();
+  return WAITING;
+}
 
-  // Parse further headers.
-  {
-    std::string header_name;
-    while (true) {
-      std::string header_line = ShiftLine();
-      if (header_line.empty())
-        break;
-
-      if (header_line[0] == ' ' || header_line[0] == '\t') {
-        // Continuation of the previous multi-line header.
-        std::string header_value =
-            Trim(header_line.substr(1, header_line.size() - 1));
-        std::string old_value = http_request_->headers[header_name];
-        http_request_->headers[header_name] = old_value + " " + header_value;
-      } else {
-        // New header.
-        size_t delimiter_pos = header_line.find(":");
-        DCHECK_NE(std::string::npos, delimiter_pos) << "Syntax error.";
-        header_name = Trim(header_line.substr(0, delimiter_pos));
-        std::string header_value = Trim(header_line.substr(
-            delimiter_pos + 1,
-            header_line.size() - delimiter_pos - 1));
-        http_request_->headers[header_name] = header_value;
-      }
-    }
+HttpRequestParser::ParseResult HttpRequestParser::FinishHeaders() {
+  // HTTP/1.1 connections are persistent unless the client says otherwise;
+  // HTTP/1.0 connections are only if the client asks.
+  keep_alive_ = is_http_1_1_;
+  if (const mojo::String* connection =
+          FindHeader(http_request_->headers, "connection")) {
+    if (base::LowerCaseEqualsASCII(connection->get(), "close"))
+      keep_alive_ = false;
+    else if (base::LowerCaseEqualsASCII(connection->get(), "keep-alive"))
+      keep_alive_ = true;
   }
 
   // Headers done. Is any content data attached to the request?
   size_t declared_content_length = 0;
-  if (http_request_->headers.find("Content-Length") !=
-      http_request_->headers.end()) {
-    const bool success = base::StringToSizeT(
-        http_request_->headers["Content-Length"].To<std::string>(),
-        &declared_content_length);
-    DCHECK(success) << "Malformed Content-Length header's value.";
+  if (const mojo::String* content_length =
+          FindHeader(http_request_->headers, "content-length")) {
+    if (!base::StringToSizeT(content_length->get(),
+                             &declared_content_length) ||
+        declared_content_length > kRequestSizeLimit) {
+      LOG(ERROR) << "Bad Content-Length: " << content_length->get();
+      state_ = STATE_ERROR;
+      return PARSE_ERROR;
+    }
   }
   if (declared_content_length == 0) {
     // No content data, so parsing is finished.
@@ -139,15 +218,17 @@ HttpRequestParser::ParseResult HttpRequestParser::ParseHeaders() {
 
   // If we ever want to support really large content length (currently pipe max
   // 256 MB), then we'll have to stream data from parser to handler.
-  MojoCreateDataPipeOptions options = {sizeof(MojoCreateDataPipeOptions),
-                                       MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,
-                                       1,
-                                       declared_content_length};
+  MojoCreateDataPipeOptions options = {
+      sizeof(MojoCreateDataPipeOptions),
+      MOJO_CREATE_DATA_PIPE_OPTIONS_FLAG_NONE,
+      1,
+      static_cast<uint32_t>(declared_content_length)};
   MojoResult result = CreateDataPipe(
       &options, &producer_handle_, &http_request_->body);
   if (result != MOJO_RESULT_OK) {
     NOTREACHED() << "Couldn't create data pipe of size "
                  << declared_content_length;
+    state_ = STATE_ERROR;
     return PARSE_ERROR;
   }
 
@@ -158,18 +239,19 @@ HttpRequestParser::ParseResult HttpRequestParser::ParseHeaders() {
   return WAITING;
 }
 
-HttpRequestParser::ParseResult HttpRequestParser::ParseContent() {
-  // Bytes available for read in the input buffer.
-  const size_t available_bytes = buffer_.size() - buffer_position_;
-  uint32_t fetch_bytes = std::min(available_bytes, remaining_content_bytes_);
+HttpRequestParser::ParseResult HttpRequestParser::ParseContent(
+    const base::StringPiece& data,
+    size_t* num_bytes_consumed) {
+  uint32_t fetch_bytes = static_cast<uint32_t>(
+      std::min(data.size(), remaining_content_bytes_));
 
-  MojoResult result = WriteDataRaw(
-      producer_handle_.get(),
-      buffer_.data() + buffer_position_,
-      &fetch_bytes,
-      MOJO_WRITE_DATA_FLAG_ALL_OR_NONE);
+  // The pipe was created large enough for all of the content (and the consumer
+  // isn't handed out until the request is accepted), so this can't fail.
+  MojoResult result = WriteDataRaw(producer_handle_.get(), data.data(),
+                                   &fetch_bytes,
+                                   MOJO_WRITE_DATA_FLAG_ALL_OR_NONE);
   DCHECK_EQ(result, MOJO_RESULT_OK);
-  buffer_position_ += fetch_bytes;
+  *num_bytes_consumed = fetch_bytes;
   remaining_content_bytes_ -= fetch_bytes;
 
   if (remaining_content_bytes_ == 0) {
@@ -178,13 +260,21 @@ HttpRequestParser::ParseResult HttpRequestParser::ParseContent() {
     return ACCEPTED;
   }
 
-  state_ = STATE_CONTENT;
   return WAITING;
 }
 
 HttpRequestPtr HttpRequestParser::GetRequest() {
   DCHECK_EQ(STATE_ACCEPTED, state_);
-  return http_request_.Pass();
+  HttpRequestPtr request = http_request_.Pass();
+
+  // Get ready for the next request on the connection.
+  http_request_ = HttpRequest::New();
+  state_ = STATE_REQUEST_LINE;
+  header_bytes_ = 0;
+  header_name_.clear();
+  is_http_1_1_ = false;
+  remaining_content_bytes_ = 0;
+  return request.Pass();
 }
 
 }  // namespace http_server
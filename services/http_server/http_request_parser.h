@@ -5,7 +5,6 @@
 #ifndef SERVICES_HTTP_SERVER_HTTP_REQUEST_PARSER_H_
 #define SERVICES_HTTP_SERVER_HTTP_REQUEST_PARSER_H_
 
-#include <map>
 #include <string>
 
 #include "base/basictypes.h"
@@ -14,8 +13,11 @@
 
 namespace http_server {
 
-// Parses the input data and produces a valid HttpRequest object. If there is
-// more than one request in one chunk, then only the first one will be parsed.
+// Incrementally parses a stream of HTTP requests. Data is parsed directly from
+// the chunks given to |ProcessChunk()|; only a header line that straddles two
+// chunks is copied. Request bodies are written straight into the request's
+// body data pipe. Parsing stops at the end of each request, so that pipelined
+// requests can be handled one at a time.
 class HttpRequestParser {
  public:
   // Parsing result.
@@ -28,44 +30,65 @@ class HttpRequestParser {
   HttpRequestParser();
   ~HttpRequestParser();
 
-  // Adds chunk of data into the internal buffer.
-  void ProcessChunk(const base::StringPiece& data);
-
-  // Parses the http request (including data - if provided).
-  // If returns ACCEPTED, then it means that the whole request has been found
-  // in the internal buffer (and parsed).
-  ParseResult ParseRequest();
-
-  // Retrieves parsed request. Can be only called when the parser is in
-  // STATE_ACCEPTED state.
+  // Parses as much of |data| as belongs to the current request, and sets
+  // |*num_bytes_consumed| to the number of bytes used. Returns ACCEPTED once
+  // the whole request has been parsed; any bytes after it (i.e., the start of
+  // the next pipelined request) are left unconsumed. Returns WAITING if all of
+  // |data| was consumed without completing the request. After PARSE_ERROR, the
+  // parser may not be used again.
+  ParseResult ProcessChunk(const base::StringPiece& data,
+                           size_t* num_bytes_consumed);
+
+  // Retrieves the parsed request and resets the parser for the next request.
+  // Can be only called when the parser is in STATE_ACCEPTED state.
   HttpRequestPtr GetRequest();
 
+  // Whether the connection should be kept open after responding to the request
+  // most recently accepted (based on its protocol version and "Connection"
+  // header).
+  bool keep_alive() const { return keep_alive_; }
+
  private:
   // Parser state.
   enum State {
+    STATE_REQUEST_LINE,  // Waiting for the request line.
     STATE_HEADERS,  // Waiting for a request headers.
     STATE_CONTENT,  // Waiting for content data.
     STATE_ACCEPTED,  // Request has been parsed.
+    STATE_ERROR,  // There was an error parsing the request.
   };
 
-  // Parses headers and returns ACCEPTED if whole request was parsed. Otherwise
-  // returns WAITING.
-  ParseResult ParseHeaders();
+  // Parses a single line (excluding the line terminator).
+  ParseResult ParseLine(const base::StringPiece& line);
+
+  // Parses the request line, e.g., "GET /foobar.html HTTP/1.1".
+  ParseResult ParseRequestLine(const base::StringPiece& line);
+
+  // Parses a header line (possibly a continuation of the previous header).
+  ParseResult ParseHeaderLine(const base::StringPiece& line);
 
-  // Parses request's content data and returns ACCEPTED if all of it have been
-  // processed. Chunked Transfer Encoding *is not* supported.
-  ParseResult ParseContent();
+  // Called at the end of the headers. Returns ACCEPTED if there's no content,
+  // and otherwise sets up the body data pipe and returns WAITING.
+  ParseResult FinishHeaders();
 
-  // Fetches the next line from the buffer. Result does not contain \r\n.
-  // Returns an empty string for an empty line. It will assert if there is
-  // no line available.
-  std::string ShiftLine();
+  // Writes content data from |data| to the request's body, consuming at most
+  // the remaining content. Returns ACCEPTED once all of it has been written.
+  // Chunked Transfer Encoding *is not* supported.
+  ParseResult ParseContent(const base::StringPiece& data,
+                           size_t* num_bytes_consumed);
 
   HttpRequestPtr http_request_;
   mojo::ScopedDataPipeProducerHandle producer_handle_;
-  std::string buffer_;
-  size_t buffer_position_;  // Current position in the internal buffer.
   State state_;
+  // Part of a line that didn't fit in the previous chunk(s).
+  std::string partial_line_;
+  // Total size of the request line and headers seen so far.
+  size_t header_bytes_;
+  // Name of the last header, for multi-line headers.
+  std::string header_name_;
+  // Whether the request's protocol is HTTP/1.1 (as opposed to HTTP/1.0).
+  bool is_http_1_1_;
+  bool keep_alive_;
   // Remaining bytes of the request content not yet put onto request->body.
   size_t remaining_content_bytes_;
 
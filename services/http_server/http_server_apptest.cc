@@ -2,6 +2,10 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
+#include <string>
+
 #include "base/bind.h"
 #include "base/run_loop.h"
 #include "base/strings/stringprintf.h"
@@ -202,4 +206,73 @@ TEST_F(HttpServerApplicationTest, PostData) {
   run_loop.Run();
 }
 
+// Verifies that the server keeps the connection open and responds, in order, to
+// requests pipelined on it.
+TEST_F(HttpServerApplicationTest, PipelinedRequests) {
+  http_server::HttpServerPtr http_server(CreateHttpServer());
+  uint16_t assigned_port;
+  http_server->GetPort([&assigned_port](uint16_t p) { assigned_port = p; });
+  http_server.WaitForIncomingMethodCall();
+
+  HttpHandlerPtr http_handler_ptr;
+  GetHandler handler(GetProxy(&http_handler_ptr).Pass());
+
+  // Set the test handler and wait for confirmation.
+  http_server->SetHandler("/test", http_handler_ptr.Pass(),
+                          [](bool result) { EXPECT_TRUE(result); });
+  http_server.WaitForIncomingMethodCall();
+
+  mojo::NetAddressPtr remote_address(mojo::NetAddress::New());
+  remote_address->family = mojo::NET_ADDRESS_FAMILY_IPV4;
+  remote_address->ipv4 = mojo::NetAddressIPv4::New();
+  remote_address->ipv4->addr.resize(4);
+  remote_address->ipv4->addr[0] = 127;
+  remote_address->ipv4->addr[1] = 0;
+  remote_address->ipv4->addr[2] = 0;
+  remote_address->ipv4->addr[3] = 1;
+  remote_address->ipv4->port = assigned_port;
+
+  mojo::DataPipe send_pipe;
+  mojo::DataPipe receive_pipe;
+  mojo::TCPConnectedSocketPtr socket;
+  network_service_->CreateTCPConnectedSocket(
+      remote_address.Pass(), send_pipe.consumer_handle.Pass(),
+      receive_pipe.producer_handle.Pass(), GetProxy(&socket),
+      [](mojo::NetworkErrorPtr err, mojo::NetAddressPtr local_address) {
+        EXPECT_EQ(0, err->code);
+      });
+  ASSERT_TRUE(network_service_.WaitForIncomingMethodCall());
+
+  // Send both requests at once; the second one asks for the connection to be
+  // closed afterwards.
+  const std::string requests =
+      "GET /test HTTP/1.1\r\nHost: localhost\r\n\r\n"
+      "GET /test HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+  uint32_t num_bytes = static_cast<uint32_t>(requests.size());
+  ASSERT_EQ(MOJO_RESULT_OK,
+            WriteDataRaw(send_pipe.producer_handle.get(), requests.data(),
+                         &num_bytes, MOJO_WRITE_DATA_FLAG_ALL_OR_NONE));
+
+  // Both requests should arrive over the same connection.
+  ASSERT_TRUE(handler.WaitForIncomingMethodCall());
+  ASSERT_TRUE(handler.WaitForIncomingMethodCall());
+
+  std::string response;
+  mojo::common::BlockingCopyToString(receive_pipe.consumer_handle.Pass(),
+                                     &response);
+  size_t first_response = response.find("HTTP/1.1 200 OK\r\n");
+  ASSERT_NE(std::string::npos, first_response);
+  size_t second_response =
+      response.find("HTTP/1.1 200 OK\r\n", first_response + 1);
+  ASSERT_NE(std::string::npos, second_response);
+  EXPECT_NE(std::string::npos, response.find(kExampleMessage, first_response));
+  EXPECT_NE(std::string::npos,
+            response.find("Connection: keep-alive\r\n", first_response));
+  EXPECT_LT(response.find("Connection: keep-alive\r\n"), second_response);
+  EXPECT_NE(std::string::npos,
+            response.find("Connection: close\r\n", second_response));
+  EXPECT_EQ(std::string(kExampleMessage),
+            response.substr(response.size() - strlen(kExampleMessage)));
+}
+
 }  // namespace http_server
@@ -38,12 +38,15 @@ void HttpServerImpl::SetHandler(const mojo::String& path,
                                 HttpHandlerPtr http_handler,
                                 const mojo::Callback<void(bool)>& callback) {
   for (const auto& handler : handlers_) {
-    if (handler->pattern->pattern() == path)
+    if (handler->pattern == path) {
       callback.Run(false);
+      return;
+    }
   }
 
   http_handler.set_error_handler(this);
   handlers_.push_back(new Handler(path, http_handler.Pass()));
+  RebuildRoutes();
   callback.Run(true);
 }
 
@@ -60,6 +63,7 @@ void HttpServerImpl::OnConnectionError() {
       std::remove_if(handlers_.begin(), handlers_.end(), [](Handler* h) {
     return h->http_handler.encountered_error();
   }), handlers_.end());
+  RebuildRoutes();
 
   if (handlers_.empty()) {
     // The call deregisters the server from the factory and deletes |this|.
@@ -140,28 +144,30 @@ void HttpServerImpl::Start() {
   WaitForNextConnection();
 }
 
-void HttpServerImpl::HandleRequest(Connection* connection,
-                                   HttpRequestPtr request) {
-  for (auto& handler : handlers_) {
-    if (RE2::FullMatch(request->relative_url.data(), *handler->pattern)) {
-      handler->http_handler->HandleRequest(
-          request.Pass(), base::Bind(&HttpServerImpl::OnResponse,
-                                     base::Unretained(this), connection));
-      return;
-    }
-  }
-
-  connection->SendResponse(CreateHttpResponse(404, "No registered handler\n"));
+void HttpServerImpl::RebuildRoutes() {
+  std::vector<std::string> patterns;
+  patterns.reserve(handlers_.size());
+  for (const auto& handler : handlers_)
+    patterns.push_back(handler->pattern);
+  routes_.reset(new RouteTable(patterns));
 }
 
-void HttpServerImpl::OnResponse(Connection* connection,
-                                HttpResponsePtr response) {
-  connection->SendResponse(response.Pass());
+void HttpServerImpl::HandleRequest(
+    HttpRequestPtr request,
+    const Connection::ResponseCallback& callback) {
+  int index = routes_ ? routes_->Match(request->relative_url.get()) : -1;
+  if (index >= 0) {
+    // |callback| is safe to run even if the connection has gone away.
+    handlers_[index]->http_handler->HandleRequest(request.Pass(), callback);
+    return;
+  }
+
+  callback.Run(CreateHttpResponse(404, "No registered handler\n"));
 }
 
 HttpServerImpl::Handler::Handler(const std::string& pattern,
                                  HttpHandlerPtr http_handler)
-    : pattern(new RE2(pattern.c_str())), http_handler(http_handler.Pass()) {
+    : pattern(pattern), http_handler(http_handler.Pass()) {
 }
 
 HttpServerImpl::Handler::~Handler() {
@@ -13,7 +13,8 @@
 #include "mojo/services/http_server/public/interfaces/http_server.mojom.h"
 #include "mojo/services/network/public/interfaces/net_address.mojom.h"
 #include "mojo/services/network/public/interfaces/network_service.mojom.h"
-#include "third_party/re2/re2/re2.h"
+#include "services/http_server/connection.h"
+#include "services/http_server/route_table.h"
 
 namespace mojo {
 class ApplicationImpl;
@@ -21,7 +22,6 @@ class ApplicationImpl;
 
 namespace http_server {
 
-class Connection;
 class HttpServerFactoryImpl;
 
 class HttpServerImpl : public HttpServer, public mojo::ErrorHandler {
@@ -56,14 +56,16 @@ class HttpServerImpl : public HttpServer, public mojo::ErrorHandler {
 
   void Start();
 
-  void HandleRequest(Connection* connection, HttpRequestPtr request);
+  // Rebuilds |routes_| from |handlers_|.
+  void RebuildRoutes();
 
-  void OnResponse(Connection* connection, HttpResponsePtr response);
+  void HandleRequest(HttpRequestPtr request,
+                     const Connection::ResponseCallback& callback);
 
   struct Handler {
     Handler(const std::string& pattern, HttpHandlerPtr http_handler);
     ~Handler();
-    scoped_ptr<re2::RE2> pattern;
+    std::string pattern;
     HttpHandlerPtr http_handler;
 
    private:
@@ -86,7 +88,10 @@ class HttpServerImpl : public HttpServer, public mojo::ErrorHandler {
   mojo::ScopedDataPipeConsumerHandle pending_receive_handle_;
   mojo::TCPConnectedSocketPtr pending_connected_socket_;
 
+  // In order of priority.
   ScopedVector<Handler> handlers_;
+  // Patterns of |handlers_|, compiled for matching.
+  scoped_ptr<RouteTable> routes_;
 
   base::WeakPtrFactory<HttpServerImpl> weak_ptr_factory_;
   DISALLOW_COPY_AND_ASSIGN(HttpServerImpl);
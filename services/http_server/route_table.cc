@@ -0,0 +1,64 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/http_server/route_table.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace http_server {
+
+RouteTable::RouteTable(const std::vector<std::string>& patterns) {
+  if (patterns.empty())
+    return;
+
+  set_.reset(new RE2::Set(RE2::Options(), RE2::ANCHOR_BOTH));
+  for (size_t i = 0; i < patterns.size(); i++) {
+    std::string error;
+    int set_index = set_->Add(patterns[i], &error);
+    if (set_index < 0) {
+      LOG(ERROR) << "Invalid handler pattern " << patterns[i] << ": " << error;
+      continue;
+    }
+    DCHECK_EQ(static_cast<size_t>(set_index), pattern_indices_.size());
+    pattern_indices_.push_back(static_cast<int>(i));
+  }
+
+  if (!pattern_indices_.empty() && set_->Compile())
+    return;
+
+  set_.reset();
+  if (pattern_indices_.empty())
+    return;
+
+  // Matching one pattern at a time is slower, but at least it works.
+  LOG(WARNING) << "Failed to compile handler patterns; matching individually";
+  pattern_indices_.clear();
+  for (const std::string& pattern : patterns)
+    fallback_patterns_.push_back(new RE2(pattern));
+}
+
+RouteTable::~RouteTable() {
+}
+
+int RouteTable::Match(const std::string& path) const {
+  if (set_) {
+    std::vector<int> set_indices;
+    if (!set_->Match(path, &set_indices))
+      return -1;
+    // Patterns are added in order, so the first matching pattern is the one
+    // with the lowest index.
+    return pattern_indices_[*std::min_element(set_indices.begin(),
+                                              set_indices.end())];
+  }
+
+  for (size_t i = 0; i < fallback_patterns_.size(); i++) {
+    if (RE2::FullMatch(path, *fallback_patterns_[i]))
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+}  // namespace http_server
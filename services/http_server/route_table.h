@@ -0,0 +1,51 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SERVICES_HTTP_SERVER_ROUTE_TABLE_H_
+#define SERVICES_HTTP_SERVER_ROUTE_TABLE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "third_party/re2/re2/re2.h"
+#include "third_party/re2/re2/set.h"
+
+namespace http_server {
+
+// Matches request paths against a list of patterns (regular expressions that
+// must match the whole path). The patterns are compiled together into a single
+// |RE2::Set|, so the cost of matching a path doesn't grow with the number of
+// patterns. A |RouteTable| is immutable; build a new one when the patterns
+// change.
+class RouteTable {
+ public:
+  explicit RouteTable(const std::vector<std::string>& patterns);
+  ~RouteTable();
+
+  // Returns the index (in the patterns given to the constructor) of the first
+  // pattern that matches all of |path|, or -1 if none do. Invalid patterns
+  // never match.
+  int Match(const std::string& path) const;
+
+ private:
+  // All the valid patterns, compiled together (null if there are none, or if
+  // they couldn't be compiled).
+  scoped_ptr<RE2::Set> set_;
+  // Maps indices in |set_| to indices in the original patterns (which differ
+  // if there were invalid patterns).
+  std::vector<int> pattern_indices_;
+
+  // If the set couldn't be compiled, the individual patterns (which are then
+  // tried one at a time).
+  ScopedVector<RE2> fallback_patterns_;
+
+  DISALLOW_COPY_AND_ASSIGN(RouteTable);
+};
+
+}  // namespace http_server
+
+#endif  // SERVICES_HTTP_SERVER_ROUTE_TABLE_H_
@@ -0,0 +1,101 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares routing requests with |RouteTable| against matching each handler's
+// pattern in turn (which is what |HttpServerImpl| used to do).
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_vector.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "services/http_server/route_table.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/re2/re2/re2.h"
+
+namespace http_server {
+namespace {
+
+const size_t kNumRequests = 100000;
+
+// Typical handler patterns: fixed prefixes followed by a variable part.
+std::vector<std::string> MakePatterns(size_t num_patterns) {
+  std::vector<std::string> patterns;
+  for (size_t i = 0; i < num_patterns; i++) {
+    patterns.push_back(
+        base::StringPrintf("/dashboard/panel%u/[a-z]+(\\?.*)?",
+                           static_cast<unsigned>(i)));
+  }
+  // Catch-all, with the lowest priority.
+  patterns.push_back("/.*");
+  return patterns;
+}
+
+std::vector<std::string> MakePaths(size_t num_patterns) {
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < num_patterns; i++) {
+    paths.push_back(base::StringPrintf(
+        "/dashboard/panel%u/data?since=12345", static_cast<unsigned>(i)));
+  }
+  paths.push_back("/favicon.ico");
+  return paths;
+}
+
+int LinearMatch(const ScopedVector<RE2>& patterns, const std::string& path) {
+  for (size_t i = 0; i < patterns.size(); i++) {
+    if (RE2::FullMatch(path, *patterns[i]))
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void MeasureRouting(size_t num_patterns) {
+  std::vector<std::string> patterns = MakePatterns(num_patterns);
+  std::vector<std::string> paths = MakePaths(num_patterns);
+
+  ScopedVector<RE2> linear_patterns;
+  for (const std::string& pattern : patterns)
+    linear_patterns.push_back(new RE2(pattern));
+  RouteTable route_table(patterns);
+
+  // Both should route identically.
+  for (size_t i = 0; i < paths.size(); i++) {
+    EXPECT_EQ(static_cast<int>(i), LinearMatch(linear_patterns, paths[i]));
+    EXPECT_EQ(static_cast<int>(i), route_table.Match(paths[i]));
+  }
+
+  std::string test_name = base::StringPrintf(
+      "Routing_%u_Patterns", static_cast<unsigned>(patterns.size()));
+  int checksum = 0;
+  {
+    base::ElapsedTimer timer;
+    for (size_t i = 0; i < kNumRequests; i++)
+      checksum += LinearMatch(linear_patterns, paths[i % paths.size()]);
+    mojo::test::LogPerfResult(
+        test_name.c_str(), "Linear",
+        timer.Elapsed().InMillisecondsF() * 1e6 / kNumRequests, "ns/route");
+  }
+  {
+    base::ElapsedTimer timer;
+    for (size_t i = 0; i < kNumRequests; i++)
+      checksum -= route_table.Match(paths[i % paths.size()]);
+    mojo::test::LogPerfResult(
+        test_name.c_str(), "RouteTable",
+        timer.Elapsed().InMillisecondsF() * 1e6 / kNumRequests, "ns/route");
+  }
+  EXPECT_EQ(0, checksum);
+}
+
+TEST(RouteTablePerfTest, FewPatterns) {
+  MeasureRouting(4);
+}
+
+TEST(RouteTablePerfTest, ManyPatterns) {
+  MeasureRouting(50);
+}
+
+}  // namespace
+}  // namespace http_server
@@ -312,7 +312,42 @@ TEST_F(ReaperAppTest, CollectNodesAreDirected) {
   mojo::Array<NodePtr> actual;
   DumpNodes(&diagnostics_, &actual);
   ExpectEqual(expected, actual);
+}
+
+TEST_F(ReaperAppTest, CollectCycle) {
+  diagnostics_->SetIsRoot(app1_url_, true);
+  Ping(&diagnostics_);
+
+  // app1 -> app2.
+  reaper1_->CreateReference(1u, 2u);
+  Transfer(&reaper1_, 2u, app2_secret_, 1u);
+
+  // app2 -> app3 -> app2.
+  reaper2_->CreateReference(2u, 3u);
+  Transfer(&reaper2_, 3u, app3_secret_, 1u);
+  reaper3_->CreateReference(2u, 3u);
+  Transfer(&reaper3_, 3u, app2_secret_, 4u);
+
+  mojo::Array<NodePtr> expected;
+  AddReference(&expected, app1_url_, 1u, app2_url_, 1u);
+  AddReference(&expected, app2_url_, 2u, app3_url_, 1u);
+  AddReference(&expected, app3_url_, 2u, app2_url_, 4u);
+  mojo::Array<NodePtr> actual;
+  DumpNodes(&diagnostics_, &actual);
+  ExpectEqual(expected, actual, "before drop");
+  EXPECT_EQ(0u, scythe_->deds.size());
 
+  // The cycle keeps references to itself, but nothing else refers to it.
+  reaper1_->DropNode(1u);
+  Ping(&reaper1_);
+  scythe_->WaitForKills(2u);
+  ASSERT_EQ(2u, scythe_->deds.size());
+  EXPECT_EQ(app2_url_, scythe_->deds[0]);
+  EXPECT_EQ(app3_url_, scythe_->deds[1]);
+
+  expected.reset();
+  DumpNodes(&diagnostics_, &actual);
+  ExpectEqual(expected, actual, "after drop");
 }
 
 }  // namespace reaper
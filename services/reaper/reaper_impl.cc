@@ -4,8 +4,6 @@
 
 #include "services/reaper/reaper_impl.h"
 
-#include <stack>
-
 #include "base/logging.h"
 #include "base/stl_util.h"
 #include "crypto/random.h"
@@ -15,17 +13,11 @@
 
 namespace reaper {
 
-struct ReaperImpl::InternedURL {
-  bool operator<(const InternedURL& other) const { return url < other.url; }
-  GURL* url = NULL;
-};
-
 struct ReaperImpl::NodeLocator {
-  NodeLocator() : node_id(0) {}
+  NodeLocator() : app(NULL), node_id(0) {}
   NodeLocator(const NodeLocator& other) = default;
-  NodeLocator(InternedURL app_url, uint32 node_id)
-      : app_url(app_url), node_id(node_id) {}
-  InternedURL app_url;
+  NodeLocator(AppInfo* app, uint32 node_id) : app(app), node_id(node_id) {}
+  AppInfo* app;
   uint32 node_id;
 };
 
@@ -38,38 +30,78 @@ struct ReaperImpl::NodeInfo {
   bool is_source;
 };
 
+struct ReaperImpl::AppInfo {
+  // Colors used by |Collect()|.
+  enum Color {
+    BLACK,  // In use (or not yet examined).
+    GRAY,   // Possible member of a garbage cycle.
+    WHITE,  // Garbage.
+  };
+
+  explicit AppInfo(const GURL& url)
+      : url(url),
+        secret(0u),
+        in_graph(false),
+        is_root(false),
+        ref_count(0u),
+        color(BLACK),
+        is_suspect(false) {}
+
+  GURL url;
+  AppSecret secret;
+  base::hash_map<uint32, NodeInfo> nodes;
+
+  // Whether the app has had nodes since it was last collected. Only these apps
+  // can be collected (i.e., killed).
+  bool in_graph;
+  bool is_root;
+
+  // The number of incoming edges (counting multiplicity), plus one if the app
+  // is a root.
+  uint32 ref_count;
+  // Outgoing edges, with their multiplicity.
+  base::hash_map<AppInfo*, uint32> out_edges;
+
+  Color color;
+  // Whether the app is in |suspects_|.
+  bool is_suspect;
+};
+
 ReaperImpl::ReaperImpl() : reaper_url_("mojo:reaper"), next_transfer_id_(1) {
   Reset();
 }
 
 ReaperImpl::~ReaperImpl() {
-  STLDeleteValues(&interned_urls_);
+  STLDeleteValues(&apps_);
 }
 
-ReaperImpl::InternedURL ReaperImpl::InternURL(const GURL& url) {
-  auto interned = interned_urls_[url];
-  if (!interned) {
-    interned = new GURL(url);
-    interned_urls_[url] = interned;
-  }
-  InternedURL result;
-  result.url = interned;
-  return result;
+ReaperImpl::AppInfo* ReaperImpl::GetApp(const GURL& app_url) {
+  AppInfo*& app = apps_[app_url.spec()];
+  if (!app)
+    app = new AppInfo(app_url);
+  return app;
 }
 
 ReaperImpl::NodeInfo* ReaperImpl::GetNode(
     const ReaperImpl::NodeLocator& locator) {
-  auto app = nodes_.find(locator.app_url);
-  if (app == nodes_.end())
-    return NULL;
-
-  auto node = app->second.find(locator.node_id);
-  if (node == app->second.end())
+  auto node = locator.app->nodes.find(locator.node_id);
+  if (node == locator.app->nodes.end())
     return NULL;
 
   return &(node->second);
 }
 
+void ReaperImpl::AddNode(const ReaperImpl::NodeLocator& locator,
+                         const ReaperImpl::NodeInfo& node) {
+  AppInfo* app = locator.app;
+  if (!app->in_graph) {
+    // The app may turn out to be unreachable without ever losing a reference.
+    app->in_graph = true;
+    AddSuspect(app);
+  }
+  app->nodes[locator.node_id] = node;
+}
+
 bool ReaperImpl::MoveNode(const ReaperImpl::NodeLocator& source_locator,
                           const ReaperImpl::NodeLocator& dest_locator) {
   NodeInfo* source = GetNode(source_locator);
@@ -82,116 +114,223 @@ bool ReaperImpl::MoveNode(const ReaperImpl::NodeLocator& source_locator,
     return false;
   }
 
-  NodeInfo* other = GetNode(source->other_node);
-  DCHECK(other);
+  DCHECK(GetNode(source->other_node));
 
-  nodes_[dest_locator.app_url][dest_locator.node_id] = *source;
-  nodes_[source_locator.app_url].erase(source_locator.node_id);
+  NodeInfo node = *source;
+  AddEdgeFor(dest_locator, node);
+  RemoveEdgeFor(source_locator, node);
+  source_locator.app->nodes.erase(source_locator.node_id);
+  AddNode(dest_locator, node);
+
+  // Look |other| up only now, since adding a node may have moved the others.
+  NodeInfo* other = GetNode(node.other_node);
+  DCHECK(other);
   other->other_node = dest_locator;
   return true;
 }
 
-void ReaperImpl::Mark(InternedURL root_url, std::set<InternedURL>* marked) {
-  struct StackState {
-    StackState(AppMap::iterator app, NodeMap::iterator node)
-        : app(app), node(node) {}
-    AppMap::iterator app;
-    NodeMap::iterator node;
-  };
+void ReaperImpl::AddEdge(AppInfo* from, AppInfo* to) {
+  from->out_edges[to]++;
+  to->ref_count++;
+}
+
+void ReaperImpl::RemoveEdge(AppInfo* from, AppInfo* to) {
+  auto edge = from->out_edges.find(to);
+  DCHECK(edge != from->out_edges.end());
+  if (--edge->second == 0u)
+    from->out_edges.erase(edge);
+
+  DCHECK_GT(to->ref_count, 0u);
+  to->ref_count--;
+  AddSuspect(to);
+}
+
+void ReaperImpl::AddEdgeFor(const ReaperImpl::NodeLocator& locator,
+                            const ReaperImpl::NodeInfo& node) {
+  if (node.is_source)
+    AddEdge(locator.app, node.other_node.app);
+  else
+    AddEdge(node.other_node.app, locator.app);
+}
+
+void ReaperImpl::RemoveEdgeFor(const ReaperImpl::NodeLocator& locator,
+                               const ReaperImpl::NodeInfo& node) {
+  if (node.is_source)
+    RemoveEdge(locator.app, node.other_node.app);
+  else
+    RemoveEdge(node.other_node.app, locator.app);
+}
+
+void ReaperImpl::SetAppIsRoot(AppInfo* app, bool is_root) {
+  if (app->is_root == is_root)
+    return;
+
+  app->is_root = is_root;
+  if (is_root) {
+    app->ref_count++;
+  } else {
+    DCHECK_GT(app->ref_count, 0u);
+    app->ref_count--;
+    AddSuspect(app);
+  }
+}
 
-  auto root_app = nodes_.find(root_url);
-  if (root_app == nodes_.end()) {
-    // This can happen because roots don't need to always have at least one
-    // reference.
+void ReaperImpl::AddSuspect(AppInfo* app) {
+  if (app->is_suspect)
     return;
+  app->is_suspect = true;
+  suspects_.push_back(app);
+}
+
+// This is synchronous cycle collection by trial deletion (Bacon and Rajan,
+// "Concurrent Cycle Collection in Reference Counted Systems"). Apps that are
+// still referenced from outside the subgraph reachable from the suspects keep
+// a nonzero count once the references within the subgraph are subtracted; so
+// does everything reachable from them. Whatever is left has no path from a
+// root, and is garbage. Unlike marking from the roots, this only touches the
+// part of the graph that could have changed.
+void ReaperImpl::Collect() {
+  std::vector<AppInfo*> candidates;
+  candidates.swap(suspects_);
+  for (size_t i = 0; i < candidates.size(); i++)
+    candidates[i]->is_suspect = false;
+
+  for (AppInfo* app : candidates) {
+    if (app->in_graph && !app->is_root)
+      MarkGray(app);
   }
+  for (AppInfo* app : candidates)
+    Scan(app);
 
-  std::stack<StackState> stack;
-  stack.push(StackState(root_app, root_app->second.begin()));
+  std::vector<AppInfo*> garbage;
+  for (AppInfo* app : candidates)
+    CollectWhite(app, &garbage);
+
+  for (AppInfo* app : garbage)
+    Kill(app);
+}
+
+void ReaperImpl::MarkGray(AppInfo* app) {
+  if (app->color == AppInfo::GRAY)
+    return;
 
+  // Subtract the references from within the subgraph.
+  app->color = AppInfo::GRAY;
+  std::vector<AppInfo*> stack(1, app);
   while (!stack.empty()) {
-    StackState current = stack.top();
-    InternedURL url = current.app->first;
-    const NodeMap& nodes = current.app->second;
-    if (current.node == nodes.begin()) {
-      if (marked->find(url) != marked->end()) {
-        stack.pop();
-        continue;
+    AppInfo* current = stack.back();
+    stack.pop_back();
+    for (const auto& edge : current->out_edges) {
+      AppInfo* child = edge.first;
+      DCHECK_GE(child->ref_count, edge.second);
+      child->ref_count -= edge.second;
+      if (child->color != AppInfo::GRAY) {
+        child->color = AppInfo::GRAY;
+        stack.push_back(child);
       }
-      marked->insert(url);
     }
+  }
+}
+
+void ReaperImpl::Scan(AppInfo* app) {
+  std::vector<AppInfo*> stack(1, app);
+  while (!stack.empty()) {
+    AppInfo* current = stack.back();
+    stack.pop_back();
+    if (current->color != AppInfo::GRAY)
+      continue;
 
-    if (current.node == nodes.end()) {
-      stack.pop();
+    if (current->ref_count > 0u) {
+      // Referenced from outside the subgraph, so in use.
+      ScanBlack(current);
       continue;
     }
 
-    ++(stack.top().node);
+    current->color = AppInfo::WHITE;
+    for (const auto& edge : current->out_edges)
+      stack.push_back(edge.first);
+  }
+}
 
-    NodeInfo* node_info = &(current.node->second);
-    // References are directed, so we only consider the outbound nodes.
-    if (node_info->is_source) {
-      auto next_app = nodes_.find(node_info->other_node.app_url);
-      // This should not be possible since we will not remove an app unless
-      // there are no nodes pointing to it.
-      DCHECK(next_app != nodes_.end());
-      stack.push(StackState(next_app, next_app->second.begin()));
+void ReaperImpl::ScanBlack(AppInfo* app) {
+  // Restore the references subtracted by |MarkGray()|. This may also find
+  // that apps already marked white are in use after all.
+  app->color = AppInfo::BLACK;
+  std::vector<AppInfo*> stack(1, app);
+  while (!stack.empty()) {
+    AppInfo* current = stack.back();
+    stack.pop_back();
+    for (const auto& edge : current->out_edges) {
+      AppInfo* child = edge.first;
+      child->ref_count += edge.second;
+      if (child->color != AppInfo::BLACK) {
+        child->color = AppInfo::BLACK;
+        stack.push_back(child);
+      }
     }
   }
 }
 
-void ReaperImpl::Collect() {
-  std::set<InternedURL> marked;
-
-  // Explore all the edges starting from the root apps.
-  for (auto root_id : roots_) {
-    Mark(root_id, &marked);
-  }
+void ReaperImpl::CollectWhite(AppInfo* app, std::vector<AppInfo*>* garbage) {
+  std::vector<AppInfo*> stack(1, app);
+  while (!stack.empty()) {
+    AppInfo* current = stack.back();
+    stack.pop_back();
+    if (current->color != AppInfo::WHITE || !current->in_graph)
+      continue;
 
-  // Sweep all apps not marked.
-  std::set<InternedURL> doooomed;
-  for (const auto& node : nodes_) {
-    if (marked.find(node.first) == marked.end()) {
-      doooomed.insert(node.first);
-    }
+    // Garbage apps are taken out of the graph here, so that |Kill()| can
+    // tell them from the apps that survive.
+    current->in_graph = false;
+    garbage->push_back(current);
+    for (const auto& edge : current->out_edges)
+      stack.push_back(edge.first);
   }
+}
 
-  for (InternedURL url : doooomed) {
-    // Clean up nodes and edges related to this app.
-    for (const auto& node : nodes_[url]) {
-      NodeLocator other = node.second.other_node;
-      nodes_[other.app_url].erase(other.node_id);
-    }
-    nodes_.erase(url);
+void ReaperImpl::Kill(AppInfo* app) {
+  // Clean up the other ends of this app's nodes. Only apps this app refers to
+  // can survive it (anything referring to it is garbage too), and
+  // |MarkGray()| has already taken those references out of their counts.
+  for (const auto& node : app->nodes) {
+    const NodeLocator& other = node.second.other_node;
+    if (!other.app->in_graph)
+      continue;
 
-    // Actually kill the app.
-    if (scythe_.get()) {
-      scythe_->KillApplication(url.url->spec());
-    }
+    DCHECK(node.second.is_source);
+    other.app->nodes.erase(other.node_id);
+  }
+  app->nodes.clear();
+  app->out_edges.clear();
+  app->ref_count = 0u;
+  app->color = AppInfo::BLACK;
+  DCHECK(!app->is_root);
+
+  // Actually kill the app.
+  if (scythe_.get()) {
+    scythe_->KillApplication(app->url.spec());
   }
 }
 
 void ReaperImpl::GetApplicationSecret(
     const GURL& caller_app,
     const mojo::Callback<void(AppSecret)>& callback) {
-  InternedURL app_url = InternURL(caller_app);
-  AppSecret secret = app_url_to_secret_[app_url];
-  if (secret == 0u) {
-    crypto::RandBytes(&secret, sizeof(AppSecret));
-    CHECK_NE(secret, 0u);
-    app_url_to_secret_[app_url] = secret;
-    app_secret_to_url_[secret] = app_url;
+  AppInfo* app = GetApp(caller_app);
+  if (app->secret == 0u) {
+    crypto::RandBytes(&app->secret, sizeof(AppSecret));
+    CHECK_NE(app->secret, 0u);
+    app_secret_to_app_[app->secret] = app;
   }
-  callback.Run(secret);
+  callback.Run(app->secret);
 }
 
 void ReaperImpl::CreateReference(const GURL& caller_app,
                                  uint32 source_node_id,
                                  uint32 target_node_id) {
-  InternedURL app_url = InternURL(caller_app);
+  AppInfo* app = GetApp(caller_app);
 
-  NodeLocator source_locator(app_url, source_node_id);
-  NodeLocator target_locator(app_url, target_node_id);
+  NodeLocator source_locator(app, source_node_id);
+  NodeLocator target_locator(app, target_node_id);
 
   if (GetNode(source_locator) != NULL) {
     LOG(ERROR) << "Duplicate source node: " << source_node_id;
@@ -205,14 +344,15 @@ void ReaperImpl::CreateReference(const GURL& caller_app,
 
   NodeInfo source_node(target_locator);
   source_node.is_source = true;
-  nodes_[source_locator.app_url][source_locator.node_id] = source_node;
+  AddNode(source_locator, source_node);
+  AddEdgeFor(source_locator, source_node);
 
   NodeInfo target_node(source_locator);
-  nodes_[target_locator.app_url][target_locator.node_id] = target_node;
+  AddNode(target_locator, target_node);
 }
 
 void ReaperImpl::DropNode(const GURL& caller_app, uint32 node_id) {
-  NodeLocator locator(InternURL(caller_app), node_id);
+  NodeLocator locator(GetApp(caller_app), node_id);
   NodeInfo* node = GetNode(locator);
   if (!node) {
     LOG(ERROR) << "Specified node does not exist: " << node_id;
@@ -221,8 +361,9 @@ void ReaperImpl::DropNode(const GURL& caller_app, uint32 node_id) {
 
   NodeLocator other_locator = node->other_node;
   DCHECK(GetNode(other_locator));
-  nodes_[locator.app_url].erase(locator.node_id);
-  nodes_[other_locator.app_url].erase(other_locator.node_id);
+  RemoveEdgeFor(locator, *node);
+  locator.app->nodes.erase(locator.node_id);
+  other_locator.app->nodes.erase(other_locator.node_id);
 
   Collect();
 }
@@ -231,8 +372,8 @@ void ReaperImpl::StartTransfer(const GURL& caller_app,
                                uint32 node_id,
                                mojo::InterfaceRequest<Transfer> request) {
   uint32 transfer_id = next_transfer_id_++;
-  NodeLocator source(InternURL(caller_app), node_id);
-  if (!MoveNode(source, NodeLocator(InternURL(reaper_url_), transfer_id))) {
+  NodeLocator source(GetApp(caller_app), node_id);
+  if (!MoveNode(source, NodeLocator(GetApp(reaper_url_), transfer_id))) {
     LOG(ERROR) << "Could not start node transfer because move failed from: ("
                << caller_app.spec() << "," << node_id << ") to: ("
                << reaper_url_.spec() << "," << transfer_id << ")";
@@ -244,20 +385,19 @@ void ReaperImpl::StartTransfer(const GURL& caller_app,
 void ReaperImpl::CompleteTransfer(uint32 source_node_id,
                                   uint64 dest_app_secret,
                                   uint32 dest_node_id) {
-  InternedURL dest_app_url = app_secret_to_url_[dest_app_secret];
-  if (!dest_app_url.url) {
+  auto dest_app = app_secret_to_app_.find(dest_app_secret);
+  if (dest_app == app_secret_to_app_.end()) {
     LOG(ERROR) << "Specified destination app secret does not exist: "
                << dest_app_secret;
     return;
   }
 
-  InternedURL source_app_url(InternURL(reaper_url_));
-  NodeLocator source(source_app_url, source_node_id);
-  NodeLocator dest(dest_app_url, dest_node_id);
+  NodeLocator source(GetApp(reaper_url_), source_node_id);
+  NodeLocator dest(dest_app->second, dest_node_id);
   if (!MoveNode(source, dest)) {
     LOG(ERROR) << "Could not complete transfer because move failed from: ("
-               << *source_app_url.url << "," << source_node_id << ") to: ("
-               << *dest_app_url.url << "," << dest_node_id << ")";
+               << reaper_url_ << "," << source_node_id << ") to: ("
+               << dest.app->url << "," << dest_node_id << ")";
   }
 
   Collect();
@@ -284,12 +424,12 @@ void ReaperImpl::Create(mojo::ApplicationConnection* connection,
 void ReaperImpl::DumpNodes(
     const mojo::Callback<void(mojo::Array<NodePtr>)>& callback) {
   mojo::Array<NodePtr> result(0u);
-  for (const auto& app : nodes_) {
-    for (const auto& node_info : app.second) {
+  for (const auto& app : apps_) {
+    for (const auto& node_info : app.second->nodes) {
       NodePtr node(Node::New());
-      node->app_url = app.first.url->spec();
+      node->app_url = app.first;
       node->node_id = node_info.first;
-      node->other_app_url = node_info.second.other_node.app_url.url->spec();
+      node->other_app_url = node_info.second.other_node.app->url.spec();
       node->other_id = node_info.second.other_node.node_id;
       node->is_source = node_info.second.is_source;
       result.push_back(node.Pass());
@@ -299,11 +439,10 @@ void ReaperImpl::DumpNodes(
 }
 
 void ReaperImpl::Reset() {
-  app_url_to_secret_.clear();
-  app_secret_to_url_.clear();
-  nodes_.clear();
-  roots_.clear();
-  roots_.insert(InternURL(reaper_url_));
+  STLDeleteValues(&apps_);
+  app_secret_to_app_.clear();
+  suspects_.clear();
+  SetAppIsRoot(GetApp(reaper_url_), true);
 }
 
 void ReaperImpl::GetReaperForApp(const mojo::String& app_url,
@@ -312,12 +451,7 @@ void ReaperImpl::GetReaperForApp(const mojo::String& app_url,
 }
 
 void ReaperImpl::SetIsRoot(const mojo::String& url, bool is_root) {
-  InternedURL interned(InternURL(GURL(url)));
-  if (is_root) {
-    roots_.insert(interned);
-  } else {
-    roots_.erase(interned);
-  }
+  SetAppIsRoot(GetApp(GURL(url)), is_root);
 }
 
 void ReaperImpl::SetScythe(ScythePtr scythe) {
@@ -6,8 +6,10 @@
 #define SERVICES_REAPER_REAPER_IMPL_H_
 
 #include <map>
-#include <set>
+#include <string>
+#include <vector>
 
+#include "base/containers/hash_tables.h"
 #include "base/macros.h"
 #include "mojo/common/weak_binding_set.h"
 #include "mojo/public/cpp/application/application_delegate.h"
@@ -49,15 +51,41 @@ class ReaperImpl : public Diagnostics,
                         uint32 dest_node_id);
 
  private:
-  struct InternedURL;
+  struct AppInfo;
   struct NodeLocator;
   struct NodeInfo;
 
-  InternedURL InternURL(const GURL& app_url);
+  // Returns the state for |app_url|, creating it if necessary.
+  AppInfo* GetApp(const GURL& app_url);
   NodeInfo* GetNode(const NodeLocator& locator);
+
+  void AddNode(const NodeLocator& locator, const NodeInfo& node);
   bool MoveNode(const NodeLocator& source, const NodeLocator& dest);
-  void Mark(InternedURL app_url, std::set<InternedURL>* marked);
+
+  // The app graph has an edge from app A to app B for each source node in A
+  // whose target node is in B. Each app counts its incoming edges, so that only
+  // the apps that lose a reference need to be considered by |Collect()|.
+  void AddEdge(AppInfo* from, AppInfo* to);
+  void RemoveEdge(AppInfo* from, AppInfo* to);
+  // Adds/removes the edge corresponding to the reference that |node| (at
+  // |locator|) is one end of.
+  void AddEdgeFor(const NodeLocator& locator, const NodeInfo& node);
+  void RemoveEdgeFor(const NodeLocator& locator, const NodeInfo& node);
+  void SetAppIsRoot(AppInfo* app, bool is_root);
+
+  // Notes that |app| may have become garbage, to be checked by the next
+  // |Collect()|.
+  void AddSuspect(AppInfo* app);
+
+  // Finds and kills the apps that are no longer reachable from any root. Only
+  // the parts of the graph reachable from suspects are examined (using trial
+  // deletion: see |MarkGray()|, |Scan()|, and |CollectWhite()|).
   void Collect();
+  void MarkGray(AppInfo* app);
+  void Scan(AppInfo* app);
+  void ScanBlack(AppInfo* app);
+  void CollectWhite(AppInfo* app, std::vector<AppInfo*>* garbage);
+  void Kill(AppInfo* app);
 
   // mojo::ApplicationDelegate
   bool ConfigureIncomingConnection(
@@ -83,29 +111,25 @@ class ReaperImpl : public Diagnostics,
 
   GURL reaper_url_;
 
-  // There will be a lot of nodes in a running system, so we intern app urls.
-  std::map<GURL, GURL*> interned_urls_;
+  // There will be a lot of nodes in a running system, so each app's URL is
+  // kept once, along with its nodes. Keyed by URL spec; owns the values.
+  base::hash_map<std::string, AppInfo*> apps_;
 
   // These are the ids assigned to nodes while they are being transferred.
   uint32 next_transfer_id_;
 
-  std::map<InternedURL, AppSecret> app_url_to_secret_;
-  std::map<AppSecret, InternedURL> app_secret_to_url_;
+  std::map<AppSecret, AppInfo*> app_secret_to_app_;
 
-  // TODO(aa): The values in at least the first-level map should probably be
-  // heap-allocated.
-  typedef std::map<uint32, NodeInfo> NodeMap;
-  typedef std::map<InternedURL, NodeMap> AppMap;
-  AppMap nodes_;
+  // Apps that might have become garbage since the last |Collect()|.
+  std::vector<AppInfo*> suspects_;
 
   mojo::WeakBindingSet<Diagnostics> diagnostics_bindings_;
 
-  std::set<InternedURL> roots_;
   ScythePtr scythe_;
 
   DISALLOW_COPY_AND_ASSIGN(ReaperImpl);
 };
 
-#endif  // SERVICES_REAPER_REAPER_IMPL_H_
-
 }  // namespace reaper
+
+#endif  // SERVICES_REAPER_REAPER_IMPL_H_
@@ -0,0 +1,133 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures how |ReaperImpl|'s collection scales with the size of the reference
+// graph: dropping references in a large live graph should only cost as much as
+// the part of the graph that might have become garbage.
+
+#include <string>
+
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "mojo/common/message_pump_mojo.h"
+#include "mojo/public/cpp/test_support/test_support.h"
+#include "services/reaper/diagnostics.mojom.h"
+#include "services/reaper/reaper_impl.h"
+#include "services/reaper/transfer.mojom.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace reaper {
+namespace {
+
+const size_t kNumDrops = 10000;
+
+// Node used while handing the target end of a new reference to another app.
+const uint32 kTransferredNodeId = 0xffffffffu;
+
+GURL AppURL(size_t i) {
+  return GURL(base::StringPrintf("https://app%u/", static_cast<unsigned>(i)));
+}
+
+class ReaperPerfTest : public testing::Test {
+ public:
+  ReaperPerfTest()
+      : loop_(make_scoped_ptr(new mojo::common::MessagePumpMojo())) {}
+  ~ReaperPerfTest() override { loop_.RunUntilIdle(); }
+
+ protected:
+  void SetIsRoot(ReaperImpl* reaper, const GURL& app) {
+    static_cast<Diagnostics*>(reaper)->SetIsRoot(app.spec(), true);
+  }
+
+  // Adds a reference from |from| (node |source_node_id|) to |to| (node
+  // |target_node_id|), the way apps do it: by creating both ends, then
+  // transferring the target.
+  void AddReference(ReaperImpl* reaper,
+                    const GURL& from,
+                    uint32 source_node_id,
+                    const GURL& to,
+                    uint32 target_node_id) {
+    uint64 secret = 0u;
+    reaper->GetApplicationSecret(
+        to, [&secret](uint64 app_secret) { secret = app_secret; });
+
+    reaper->CreateReference(from, source_node_id, kTransferredNodeId);
+    TransferPtr transfer;
+    reaper->StartTransfer(from, kTransferredNodeId, GetProxy(&transfer));
+    transfer->Complete(secret, target_node_id);
+    loop_.RunUntilIdle();
+  }
+
+  size_t CountNodes(ReaperImpl* reaper) {
+    size_t num_nodes = 0u;
+    static_cast<Diagnostics*>(reaper)->DumpNodes(
+        [&num_nodes](mojo::Array<NodePtr> nodes) { num_nodes = nodes.size(); });
+    return num_nodes;
+  }
+
+  // A root referring to |num_apps| apps, in which references are repeatedly
+  // created and dropped.
+  void MeasureChurn(size_t num_apps) {
+    ReaperImpl reaper;
+    SetIsRoot(&reaper, AppURL(0));
+    for (size_t i = 1; i <= num_apps; i++)
+      AddReference(&reaper, AppURL(0), static_cast<uint32>(i), AppURL(i), 1u);
+    ASSERT_EQ(2 * num_apps, CountNodes(&reaper));
+
+    std::string test_name =
+        base::StringPrintf("Churn_%u_Apps", static_cast<unsigned>(num_apps));
+    base::ElapsedTimer timer;
+    for (size_t i = 0; i < kNumDrops; i++) {
+      GURL app = AppURL(1 + i % num_apps);
+      reaper.CreateReference(app, 2u, 3u);
+      reaper.DropNode(app, 2u);
+    }
+    mojo::test::LogPerfResult(
+        test_name.c_str(), "DropNode",
+        timer.Elapsed().InMillisecondsF() * 1e3 / kNumDrops, "us/drop");
+
+    // Nothing should have been collected.
+    EXPECT_EQ(2 * num_apps, CountNodes(&reaper));
+  }
+
+  // A chain of |num_apps| apps hanging off a root, all of which become garbage
+  // at once.
+  void MeasureCollectChain(size_t num_apps) {
+    ReaperImpl reaper;
+    SetIsRoot(&reaper, AppURL(0));
+    for (size_t i = 0; i < num_apps; i++)
+      AddReference(&reaper, AppURL(i), 1u, AppURL(i + 1), 2u);
+    ASSERT_EQ(2 * num_apps, CountNodes(&reaper));
+
+    std::string test_name =
+        base::StringPrintf("Chain_%u_Apps", static_cast<unsigned>(num_apps));
+    base::ElapsedTimer timer;
+    reaper.DropNode(AppURL(0), 1u);
+    mojo::test::LogPerfResult(test_name.c_str(), "Collect",
+                              timer.Elapsed().InMillisecondsF(), "ms");
+
+    EXPECT_EQ(0u, CountNodes(&reaper));
+  }
+
+ private:
+  base::MessageLoop loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReaperPerfTest);
+};
+
+TEST_F(ReaperPerfTest, Churn) {
+  MeasureChurn(10);
+  MeasureChurn(1000);
+  MeasureChurn(10000);
+}
+
+TEST_F(ReaperPerfTest, CollectChain) {
+  MeasureCollectChain(1000);
+  MeasureCollectChain(10000);
+}
+
+}  // namespace
+}  // namespace reaper
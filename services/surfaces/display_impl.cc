@@ -4,6 +4,12 @@
 
 #include "services/surfaces/display_impl.h"
 
+#include <algorithm>
+
+#include "base/command_line.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/sys_info.h"
+#include "cc/base/switches.h"
 #include "cc/output/compositor_frame.h"
 #include "cc/surfaces/display.h"
 #include "mojo/converters/geometry/geometry_type_converters.h"
@@ -14,11 +20,35 @@
 
 namespace surfaces {
 namespace {
+
+// More threads than this don't speed up the software renderer's raster.
+const int kMaxSoftwareRasterThreads = 3;
+
 void CallCallback(const mojo::Closure& callback, cc::SurfaceDrawStatus status) {
   callback.Run();
 }
+
+// Only used if the display ends up with the software renderer, i.e. if its
+// output surface has no context provider.
+int GetNumSoftwareRasterThreads() {
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+  if (command_line.HasSwitch(cc::switches::kNumSoftwareRasterThreads)) {
+    int num_threads = 0;
+    if (base::StringToInt(command_line.GetSwitchValueASCII(
+                              cc::switches::kNumSoftwareRasterThreads),
+                          &num_threads) &&
+        num_threads >= 0) {
+      return num_threads;
+    }
+    LOG(WARNING) << "Invalid --" << cc::switches::kNumSoftwareRasterThreads;
+  }
+  return std::max(0, std::min(kMaxSoftwareRasterThreads,
+                              base::SysInfo::NumberOfProcessors() - 1));
 }
 
+}  // namespace
+
 DisplayImpl::DisplayImpl(cc::SurfaceManager* manager,
                          cc::SurfaceId cc_id,
                          SurfacesScheduler* scheduler,
@@ -45,6 +75,7 @@ void DisplayImpl::OnContextCreated(mojo::CommandBufferPtr gles2_client) {
   DCHECK(!display_);
 
   cc::RendererSettings settings;
+  settings.num_software_raster_threads = GetNumSoftwareRasterThreads();
   display_.reset(new cc::Display(this, manager_, nullptr, nullptr, settings));
   scheduler_->AddDisplay(display_.get());
   display_->Initialize(make_scoped_ptr(new mojo::DirectOutputSurface(
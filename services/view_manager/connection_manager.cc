@@ -9,6 +9,7 @@
 #include "mojo/converters/geometry/geometry_type_converters.h"
 #include "mojo/converters/input_events/input_events_type_converters.h"
 #include "mojo/public/interfaces/application/service_provider.mojom.h"
+#include "mojo/services/view_manager/public/interfaces/animations.mojom.h"
 #include "services/view_manager/client_connection.h"
 #include "services/view_manager/connection_manager_delegate.h"
 #include "services/view_manager/display_manager.h"
@@ -21,6 +22,9 @@ using mojo::ConnectionSpecificId;
 namespace view_manager {
 namespace {
 
+// How long a cloned view takes to fade out.
+const int64 kCloneFadeOutMs = 2000;
+
 // Creates a copy of |view|. The copied view has |delegate| as its delegate.
 // This does not recurse.
 ServerView* CloneView(const ServerView* view, ServerViewDelegate* delegate) {
@@ -75,22 +79,23 @@ void DeleteViewTree(ServerView* view) {
   delete view;
 }
 
-// TODO(sky): nuke, proof of concept.
-bool DecrementAnimatingViewsOpacity(ServerView* view) {
-  if (view->id() == ClonedViewId()) {
-    const float new_opacity = view->opacity() - .05f;
-    if (new_opacity <= 0)
-      DeleteViewTree(view);
-    else
-      view->SetOpacity(new_opacity);
-    return true;
-  }
-  bool ret_value = false;
-  for (ServerView* child : view->GetChildren()) {
-    if (DecrementAnimatingViewsOpacity(child))
-      ret_value = true;
-  }
-  return ret_value;
+// Builds an animation that fades a view out over |duration|.
+mojo::AnimationGroupPtr CreateFadeOutAnimation(base::TimeDelta duration) {
+  mojo::AnimationElementPtr element(mojo::AnimationElement::New());
+  element->property = mojo::ANIMATION_PROPERTY_OPACITY;
+  element->duration = duration.InMicroseconds();
+  element->tween_type = mojo::ANIMATION_TWEEN_TYPE_LINEAR;
+  element->target_value = mojo::AnimationValue::New();
+  element->target_value->float_value = 0.f;
+
+  mojo::AnimationSequencePtr sequence(mojo::AnimationSequence::New());
+  sequence->cycle_count = 1u;
+  sequence->elements.push_back(element.Pass());
+
+  mojo::AnimationGroupPtr group(mojo::AnimationGroup::New());
+  group->view_id = ViewIdToTransportId(ClonedViewId());
+  group->sequences.push_back(sequence.Pass());
+  return group.Pass();
 }
 
 }  // namespace
@@ -121,6 +126,7 @@ ConnectionManager::ConnectionManager(ConnectionManagerDelegate* delegate,
       current_change_(nullptr),
       in_destructor_(false),
       animation_runner_(base::TimeTicks::Now()) {
+  animation_runner_.AddObserver(this);
   root_->SetBounds(gfx::Rect(800, 600));
   root_->SetVisible(true);
   display_manager_->Init(this);
@@ -133,6 +139,7 @@ ConnectionManager::~ConnectionManager() {
   // All the connections should have been destroyed.
   DCHECK(connection_map_.empty());
   root_.reset();
+  animation_runner_.RemoveObserver(this);
 }
 
 ServerView* ConnectionManager::CreateServerView(const ViewId& id) {
@@ -258,17 +265,30 @@ bool ConnectionManager::CloneAndAnimate(const ViewId& view_id) {
   ServerView* view = GetView(view_id);
   if (!view || !view->IsDrawn(root_.get()) || view == root_.get())
     return false;
-  if (!animation_timer_.IsRunning()) {
-    animation_timer_.Start(FROM_HERE, base::TimeDelta::FromMilliseconds(100),
-                           this, &ConnectionManager::DoAnimation);
-  }
   ServerView* clone = CloneView(view, this);
   CloneViewTree(view, clone, this);
   view->parent()->Add(clone);
   view->parent()->Reorder(clone, view, mojo::ORDER_DIRECTION_ABOVE);
+
+  mojo::AnimationGroupPtr fade_out(CreateFadeOutAnimation(
+      base::TimeDelta::FromMilliseconds(kCloneFadeOutMs)));
+  std::vector<AnimationRunner::ViewAndAnimationPair> animations;
+  animations.push_back(std::make_pair(clone, fade_out.get()));
+  const AnimationRunner::AnimationId animation_id =
+      animation_runner_.Schedule(animations, base::TimeTicks::Now());
+  DCHECK(animation_id);
+  fading_clones_[animation_id] = clone;
   return true;
 }
 
+void ConnectionManager::AnimateFrame(base::TimeTicks frame_time) {
+  // The views' new values are only painted; clients aren't told about each
+  // step, only about the animation starting and finishing.
+  animation_runner_.Tick(frame_time);
+  if (animation_runner_.HasAnimations())
+    display_manager_->RequestAnimationFrame();
+}
+
 void ConnectionManager::ProcessViewBoundsChanged(const ServerView* view,
                                                  const gfx::Rect& old_bounds,
                                                  const gfx::Rect& new_bounds) {
@@ -336,11 +356,6 @@ void ConnectionManager::FinishChange() {
   current_change_ = NULL;
 }
 
-void ConnectionManager::DoAnimation() {
-  if (!DecrementAnimatingViewsOpacity(root()))
-    animation_timer_.Stop();
-}
-
 void ConnectionManager::AddConnection(ClientConnection* connection) {
   DCHECK_EQ(0u, connection_map_.count(connection->service()->id()));
   connection_map_[connection->service()->id()] = connection;
@@ -482,6 +497,29 @@ void ConnectionManager::OnViewSharedPropertyChanged(
   }
 }
 
+void ConnectionManager::OnAnimationScheduled(AnimationRunner::AnimationId id) {
+  display_manager_->RequestAnimationFrame();
+}
+
+void ConnectionManager::OnAnimationDone(AnimationRunner::AnimationId id) {
+  auto it = fading_clones_.find(id);
+  if (it == fading_clones_.end())
+    return;
+  ServerView* clone = it->second;
+  fading_clones_.erase(it);
+  DeleteViewTree(clone);
+}
+
+void ConnectionManager::OnAnimationInterrupted(
+    AnimationRunner::AnimationId id) {
+  fading_clones_.erase(id);
+}
+
+void ConnectionManager::OnAnimationCanceled(AnimationRunner::AnimationId id) {
+  // Only happens to a clone while it's being destroyed.
+  fading_clones_.erase(id);
+}
+
 void ConnectionManager::DispatchInputEventToView(mojo::Id transport_view_id,
                                                  mojo::EventPtr event) {
   const ViewId view_id(ViewIdFromTransportId(transport_view_id));
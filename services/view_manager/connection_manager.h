@@ -10,11 +10,11 @@
 
 #include "base/basictypes.h"
 #include "base/memory/scoped_ptr.h"
-#include "base/timer/timer.h"
 #include "mojo/public/cpp/bindings/array.h"
 #include "mojo/services/view_manager/public/interfaces/view_manager.mojom.h"
 #include "mojo/services/window_manager/public/interfaces/window_manager_internal.mojom.h"
 #include "services/view_manager/animation_runner.h"
+#include "services/view_manager/animation_runner_observer.h"
 #include "services/view_manager/ids.h"
 #include "services/view_manager/server_view_delegate.h"
 #include "services/view_manager/server_view_observer.h"
@@ -31,6 +31,7 @@ class ViewManagerServiceImpl;
 // ViewManagerServiceImpls) as well as providing the root of the hierarchy.
 class ConnectionManager : public ServerViewDelegate,
                           public ServerViewObserver,
+                          public AnimationRunnerObserver,
                           public mojo::WindowManagerInternalClient {
  public:
   // Create when a ViewManagerServiceImpl is about to make a change. Ensures
@@ -135,6 +136,12 @@ class ConnectionManager : public ServerViewDelegate,
   // WindowManagerInternalClient implementation helper; see mojom for details.
   bool CloneAndAnimate(const ViewId& view_id);
 
+  // Advances animations to |frame_time|. Called by the DisplayManager, once a
+  // frame, before it draws (see DisplayManager::RequestAnimationFrame()).
+  void AnimateFrame(base::TimeTicks frame_time);
+
+  AnimationRunner* animation_runner() { return &animation_runner_; }
+
   // These functions trivially delegate to all ViewManagerServiceImpls, which in
   // term notify their clients.
   void ProcessViewDestroyed(ServerView* view);
@@ -176,10 +183,6 @@ class ConnectionManager : public ServerViewDelegate,
   // Adds |connection| to internal maps.
   void AddConnection(ClientConnection* connection);
 
-  // Callback from animation timer.
-  // TODO(sky): make this real (move to a different class).
-  void DoAnimation();
-
   // Overridden from ServerViewDelegate:
   void PrepareToDestroyView(ServerView* view) override;
   void PrepareToChangeViewHierarchy(ServerView* view,
@@ -208,6 +211,12 @@ class ConnectionManager : public ServerViewDelegate,
       const std::string& name,
       const std::vector<uint8_t>* new_data) override;
 
+  // Overridden from AnimationRunnerObserver:
+  void OnAnimationScheduled(AnimationRunner::AnimationId id) override;
+  void OnAnimationDone(AnimationRunner::AnimationId id) override;
+  void OnAnimationInterrupted(AnimationRunner::AnimationId id) override;
+  void OnAnimationCanceled(AnimationRunner::AnimationId id) override;
+
   // WindowManagerInternalClient:
   void DispatchInputEventToView(mojo::Id transport_view_id,
                                 mojo::EventPtr event) override;
@@ -239,11 +248,12 @@ class ConnectionManager : public ServerViewDelegate,
 
   bool in_destructor_;
 
-  // TODO(sky): nuke! Just a proof of concept until get real animation api.
-  base::RepeatingTimer<ConnectionManager> animation_timer_;
-
   AnimationRunner animation_runner_;
 
+  // Cloned views (see CloneAndAnimate()) that are fading out, by the id of
+  // their animation. The views are deleted once their animation is done.
+  std::map<AnimationRunner::AnimationId, ServerView*> fading_clones_;
+
   DISALLOW_COPY_AND_ASSIGN(ConnectionManager);
 };
 
@@ -23,51 +23,9 @@ using mojo::Size;
 namespace view_manager {
 namespace {
 
-void DrawViewTree(mojo::Pass* pass,
-                  const ServerView* view,
-                  const gfx::Vector2d& parent_to_root_origin_offset,
-                  float opacity) {
-  if (!view->visible())
-    return;
-
-  const gfx::Rect absolute_bounds =
-      view->bounds() + parent_to_root_origin_offset;
-  std::vector<const ServerView*> children(view->GetChildren());
-  const float combined_opacity = opacity * view->opacity();
-  for (std::vector<const ServerView*>::reverse_iterator it = children.rbegin();
-       it != children.rend();
-       ++it) {
-    DrawViewTree(pass, *it, absolute_bounds.OffsetFromOrigin(),
-                 combined_opacity);
-  }
-
-  cc::SurfaceId node_id = view->surface_id();
-
-  auto surface_quad_state = mojo::SurfaceQuadState::New();
-  surface_quad_state->surface = mojo::SurfaceId::From(node_id);
-
-  gfx::Transform node_transform;
-  node_transform.Translate(absolute_bounds.x(), absolute_bounds.y());
-
-  const gfx::Rect bounds_at_origin(view->bounds().size());
-  auto surface_quad = mojo::Quad::New();
-  surface_quad->material = mojo::Material::MATERIAL_SURFACE_CONTENT;
-  surface_quad->rect = Rect::From(bounds_at_origin);
-  surface_quad->opaque_rect = Rect::From(bounds_at_origin);
-  surface_quad->visible_rect = Rect::From(bounds_at_origin);
-  surface_quad->needs_blending = true;
-  surface_quad->shared_quad_state_index =
-      base::saturated_cast<int32_t>(pass->shared_quad_states.size());
-  surface_quad->surface_quad_state = surface_quad_state.Pass();
-
-  auto sqs = CreateDefaultSQS(*Size::From(view->bounds().size()));
-  sqs->blend_mode = mojo::SK_XFERMODE_kSrcOver_Mode;
-  sqs->opacity = combined_opacity;
-  sqs->content_to_target_transform = mojo::Transform::From(node_transform);
-
-  pass->quads.push_back(surface_quad.Pass());
-  pass->shared_quad_states.push_back(sqs.Pass());
-}
+// How long to wait before running animations again when a frame produced
+// nothing to draw (so there's no frame acknowledgement to wait for).
+const int64 kIdleAnimationFrameIntervalMs = 16;
 
 }  // namespace
 
@@ -80,6 +38,7 @@ DefaultDisplayManager::DefaultDisplayManager(
       connection_manager_(nullptr),
       draw_timer_(false, false),
       frame_pending_(false),
+      animation_frame_requested_(false),
       native_viewport_closed_callback_(native_viewport_closed_callback),
       weak_factory_(this) {
   metrics_.size = mojo::Size::New();
@@ -87,8 +46,24 @@ DefaultDisplayManager::DefaultDisplayManager(
   metrics_.size->height = 600;
 }
 
+DefaultDisplayManager::DefaultDisplayManager(mojo::DisplayPtr display)
+    : app_impl_(nullptr),
+      app_connection_(nullptr),
+      connection_manager_(nullptr),
+      draw_timer_(false, false),
+      frame_pending_(false),
+      animation_frame_requested_(false),
+      display_(display.Pass()),
+      weak_factory_(this) {
+  metrics_.size = mojo::Size::New();
+  metrics_.size->width = 800;
+  metrics_.size->height = 600;
+}
+
 void DefaultDisplayManager::Init(ConnectionManager* connection_manager) {
   connection_manager_ = connection_manager;
+  if (display_)
+    return;
   app_impl_->ConnectToService("mojo:native_viewport_service",
                               &native_viewport_);
   native_viewport_.set_error_handler(this);
@@ -117,14 +92,21 @@ void DefaultDisplayManager::SchedulePaint(const ServerView* view,
                                           const gfx::Rect& bounds) {
   if (!view->IsDrawn(connection_manager_->root()))
     return;
-  const gfx::Rect root_relative_rect =
+  gfx::Rect root_relative_rect =
       ConvertRectBetweenViews(view, connection_manager_->root(), bounds);
+  // Changes that can't be seen don't need a frame.
+  root_relative_rect.Intersect(GetViewportRect());
   if (root_relative_rect.IsEmpty())
     return;
   dirty_rect_.Union(root_relative_rect);
   WantToDraw();
 }
 
+void DefaultDisplayManager::RequestAnimationFrame() {
+  animation_frame_requested_ = true;
+  WantToDraw();
+}
+
 void DefaultDisplayManager::SetViewportSize(const gfx::Size& size) {
   native_viewport_->SetSize(Size::From(size));
 }
@@ -134,13 +116,30 @@ const mojo::ViewportMetrics& DefaultDisplayManager::GetViewportMetrics() {
 }
 
 void DefaultDisplayManager::Draw() {
-  Rect rect;
-  rect.width = metrics_.size->width;
-  rect.height = metrics_.size->height;
-  auto pass = CreateDefaultPass(1, rect);
+  if (animation_frame_requested_) {
+    // Animations are ticked once per frame, just before drawing, so that all
+    // of their changes end up in the one frame.
+    animation_frame_requested_ = false;
+    connection_manager_->AnimateFrame(base::TimeTicks::Now());
+  }
+  // Drawing below covers anything the animations scheduled.
+  draw_timer_.Stop();
+  if (dirty_rect_.IsEmpty()) {
+    if (animation_frame_requested_) {
+      draw_timer_.Start(
+          FROM_HERE,
+          base::TimeDelta::FromMilliseconds(kIdleAnimationFrameIntervalMs),
+          base::Bind(&DefaultDisplayManager::Draw, base::Unretained(this)));
+    }
+    return;
+  }
+
+  const gfx::Rect viewport = GetViewportRect();
+  auto pass = CreateDefaultPass(1, *Rect::From(viewport));
   pass->damage_rect = Rect::From(dirty_rect_);
 
-  DrawViewTree(pass.get(), connection_manager_->root(), gfx::Vector2d(), 1.0f);
+  DrawViewTree(pass.get(), connection_manager_->root(), gfx::Vector2d(), 1.0f,
+               viewport);
 
   auto frame = mojo::Frame::New();
   frame->passes.push_back(pass.Pass());
@@ -152,9 +151,65 @@ void DefaultDisplayManager::Draw() {
   dirty_rect_ = gfx::Rect();
 }
 
+void DefaultDisplayManager::DrawViewTree(
+    mojo::Pass* pass,
+    const ServerView* view,
+    const gfx::Vector2d& parent_to_root_origin_offset,
+    float opacity,
+    const gfx::Rect& viewport) {
+  const float combined_opacity = opacity * view->opacity();
+  // Nothing in a transparent subtree can be seen.
+  if (!view->visible() || combined_opacity <= 0.f)
+    return;
+
+  const gfx::Rect absolute_bounds =
+      view->bounds() + parent_to_root_origin_offset;
+  const ServerView::Views& children = view->children();
+  for (ServerView::Views::const_reverse_iterator it = children.rbegin();
+       it != children.rend();
+       ++it) {
+    DrawViewTree(pass, *it, absolute_bounds.OffsetFromOrigin(),
+                 combined_opacity, viewport);
+  }
+
+  // Children aren't clipped to their parent, so only the view itself is culled
+  // here. A view without a surface has nothing to draw.
+  if (view->surface_id().is_null() || !viewport.Intersects(absolute_bounds))
+    return;
+
+  auto surface_quad_state = mojo::SurfaceQuadState::New();
+  surface_quad_state->surface = mojo::SurfaceId::From(view->surface_id());
+
+  gfx::Transform node_transform;
+  node_transform.Translate(absolute_bounds.x(), absolute_bounds.y());
+
+  const gfx::Rect bounds_at_origin(view->bounds().size());
+  auto surface_quad = mojo::Quad::New();
+  surface_quad->material = mojo::Material::MATERIAL_SURFACE_CONTENT;
+  surface_quad->rect = Rect::From(bounds_at_origin);
+  surface_quad->opaque_rect = Rect::From(bounds_at_origin);
+  surface_quad->visible_rect = Rect::From(bounds_at_origin);
+  surface_quad->needs_blending = true;
+  surface_quad->shared_quad_state_index =
+      base::saturated_cast<int32_t>(pass->shared_quad_states.size());
+  surface_quad->surface_quad_state = surface_quad_state.Pass();
+
+  auto sqs = CreateDefaultSQS(*Size::From(view->bounds().size()));
+  sqs->blend_mode = mojo::SK_XFERMODE_kSrcOver_Mode;
+  sqs->opacity = combined_opacity;
+  sqs->content_to_target_transform = mojo::Transform::From(node_transform);
+
+  pass->quads.push_back(surface_quad.Pass());
+  pass->shared_quad_states.push_back(sqs.Pass());
+}
+
+gfx::Rect DefaultDisplayManager::GetViewportRect() const {
+  return gfx::Rect(metrics_.size.To<gfx::Size>());
+}
+
 void DefaultDisplayManager::DidDraw() {
   frame_pending_ = false;
-  if (!dirty_rect_.IsEmpty())
+  if (!dirty_rect_.IsEmpty() || animation_frame_requested_)
     WantToDraw();
 }
 
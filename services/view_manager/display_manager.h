@@ -42,6 +42,10 @@ class DisplayManager {
   virtual void SchedulePaint(const ServerView* view,
                              const gfx::Rect& bounds) = 0;
 
+  // Requests that ConnectionManager::AnimateFrame() be run before the next
+  // frame is drawn. Whatever the animations change is drawn in that frame.
+  virtual void RequestAnimationFrame() = 0;
+
   virtual void SetViewportSize(const gfx::Size& size) = 0;
 
   virtual const mojo::ViewportMetrics& GetViewportMetrics() = 0;
@@ -56,11 +60,15 @@ class DefaultDisplayManager : public DisplayManager,
       mojo::ApplicationImpl* app_impl,
       mojo::ApplicationConnection* app_connection,
       const mojo::Callback<void()>& native_viewport_closed_callback);
+  // Draws to |display| rather than connecting to the native viewport and
+  // surfaces services. Used by tests.
+  explicit DefaultDisplayManager(mojo::DisplayPtr display);
   ~DefaultDisplayManager() override;
 
   // DisplayManager:
   void Init(ConnectionManager* connection_manager) override;
   void SchedulePaint(const ServerView* view, const gfx::Rect& bounds) override;
+  void RequestAnimationFrame() override;
   void SetViewportSize(const gfx::Size& size) override;
   const mojo::ViewportMetrics& GetViewportMetrics() override;
 
@@ -69,6 +77,16 @@ class DefaultDisplayManager : public DisplayManager,
   void Draw();
   void DidDraw();
 
+  // Appends the quads for |view| and its descendants to |pass|, front to back.
+  // Views outside |viewport| are left out.
+  void DrawViewTree(mojo::Pass* pass,
+                    const ServerView* view,
+                    const gfx::Vector2d& parent_to_root_origin_offset,
+                    float opacity,
+                    const gfx::Rect& viewport);
+
+  gfx::Rect GetViewportRect() const;
+
   void OnMetricsChanged(mojo::ViewportMetricsPtr metrics);
 
   // ErrorHandler:
@@ -82,6 +100,7 @@ class DefaultDisplayManager : public DisplayManager,
   gfx::Rect dirty_rect_;
   base::Timer draw_timer_;
   bool frame_pending_;
+  bool animation_frame_requested_;
 
   mojo::DisplayPtr display_;
   mojo::NativeViewportPtr native_viewport_;
@@ -0,0 +1,271 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/view_manager/display_manager.h"
+
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "cc/surfaces/surface_id.h"
+#include "mojo/common/message_pump_mojo.h"
+#include "mojo/converters/geometry/geometry_type_converters.h"
+#include "mojo/converters/surfaces/surfaces_type_converters.h"
+#include "mojo/public/cpp/bindings/binding.h"
+#include "mojo/services/surfaces/public/interfaces/display.mojom.h"
+#include "mojo/services/surfaces/public/interfaces/quads.mojom.h"
+#include "mojo/services/window_manager/public/interfaces/window_manager_internal.mojom.h"
+#include "services/view_manager/client_connection.h"
+#include "services/view_manager/connection_manager.h"
+#include "services/view_manager/connection_manager_delegate.h"
+#include "services/view_manager/server_view.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/point_conversions.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/transform.h"
+
+namespace view_manager {
+namespace {
+
+// -----------------------------------------------------------------------------
+
+// Display implementation that keeps the last frame it was given.
+class TestDisplay : public mojo::Display {
+ public:
+  explicit TestDisplay(mojo::DisplayPtr* display)
+      : binding_(this, display), frame_count_(0) {}
+  ~TestDisplay() override {}
+
+  int frame_count() const { return frame_count_; }
+
+  // The root pass of the last frame.
+  const mojo::Pass& last_pass() const { return *last_frame_->passes[0]; }
+
+ private:
+  // mojo::Display:
+  void SubmitFrame(mojo::FramePtr frame,
+                   const SubmitFrameCallback& callback) override {
+    frame_count_++;
+    last_frame_ = frame.Pass();
+    callback.Run();
+  }
+
+  mojo::Binding<mojo::Display> binding_;
+  int frame_count_;
+  mojo::FramePtr last_frame_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestDisplay);
+};
+
+// -----------------------------------------------------------------------------
+
+class TestConnectionManagerDelegate : public ConnectionManagerDelegate {
+ public:
+  TestConnectionManagerDelegate() {}
+  ~TestConnectionManagerDelegate() override {}
+
+ private:
+  // ConnectionManagerDelegate:
+  void OnLostConnectionToWindowManager() override {}
+  ClientConnection* CreateClientConnectionForEmbedAtView(
+      ConnectionManager* connection_manager,
+      mojo::InterfaceRequest<mojo::ViewManagerService> service_request,
+      mojo::ConnectionSpecificId creator_id,
+      const std::string& creator_url,
+      const std::string& url,
+      const ViewId& root_id) override {
+    NOTIMPLEMENTED();
+    return nullptr;
+  }
+  ClientConnection* CreateClientConnectionForEmbedAtView(
+      ConnectionManager* connection_manager,
+      mojo::InterfaceRequest<mojo::ViewManagerService> service_request,
+      mojo::ConnectionSpecificId creator_id,
+      const std::string& creator_url,
+      const ViewId& root_id,
+      mojo::ViewManagerClientPtr client) override {
+    NOTIMPLEMENTED();
+    return nullptr;
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(TestConnectionManagerDelegate);
+};
+
+// -----------------------------------------------------------------------------
+
+class TestWindowManagerInternal : public mojo::WindowManagerInternal {
+ public:
+  TestWindowManagerInternal() {}
+  ~TestWindowManagerInternal() override {}
+
+  // WindowManagerInternal:
+  void CreateWindowManagerForViewManagerClient(
+      uint16_t connection_id,
+      mojo::ScopedMessagePipeHandle window_manager_pipe) override {}
+  void SetViewManagerClient(mojo::ScopedMessagePipeHandle) override {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TestWindowManagerInternal);
+};
+
+cc::SurfaceId QuadSurfaceId(const mojo::Quad& quad) {
+  return quad.surface_quad_state->surface.To<cc::SurfaceId>();
+}
+
+// Returns where the quad at |index| in |pass| is drawn, in root coordinates.
+gfx::Rect QuadBounds(const mojo::Pass& pass, size_t index) {
+  const mojo::Quad& quad = *pass.quads[index];
+  const gfx::Transform transform =
+      pass.shared_quad_states[quad.shared_quad_state_index]
+          ->content_to_target_transform.To<gfx::Transform>();
+  const gfx::PointF origin =
+      gfx::PointAtOffsetFromOrigin(transform.To2dTranslation());
+  return gfx::Rect(gfx::ToFlooredPoint(origin),
+                   quad.rect.To<gfx::Rect>().size());
+}
+
+float QuadOpacity(const mojo::Pass& pass, size_t index) {
+  return pass.shared_quad_states[pass.quads[index]->shared_quad_state_index]
+      ->opacity;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+
+class DisplayManagerTest : public testing::Test {
+ public:
+  DisplayManagerTest()
+      : message_loop_(
+            scoped_ptr<base::MessagePump>(new mojo::common::MessagePumpMojo)),
+        display_manager_(nullptr) {}
+  ~DisplayManagerTest() override {}
+
+  ConnectionManager* connection_manager() { return connection_manager_.get(); }
+  DefaultDisplayManager* display_manager() { return display_manager_; }
+  TestDisplay* display() { return display_.get(); }
+
+  // Creates a visible view with a surface, parented to the root.
+  scoped_ptr<ServerView> CreateView(uint32_t id, const gfx::Rect& bounds) {
+    scoped_ptr<ServerView> view(
+        connection_manager_->CreateServerView(ViewId(1, id)));
+    view->SetBounds(bounds);
+    view->SetVisible(true);
+    view->SetSurfaceId(cc::SurfaceId(id));
+    connection_manager_->root()->Add(view.get());
+    return view.Pass();
+  }
+
+  // Runs any pending draw, returning the number of frames submitted.
+  int Draw() {
+    const int frame_count = display_->frame_count();
+    base::RunLoop().RunUntilIdle();
+    return display_->frame_count() - frame_count;
+  }
+
+ protected:
+  void SetUp() override {
+    mojo::DisplayPtr display;
+    display_.reset(new TestDisplay(&display));
+    display_manager_ = new DefaultDisplayManager(display.Pass());
+    connection_manager_.reset(new ConnectionManager(
+        &delegate_, scoped_ptr<DisplayManager>(display_manager_),
+        &wm_internal_));
+    Draw();
+  }
+
+ private:
+  base::MessageLoop message_loop_;
+  scoped_ptr<TestDisplay> display_;
+
+  // Owned by |connection_manager_|.
+  DefaultDisplayManager* display_manager_;
+
+  TestConnectionManagerDelegate delegate_;
+  TestWindowManagerInternal wm_internal_;
+  scoped_ptr<ConnectionManager> connection_manager_;
+
+  DISALLOW_COPY_AND_ASSIGN(DisplayManagerTest);
+};
+
+// Views that can't be seen don't get quads.
+TEST_F(DisplayManagerTest, CullsInvisibleViews) {
+  scoped_ptr<ServerView> drawn(CreateView(1, gfx::Rect(10, 20, 30, 40)));
+  scoped_ptr<ServerView> off_viewport(CreateView(2, gfx::Rect(900, 0, 50, 50)));
+  scoped_ptr<ServerView> transparent(CreateView(3, gfx::Rect(0, 0, 50, 50)));
+  transparent->SetOpacity(0.f);
+  scoped_ptr<ServerView> no_surface(CreateView(4, gfx::Rect(0, 0, 50, 50)));
+  no_surface->SetSurfaceId(cc::SurfaceId());
+  // Children of a transparent view can't be seen either.
+  scoped_ptr<ServerView> transparent_child(
+      connection_manager()->CreateServerView(ViewId(1, 5)));
+  transparent_child->SetBounds(gfx::Rect(0, 0, 10, 10));
+  transparent_child->SetVisible(true);
+  transparent_child->SetSurfaceId(cc::SurfaceId(5));
+  transparent->Add(transparent_child.get());
+
+  EXPECT_EQ(1, Draw());
+  const mojo::Pass& pass = display()->last_pass();
+  ASSERT_EQ(1u, pass.quads.size());
+  ASSERT_EQ(1u, pass.shared_quad_states.size());
+  EXPECT_EQ(cc::SurfaceId(1), QuadSurfaceId(*pass.quads[0]));
+  EXPECT_EQ(gfx::Rect(10, 20, 30, 40), QuadBounds(pass, 0));
+  EXPECT_EQ(1.f, QuadOpacity(pass, 0));
+
+  // A view partially in the viewport is drawn.
+  off_viewport->SetBounds(gfx::Rect(790, 0, 50, 50));
+  EXPECT_EQ(1, Draw());
+  ASSERT_EQ(2u, display()->last_pass().quads.size());
+}
+
+// Quads follow changes to the view's bounds, opacity and surface.
+TEST_F(DisplayManagerTest, RebuildsChangedViews) {
+  scoped_ptr<ServerView> view(CreateView(1, gfx::Rect(10, 20, 30, 40)));
+  EXPECT_EQ(1, Draw());
+
+  view->SetBounds(gfx::Rect(50, 60, 70, 80));
+  EXPECT_EQ(1, Draw());
+  ASSERT_EQ(1u, display()->last_pass().quads.size());
+  EXPECT_EQ(gfx::Rect(50, 60, 70, 80), QuadBounds(display()->last_pass(), 0));
+
+  view->SetOpacity(.5f);
+  EXPECT_EQ(1, Draw());
+  ASSERT_EQ(1u, display()->last_pass().quads.size());
+  EXPECT_EQ(.5f, QuadOpacity(display()->last_pass(), 0));
+
+  // Opacity combines with the parent's.
+  connection_manager()->root()->SetOpacity(.5f);
+  EXPECT_EQ(1, Draw());
+  ASSERT_EQ(1u, display()->last_pass().quads.size());
+  EXPECT_EQ(.25f, QuadOpacity(display()->last_pass(), 0));
+
+  view->SetSurfaceId(cc::SurfaceId(7));
+  EXPECT_EQ(1, Draw());
+  ASSERT_EQ(1u, display()->last_pass().quads.size());
+  EXPECT_EQ(cc::SurfaceId(7), QuadSurfaceId(*display()->last_pass().quads[0]));
+}
+
+// Only damage inside the viewport produces a frame.
+TEST_F(DisplayManagerTest, NoFrameWithoutVisibleDamage) {
+  scoped_ptr<ServerView> view(CreateView(1, gfx::Rect(10, 20, 30, 40)));
+  scoped_ptr<ServerView> off_viewport(CreateView(2, gfx::Rect(900, 0, 50, 50)));
+  EXPECT_EQ(1, Draw());
+
+  // Nothing is dirty.
+  EXPECT_EQ(0, Draw());
+
+  // Changes to a view entirely outside the viewport can't be seen.
+  off_viewport->SetOpacity(.5f);
+  EXPECT_EQ(0, Draw());
+
+  display_manager()->SchedulePaint(connection_manager()->root(),
+                                   gfx::Rect(0, 700, 10, 10));
+  EXPECT_EQ(0, Draw());
+
+  display_manager()->SchedulePaint(connection_manager()->root(),
+                                   gfx::Rect(0, 0, 10, 10));
+  EXPECT_EQ(1, Draw());
+  EXPECT_EQ(gfx::Rect(0, 0, 10, 10),
+            display()->last_pass().damage_rect.To<gfx::Rect>());
+}
+
+}  // namespace view_manager
@@ -9,6 +9,8 @@
 #include "base/strings/stringprintf.h"
 #include "services/view_manager/server_view_delegate.h"
 #include "services/view_manager/server_view_observer.h"
+#include "ui/gfx/geometry/point_f.h"
+#include "ui/gfx/point3_f.h"
 
 namespace view_manager {
 
@@ -18,6 +20,7 @@ ServerView::ServerView(ServerViewDelegate* delegate, const ViewId& id)
       parent_(nullptr),
       visible_(false),
       opacity_(1),
+      hit_test_cache_valid_(false),
       // Don't notify newly added observers during notification. This causes
       // problems for code that adds an observer as part of an observer
       // notification (such as ServerViewDrawTracker).
@@ -68,6 +71,7 @@ void ServerView::Add(ServerView* child) {
 
   child->parent_ = this;
   children_.push_back(child);
+  InvalidateHitTestCache();
   FOR_EACH_OBSERVER(ServerViewObserver, child->observers_,
                     OnViewHierarchyChanged(child, this, old_parent));
 }
@@ -102,6 +106,7 @@ void ServerView::Reorder(ServerView* child,
     DCHECK(i != children_.end());
     children_.insert(i, child);
   }
+  InvalidateHitTestCache();
   FOR_EACH_OBSERVER(ServerViewObserver, observers_,
                     OnViewReordered(this, relative, direction));
 }
@@ -112,6 +117,8 @@ void ServerView::SetBounds(const gfx::Rect& bounds) {
 
   const gfx::Rect old_bounds = bounds_;
   bounds_ = bounds;
+  if (parent_)
+    parent_->InvalidateHitTestCache();
   FOR_EACH_OBSERVER(ServerViewObserver, observers_,
                     OnViewBoundsChanged(this, old_bounds, bounds));
 }
@@ -136,6 +143,29 @@ std::vector<ServerView*> ServerView::GetChildren() {
   return children_;
 }
 
+const ServerView* ServerView::GetChildAt(const gfx::PointF& location,
+                                         gfx::PointF* child_location) const {
+  if (!hit_test_cache_valid_)
+    UpdateHitTestCache();
+
+  for (const HitTestEntry& entry : hit_test_cache_) {
+    if (!entry.bounds.Contains(location))
+      continue;
+
+    // |bounds| is only a bounding box if the child is rotated or skewed, so
+    // check against the child's actual bounds.
+    gfx::Point3F point(location);
+    entry.to_child.TransformPoint(&point);
+    const gfx::PointF local_location(point.AsPointF());
+    if (!gfx::RectF(entry.view->bounds().size()).Contains(local_location))
+      continue;
+
+    *child_location = local_location;
+    return entry.view;
+  }
+  return nullptr;
+}
+
 bool ServerView::Contains(const ServerView* view) const {
   for (const ServerView* parent = view; parent; parent = parent->parent_) {
     if (parent == this)
@@ -152,6 +182,8 @@ void ServerView::SetVisible(bool value) {
   FOR_EACH_OBSERVER(ServerViewObserver, observers_,
                     OnWillChangeViewVisibility(this));
   visible_ = value;
+  if (parent_)
+    parent_->InvalidateHitTestCache();
   FOR_EACH_OBSERVER(ServerViewObserver, observers_,
                     OnViewVisibilityChanged(this));
 }
@@ -168,6 +200,8 @@ void ServerView::SetTransform(const gfx::Transform& transform) {
     return;
 
   transform_ = transform;
+  if (parent_)
+    parent_->InvalidateHitTestCache();
   delegate_->OnScheduleViewPaint(this);
 }
 
@@ -229,6 +263,35 @@ void ServerView::BuildDebugInfo(const std::string& depth,
 void ServerView::RemoveImpl(ServerView* view) {
   view->parent_ = NULL;
   children_.erase(std::find(children_.begin(), children_.end(), view));
+  InvalidateHitTestCache();
+}
+
+void ServerView::InvalidateHitTestCache() {
+  hit_test_cache_valid_ = false;
+}
+
+void ServerView::UpdateHitTestCache() const {
+  hit_test_cache_.clear();
+  for (Views::const_reverse_iterator it = children_.rbegin();
+       it != children_.rend(); ++it) {
+    const ServerView* child = *it;
+    if (!child->visible())
+      continue;
+
+    // The child's transform applies in its own coordinates.
+    gfx::Transform to_parent;
+    to_parent.Translate(child->bounds().x(), child->bounds().y());
+    to_parent.PreconcatTransform(child->transform());
+
+    HitTestEntry entry;
+    entry.view = child;
+    if (!to_parent.GetInverse(&entry.to_child))
+      continue;  // Collapsed to nothing, so it can't be hit.
+    entry.bounds = gfx::RectF(child->bounds().size());
+    to_parent.TransformRect(&entry.bounds);
+    hit_test_cache_.push_back(entry);
+  }
+  hit_test_cache_valid_ = true;
 }
 
 }  // namespace view_manager
@@ -13,8 +13,13 @@
 #include "mojo/services/view_manager/public/interfaces/view_manager.mojom.h"
 #include "services/view_manager/ids.h"
 #include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/rect_f.h"
 #include "ui/gfx/transform.h"
 
+namespace gfx {
+class PointF;
+}
+
 namespace view_manager {
 
 class ServerViewDelegate;
@@ -32,6 +37,8 @@ class ServerViewObserver;
 // view is deleted the deleted view is implicitly removed from the parent.
 class ServerView {
  public:
+  typedef std::vector<ServerView*> Views;
+
   ServerView(ServerViewDelegate* delegate, const ViewId& id);
   virtual ~ServerView();
 
@@ -58,9 +65,20 @@ class ServerView {
         const_cast<const ServerView*>(this)->GetRoot());
   }
 
+  // Returns the children in increasing z-order (topmost last). Unlike
+  // GetChildren() this doesn't copy.
+  const Views& children() const { return children_; }
+
   std::vector<const ServerView*> GetChildren() const;
   std::vector<ServerView*> GetChildren();
 
+  // Returns the topmost visible child containing |location| (in this view's
+  // coordinates), taking the children's transforms into account, and sets
+  // |child_location| to |location| in that child's coordinates. Returns null if
+  // there is no such child. The children's bounds are cached between calls.
+  const ServerView* GetChildAt(const gfx::PointF& location,
+                               gfx::PointF* child_location) const;
+
   // Returns true if this contains |view| or is |view|.
   bool Contains(const ServerView* view) const;
 
@@ -93,11 +111,23 @@ class ServerView {
 #endif
 
  private:
-  typedef std::vector<ServerView*> Views;
+  // Cached hit testing information for a visible child.
+  struct HitTestEntry {
+    const ServerView* view;
+    // The child's bounds, after its transform, in this view's coordinates.
+    gfx::RectF bounds;
+    // Maps from this view's coordinates to the child's.
+    gfx::Transform to_child;
+  };
 
   // Implementation of removing a view. Doesn't send any notification.
   void RemoveImpl(ServerView* view);
 
+  // Called when the bounds, transform, visibility or order of the children
+  // change.
+  void InvalidateHitTestCache();
+  void UpdateHitTestCache() const;
+
   ServerViewDelegate* delegate_;
   const ViewId id_;
   ServerView* parent_;
@@ -110,6 +140,11 @@ class ServerView {
 
   std::map<std::string, std::vector<uint8_t>> properties_;
 
+  // Visible children, topmost first. The vector is reused when the cache is
+  // rebuilt, so hit testing doesn't allocate.
+  mutable std::vector<HitTestEntry> hit_test_cache_;
+  mutable bool hit_test_cache_valid_;
+
   ObserverList<ServerViewObserver> observers_;
 
   DISALLOW_COPY_AND_ASSIGN(ServerView);
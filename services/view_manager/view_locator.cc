@@ -5,23 +5,19 @@
 #include "services/view_manager/view_locator.h"
 
 #include "services/view_manager/server_view.h"
+#include "ui/gfx/geometry/point.h"
+#include "ui/gfx/geometry/point_f.h"
 
 namespace view_manager {
 
 const ServerView* FindDeepestVisibleView(const ServerView* view,
                                          const gfx::Point& location) {
-  for (const ServerView* child : view->GetChildren()) {
-    if (!child->visible())
-      continue;
-
-    // TODO(sky): support transform.
-    const gfx::Point child_location(location.x() - child->bounds().x(),
-                                    location.y() - child->bounds().y());
-    if (child_location.x() >= 0 && child_location.y() >= 0 &&
-        child_location.x() < child->bounds().width() &&
-        child_location.y() < child->bounds().height()) {
-      return FindDeepestVisibleView(child, child_location);
-    }
+  gfx::PointF view_location(location.x(), location.y());
+  gfx::PointF child_location;
+  while (const ServerView* child =
+             view->GetChildAt(view_location, &child_location)) {
+    view = child;
+    view_location = child_location;
   }
   return view;
 }
@@ -13,7 +13,8 @@ namespace view_manager {
 
 class ServerView;
 
-// Finds the deepest visible view that contains the specified location.
+// Finds the deepest visible view that contains the specified location (in
+// |view|'s coordinates). Where children overlap, the topmost one is used.
 const ServerView* FindDeepestVisibleView(const ServerView* view,
                                          const gfx::Point& location);
 ServerView* FindDeepestVisibleView(ServerView* view,
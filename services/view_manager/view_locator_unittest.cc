@@ -0,0 +1,90 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/view_manager/view_locator.h"
+
+#include "services/view_manager/server_view.h"
+#include "services/view_manager/test_server_view_delegate.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/point.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/transform.h"
+
+namespace view_manager {
+
+using ViewLocatorTest = testing::Test;
+
+TEST_F(ViewLocatorTest, FindDeepest) {
+  TestServerViewDelegate delegate;
+  ServerView v1(&delegate, ViewId()), v2(&delegate, ViewId()),
+      v3(&delegate, ViewId());
+  v1.SetBounds(gfx::Rect(0, 0, 100, 100));
+  v2.SetBounds(gfx::Rect(10, 10, 50, 50));
+  v3.SetBounds(gfx::Rect(5, 5, 10, 10));
+  v1.SetVisible(true);
+  v2.SetVisible(true);
+  v3.SetVisible(true);
+  v1.Add(&v2);
+  v2.Add(&v3);
+
+  EXPECT_EQ(&v3, FindDeepestVisibleView(&v1, gfx::Point(15, 15)));
+  EXPECT_EQ(&v2, FindDeepestVisibleView(&v1, gfx::Point(30, 30)));
+  EXPECT_EQ(&v1, FindDeepestVisibleView(&v1, gfx::Point(70, 70)));
+
+  v3.SetVisible(false);
+  EXPECT_EQ(&v2, FindDeepestVisibleView(&v1, gfx::Point(15, 15)));
+
+  v2.SetBounds(gfx::Rect(60, 60, 20, 20));
+  EXPECT_EQ(&v1, FindDeepestVisibleView(&v1, gfx::Point(30, 30)));
+  EXPECT_EQ(&v2, FindDeepestVisibleView(&v1, gfx::Point(70, 70)));
+}
+
+TEST_F(ViewLocatorTest, Topmost) {
+  TestServerViewDelegate delegate;
+  ServerView v1(&delegate, ViewId()), v2(&delegate, ViewId()),
+      v3(&delegate, ViewId());
+  v1.SetBounds(gfx::Rect(0, 0, 100, 100));
+  v2.SetBounds(gfx::Rect(0, 0, 50, 50));
+  v3.SetBounds(gfx::Rect(25, 25, 50, 50));
+  v1.SetVisible(true);
+  v2.SetVisible(true);
+  v3.SetVisible(true);
+  v1.Add(&v2);
+  v1.Add(&v3);
+
+  EXPECT_EQ(&v3, FindDeepestVisibleView(&v1, gfx::Point(30, 30)));
+
+  v1.Reorder(&v2, &v3, mojo::ORDER_DIRECTION_ABOVE);
+  EXPECT_EQ(&v2, FindDeepestVisibleView(&v1, gfx::Point(30, 30)));
+
+  v1.Remove(&v2);
+  EXPECT_EQ(&v3, FindDeepestVisibleView(&v1, gfx::Point(30, 30)));
+}
+
+TEST_F(ViewLocatorTest, Transform) {
+  TestServerViewDelegate delegate;
+  ServerView v1(&delegate, ViewId()), v2(&delegate, ViewId());
+  v1.SetBounds(gfx::Rect(0, 0, 100, 100));
+  v2.SetBounds(gfx::Rect(10, 10, 20, 20));
+  v1.SetVisible(true);
+  v2.SetVisible(true);
+  v1.Add(&v2);
+
+  EXPECT_EQ(&v1, FindDeepestVisibleView(&v1, gfx::Point(40, 40)));
+
+  // Doubling the size of |v2| puts (40, 40) inside it.
+  gfx::Transform scale;
+  scale.Scale(2, 2);
+  v2.SetTransform(scale);
+  EXPECT_EQ(&v2, FindDeepestVisibleView(&v1, gfx::Point(40, 40)));
+  EXPECT_EQ(&v1, FindDeepestVisibleView(&v1, gfx::Point(55, 55)));
+
+  // A view that has been scaled to nothing can't be hit.
+  gfx::Transform collapse;
+  collapse.Scale(0, 0);
+  v2.SetTransform(collapse);
+  EXPECT_EQ(&v1, FindDeepestVisibleView(&v1, gfx::Point(10, 10)));
+}
+
+}  // namespace view_manager
@@ -176,13 +176,21 @@ class TestConnectionManagerDelegate : public ConnectionManagerDelegate {
 // Empty implementation of DisplayManager.
 class TestDisplayManager : public DisplayManager {
  public:
-  TestDisplayManager() {}
+  TestDisplayManager() : animation_frame_requested_(false) {}
   ~TestDisplayManager() override {}
 
+  // Returns whether RequestAnimationFrame() was called since the last call.
+  bool GetAndClearAnimationFrameRequested() {
+    const bool requested = animation_frame_requested_;
+    animation_frame_requested_ = false;
+    return requested;
+  }
+
   // DisplayManager:
   void Init(ConnectionManager* connection_manager) override {}
   void SchedulePaint(const ServerView* view, const gfx::Rect& bounds) override {
   }
+  void RequestAnimationFrame() override { animation_frame_requested_ = true; }
   void SetViewportSize(const gfx::Size& size) override {}
   const mojo::ViewportMetrics& GetViewportMetrics() override {
     return display_metrices_;
@@ -190,6 +198,7 @@ class TestDisplayManager : public DisplayManager {
 
  private:
   mojo::ViewportMetrics display_metrices_;
+  bool animation_frame_requested_;
 
   DISALLOW_COPY_AND_ASSIGN(TestDisplayManager);
 };
@@ -236,13 +245,16 @@ class ViewManagerServiceTest : public testing::Test {
 
   ConnectionManager* connection_manager() { return connection_manager_.get(); }
 
+  TestDisplayManager* display_manager() { return display_manager_; }
+
   TestViewManagerClient* wm_client() { return wm_client_; }
 
  protected:
   // testing::Test:
   void SetUp() override {
+    display_manager_ = new TestDisplayManager;
     connection_manager_.reset(new ConnectionManager(
-        &delegate_, scoped_ptr<DisplayManager>(new TestDisplayManager),
+        &delegate_, scoped_ptr<DisplayManager>(display_manager_),
         &wm_internal_));
     scoped_ptr<ViewManagerServiceImpl> service(new ViewManagerServiceImpl(
         connection_manager_.get(), kInvalidConnectionId, std::string(),
@@ -261,6 +273,9 @@ class ViewManagerServiceTest : public testing::Test {
   // TestViewManagerClient that is used for the WM connection.
   TestViewManagerClient* wm_client_;
 
+  // Owned by |connection_manager_|.
+  TestDisplayManager* display_manager_;
+
   TestWindowManagerInternal wm_internal_;
   TestConnectionManagerDelegate delegate_;
   scoped_ptr<ConnectionManager> connection_manager_;
@@ -421,6 +436,42 @@ TEST_F(ViewManagerServiceTest, ClonedViewsPromotedOnHide) {
   EXPECT_TRUE(cloned_view->parent()->GetChildren()[1] == cloned_view);
 }
 
+// Verifies the cloned view fades out as animation frames are run, and is
+// deleted at the end without any client being told.
+TEST_F(ViewManagerServiceTest, ClonedViewFadesOutOnAnimationFrames) {
+  display_manager()->GetAndClearAnimationFrameRequested();
+  ViewId embed_view_id;
+  EXPECT_NO_FATAL_FAILURE(SetUpAnimate1(this, &embed_view_id));
+  EXPECT_TRUE(display_manager()->GetAndClearAnimationFrameRequested());
+
+  ViewManagerServiceImpl* connection1 =
+      connection_manager()->GetConnectionWithRoot(embed_view_id);
+  const ServerView* v1 = connection1->GetView(ViewId(connection1->id(), 1));
+  const ServerView* cloned_view = GetFirstCloned(v1);
+  ASSERT_TRUE(cloned_view);
+  EXPECT_EQ(1.f, cloned_view->opacity());
+  EXPECT_TRUE(connection_manager()->animation_runner()->HasAnimations());
+
+  TestViewManagerClient* connection1_client = last_view_manager_client();
+  const base::TimeTicks start = base::TimeTicks::Now();
+  connection_manager()->AnimateFrame(start +
+                                     base::TimeDelta::FromMilliseconds(1000));
+  ASSERT_EQ(cloned_view, GetFirstCloned(v1));
+  EXPECT_GT(1.f, cloned_view->opacity());
+  EXPECT_LT(0.f, cloned_view->opacity());
+  // The animation isn't done, so another frame is wanted.
+  EXPECT_TRUE(display_manager()->GetAndClearAnimationFrameRequested());
+
+  connection_manager()->AnimateFrame(start +
+                                     base::TimeDelta::FromMilliseconds(3000));
+  EXPECT_FALSE(GetFirstCloned(v1));
+  EXPECT_FALSE(connection_manager()->animation_runner()->HasAnimations());
+  EXPECT_FALSE(display_manager()->GetAndClearAnimationFrameRequested());
+
+  EXPECT_TRUE(connection1_client->tracker()->changes()->empty());
+  EXPECT_TRUE(wm_client()->tracker()->changes()->empty());
+}
+
 // Clone and animate on a tree with more depth. Basically that of
 // SetUpAnimate1() but cloning 2,1.
 TEST_F(ViewManagerServiceTest, CloneAndAnimateLargerDepth) {
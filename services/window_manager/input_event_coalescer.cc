@@ -0,0 +1,157 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/window_manager/input_event_coalescer.h"
+
+#include <vector>
+
+#include "base/logging.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "ui/events/event_utils.h"
+
+namespace window_manager {
+
+namespace {
+
+// Moves are sent at most once a frame (at 60Hz).
+const int64 kFrameIntervalMicroseconds = 16667;
+
+bool IsPointerMove(const mojo::EventPtr& event) {
+  return event && event->action == mojo::EVENT_TYPE_POINTER_MOVE &&
+         event->pointer_data;
+}
+
+// Merges the move |pending| into the later move |event|.
+void MergeMove(mojo::EventPtr pending, mojo::Event* event) {
+  DCHECK(!event->pointer_history);
+  mojo::PointerDataPtr previous = pending->pointer_data.Pass();
+  event->pointer_data->horizontal_wheel += previous->horizontal_wheel;
+  event->pointer_data->vertical_wheel += previous->vertical_wheel;
+
+  mojo::Array<mojo::PointerDataPtr> history = pending->pointer_history.Pass();
+  if (history.is_null())
+    history = mojo::Array<mojo::PointerDataPtr>(0u);
+  if (history.size() == InputEventCoalescer::kMaxHistorySamples) {
+    std::vector<mojo::PointerDataPtr> samples;
+    history.Swap(&samples);
+    samples.erase(samples.begin());
+    history.Swap(&samples);
+  }
+  history.push_back(previous.Pass());
+  event->pointer_history = history.Pass();
+}
+
+}  // namespace
+
+struct InputEventCoalescer::PendingEvent {
+  PendingEvent(mojo::Id view_id, mojo::EventPtr event)
+      : view_id(view_id),
+        first_time_stamp(event ? event->time_stamp : 0),
+        event(event.Pass()) {}
+
+  mojo::Id view_id;
+  // Time stamp of the oldest sample merged into |event|.
+  int64 first_time_stamp;
+  mojo::EventPtr event;
+};
+
+// static
+const size_t InputEventCoalescer::kMaxHistorySamples;
+
+InputEventCoalescer::InputEventCoalescer(
+    const DispatchCallback& dispatch_callback)
+    : dispatch_callback_(dispatch_callback) {
+}
+
+InputEventCoalescer::~InputEventCoalescer() {
+}
+
+void InputEventCoalescer::QueueEvent(mojo::Id view_id, mojo::EventPtr event) {
+  if (!IsPointerMove(event)) {
+    FlushView(view_id);
+    PendingEvent pending_event(view_id, event.Pass());
+    Dispatch(&pending_event);
+    return;
+  }
+
+  for (PendingEvent* pending_event : pending_events_) {
+    if (pending_event->view_id != view_id ||
+        pending_event->event->pointer_data->pointer_id !=
+            event->pointer_data->pointer_id) {
+      continue;
+    }
+
+    if (pending_event->event->flags != event->flags) {
+      // Something changed in between (e.g., a modifier was pressed), so this
+      // can't stand in for the held move.
+      FlushView(view_id);
+      break;
+    }
+
+    MergeMove(pending_event->event.Pass(), event.get());
+    pending_event->event = event.Pass();
+    return;
+  }
+
+  if (!frame_timer_.IsRunning()) {
+    // Nothing has been sent for a frame, so there's no reason to wait.
+    PendingEvent pending_event(view_id, event.Pass());
+    Dispatch(&pending_event);
+    frame_timer_.Start(
+        FROM_HERE,
+        base::TimeDelta::FromMicroseconds(kFrameIntervalMicroseconds), this,
+        &InputEventCoalescer::OnFrameTimer);
+    return;
+  }
+
+  pending_events_.push_back(new PendingEvent(view_id, event.Pass()));
+}
+
+void InputEventCoalescer::Flush() {
+  ScopedVector<PendingEvent> pending_events;
+  pending_events.swap(pending_events_);
+  for (PendingEvent* pending_event : pending_events)
+    Dispatch(pending_event);
+}
+
+void InputEventCoalescer::FlushView(mojo::Id view_id) {
+  for (size_t i = 0; i < pending_events_.size();) {
+    if (pending_events_[i]->view_id == view_id) {
+      Dispatch(pending_events_[i]);
+      pending_events_.erase(pending_events_.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
+
+void InputEventCoalescer::Dispatch(PendingEvent* pending_event) {
+  if (pending_event->event) {
+    // Measures from when the (oldest) native event happened.
+    const base::TimeDelta latency =
+        ui::EventTimeForNow() -
+        base::TimeDelta::FromInternalValue(pending_event->first_time_stamp);
+    const size_t num_samples =
+        1u + pending_event->event->pointer_history.size();
+    TRACE_EVENT_INSTANT2("input", "InputEventCoalescer::Dispatch",
+                         TRACE_EVENT_SCOPE_THREAD, "latency_us",
+                         latency.InMicroseconds(), "samples", num_samples);
+  }
+  dispatch_callback_.Run(pending_event->view_id, pending_event->event.Pass());
+}
+
+void InputEventCoalescer::OnFrameTimer() {
+  // If nothing was held during the frame, the next move can be sent straight
+  // away.
+  if (pending_events_.empty())
+    return;
+
+  Flush();
+  frame_timer_.Start(
+      FROM_HERE, base::TimeDelta::FromMicroseconds(kFrameIntervalMicroseconds),
+      this, &InputEventCoalescer::OnFrameTimer);
+}
+
+}  // namespace window_manager
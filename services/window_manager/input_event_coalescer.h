@@ -0,0 +1,65 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SERVICES_WINDOW_MANAGER_INPUT_EVENT_COALESCER_H_
+#define SERVICES_WINDOW_MANAGER_INPUT_EVENT_COALESCER_H_
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/scoped_vector.h"
+#include "base/timer/timer.h"
+#include "mojo/services/input_events/public/interfaces/input_events.mojom.h"
+#include "mojo/services/view_manager/public/cpp/types.h"
+
+namespace window_manager {
+
+// Sits between event targeting and the view manager, and cuts down the number
+// of pointer moves sent to views. A move is sent straight away if nothing has
+// been sent for a frame; otherwise it's held until the end of the frame, and
+// any further moves of the same pointer to the same view are merged into it
+// (see |mojo::Event::pointer_history|). Any other event for a view first sends
+// the moves held for that view, so each view sees its events in order.
+class InputEventCoalescer {
+ public:
+  typedef base::Callback<void(mojo::Id, mojo::EventPtr)> DispatchCallback;
+
+  // Most samples kept in |pointer_history|; older ones are dropped.
+  static const size_t kMaxHistorySamples = 64;
+
+  explicit InputEventCoalescer(const DispatchCallback& dispatch_callback);
+  ~InputEventCoalescer();
+
+  // Sends (now or later) |event| to the view |view_id|.
+  void QueueEvent(mojo::Id view_id, mojo::EventPtr event);
+
+  // Sends all the held moves.
+  void Flush();
+
+  size_t num_pending_events() const { return pending_events_.size(); }
+
+ private:
+  struct PendingEvent;
+
+  // Sends the held moves for |view_id|.
+  void FlushView(mojo::Id view_id);
+
+  void Dispatch(PendingEvent* pending_event);
+
+  void OnFrameTimer();
+
+  const DispatchCallback dispatch_callback_;
+
+  // Held moves, in the order they arrived. There are at most a few (one per
+  // view and pointer), so they're searched linearly.
+  ScopedVector<PendingEvent> pending_events_;
+
+  // Runs while a frame's worth of moves is being held back.
+  base::OneShotTimer<InputEventCoalescer> frame_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(InputEventCoalescer);
+};
+
+}  // namespace window_manager
+
+#endif  // SERVICES_WINDOW_MANAGER_INPUT_EVENT_COALESCER_H_
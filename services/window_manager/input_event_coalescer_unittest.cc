@@ -0,0 +1,165 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "services/window_manager/input_event_coalescer.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace window_manager {
+namespace {
+
+mojo::EventPtr CreatePointerEvent(mojo::EventType action,
+                                  int32_t pointer_id,
+                                  float x,
+                                  float y) {
+  mojo::EventPtr event(mojo::Event::New());
+  event->action = action;
+  event->flags = mojo::EVENT_FLAGS_NONE;
+  event->pointer_data = mojo::PointerData::New();
+  event->pointer_data->pointer_id = pointer_id;
+  event->pointer_data->kind = mojo::POINTER_KIND_MOUSE;
+  event->pointer_data->x = x;
+  event->pointer_data->y = y;
+  return event.Pass();
+}
+
+mojo::EventPtr CreateMove(int32_t pointer_id, float x, float y) {
+  return CreatePointerEvent(mojo::EVENT_TYPE_POINTER_MOVE, pointer_id, x, y);
+}
+
+struct DispatchedEvent {
+  mojo::Id view_id;
+  mojo::EventType action;
+  float x;
+  // Number of samples merged into the event.
+  size_t num_samples;
+};
+
+class InputEventCoalescerTest : public testing::Test {
+ public:
+  InputEventCoalescerTest()
+      : coalescer_(base::Bind(&InputEventCoalescerTest::OnDispatch,
+                              base::Unretained(this))) {}
+  ~InputEventCoalescerTest() override {}
+
+ protected:
+  InputEventCoalescer* coalescer() { return &coalescer_; }
+  std::vector<DispatchedEvent>* dispatched() { return &dispatched_; }
+  const mojo::EventPtr& last_event() const { return last_event_; }
+
+ private:
+  void OnDispatch(mojo::Id view_id, mojo::EventPtr event) {
+    DispatchedEvent dispatched_event = {
+        view_id, event->action, event->pointer_data->x,
+        1u + event->pointer_history.size()};
+    dispatched_.push_back(dispatched_event);
+    last_event_ = event.Pass();
+  }
+
+  base::MessageLoop message_loop_;
+  InputEventCoalescer coalescer_;
+  std::vector<DispatchedEvent> dispatched_;
+  mojo::EventPtr last_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(InputEventCoalescerTest);
+};
+
+TEST_F(InputEventCoalescerTest, MergesMovesWithinFrame) {
+  // The first move goes straight through.
+  coalescer()->QueueEvent(1, CreateMove(0, 1, 1));
+  ASSERT_EQ(1u, dispatched()->size());
+  EXPECT_EQ(1.f, (*dispatched())[0].x);
+  EXPECT_EQ(0u, coalescer()->num_pending_events());
+
+  // Later ones in the same frame are merged.
+  coalescer()->QueueEvent(1, CreateMove(0, 2, 2));
+  coalescer()->QueueEvent(1, CreateMove(0, 3, 3));
+  coalescer()->QueueEvent(1, CreateMove(0, 4, 4));
+  EXPECT_EQ(1u, dispatched()->size());
+  EXPECT_EQ(1u, coalescer()->num_pending_events());
+
+  coalescer()->Flush();
+  ASSERT_EQ(2u, dispatched()->size());
+  EXPECT_EQ(4.f, (*dispatched())[1].x);
+  EXPECT_EQ(3u, (*dispatched())[1].num_samples);
+  ASSERT_EQ(2u, last_event()->pointer_history.size());
+  EXPECT_EQ(2.f, last_event()->pointer_history[0]->x);
+  EXPECT_EQ(3.f, last_event()->pointer_history[1]->x);
+  EXPECT_EQ(0u, coalescer()->num_pending_events());
+}
+
+TEST_F(InputEventCoalescerTest, OtherEventsFlushMovesFirst) {
+  coalescer()->QueueEvent(1, CreateMove(0, 1, 1));
+  coalescer()->QueueEvent(1, CreateMove(0, 2, 2));
+  coalescer()->QueueEvent(2, CreateMove(0, 5, 5));
+  EXPECT_EQ(2u, coalescer()->num_pending_events());
+
+  coalescer()->QueueEvent(
+      1, CreatePointerEvent(mojo::EVENT_TYPE_POINTER_DOWN, 0, 3, 3));
+  ASSERT_EQ(3u, dispatched()->size());
+  EXPECT_EQ(mojo::EVENT_TYPE_POINTER_MOVE, (*dispatched())[1].action);
+  EXPECT_EQ(2.f, (*dispatched())[1].x);
+  EXPECT_EQ(mojo::EVENT_TYPE_POINTER_DOWN, (*dispatched())[2].action);
+
+  // The move held for the other view isn't affected.
+  EXPECT_EQ(1u, coalescer()->num_pending_events());
+  coalescer()->Flush();
+  ASSERT_EQ(4u, dispatched()->size());
+  EXPECT_EQ(2u, (*dispatched())[3].view_id);
+}
+
+TEST_F(InputEventCoalescerTest, SumsWheelOffsets) {
+  coalescer()->QueueEvent(1, CreateMove(0, 1, 1));
+  for (int i = 0; i < 3; i++) {
+    mojo::EventPtr wheel = CreateMove(0, 1, 1);
+    wheel->pointer_data->vertical_wheel = 10;
+    wheel->pointer_data->horizontal_wheel = 1;
+    coalescer()->QueueEvent(1, wheel.Pass());
+  }
+  coalescer()->Flush();
+  ASSERT_EQ(2u, dispatched()->size());
+  EXPECT_EQ(30.f, last_event()->pointer_data->vertical_wheel);
+  EXPECT_EQ(3.f, last_event()->pointer_data->horizontal_wheel);
+}
+
+TEST_F(InputEventCoalescerTest, DoesNotMergeDifferentPointersOrFlags) {
+  coalescer()->QueueEvent(1, CreateMove(0, 1, 1));
+  coalescer()->QueueEvent(1, CreateMove(0, 2, 2));
+  coalescer()->QueueEvent(1, CreateMove(1, 3, 3));
+  EXPECT_EQ(2u, coalescer()->num_pending_events());
+
+  mojo::EventPtr shifted = CreateMove(0, 4, 4);
+  shifted->flags = mojo::EVENT_FLAGS_SHIFT_DOWN;
+  coalescer()->QueueEvent(1, shifted.Pass());
+  // The moves held before the flags changed were sent.
+  EXPECT_EQ(3u, dispatched()->size());
+  EXPECT_EQ(1u, coalescer()->num_pending_events());
+
+  coalescer()->Flush();
+  ASSERT_EQ(4u, dispatched()->size());
+  EXPECT_EQ(4.f, (*dispatched())[3].x);
+  EXPECT_EQ(1u, (*dispatched())[3].num_samples);
+}
+
+TEST_F(InputEventCoalescerTest, CapsHistory) {
+  coalescer()->QueueEvent(1, CreateMove(0, 0, 0));
+  const size_t num_moves = InputEventCoalescer::kMaxHistorySamples + 10;
+  for (size_t i = 1; i <= num_moves; i++)
+    coalescer()->QueueEvent(1, CreateMove(0, static_cast<float>(i), 0));
+  coalescer()->Flush();
+  ASSERT_EQ(2u, dispatched()->size());
+  ASSERT_EQ(InputEventCoalescer::kMaxHistorySamples,
+            last_event()->pointer_history.size());
+  // The oldest samples were dropped.
+  EXPECT_EQ(static_cast<float>(num_moves - 1),
+            last_event()->pointer_history[
+                InputEventCoalescer::kMaxHistorySamples - 1]->x);
+}
+
+}  // namespace
+}  // namespace window_manager
@@ -25,6 +25,7 @@ DEFINE_OWNED_VIEW_PROPERTY_KEY(ViewTarget, kViewTargetKey, nullptr);
 }  // namespace
 
 ViewTarget::~ViewTarget() {
+  view_->RemoveObserver(this);
 }
 
 // static
@@ -42,12 +43,22 @@ ViewTarget* ViewTarget::TargetFromView(mojo::View* view) {
 void ViewTarget::ConvertPointToTarget(const ViewTarget* source,
                                       const ViewTarget* target,
                                       gfx::Point* point) {
-  // TODO(erg): Do we need to deal with |source| and |target| being in
-  // different trees?
-  DCHECK_EQ(source->GetRoot(), target->GetRoot());
   if (source == target)
     return;
 
+  // Targeting converts between parents and children at every level, so avoid
+  // going through the root for those.
+  if (target->GetParent() == source) {
+    *point -= target->GetBounds().OffsetFromOrigin();
+    return;
+  }
+  if (source->GetParent() == target) {
+    *point += source->GetBounds().OffsetFromOrigin();
+    return;
+  }
+
+  // TODO(erg): Do we need to deal with |source| and |target| being in
+  // different trees?
   const ViewTarget* root_target = source->GetRoot();
   CHECK_EQ(root_target, target->GetRoot());
 
@@ -57,11 +68,14 @@ void ViewTarget::ConvertPointToTarget(const ViewTarget* source,
     target->ConvertPointFromAncestor(root_target, point);
 }
 
-std::vector<ViewTarget*> ViewTarget::GetChildren() {
-  std::vector<ViewTarget*> targets;
-  for (mojo::View* child : view_->children())
-    targets.push_back(TargetFromView(child));
-  return targets;
+const std::vector<ViewTarget*>& ViewTarget::GetChildren() {
+  if (!children_valid_) {
+    children_.clear();
+    for (mojo::View* child : view_->children())
+      children_.push_back(TargetFromView(child));
+    children_valid_ = true;
+  }
+  return children_;
 }
 
 const ViewTarget* ViewTarget::GetParent() const {
@@ -120,8 +134,10 @@ ui::EventTarget* ViewTarget::GetParentTarget() {
 }
 
 scoped_ptr<ui::EventTargetIterator> ViewTarget::GetChildIterator() {
+  // The cache can't be invalidated while the iterator is in use: targeting
+  // doesn't change the hierarchy.
   return scoped_ptr<ui::EventTargetIterator>(
-      new ui::CopyingEventTargetIteratorImpl<ViewTarget>(GetChildren()));
+      new ui::EventTargetIteratorImpl<ViewTarget>(GetChildren()));
 }
 
 ui::EventTargeter* ViewTarget::GetEventTargeter() {
@@ -133,9 +149,11 @@ void ViewTarget::ConvertEventToTarget(ui::EventTarget* target,
   event->ConvertLocationToTarget(this, static_cast<ViewTarget*>(target));
 }
 
-ViewTarget::ViewTarget(mojo::View* view_to_wrap) : view_(view_to_wrap) {
+ViewTarget::ViewTarget(mojo::View* view_to_wrap)
+    : view_(view_to_wrap), children_valid_(false) {
   DCHECK(view_->GetLocalProperty(kViewTargetKey) == nullptr);
   view_->SetLocalProperty(kViewTargetKey, this);
+  view_->AddObserver(this);
 }
 
 bool ViewTarget::ConvertPointForAncestor(const ViewTarget* ancestor,
@@ -164,4 +182,25 @@ bool ViewTarget::GetTargetOffsetRelativeTo(const ViewTarget* ancestor,
   return v == ancestor;
 }
 
+void ViewTarget::InvalidateChildren() {
+  children_valid_ = false;
+  children_.clear();
+}
+
+void ViewTarget::OnTreeChanged(const TreeChangeParams& params) {
+  // We're told about changes anywhere in our subtree (and about changes to our
+  // ancestors); only our own children matter.
+  if (params.old_parent == view_ || params.new_parent == view_)
+    InvalidateChildren();
+}
+
+void ViewTarget::OnViewReordered(mojo::View* view,
+                                 mojo::View* relative,
+                                 mojo::OrderDirection direction) {
+  // Reorders are only reported to the view being moved.
+  DCHECK_EQ(view_, view);
+  if (view_->parent())
+    TargetFromView(view_->parent())->InvalidateChildren();
+}
+
 }  // namespace window_manager
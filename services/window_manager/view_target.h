@@ -5,6 +5,9 @@
 #ifndef SERVICES_WINDOW_MANAGER_VIEW_TARGET_H_
 #define SERVICES_WINDOW_MANAGER_VIEW_TARGET_H_
 
+#include <vector>
+
+#include "mojo/services/view_manager/public/cpp/view_observer.h"
 #include "ui/events/event_target.h"
 
 namespace gfx {
@@ -33,7 +36,11 @@ class WindowManagerApp;
 //
 // We set ourselves as a property of the view passed in, and we are owned by
 // said View.
-class ViewTarget : public ui::EventTarget {
+//
+// The targets of the view's children are cached (since every located event
+// walks them), and the cache is invalidated when children are added, removed
+// or reordered.
+class ViewTarget : public ui::EventTarget, public mojo::ViewObserver {
  public:
   ~ViewTarget() override;
 
@@ -55,7 +62,7 @@ class ViewTarget : public ui::EventTarget {
   // accept const objects. (When that gets done, re-const the
   // EventTargetIterator::GetNextTarget and EventTarget::GetChildIterator
   // interfaces.)
-  std::vector<ViewTarget*> GetChildren();
+  const std::vector<ViewTarget*>& GetChildren();
 
   const ViewTarget* GetParent() const;
   gfx::Rect GetBounds() const;
@@ -87,9 +94,22 @@ class ViewTarget : public ui::EventTarget {
   bool GetTargetOffsetRelativeTo(const ViewTarget* ancestor,
                                  gfx::Vector2d* offset) const;
 
+  void InvalidateChildren();
+
+  // Overridden from mojo::ViewObserver:
+  void OnTreeChanged(const TreeChangeParams& params) override;
+  void OnViewReordered(mojo::View* view,
+                       mojo::View* relative,
+                       mojo::OrderDirection direction) override;
+
   // The mojo::View that we dispatch to.
   mojo::View* view_;
 
+  // Targets of |view_|'s children, in the same (increasing z-) order. Only
+  // valid if |children_valid_|.
+  std::vector<ViewTarget*> children_;
+  bool children_valid_;
+
   scoped_ptr<ViewTargeter> targeter_;
 
   DISALLOW_COPY_AND_ASSIGN(ViewTarget);
@@ -78,4 +78,35 @@ TEST_F(ViewTargetTest, ConvertPointToTarget_Medium) {
   EXPECT_EQ(point2_in_t3_coords, point2_in_t1_coords);
 }
 
+// V1
+//  +-- V2
+//  +-- V3
+TEST_F(ViewTargetTest, GetChildrenTracksHierarchy) {
+  TestView v1(1, gfx::Rect(0, 0, 400, 400));
+  TestView v2(2, gfx::Rect(10, 10, 100, 100));
+  TestView v3(3, gfx::Rect(20, 20, 100, 100));
+  v1.AddChild(&v2);
+  v1.AddChild(&v3);
+
+  ViewTarget* t1 = v1.target();
+  ASSERT_EQ(2u, t1->GetChildren().size());
+  EXPECT_EQ(v2.target(), t1->GetChildren()[0]);
+  EXPECT_EQ(v3.target(), t1->GetChildren()[1]);
+
+  v2.MoveToFront();
+  ASSERT_EQ(2u, t1->GetChildren().size());
+  EXPECT_EQ(v3.target(), t1->GetChildren()[0]);
+  EXPECT_EQ(v2.target(), t1->GetChildren()[1]);
+
+  v1.RemoveChild(&v3);
+  ASSERT_EQ(1u, t1->GetChildren().size());
+  EXPECT_EQ(v2.target(), t1->GetChildren()[0]);
+
+  // Adding to a grandchild doesn't change |t1|'s children.
+  v2.AddChild(&v3);
+  ASSERT_EQ(1u, t1->GetChildren().size());
+  ASSERT_EQ(1u, v2.target()->GetChildren().size());
+  EXPECT_EQ(v3.target(), v2.target()->GetChildren()[0]);
+}
+
 }  // namespace window_manager
@@ -4,6 +4,7 @@
 
 #include "services/window_manager/window_manager_app.h"
 
+#include "base/bind.h"
 #include "base/message_loop/message_loop.h"
 #include "base/stl_util.h"
 #include "mojo/converters/geometry/geometry_type_converters.h"
@@ -55,7 +56,10 @@ WindowManagerApp::WindowManagerApp(
     : shell_(nullptr),
       wrapped_view_manager_delegate_(view_manager_delegate),
       window_manager_delegate_(window_manager_delegate),
-      root_(nullptr) {
+      root_(nullptr),
+      input_event_coalescer_(
+          base::Bind(&WindowManagerApp::SendInputEventToView,
+                     base::Unretained(this))) {
 }
 
 WindowManagerApp::~WindowManagerApp() {
@@ -253,8 +257,7 @@ void WindowManagerApp::OnEvent(ui::Event* event) {
   if (focus_controller_)
     focus_controller_->OnEvent(event);
 
-  window_manager_client_->DispatchInputEventToView(view->id(),
-                                                   mojo::Event::From(*event));
+  input_event_coalescer_.QueueEvent(view->id(), mojo::Event::From(*event));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -347,13 +350,19 @@ void WindowManagerApp::Unregister(View* view) {
 
 void WindowManagerApp::DispatchInputEventToView(View* view,
                                                 mojo::EventPtr event) {
-  window_manager_client_->DispatchInputEventToView(view->id(), event.Pass());
+  input_event_coalescer_.QueueEvent(view->id(), event.Pass());
 }
 
 void WindowManagerApp::SetViewportSize(const gfx::Size& size) {
   window_manager_client_->SetViewportSize(mojo::Size::From(size));
 }
 
+void WindowManagerApp::SendInputEventToView(Id view_id,
+                                            mojo::EventPtr event) {
+  if (window_manager_client_)
+    window_manager_client_->DispatchInputEventToView(view_id, event.Pass());
+}
+
 void WindowManagerApp::LaunchViewManager(mojo::ApplicationImpl* app) {
   // TODO(sky): figure out logic if this connection goes away.
   view_manager_client_factory_.reset(
@@ -20,6 +20,7 @@
 #include "mojo/services/window_manager/public/interfaces/window_manager_internal.mojom.h"
 #include "services/window_manager/capture_controller_observer.h"
 #include "services/window_manager/focus_controller_observer.h"
+#include "services/window_manager/input_event_coalescer.h"
 #include "services/window_manager/native_viewport_event_dispatcher_impl.h"
 #include "services/window_manager/view_target.h"
 #include "services/window_manager/window_manager_impl.h"
@@ -157,6 +158,9 @@ class WindowManagerApp
   // Creates the connection to the ViewManager.
   void LaunchViewManager(mojo::ApplicationImpl* app);
 
+  // Sends the events that |input_event_coalescer_| lets through.
+  void SendInputEventToView(mojo::Id view_id, mojo::EventPtr event);
+
   // InterfaceFactory<WindowManagerInternal>:
   void Create(
       mojo::ApplicationConnection* connection,
@@ -197,6 +201,8 @@ class WindowManagerApp
 
   mojo::WindowManagerInternalClientPtr window_manager_client_;
 
+  InputEventCoalescer input_event_coalescer_;
+
   ScopedVector<PendingEmbed> pending_embeds_;
 
   scoped_ptr<mojo::ViewManagerClient> view_manager_client_;
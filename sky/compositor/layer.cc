@@ -4,6 +4,7 @@
 
 #include "sky/compositor/layer.h"
 
+#include "base/bind.h"
 #include "base/trace_event/trace_event.h"
 #include "sky/compositor/layer_host.h"
 #include "sky/compositor/picture_serializer.h"
@@ -13,27 +14,51 @@
 
 namespace sky {
 
-Layer::Layer(LayerClient* client) : client_(client) {
+Layer::Layer(LayerClient* client)
+    : client_(client),
+      contents_may_have_changed_(false),
+      weak_factory_(this) {
 }
 
 Layer::~Layer() {
 }
 
 void Layer::SetSize(const gfx::Size& size) {
+  if (size == size_)
+    return;
   size_ = size;
+  SetNeedsDisplay();
 }
 
-void Layer::Display() {
+void Layer::SetNeedsDisplayInRect(const gfx::Rect& rect) {
+  damage_.Union(gfx::IntersectRects(rect, gfx::Rect(size_)));
+}
+
+void Layer::Display(const base::Closure& callback) {
   TRACE_EVENT0("sky", "Layer::Display");
   DCHECK(rasterizer_);
-  auto picture = RecordPicture();
+  if (contents_may_have_changed_ || !damage_.IsEmpty() || !picture_) {
+    picture_ = RecordPicture();
+    damage_.Union(picture_differ_.Update(picture_.get()));
+    contents_may_have_changed_ = false;
+  }
 
 #if 0
   SerializePicture(
-      "/data/data/org.chromium.mojo.shell/cache/layer0.skp", picture.get());
+      "/data/data/org.chromium.mojo.shell/cache/layer0.skp", picture_.get());
 #endif
 
-  texture_ = rasterizer_->Rasterize(picture.get());
+  const gfx::Rect damage = damage_;
+  damage_ = gfx::Rect();
+  rasterizer_->Rasterize(picture_, damage,
+                         base::Bind(&Layer::DidRaster,
+                                    weak_factory_.GetWeakPtr(), callback));
+}
+
+void Layer::DidRaster(const base::Closure& callback,
+                      scoped_ptr<mojo::GLTexture> texture) {
+  texture_ = texture.Pass();
+  callback.Run();
 }
 
 skia::RefPtr<SkPicture> Layer::RecordPicture() {
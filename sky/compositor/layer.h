@@ -5,10 +5,13 @@
 #ifndef SKY_COMPOSITOR_LAYER_H_
 #define SKY_COMPOSITOR_LAYER_H_
 
+#include "base/callback.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "mojo/gpu/gl_texture.h"
 #include "skia/ext/refptr.h"
 #include "sky/compositor/layer_client.h"
+#include "sky/compositor/picture_differ.h"
 #include "sky/compositor/rasterizer.h"
 #include "third_party/skia/include/core/SkPicture.h"
 #include "ui/gfx/geometry/rect.h"
@@ -22,7 +25,20 @@ class Layer : public base::RefCounted<Layer> {
   explicit Layer(LayerClient* client);
 
   void SetSize(const gfx::Size& size);
-  void Display();
+
+  // Marks |rect| as needing to be repainted by the next Display().
+  void SetNeedsDisplayInRect(const gfx::Rect& rect);
+  void SetNeedsDisplay() { SetNeedsDisplayInRect(gfx::Rect(size_)); }
+
+  // Re-records the contents at the next Display(), damaging only the tiles
+  // that draw differently than before. For clients that don't know what they
+  // invalidated.
+  void SetContentsMayHaveChanged() { contents_may_have_changed_ = true; }
+
+  // Records the layer's contents and rasters them, then runs |callback| once
+  // GetTexture() has the result. The callback may be run before Display()
+  // returns.
+  void Display(const base::Closure& callback);
 
   scoped_ptr<mojo::GLTexture> GetTexture();
 
@@ -37,12 +53,22 @@ class Layer : public base::RefCounted<Layer> {
   ~Layer();
 
   skia::RefPtr<SkPicture> RecordPicture();
+  void DidRaster(const base::Closure& callback,
+                 scoped_ptr<mojo::GLTexture> texture);
 
   LayerClient* client_;
   gfx::Size size_;
+  // The area that changed since the last Display().
+  gfx::Rect damage_;
+  bool contents_may_have_changed_;
+  // The last picture recorded, reused if nothing changed since.
+  skia::RefPtr<SkPicture> picture_;
+  PictureDiffer picture_differ_;
   scoped_ptr<mojo::GLTexture> texture_;
   scoped_ptr<Rasterizer> rasterizer_;
 
+  base::WeakPtrFactory<Layer> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(Layer);
 };
 
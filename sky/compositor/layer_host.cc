@@ -77,16 +77,13 @@ void LayerHost::BeginFrame() {
     return;
   }
 
-  {
-    mojo::GaneshContext::Scope scope(&ganesh_context_);
-    ganesh_context_.gr()->resetContext();
-    root_layer_->Display();
-  }
-
-  Upload(root_layer_.get());
+  // Rasterizing may finish later (off this thread); the frame is uploaded
+  // once it does.
+  root_layer_->Display(base::Bind(&LayerHost::Upload,
+                                  weak_factory_.GetWeakPtr(), root_layer_));
 }
 
-void LayerHost::Upload(Layer* layer) {
+void LayerHost::Upload(scoped_refptr<Layer> layer) {
   TRACE_EVENT0("sky", "LayerHost::Upload");
 
   gfx::Size size = layer->size();
@@ -104,7 +101,7 @@ void LayerHost::Upload(Layer* layer) {
       mojo::TypeConverter<mojo::Size, gfx::Size>::Convert(size)));
 
   mojo::TransferableResourcePtr resource =
-      resource_manager_.CreateTransferableResource(layer);
+      resource_manager_.CreateTransferableResource(layer.get());
 
   mojo::QuadPtr quad = mojo::Quad::New();
   quad->material = mojo::MATERIAL_TEXTURE_CONTENT;
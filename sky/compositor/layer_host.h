@@ -55,7 +55,7 @@ class LayerHost : public SurfaceHolder::Client {
   void BeginFrameSoon();
   void BeginFrame();
 
-  void Upload(Layer* layer);
+  void Upload(scoped_refptr<Layer> layer);
   void DidCompleteFrame();
 
   LayerHostClient* client_;
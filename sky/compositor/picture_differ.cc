@@ -0,0 +1,73 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/compositor/picture_differ.h"
+
+#include "base/hash.h"
+#include "base/trace_event/trace_event.h"
+#include "skia/ext/refptr.h"
+#include "sky/compositor/raster_worker_pool.h"
+#include "third_party/skia/include/core/SkCanvas.h"
+#include "third_party/skia/include/core/SkData.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
+#include "third_party/skia/include/core/SkStream.h"
+#include "ui/gfx/skia_util.h"
+
+namespace sky {
+namespace {
+
+// Plays back the commands of |picture| that touch |tile| and hashes them.
+// Pictures recorded with a bounding box hierarchy skip the other commands,
+// so this is much cheaper than rastering the tile.
+uint32 FingerprintTile(const SkPicture* picture, const gfx::Rect& tile) {
+  SkPictureRecorder recorder;
+  SkCanvas* canvas = recorder.beginRecording(gfx::RectToSkRect(tile));
+  canvas->clipRect(gfx::RectToSkRect(tile));
+  picture->playback(canvas);
+  skia::RefPtr<SkPicture> tile_picture =
+      skia::AdoptRef(recorder.endRecordingAsPicture());
+
+  SkDynamicMemoryWStream stream;
+  tile_picture->serialize(&stream);
+  skia::RefPtr<SkData> data = skia::AdoptRef(stream.copyToData());
+  return base::Hash(static_cast<const char*>(data->data()), data->size());
+}
+
+}  // namespace
+
+PictureDiffer::PictureDiffer() {
+}
+
+PictureDiffer::~PictureDiffer() {
+}
+
+gfx::Rect PictureDiffer::Update(const SkPicture* picture) {
+  TRACE_EVENT0("sky", "PictureDiffer::Update");
+
+  const SkRect cull_rect = picture->cullRect();
+  const gfx::Size size(cull_rect.width(), cull_rect.height());
+  const std::vector<gfx::Rect> tiles =
+      RasterWorkerPool::GetTilesInRect(size, gfx::Rect(size));
+
+  std::vector<uint32> fingerprints;
+  fingerprints.reserve(tiles.size());
+  for (const gfx::Rect& tile : tiles)
+    fingerprints.push_back(FingerprintTile(picture, tile));
+
+  gfx::Rect damage;
+  if (size != size_ || fingerprints.size() != tile_fingerprints_.size()) {
+    damage = gfx::Rect(size);
+  } else {
+    for (size_t i = 0; i < tiles.size(); i++) {
+      if (fingerprints[i] != tile_fingerprints_[i])
+        damage.Union(tiles[i]);
+    }
+  }
+
+  size_ = size;
+  tile_fingerprints_.swap(fingerprints);
+  return damage;
+}
+
+}  // namespace sky
@@ -0,0 +1,40 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_COMPOSITOR_PICTURE_DIFFER_H_
+#define SKY_COMPOSITOR_PICTURE_DIFFER_H_
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "third_party/skia/include/core/SkPicture.h"
+#include "ui/gfx/geometry/rect.h"
+
+namespace sky {
+
+// Works out which tiles of a layer changed when its client can't say what it
+// invalidated. Each tile of a picture is fingerprinted by the drawing
+// commands that touch it, and a tile is damaged when its fingerprint differs
+// from the one it had in the previous picture. Tiles match those of
+// RasterWorkerPool.
+class PictureDiffer {
+ public:
+  PictureDiffer();
+  ~PictureDiffer();
+
+  // Returns the part of |picture| that draws differently from the picture
+  // passed to the last call, rounded out to whole tiles. All of |picture| is
+  // damaged the first time, and when its size changes.
+  gfx::Rect Update(const SkPicture* picture);
+
+ private:
+  gfx::Size size_;
+  std::vector<uint32> tile_fingerprints_;
+
+  DISALLOW_COPY_AND_ASSIGN(PictureDiffer);
+};
+
+}  // namespace sky
+
+#endif  // SKY_COMPOSITOR_PICTURE_DIFFER_H_
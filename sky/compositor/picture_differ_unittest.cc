@@ -0,0 +1,88 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/compositor/picture_differ.h"
+
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "skia/ext/refptr.h"
+#include "sky/compositor/raster_worker_pool.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/skia/include/core/SkCanvas.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
+
+namespace sky {
+namespace {
+
+const int kWidth = 600;
+const int kHeight = 300;
+
+// A blue picture with a small square of |color| at (300, 10), which is in the
+// second tile of the first row. Recorded the way Layer records.
+skia::RefPtr<SkPicture> RecordPicture(SkColor color,
+                                      int width = kWidth,
+                                      int height = kHeight) {
+  SkRTreeFactory factory;
+  SkPictureRecorder recorder;
+  SkCanvas* canvas = recorder.beginRecording(width, height, &factory);
+  canvas->drawColor(SK_ColorBLUE);
+  SkPaint paint;
+  paint.setColor(color);
+  canvas->drawRect(SkRect::MakeXYWH(300, 10, 20, 20), paint);
+  return skia::AdoptRef(recorder.endRecordingAsPicture());
+}
+
+TEST(PictureDifferTest, DamagesChangedTiles) {
+  PictureDiffer differ;
+  EXPECT_EQ(gfx::Rect(kWidth, kHeight),
+            differ.Update(RecordPicture(SK_ColorRED).get()));
+
+  // The same drawing again damages nothing.
+  EXPECT_TRUE(differ.Update(RecordPicture(SK_ColorRED).get()).IsEmpty());
+
+  // Only the tile with the square changes.
+  EXPECT_EQ(gfx::Rect(256, 0, 256, 256),
+            differ.Update(RecordPicture(SK_ColorGREEN).get()));
+
+  // A new size damages everything.
+  EXPECT_EQ(gfx::Rect(kWidth, 400),
+            differ.Update(RecordPicture(SK_ColorGREEN, kWidth, 400).get()));
+}
+
+TEST(PictureDifferTest, OnlyDamagedTilesAreRasteredAgain) {
+  base::MessageLoop message_loop;
+  RasterWorkerPool pool(2, base::Closure());
+  PictureDiffer differ;
+
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(kWidth, kHeight);
+  skia::RefPtr<SkPicture> picture = RecordPicture(SK_ColorRED);
+  {
+    base::RunLoop run_loop;
+    pool.Raster(picture, bitmap, differ.Update(picture.get()),
+                run_loop.QuitClosure());
+    run_loop.Run();
+  }
+
+  // Mark the first tile, which the next picture leaves alone, so we can see
+  // whether it's rastered again.
+  bitmap.eraseArea(SkIRect::MakeWH(256, 256), SK_ColorMAGENTA);
+
+  picture = RecordPicture(SK_ColorGREEN);
+  {
+    base::RunLoop run_loop;
+    pool.Raster(picture, bitmap, differ.Update(picture.get()),
+                run_loop.QuitClosure());
+    run_loop.Run();
+  }
+
+  SkAutoLockPixels bitmap_lock(bitmap);
+  EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(310, 20));
+  EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(400, 200));
+  EXPECT_EQ(SK_ColorMAGENTA, bitmap.getColor(10, 10));
+  EXPECT_EQ(SK_ColorMAGENTA, bitmap.getColor(255, 255));
+}
+
+}  // namespace
+}  // namespace sky
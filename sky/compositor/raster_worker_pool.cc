@@ -0,0 +1,154 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/compositor/raster_worker_pool.h"
+
+#include <algorithm>
+
+#include "base/atomic_ref_count.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/ref_counted.h"
+#include "base/strings/stringprintf.h"
+#include "base/thread_task_runner_handle.h"
+#include "base/threading/thread.h"
+#include "base/trace_event/trace_event.h"
+#include "third_party/skia/include/core/SkCanvas.h"
+#include "ui/gfx/skia_util.h"
+
+namespace sky {
+
+// The state shared by the workers of one Raster() call. The last worker to
+// finish posts the callback back to the thread Raster() was called on.
+class RasterWorkerPool::RasterJob
+    : public base::RefCountedThreadSafe<RasterJob> {
+ public:
+  RasterJob(skia::RefPtr<SkPicture> picture,
+            const SkBitmap& bitmap,
+            int num_workers,
+            const base::Closure& idle_callback,
+            const base::Closure& callback)
+      : picture_(picture),
+        bitmap_(bitmap),
+        remaining_workers_(num_workers),
+        origin_task_runner_(base::ThreadTaskRunnerHandle::Get()),
+        idle_callback_(idle_callback),
+        callback_(callback) {}
+
+  void RasterTiles(const std::vector<gfx::Rect>& tiles) {
+    for (const gfx::Rect& tile : tiles)
+      RasterTile(tile);
+    if (!idle_callback_.is_null())
+      idle_callback_.Run();
+    if (!base::AtomicRefCountDec(&remaining_workers_))
+      origin_task_runner_->PostTask(FROM_HERE, callback_);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<RasterJob>;
+  ~RasterJob() {}
+
+  void RasterTile(const gfx::Rect& tile) {
+    TRACE_EVENT0("sky", "RasterWorkerPool::RasterTile");
+
+    // The subset shares |bitmap_|'s pixels. Tiles don't overlap, so each
+    // thread writes to its own pixels.
+    SkBitmap tile_bitmap;
+    bitmap_.extractSubset(&tile_bitmap, gfx::RectToSkIRect(tile));
+    SkCanvas canvas(tile_bitmap);
+    canvas.translate(-tile.x(), -tile.y());
+    // Draw red so we can see when we fail to paint.
+    canvas.drawColor(SK_ColorRED);
+    canvas.drawPicture(picture_.get());
+    canvas.flush();
+  }
+
+  const skia::RefPtr<SkPicture> picture_;
+  const SkBitmap bitmap_;
+  base::AtomicRefCount remaining_workers_;
+  const scoped_refptr<base::SingleThreadTaskRunner> origin_task_runner_;
+  const base::Closure idle_callback_;
+  const base::Closure callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(RasterJob);
+};
+
+// static
+const int RasterWorkerPool::kTileSize;
+
+RasterWorkerPool::RasterWorkerPool(int num_threads,
+                                   const base::Closure& idle_callback)
+    : idle_callback_(idle_callback), next_thread_(0u) {
+  DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; i++) {
+    scoped_ptr<base::Thread> thread(
+        new base::Thread(base::StringPrintf("SkyRasterWorker%d", i + 1)));
+    CHECK(thread->Start());
+    threads_.push_back(thread.release());
+  }
+}
+
+RasterWorkerPool::~RasterWorkerPool() {
+  // Joins the threads, so any tiles in flight finish first.
+  threads_.clear();
+}
+
+// static
+std::vector<gfx::Rect> RasterWorkerPool::GetTilesInRect(
+    const gfx::Size& size,
+    const gfx::Rect& rect) {
+  std::vector<gfx::Rect> tiles;
+  gfx::Rect area(size);
+  area.Intersect(rect);
+  if (area.IsEmpty())
+    return tiles;
+
+  const int first_column = area.x() / kTileSize;
+  const int last_column = (area.right() - 1) / kTileSize;
+  const int first_row = area.y() / kTileSize;
+  const int last_row = (area.bottom() - 1) / kTileSize;
+  for (int row = first_row; row <= last_row; row++) {
+    for (int column = first_column; column <= last_column; column++) {
+      gfx::Rect tile(column * kTileSize, row * kTileSize, kTileSize,
+                     kTileSize);
+      // Tiles on the right and bottom edges are cut to the picture.
+      tile.Intersect(gfx::Rect(size));
+      tiles.push_back(tile);
+    }
+  }
+  return tiles;
+}
+
+void RasterWorkerPool::Raster(skia::RefPtr<SkPicture> picture,
+                              const SkBitmap& bitmap,
+                              const gfx::Rect& damage,
+                              const base::Closure& callback) {
+  TRACE_EVENT0("sky", "RasterWorkerPool::Raster");
+  DCHECK(!bitmap.isNull());
+
+  const std::vector<gfx::Rect> tiles = GetTilesInRect(
+      gfx::Size(bitmap.width(), bitmap.height()), damage);
+  if (tiles.empty()) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE, callback);
+    return;
+  }
+
+  // Deal the tiles out to the workers, each of which rasters its share in one
+  // task.
+  std::vector<std::vector<gfx::Rect>> worker_tiles(
+      std::min(tiles.size(), threads_.size()));
+  for (size_t i = 0; i < tiles.size(); i++)
+    worker_tiles[i % worker_tiles.size()].push_back(tiles[i]);
+
+  scoped_refptr<RasterJob> job(
+      new RasterJob(picture, bitmap, static_cast<int>(worker_tiles.size()),
+                    idle_callback_, callback));
+  for (const std::vector<gfx::Rect>& share : worker_tiles) {
+    threads_[next_thread_]->task_runner()->PostTask(
+        FROM_HERE, base::Bind(&RasterJob::RasterTiles, job, share));
+    next_thread_ = (next_thread_ + 1) % threads_.size();
+  }
+}
+
+}  // namespace sky
@@ -0,0 +1,62 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_COMPOSITOR_RASTER_WORKER_POOL_H_
+#define SKY_COMPOSITOR_RASTER_WORKER_POOL_H_
+
+#include <vector>
+
+#include "base/callback.h"
+#include "base/memory/scoped_vector.h"
+#include "skia/ext/refptr.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkPicture.h"
+#include "ui/gfx/geometry/rect.h"
+
+namespace base {
+class Thread;
+}
+
+namespace sky {
+
+// Plays pictures back into bitmaps on a set of worker threads. Pictures are
+// split into tiles, which are rastered in parallel. Only the tiles touching
+// the damaged part of a picture are redrawn; the rest of the bitmap is left
+// as it was.
+class RasterWorkerPool {
+ public:
+  static const int kTileSize = 256;
+
+  // |idle_callback|, if not null, runs on a worker each time it finishes its
+  // share of a Raster() call, before that call's callback is posted.
+  RasterWorkerPool(int num_threads, const base::Closure& idle_callback);
+  ~RasterWorkerPool();
+
+  // Returns the tiles of a |size| sized picture that intersect |rect|.
+  static std::vector<gfx::Rect> GetTilesInRect(const gfx::Size& size,
+                                               const gfx::Rect& rect);
+
+  // Rasters the tiles of |picture| touching |damage| into |bitmap|, which has
+  // to be allocated and as big as the picture, then runs |callback| on the
+  // calling thread. |bitmap|'s pixels mustn't be used until then.
+  void Raster(skia::RefPtr<SkPicture> picture,
+              const SkBitmap& bitmap,
+              const gfx::Rect& damage,
+              const base::Closure& callback);
+
+ private:
+  class RasterJob;
+
+  ScopedVector<base::Thread> threads_;
+  const base::Closure idle_callback_;
+
+  // Thread the next tile goes to.
+  size_t next_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(RasterWorkerPool);
+};
+
+}  // namespace sky
+
+#endif  // SKY_COMPOSITOR_RASTER_WORKER_POOL_H_
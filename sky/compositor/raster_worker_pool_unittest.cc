@@ -0,0 +1,148 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/compositor/raster_worker_pool.h"
+
+#include "base/atomic_ref_count.h"
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/skia/include/core/SkCanvas.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
+
+namespace sky {
+namespace {
+
+const int kWidth = 600;
+const int kHeight = 300;
+
+// A picture filled with |color|, with a diagonal line across it so that tiles
+// that are placed wrongly show up.
+skia::RefPtr<SkPicture> RecordPicture(SkColor color) {
+  SkPictureRecorder recorder;
+  SkCanvas* canvas = recorder.beginRecording(kWidth, kHeight);
+  canvas->drawColor(color);
+  SkPaint paint;
+  paint.setColor(SK_ColorBLACK);
+  paint.setStrokeWidth(3);
+  canvas->drawLine(0, 0, kWidth, kHeight, paint);
+  return skia::AdoptRef(recorder.endRecordingAsPicture());
+}
+
+class RasterWorkerPoolTest : public testing::Test {
+ public:
+  RasterWorkerPoolTest() : pool_(3, base::Closure()) {}
+  ~RasterWorkerPoolTest() override {}
+
+ protected:
+  // Rasters |picture| into |bitmap| and waits for it to finish.
+  void Raster(skia::RefPtr<SkPicture> picture,
+              const SkBitmap& bitmap,
+              const gfx::Rect& damage) {
+    base::RunLoop run_loop;
+    pool_.Raster(picture, bitmap, damage, run_loop.QuitClosure());
+    run_loop.Run();
+  }
+
+ private:
+  base::MessageLoop message_loop_;
+  RasterWorkerPool pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(RasterWorkerPoolTest);
+};
+
+TEST_F(RasterWorkerPoolTest, GetTilesInRect) {
+  const gfx::Size size(kWidth, kHeight);
+  std::vector<gfx::Rect> tiles =
+      RasterWorkerPool::GetTilesInRect(size, gfx::Rect(size));
+  ASSERT_EQ(6u, tiles.size());
+  EXPECT_EQ(gfx::Rect(0, 0, 256, 256), tiles[0]);
+  // Edge tiles are cut to the picture.
+  EXPECT_EQ(gfx::Rect(512, 0, 88, 256), tiles[2]);
+  EXPECT_EQ(gfx::Rect(512, 256, 88, 44), tiles[5]);
+
+  tiles = RasterWorkerPool::GetTilesInRect(size, gfx::Rect(250, 10, 10, 10));
+  ASSERT_EQ(2u, tiles.size());
+  EXPECT_EQ(gfx::Rect(0, 0, 256, 256), tiles[0]);
+  EXPECT_EQ(gfx::Rect(256, 0, 256, 256), tiles[1]);
+
+  EXPECT_TRUE(
+      RasterWorkerPool::GetTilesInRect(size, gfx::Rect(700, 0, 10, 10))
+          .empty());
+  EXPECT_TRUE(RasterWorkerPool::GetTilesInRect(size, gfx::Rect()).empty());
+}
+
+TEST_F(RasterWorkerPoolTest, MatchesDirectRaster) {
+  skia::RefPtr<SkPicture> picture = RecordPicture(SK_ColorBLUE);
+
+  SkBitmap expected;
+  expected.allocN32Pixels(kWidth, kHeight);
+  SkCanvas canvas(expected);
+  canvas.drawPicture(picture.get());
+
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(kWidth, kHeight);
+  Raster(picture, bitmap, gfx::Rect(kWidth, kHeight));
+
+  SkAutoLockPixels expected_lock(expected);
+  SkAutoLockPixels bitmap_lock(bitmap);
+  for (int y = 0; y < kHeight; y++) {
+    for (int x = 0; x < kWidth; x++) {
+      ASSERT_EQ(expected.getColor(x, y), bitmap.getColor(x, y))
+          << x << "," << y;
+    }
+  }
+}
+
+TEST_F(RasterWorkerPoolTest, OnlyDamagedTilesAreRedrawn) {
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(kWidth, kHeight);
+  Raster(RecordPicture(SK_ColorBLUE), bitmap, gfx::Rect(kWidth, kHeight));
+
+  Raster(RecordPicture(SK_ColorGREEN), bitmap, gfx::Rect(300, 10, 5, 5));
+
+  SkAutoLockPixels bitmap_lock(bitmap);
+  // The damage is in the second tile of the first row, which is redrawn in
+  // full.
+  EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(300, 10));
+  EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(500, 200));
+  // The other tiles are kept.
+  EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(100, 10));
+  EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(550, 10));
+  EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(300, 290));
+}
+
+void CountIdleWorker(base::AtomicRefCount* count) {
+  base::AtomicRefCountInc(count);
+}
+
+TEST(RasterWorkerPoolIdleTest, IdleCallbackRunsOncePerWorker) {
+  base::MessageLoop message_loop;
+  base::AtomicRefCount idle_count = 0;
+  RasterWorkerPool pool(4, base::Bind(&CountIdleWorker, &idle_count));
+
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(kWidth, kHeight);
+  {
+    // The six tiles are shared by all four workers.
+    base::RunLoop run_loop;
+    pool.Raster(RecordPicture(SK_ColorBLUE), bitmap,
+                gfx::Rect(kWidth, kHeight), run_loop.QuitClosure());
+    run_loop.Run();
+  }
+  EXPECT_EQ(4, idle_count);
+
+  {
+    // A single tile keeps a single worker busy.
+    base::RunLoop run_loop;
+    pool.Raster(RecordPicture(SK_ColorGREEN), bitmap, gfx::Rect(10, 10, 5, 5),
+                run_loop.QuitClosure());
+    run_loop.Run();
+  }
+  EXPECT_EQ(5, idle_count);
+}
+
+}  // namespace
+}  // namespace sky
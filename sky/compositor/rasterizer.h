@@ -5,10 +5,12 @@
 #ifndef SKY_COMPOSITOR_RASTERIZER_H_
 #define SKY_COMPOSITOR_RASTERIZER_H_
 
+#include "base/callback.h"
 #include "base/memory/scoped_ptr.h"
 #include "mojo/gpu/gl_texture.h"
-
-class SkPicture;
+#include "skia/ext/refptr.h"
+#include "third_party/skia/include/core/SkPicture.h"
+#include "ui/gfx/geometry/rect.h"
 
 namespace sky {
 
@@ -17,7 +19,15 @@ class Rasterizer {
   Rasterizer();
   virtual ~Rasterizer();
 
-  virtual scoped_ptr<mojo::GLTexture> Rasterize(SkPicture* picture) = 0;
+  typedef base::Callback<void(scoped_ptr<mojo::GLTexture>)> RasterCallback;
+
+  // Rasters |picture| into a texture and passes it to |callback|, which may
+  // be run before Rasterize() returns. |damage| is the part of the picture
+  // that changed since the last call; a rasterizer that keeps its previous
+  // output may redraw only that part.
+  virtual void Rasterize(skia::RefPtr<SkPicture> picture,
+                         const gfx::Rect& damage,
+                         const RasterCallback& callback) = 0;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(Rasterizer);
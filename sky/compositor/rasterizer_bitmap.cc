@@ -4,40 +4,86 @@
 
 #include "sky/compositor/rasterizer_bitmap.h"
 
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/sys_info.h"
+#include "base/trace_event/trace_event.h"
 #include "sky/compositor/layer_client.h"
 #include "sky/compositor/layer_host.h"
-#include "third_party/skia/include/core/SkBitmapDevice.h"
-#include "third_party/skia/include/core/SkCanvas.h"
-#include "third_party/skia/include/core/SkPicture.h"
 #include "ui/gfx/codec/png_codec.h"
-#include "ui/gfx/geometry/rect.h"
 
 namespace sky {
+namespace {
+
+// More threads than this don't help with the tile counts we see.
+const int kMaxRasterThreads = 4;
+
+int GetNumRasterThreads() {
+  return std::max(1,
+                  std::min(kMaxRasterThreads,
+                           base::SysInfo::NumberOfProcessors() - 1));
+}
+
+}  // namespace
 
-RasterizerBitmap::RasterizerBitmap(LayerHost* host) : host_(host) {
+RasterizerBitmap::RasterizerBitmap(LayerHost* host,
+                                   const base::Closure& worker_idle_callback)
+    : host_(host),
+      raster_pending_(false),
+      worker_pool_(GetNumRasterThreads(), worker_idle_callback),
+      weak_factory_(this) {
   DCHECK(host_);
 }
 
 RasterizerBitmap::~RasterizerBitmap() {
 }
 
-void RasterizerBitmap::GetPixelsForTesting(std::vector<unsigned char>* pixels) {
-  gfx::PNGCodec::EncodeBGRASkBitmap(bitmap_, true, pixels);
+void RasterizerBitmap::GetPixelsForTesting(const PixelsCallback& callback) {
+  if (raster_pending_) {
+    pending_pixels_callbacks_.push_back(callback);
+    return;
+  }
+  RunPixelsCallback(callback);
 }
 
-scoped_ptr<mojo::GLTexture> RasterizerBitmap::Rasterize(SkPicture* picture) {
+void RasterizerBitmap::RunPixelsCallback(const PixelsCallback& callback) {
+  DCHECK(!raster_pending_);
+  std::vector<unsigned char> pixels;
+  gfx::PNGCodec::EncodeBGRASkBitmap(bitmap_, true, &pixels);
+  callback.Run(pixels);
+}
+
+void RasterizerBitmap::Rasterize(skia::RefPtr<SkPicture> picture,
+                                 const gfx::Rect& damage,
+                                 const RasterCallback& callback) {
+  TRACE_EVENT0("sky", "RasterizerBitmap::Rasterize");
+  DCHECK(!raster_pending_);
+
   auto size = picture->cullRect();
-  bitmap_.allocN32Pixels(size.width(), size.height());
+  gfx::Rect dirty_rect = damage;
+  if (bitmap_.width() != size.width() || bitmap_.height() != size.height()) {
+    // Nothing from the last picture can be kept.
+    bitmap_.allocN32Pixels(size.width(), size.height());
+    dirty_rect = gfx::Rect(bitmap_.width(), bitmap_.height());
+  }
+
+  raster_pending_ = true;
+  worker_pool_.Raster(picture, bitmap_, dirty_rect,
+                      base::Bind(&RasterizerBitmap::DidRaster,
+                                 weak_factory_.GetWeakPtr(), callback));
+}
+
+void RasterizerBitmap::DidRaster(const RasterCallback& callback) {
+  raster_pending_ = false;
 
-  SkBitmapDevice device(bitmap_);
-  SkCanvas canvas(&device);
-  // Draw red so we can see when we fail to paint.
-  canvas.drawColor(SK_ColorRED);
-  canvas.drawPicture(picture);
-  canvas.flush();
+  std::vector<PixelsCallback> pixels_callbacks;
+  pixels_callbacks.swap(pending_pixels_callbacks_);
+  for (const PixelsCallback& pixels_callback : pixels_callbacks)
+    RunPixelsCallback(pixels_callback);
 
-  return host_->resource_manager()->CreateTexture(
-      gfx::Size(size.width(), size.height()));
+  callback.Run(host_->resource_manager()->CreateTexture(
+      gfx::Size(bitmap_.width(), bitmap_.height())));
 }
 
 }  // namespace sky
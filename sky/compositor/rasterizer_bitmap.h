@@ -5,6 +5,11 @@
 #ifndef SKY_COMPOSITOR_DISPLAY_RASTERIZER_BITMAP_H_
 #define SKY_COMPOSITOR_DISPLAY_RASTERIZER_BITMAP_H_
 
+#include <vector>
+
+#include "base/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "sky/compositor/raster_worker_pool.h"
 #include "sky/compositor/rasterizer.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 
@@ -13,15 +18,35 @@ class LayerHost;
 
 class RasterizerBitmap : public Rasterizer {
  public:
-  explicit RasterizerBitmap(LayerHost* host);
+  // |worker_idle_callback| runs on a raster worker whenever it runs out of
+  // tiles. See RasterWorkerPool.
+  RasterizerBitmap(LayerHost* host, const base::Closure& worker_idle_callback);
   ~RasterizerBitmap() override;
 
-  scoped_ptr<mojo::GLTexture> Rasterize(SkPicture* picture) override;
-  void GetPixelsForTesting(std::vector<unsigned char>* pixels);
+  void Rasterize(skia::RefPtr<SkPicture> picture,
+                 const gfx::Rect& damage,
+                 const RasterCallback& callback) override;
+
+  typedef base::Callback<void(const std::vector<unsigned char>&)>
+      PixelsCallback;
+  // Passes the last rastered picture to |callback| as a PNG. If a raster is
+  // still running on the workers, |callback| waits for it to finish.
+  void GetPixelsForTesting(const PixelsCallback& callback);
 
  private:
+  void DidRaster(const RasterCallback& callback);
+  void RunPixelsCallback(const PixelsCallback& callback);
+
   LayerHost* host_;
+
+  // Holds the last picture rastered; only damaged tiles are redrawn.
   SkBitmap bitmap_;
+  bool raster_pending_;
+  std::vector<PixelsCallback> pending_pixels_callbacks_;
+
+  RasterWorkerPool worker_pool_;
+
+  base::WeakPtrFactory<RasterizerBitmap> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(RasterizerBitmap);
 };
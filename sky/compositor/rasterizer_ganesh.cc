@@ -5,6 +5,7 @@
 #include "sky/compositor/rasterizer_ganesh.h"
 
 #include "base/trace_event/trace_event.h"
+#include "mojo/skia/ganesh_context.h"
 #include "mojo/skia/ganesh_surface.h"
 #include "sky/compositor/layer_host.h"
 #include "third_party/skia/include/core/SkCanvas.h"
@@ -19,20 +20,31 @@ RasterizerGanesh::RasterizerGanesh(LayerHost* host) : host_(host) {
 RasterizerGanesh::~RasterizerGanesh() {
 }
 
-scoped_ptr<mojo::GLTexture> RasterizerGanesh::Rasterize(SkPicture* picture) {
+void RasterizerGanesh::Rasterize(skia::RefPtr<SkPicture> picture,
+                                 const gfx::Rect& damage,
+                                 const RasterCallback& callback) {
   TRACE_EVENT0("sky", "RasterizerGanesh::Rasterize");
 
   SkRect cull_rect = picture->cullRect();
   gfx::Size size(cull_rect.width(), cull_rect.height());
 
-  mojo::GaneshSurface surface(host_->ganesh_context(),
-                              host_->resource_manager()->CreateTexture(size));
+  // Every frame gets a new texture, so the whole picture is drawn regardless
+  // of |damage|. The GL context can only be used on this thread.
+  scoped_ptr<mojo::GLTexture> texture;
+  {
+    mojo::GaneshContext::Scope scope(host_->ganesh_context());
+    host_->ganesh_context()->gr()->resetContext();
 
-  SkCanvas* canvas = surface.canvas();
-  canvas->drawPicture(picture);
-  canvas->flush();
+    mojo::GaneshSurface surface(host_->ganesh_context(),
+                                host_->resource_manager()->CreateTexture(size));
 
-  return surface.TakeTexture();
+    SkCanvas* canvas = surface.canvas();
+    canvas->drawPicture(picture.get());
+    canvas->flush();
+
+    texture = surface.TakeTexture();
+  }
+  callback.Run(texture.Pass());
 }
 
 }  // namespace sky
@@ -15,7 +15,9 @@ class RasterizerGanesh : public Rasterizer {
   explicit RasterizerGanesh(LayerHost* host);
   ~RasterizerGanesh() override;
 
-  scoped_ptr<mojo::GLTexture> Rasterize(SkPicture* picture) override;
+  void Rasterize(skia::RefPtr<SkPicture> picture,
+                 const gfx::Rect& damage,
+                 const RasterCallback& callback) override;
 
  private:
   LayerHost* host_;
@@ -4,34 +4,22 @@
 
 #include "sky/compositor/texture_cache.h"
 
-#include "mojo/converters/geometry/geometry_type_converters.h"
-#include "mojo/gpu/gl_texture.h"
+#include "base/trace_event/trace_event.h"
 
 namespace sky {
+namespace internal {
 
-TextureCache::TextureCache() {
+size_t GetTextureBytes(const mojo::Size& size) {
+  return static_cast<size_t>(size.width) * size.height * 4u;
 }
 
-TextureCache::~TextureCache() {
-}
-
-scoped_ptr<mojo::GLTexture> TextureCache::GetTexture(const gfx::Size& size) {
-  if (size != size_) {
-    available_textures_.clear();
-    size_ = size;
-  }
-  if (available_textures_.empty())
-    return nullptr;
-  scoped_ptr<mojo::GLTexture> texture(available_textures_.back());
-  available_textures_.back() = nullptr;
-  available_textures_.pop_back();
-  return texture.Pass();
-}
-
-void TextureCache::PutTexture(scoped_ptr<mojo::GLTexture> texture) {
-  if (texture->size() != size_)
-    return;
-  available_textures_.push_back(texture.release());
+void TraceTextureCacheCounters(size_t bytes_resident,
+                               size_t hits,
+                               size_t misses) {
+  TRACE_COUNTER1("sky", "TextureCache::BytesResident", bytes_resident);
+  TRACE_COUNTER2("sky", "TextureCache::Requests", "hits", hits, "misses",
+                 misses);
 }
 
+}  // namespace internal
 }  // namespace sky
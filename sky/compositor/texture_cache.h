@@ -5,8 +5,21 @@
 #ifndef SKY_COMPOSITOR_TEXTURE_CACHE_H_
 #define SKY_COMPOSITOR_TEXTURE_CACHE_H_
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
-#include "base/memory/scoped_vector.h"
+#include "base/single_thread_task_runner.h"
+#include "base/time/default_tick_clock.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "mojo/services/geometry/public/interfaces/geometry.mojom.h"
 #include "ui/gfx/geometry/size.h"
 
 namespace mojo {
@@ -15,21 +28,211 @@ class GLTexture;
 
 namespace sky {
 
-class TextureCache {
+namespace internal {
+
+size_t GetTextureBytes(const mojo::Size& size);
+void TraceTextureCacheCounters(size_t bytes_resident,
+                               size_t hits,
+                               size_t misses);
+
+}  // namespace internal
+
+// Pool of textures that the display compositor has handed back, so that new
+// frames can reuse them rather than allocating. Textures are pooled by size
+// (they're all RGBA). Textures that go unused for |kMaxIdleTime| are freed,
+// as are the least recently returned ones once the pool grows past its
+// budget, and as many as asked for under memory pressure.
+//
+// |Texture| is mojo::GLTexture (see TextureCache below) except in tests. It
+// has to provide size() returning a mojo::Size.
+template <typename Texture>
+class TexturePool {
  public:
-  TextureCache();
-  ~TextureCache();
+  // Textures unused for this long are freed.
+  static const int64 kMaxIdleTimeMs = 5000;
+
+  static const size_t kDefaultBudgetBytes = 32 * 1024 * 1024;
+
+  TexturePool()
+      : tick_clock_(new base::DefaultTickClock),
+        budget_bytes_(kDefaultBudgetBytes),
+        bytes_resident_(0u),
+        hits_(0u),
+        misses_(0u),
+        memory_pressure_listener_(base::Bind(&TexturePool::OnMemoryPressure,
+                                             base::Unretained(this))) {}
+
+  ~TexturePool() { Clear(); }
+
+  // Returns a pooled texture of |size|, or null if there isn't one.
+  scoped_ptr<Texture> GetTexture(const gfx::Size& size) {
+    typename Buckets::iterator it =
+        buckets_.find(SizeKey(size.width(), size.height()));
+    if (it == buckets_.end()) {
+      misses_++;
+      TraceCounters();
+      return nullptr;
+    }
+
+    // The most recently returned texture is the likeliest to still be warm.
+    scoped_ptr<Texture> texture(it->second.back().texture);
+    it->second.pop_back();
+    if (it->second.empty())
+      buckets_.erase(it);
+    bytes_resident_ -= internal::GetTextureBytes(texture->size());
+    hits_++;
+    TraceCounters();
+    return texture.Pass();
+  }
+
+  // Adds |texture| to the pool.
+  void PutTexture(scoped_ptr<Texture> texture) {
+    const size_t bytes = internal::GetTextureBytes(texture->size());
+    if (bytes > budget_bytes_)
+      return;
+    EvictUntilUnder(budget_bytes_ - bytes);
+
+    Entry entry;
+    entry.put_time = tick_clock_->NowTicks();
+    entry.texture = texture.release();
+    buckets_[SizeKey(entry.texture->size().width,
+                     entry.texture->size().height)].push_back(entry);
+    bytes_resident_ += bytes;
+    TraceCounters();
+
+    if (!idle_timer_.IsRunning()) {
+      idle_timer_.Start(FROM_HERE,
+                        base::TimeDelta::FromMilliseconds(kMaxIdleTimeMs),
+                        this, &TexturePool::OnIdleTimer);
+    }
+  }
+
+  // Frees all the pooled textures.
+  void Clear() { EvictUntilUnder(0u); }
 
-  scoped_ptr<mojo::GLTexture> GetTexture(const gfx::Size& size);
-  void PutTexture(scoped_ptr<mojo::GLTexture> texture);
+  void set_budget_bytes(size_t budget_bytes) {
+    budget_bytes_ = budget_bytes;
+    EvictUntilUnder(budget_bytes_);
+  }
+
+  // Times textures with |tick_clock| and runs the idle timer on |task_runner|
+  // rather than the real clock and the current thread. Used by tests.
+  void SetTimeSourceForTesting(
+      scoped_ptr<base::TickClock> tick_clock,
+      const scoped_refptr<base::SingleThreadTaskRunner>& task_runner) {
+    tick_clock_ = tick_clock.Pass();
+    idle_timer_.SetTaskRunner(task_runner);
+  }
+
+  size_t bytes_resident() const { return bytes_resident_; }
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
 
  private:
-  gfx::Size size_;
-  ScopedVector<mojo::GLTexture> available_textures_;
+  struct Entry {
+    Texture* texture;
+    base::TimeTicks put_time;
+  };
+  typedef std::pair<int, int> SizeKey;
+  // Each bucket is ordered from the least to the most recently returned.
+  typedef std::map<SizeKey, std::deque<Entry>> Buckets;
+
+  // Frees pooled textures, oldest first, until at most |max_bytes| are left.
+  void EvictUntilUnder(size_t max_bytes) {
+    while (bytes_resident_ > max_bytes) {
+      // Buckets are few (one per size in use), so finding the oldest texture
+      // across them is cheap.
+      typename Buckets::iterator oldest = buckets_.begin();
+      for (typename Buckets::iterator it = buckets_.begin();
+           it != buckets_.end(); ++it) {
+        if (it->second.front().put_time < oldest->second.front().put_time)
+          oldest = it;
+      }
+      FreeEntry(oldest->second.front());
+      oldest->second.pop_front();
+      if (oldest->second.empty())
+        buckets_.erase(oldest);
+    }
+    TraceCounters();
+  }
+
+  // Frees textures returned at or before |cutoff|.
+  void EvictOlderThan(base::TimeTicks cutoff) {
+    for (typename Buckets::iterator it = buckets_.begin();
+         it != buckets_.end();) {
+      std::deque<Entry>& entries = it->second;
+      while (!entries.empty() && entries.front().put_time <= cutoff) {
+        FreeEntry(entries.front());
+        entries.pop_front();
+      }
+      if (entries.empty())
+        buckets_.erase(it++);
+      else
+        ++it;
+    }
+    TraceCounters();
+  }
+
+  void FreeEntry(const Entry& entry) {
+    bytes_resident_ -= internal::GetTextureBytes(entry.texture->size());
+    delete entry.texture;
+  }
+
+  void OnIdleTimer() {
+    const base::TimeTicks now = tick_clock_->NowTicks();
+    EvictOlderThan(now - base::TimeDelta::FromMilliseconds(kMaxIdleTimeMs));
+    if (buckets_.empty())
+      return;
+
+    // Come back when the oldest of what's left expires.
+    base::TimeTicks oldest = now;
+    for (const auto& bucket : buckets_)
+      oldest = std::min(oldest, bucket.second.front().put_time);
+    idle_timer_.Start(
+        FROM_HERE,
+        oldest + base::TimeDelta::FromMilliseconds(kMaxIdleTimeMs) - now,
+        this, &TexturePool::OnIdleTimer);
+  }
 
-  DISALLOW_COPY_AND_ASSIGN(TextureCache);
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level) {
+    switch (level) {
+      case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+        EvictUntilUnder(budget_bytes_ / 2);
+        break;
+      case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+        Clear();
+        break;
+      case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+        break;
+    }
+  }
+
+  void TraceCounters() const {
+    internal::TraceTextureCacheCounters(bytes_resident_, hits_, misses_);
+  }
+
+  scoped_ptr<base::TickClock> tick_clock_;
+  Buckets buckets_;
+  size_t budget_bytes_;
+  size_t bytes_resident_;
+  size_t hits_;
+  size_t misses_;
+
+  base::OneShotTimer<TexturePool> idle_timer_;
+  base::MemoryPressureListener memory_pressure_listener_;
+
+  DISALLOW_COPY_AND_ASSIGN(TexturePool);
 };
 
+// static
+template <typename Texture>
+const int64 TexturePool<Texture>::kMaxIdleTimeMs;
+template <typename Texture>
+const size_t TexturePool<Texture>::kDefaultBudgetBytes;
+
+typedef TexturePool<mojo::GLTexture> TextureCache;
+
 }  // namespace sky
 
 #endif  // SKY_COMPOSITOR_TEXTURE_CACHE_H_
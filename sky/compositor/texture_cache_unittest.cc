@@ -0,0 +1,188 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/compositor/texture_cache.h"
+
+#include "base/memory/memory_pressure_listener.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/test/test_mock_time_task_runner.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace sky {
+namespace {
+
+// Stands in for a GLTexture. Counts how many are alive so the tests can see
+// when the cache frees them.
+class FakeTexture {
+ public:
+  FakeTexture(const gfx::Size& size, int* live_count)
+      : live_count_(live_count) {
+    size_.width = size.width();
+    size_.height = size.height();
+    (*live_count_)++;
+  }
+  ~FakeTexture() { (*live_count_)--; }
+
+  const mojo::Size& size() const { return size_; }
+
+ private:
+  mojo::Size size_;
+  int* live_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeTexture);
+};
+
+typedef TexturePool<FakeTexture> FakeTextureCache;
+
+// 4MB each.
+const gfx::Size kLargeSize(1024, 1024);
+
+class TextureCacheTest : public testing::Test {
+ public:
+  TextureCacheTest()
+      : task_runner_(new base::TestMockTimeTaskRunner), live_count_(0) {
+    cache_.SetTimeSourceForTesting(task_runner_->GetMockTickClock(),
+                                   task_runner_);
+  }
+  ~TextureCacheTest() override {}
+
+ protected:
+  FakeTexture* Put(const gfx::Size& size) {
+    FakeTexture* texture = new FakeTexture(size, &live_count_);
+    cache_.PutTexture(make_scoped_ptr(texture));
+    return texture;
+  }
+
+  // Returns the texture the cache hands out for |size|, or null. The texture
+  // is freed.
+  FakeTexture* Get(const gfx::Size& size) {
+    scoped_ptr<FakeTexture> texture = cache_.GetTexture(size);
+    return texture.get();
+  }
+
+  void AdvanceTime(int64 ms) {
+    task_runner_->FastForwardBy(base::TimeDelta::FromMilliseconds(ms));
+  }
+
+  FakeTextureCache* cache() { return &cache_; }
+  int live_count() const { return live_count_; }
+
+ private:
+  base::MessageLoop message_loop_;
+  scoped_refptr<base::TestMockTimeTaskRunner> task_runner_;
+  int live_count_;
+  FakeTextureCache cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(TextureCacheTest);
+};
+
+TEST_F(TextureCacheTest, ReusesTexturesOfTheSameSize) {
+  FakeTexture* small = Put(gfx::Size(100, 100));
+  FakeTexture* large = Put(gfx::Size(200, 100));
+  EXPECT_EQ((100 * 100 + 200 * 100) * 4u, cache()->bytes_resident());
+
+  EXPECT_FALSE(Get(gfx::Size(100, 200)));
+  EXPECT_EQ(1u, cache()->misses());
+
+  EXPECT_EQ(large, Get(gfx::Size(200, 100)));
+  EXPECT_EQ(small, Get(gfx::Size(100, 100)));
+  EXPECT_EQ(2u, cache()->hits());
+  EXPECT_EQ(0u, cache()->bytes_resident());
+
+  EXPECT_FALSE(Get(gfx::Size(100, 100)));
+  EXPECT_EQ(2u, cache()->misses());
+  EXPECT_EQ(0, live_count());
+}
+
+TEST_F(TextureCacheTest, HandsOutTheMostRecentlyReturnedFirst) {
+  FakeTexture* first = Put(gfx::Size(100, 100));
+  FakeTexture* second = Put(gfx::Size(100, 100));
+  EXPECT_EQ(second, Get(gfx::Size(100, 100)));
+  EXPECT_EQ(first, Get(gfx::Size(100, 100)));
+}
+
+TEST_F(TextureCacheTest, EvictsIdleTextures) {
+  Put(gfx::Size(100, 100));
+  AdvanceTime(2000);
+  FakeTexture* newer = Put(gfx::Size(100, 100));
+  EXPECT_EQ(2, live_count());
+
+  AdvanceTime(FakeTextureCache::kMaxIdleTimeMs - 2001);
+  EXPECT_EQ(2, live_count());
+
+  // The first texture has now been idle for the timeout.
+  AdvanceTime(1);
+  EXPECT_EQ(1, live_count());
+  EXPECT_EQ(100 * 100 * 4u, cache()->bytes_resident());
+
+  AdvanceTime(2000);
+  EXPECT_EQ(0, live_count());
+  EXPECT_EQ(0u, cache()->bytes_resident());
+  EXPECT_FALSE(Get(gfx::Size(100, 100)));
+
+  // Taking a texture back out keeps it from being evicted.
+  newer = Put(gfx::Size(100, 100));
+  scoped_ptr<FakeTexture> taken = cache()->GetTexture(gfx::Size(100, 100));
+  EXPECT_EQ(newer, taken.get());
+  AdvanceTime(FakeTextureCache::kMaxIdleTimeMs);
+  EXPECT_EQ(1, live_count());
+}
+
+TEST_F(TextureCacheTest, StaysWithinBudget) {
+  const size_t texture_bytes = kLargeSize.GetArea() * 4u;
+  const size_t count = FakeTextureCache::kDefaultBudgetBytes / texture_bytes;
+  ASSERT_EQ(8u, count);
+
+  // One texture of another size but the same area, returned first.
+  const gfx::Size other_size(kLargeSize.width() * 2, kLargeSize.height() / 2);
+  Put(other_size);
+  AdvanceTime(1);
+  for (size_t i = 1; i < count; ++i) {
+    Put(kLargeSize);
+    AdvanceTime(1);
+  }
+  EXPECT_EQ(FakeTextureCache::kDefaultBudgetBytes, cache()->bytes_resident());
+  EXPECT_EQ(static_cast<int>(count), live_count());
+
+  // Going over the budget frees the least recently returned texture, even
+  // though it's in another bucket.
+  Put(kLargeSize);
+  EXPECT_EQ(FakeTextureCache::kDefaultBudgetBytes, cache()->bytes_resident());
+  EXPECT_EQ(static_cast<int>(count), live_count());
+  EXPECT_FALSE(Get(other_size));
+
+  // Textures bigger than the whole budget aren't kept.
+  Put(gfx::Size(4096, 4096));
+  EXPECT_EQ(FakeTextureCache::kDefaultBudgetBytes, cache()->bytes_resident());
+
+  // Lowering the budget evicts down to it.
+  cache()->set_budget_bytes(texture_bytes * 2);
+  EXPECT_EQ(texture_bytes * 2, cache()->bytes_resident());
+  EXPECT_EQ(2, live_count());
+}
+
+TEST_F(TextureCacheTest, PurgesOnMemoryPressure) {
+  for (int i = 0; i < 4; ++i)
+    Put(kLargeSize);
+  const size_t texture_bytes = kLargeSize.GetArea() * 4u;
+
+  // Moderate pressure brings the cache down to half its budget.
+  cache()->set_budget_bytes(texture_bytes * 4);
+  base::MemoryPressureListener::NotifyMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(texture_bytes * 2, cache()->bytes_resident());
+  EXPECT_EQ(2, live_count());
+
+  // Critical pressure empties it.
+  base::MemoryPressureListener::NotifyMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, cache()->bytes_resident());
+  EXPECT_EQ(0, live_count());
+}
+
+}  // namespace
+}  // namespace sky
@@ -31,6 +31,7 @@
 
 #include "sky/engine/core/css/CSSSelector.h"
 #include "sky/engine/core/css/CSSStyleSheet.h"
+#include "sky/engine/core/css/SelectorFilter.h"
 #include "sky/engine/core/css/StylePropertySet.h"
 #include "sky/engine/core/css/resolver/StyleResolver.h"
 #include "sky/engine/core/dom/shadow/ShadowRoot.h"
@@ -40,9 +41,16 @@
 namespace blink {
 
 ElementRuleCollector::ElementRuleCollector(const ElementResolveContext& context,
-    RenderStyle* style)
+    const SelectorFilter& filter, RenderStyle* style)
     : m_context(context)
+    , m_selectorFilter(filter)
     , m_style(style)
+    , m_rulesTested(0)
+    , m_rulesFastRejected(0)
+    , m_rulesMatched(0)
+    , m_matchedSelectorFlags(0)
+    , m_matchingOffMainThread(false)
+    , m_needsMainThread(false)
 { }
 
 ElementRuleCollector::~ElementRuleCollector()
@@ -61,6 +69,24 @@ inline void ElementRuleCollector::addMatchedRule(const RuleData* rule, CascadeOr
     m_matchedRules->append(MatchedRule(rule, cascadeOrder, styleSheetIndex, parentStyleSheet));
 }
 
+void ElementRuleCollector::releaseCollectedRules(CollectedRules& rules)
+{
+    rules.matchedRules = m_matchedRules.release();
+    rules.matchedSelectorFlags = m_matchedSelectorFlags;
+    rules.rulesTested = m_rulesTested;
+    rules.rulesFastRejected = m_rulesFastRejected;
+    rules.rulesMatched = m_rulesMatched;
+}
+
+void ElementRuleCollector::adoptCollectedRules(CollectedRules& rules)
+{
+    m_matchedRules = rules.matchedRules.release();
+    m_matchedSelectorFlags |= rules.matchedSelectorFlags;
+    m_rulesTested += rules.rulesTested;
+    m_rulesFastRejected += rules.rulesFastRejected;
+    m_rulesMatched += rules.rulesMatched;
+}
+
 void ElementRuleCollector::clearMatchedRules()
 {
     if (!m_matchedRules)
@@ -104,6 +130,19 @@ void ElementRuleCollector::collectMatchingHostRules(const MatchRequest& matchReq
 
 void ElementRuleCollector::sortAndTransferMatchedRules()
 {
+    ASSERT(!m_matchingOffMainThread);
+
+    if (m_style) {
+        if (m_matchedSelectorFlags & MatchedAttributeSelector)
+            m_style->setUnique();
+        if (m_matchedSelectorFlags & MatchedFocusSelector)
+            m_style->setAffectedByFocus();
+        if (m_matchedSelectorFlags & MatchedHoverSelector)
+            m_style->setAffectedByHover();
+        if (m_matchedSelectorFlags & MatchedActiveSelector)
+            m_style->setAffectedByActive();
+    }
+
     if (!m_matchedRules || m_matchedRules->isEmpty())
         return;
 
@@ -120,28 +159,38 @@ void ElementRuleCollector::sortAndTransferMatchedRules()
 
 inline bool ElementRuleCollector::ruleMatches(const RuleData& ruleData)
 {
-    SelectorChecker checker(*m_context.element());
+    SelectorChecker checker(*m_context.element(), m_matchingOffMainThread ? SelectorChecker::MatchingOffMainThread : SelectorChecker::MatchingOnMainThread);
     bool matched = checker.match(ruleData.selector());
 
+    if (checker.needsMainThread())
+        m_needsMainThread = true;
+
     if (checker.matchedAttributeSelector())
-        m_style->setUnique();
+        m_matchedSelectorFlags |= MatchedAttributeSelector;
 
     if (checker.matchedFocusSelector())
-        m_style->setAffectedByFocus();
+        m_matchedSelectorFlags |= MatchedFocusSelector;
 
     if (checker.matchedHoverSelector())
-        m_style->setAffectedByHover();
+        m_matchedSelectorFlags |= MatchedHoverSelector;
 
     if (checker.matchedActiveSelector())
-        m_style->setAffectedByActive();
+        m_matchedSelectorFlags |= MatchedActiveSelector;
 
     return matched;
 }
 
 void ElementRuleCollector::collectRuleIfMatches(const RuleData& ruleData, CascadeOrder cascadeOrder, const MatchRequest& matchRequest)
 {
+    ++m_rulesTested;
+    if (m_selectorFilter.fastRejectSelector<RuleData::maximumIdentifierCount>(ruleData.identifierHashes())) {
+        ++m_rulesFastRejected;
+        return;
+    }
+
     StyleRule* rule = ruleData.rule();
     if (ruleMatches(ruleData)) {
+        ++m_rulesMatched;
         // If the rule has no properties to apply, then ignore it in the non-debug mode.
         const StylePropertySet& properties = rule->properties();
         if (properties.isEmpty())
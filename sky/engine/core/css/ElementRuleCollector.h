@@ -34,6 +34,7 @@ namespace blink {
 
 class CSSStyleSheet;
 class ScopedStyleResolver;
+class SelectorFilter;
 
 typedef unsigned CascadeOrder;
 
@@ -80,6 +81,25 @@ public:
     Vector<RawPtr<StyleRule> > m_list;
 };
 
+// The rules an ElementRuleCollector matched, detached from it so that rules
+// matched on a worker thread can be handed to the collector resolving the
+// element's style on the main thread.
+struct CollectedRules {
+    CollectedRules()
+        : matchedSelectorFlags(0)
+        , rulesTested(0)
+        , rulesFastRejected(0)
+        , rulesMatched(0)
+    {
+    }
+
+    OwnPtr<Vector<MatchedRule, 32> > matchedRules;
+    unsigned matchedSelectorFlags;
+    unsigned rulesTested;
+    unsigned rulesFastRejected;
+    unsigned rulesMatched;
+};
+
 // ElementRuleCollector is designed to be used as a stack object.
 // Create one, ask what rules the ElementResolveContext matches
 // and then let it go out of scope.
@@ -88,11 +108,26 @@ class ElementRuleCollector {
     STACK_ALLOCATED();
     WTF_MAKE_NONCOPYABLE(ElementRuleCollector);
 public:
-    ElementRuleCollector(const ElementResolveContext&, RenderStyle* = 0);
+    ElementRuleCollector(const ElementResolveContext&, const SelectorFilter&, RenderStyle* = 0);
     ~ElementRuleCollector();
 
     MatchResult& matchedResult();
 
+    // Candidate rules taken from the rule sets, how many of them the
+    // SelectorFilter rejected, and how many matched.
+    unsigned rulesTested() const { return m_rulesTested; }
+    unsigned rulesFastRejected() const { return m_rulesFastRejected; }
+    unsigned rulesMatched() const { return m_rulesMatched; }
+
+    // Off the main thread, selectors that can't be checked there make
+    // needsMainThread() true instead of matching, and the RenderStyle must
+    // be null.
+    void setMatchingOffMainThread() { m_matchingOffMainThread = true; }
+    bool needsMainThread() const { return m_needsMainThread; }
+
+    void releaseCollectedRules(CollectedRules&);
+    void adoptCollectedRules(CollectedRules&);
+
     void collectMatchingRules(const MatchRequest&, CascadeOrder = ignoreCascadeOrder);
     void collectMatchingHostRules(const MatchRequest&, CascadeOrder cascadeOrder = ignoreCascadeOrder);
     void sortAndTransferMatchedRules();
@@ -119,8 +154,26 @@ private:
 
 private:
     const ElementResolveContext& m_context;
+    const SelectorFilter& m_selectorFilter;
     RefPtr<RenderStyle> m_style; // FIXME: This can be mutated during matching!
 
+    unsigned m_rulesTested;
+    unsigned m_rulesFastRejected;
+    unsigned m_rulesMatched;
+
+    enum MatchedSelectorFlag {
+        MatchedAttributeSelector = 1 << 0,
+        MatchedFocusSelector = 1 << 1,
+        MatchedHoverSelector = 1 << 2,
+        MatchedActiveSelector = 1 << 3,
+    };
+    // Applied to the RenderStyle once matching is done, so that matching
+    // itself doesn't touch it.
+    unsigned m_matchedSelectorFlags;
+
+    bool m_matchingOffMainThread;
+    bool m_needsMainThread;
+
     OwnPtr<Vector<MatchedRule, 32> > m_matchedRules;
 
     // Output.
@@ -34,6 +34,7 @@
 #include "sky/engine/core/css/CSSSelector.h"
 #include "sky/engine/core/css/CSSSelectorList.h"
 #include "sky/engine/core/css/SelectorChecker.h"
+#include "sky/engine/core/css/SelectorFilter.h"
 #include "sky/engine/core/css/StyleSheetContents.h"
 #include "sky/engine/platform/TraceEvent.h"
 #include "sky/engine/wtf/TerminatedArrayBuilder.h"
@@ -50,6 +51,7 @@ RuleData::RuleData(StyleRule* rule, unsigned selectorIndex, unsigned position)
 {
     ASSERT(m_position == position);
     ASSERT(m_selectorIndex == selectorIndex);
+    SelectorFilter::collectIdentifierHashes(selector(), m_identifierHashes, maximumIdentifierCount);
 }
 
 void RuleSet::addToRuleSet(const AtomicString& key, PendingRuleMap& map, const RuleData& ruleData)
@@ -48,6 +48,11 @@ public:
     bool isLastInArray() const { return m_isLastInArray; }
     void setLastInArray(bool flag) { m_isLastInArray = flag; }
 
+    // Hashes of the tag name, id, classes and attribute names the selector
+    // requires, for SelectorFilter::fastRejectSelector().
+    static const unsigned maximumIdentifierCount = 4;
+    const unsigned* identifierHashes() const { return m_identifierHashes; }
+
 private:
     RawPtr<StyleRule> m_rule;
     unsigned m_selectorIndex : 12;
@@ -55,11 +60,13 @@ private:
     // This number was picked fairly arbitrarily. We can probably lower it if we need to.
     // Some simple testing showed <100,000 RuleData's on large sites.
     unsigned m_position : 17;
+    unsigned m_identifierHashes[maximumIdentifierCount];
 };
 
 struct SameSizeAsRuleData {
     void* a;
     unsigned b;
+    unsigned c[4];
 };
 
 COMPILE_ASSERT(sizeof(RuleData) == sizeof(SameSizeAsRuleData), RuleData_should_stay_small);
@@ -96,7 +103,9 @@ public:
 
 private:
     typedef HashMap<AtomicString, OwnPtr<LinkedStack<RuleData> > > PendingRuleMap;
-    typedef HashMap<AtomicString, OwnPtr<TerminatedArray<RuleData> > > CompactRuleMap;
+    // Matching looks up every id, class and tag of every element, and most
+    // of them have no rules, so the compact maps probe by hash bits first.
+    typedef HashMap<AtomicString, OwnPtr<TerminatedArray<RuleData> >, DefaultHash<AtomicString>::Hash, GroupProbingHashTraits<HashTraits<AtomicString> > > CompactRuleMap;
 
     RuleSet()
         : m_ruleCount(0)
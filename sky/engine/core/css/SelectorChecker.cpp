@@ -52,8 +52,10 @@ static bool matchesFocusPseudoClass(const Element& element)
     return true;
 }
 
-SelectorChecker::SelectorChecker(const Element& element)
+SelectorChecker::SelectorChecker(const Element& element, Mode mode)
     : m_element(element)
+    , m_mode(mode)
+    , m_needsMainThread(false)
     , m_matchedAttributeSelector(false)
     , m_matchedFocusSelector(false)
     , m_matchedHoverSelector(false)
@@ -141,6 +143,12 @@ bool SelectorChecker::checkPseudoClass(const CSSSelector& selector)
 
     case CSSSelector::PseudoLang:
         {
+            // The inherited language is returned by value, which isn't safe
+            // off the main thread.
+            if (m_mode == MatchingOffMainThread) {
+                m_needsMainThread = true;
+                return false;
+            }
             AtomicString value = m_element.computeInheritedLanguage();
             const AtomicString& argument = selector.argument();
             if (value.isEmpty() || !value.startsWith(argument, false))
@@ -39,10 +39,19 @@ class Element;
 class SelectorChecker {
     WTF_MAKE_NONCOPYABLE(SelectorChecker);
 public:
-    explicit SelectorChecker(const Element&);
+    enum Mode {
+        MatchingOnMainThread,
+        // Selectors whose checks would touch ref counts or other main thread
+        // state fail to match and set needsMainThread() instead.
+        MatchingOffMainThread,
+    };
+
+    explicit SelectorChecker(const Element&, Mode = MatchingOnMainThread);
 
     bool match(const CSSSelector&);
 
+    bool needsMainThread() const { return m_needsMainThread; }
+
     bool matchedAttributeSelector() const { return m_matchedAttributeSelector; }
     bool matchedFocusSelector() const { return m_matchedFocusSelector; }
     bool matchedHoverSelector() const { return m_matchedHoverSelector; }
@@ -53,6 +62,8 @@ private:
     bool checkOne(const CSSSelector&);
 
     const Element& m_element;
+    Mode m_mode;
+    bool m_needsMainThread;
     bool m_matchedAttributeSelector;
     bool m_matchedFocusSelector;
     bool m_matchedHoverSelector;
@@ -0,0 +1,99 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/core/css/SelectorFilter.h"
+
+#include "gen/sky/core/HTMLNames.h"
+#include "sky/engine/core/css/CSSSelector.h"
+#include "sky/engine/core/dom/Element.h"
+#include "sky/engine/core/dom/SpaceSplitString.h"
+
+namespace blink {
+
+// Salt to separate otherwise identical string hashes so a class-selector like
+// .article won't match <article> elements.
+enum {
+    TagNameSalt = 13,
+    IdAttributeSalt = 17,
+    ClassAttributeSalt = 19,
+    AttributeSalt = 23,
+};
+
+static inline unsigned identifierHash(const AtomicString& identifier, unsigned salt)
+{
+    if (identifier.isEmpty())
+        return 0;
+    return identifier.impl()->existingHash() * salt;
+}
+
+void SelectorFilter::addIdentifierHash(unsigned hash)
+{
+    // Zero terminates the hash lists in RuleData, so it's never looked up.
+    if (!hash)
+        return;
+    m_filter.add(hash);
+    m_identifierHashes.append(hash);
+}
+
+void SelectorFilter::pushElement(const Element& element)
+{
+    ASSERT(!isActive());
+    ASSERT(m_filter.likelyEmpty());
+
+    addIdentifierHash(identifierHash(element.localName(), TagNameSalt));
+    if (element.hasID())
+        addIdentifierHash(identifierHash(element.idForStyleResolution(), IdAttributeSalt));
+    if (element.hasClass()) {
+        const SpaceSplitString& classNames = element.classNames();
+        for (size_t i = 0; i < classNames.size(); ++i)
+            addIdentifierHash(identifierHash(classNames[i], ClassAttributeSalt));
+    }
+    for (auto& attribute : element.attributesWithoutUpdate())
+        addIdentifierHash(identifierHash(attribute.localName(), AttributeSalt));
+    // A style attribute that was set through the CSSOM isn't in the attribute
+    // list until it's synchronized, but the SelectorChecker will see it.
+    if (element.inlineStyle())
+        addIdentifierHash(identifierHash(HTMLNames::styleAttr.localName(), AttributeSalt));
+}
+
+void SelectorFilter::popElement()
+{
+    for (unsigned hash : m_identifierHashes)
+        m_filter.remove(hash);
+    m_identifierHashes.clear();
+}
+
+static inline unsigned selectorIdentifierHash(const CSSSelector& selector)
+{
+    switch (selector.match()) {
+    case CSSSelector::Tag:
+        if (selector.tagQName().localName() == starAtom)
+            return 0;
+        return identifierHash(selector.tagQName().localName(), TagNameSalt);
+    case CSSSelector::Id:
+        return identifierHash(selector.value(), IdAttributeSalt);
+    case CSSSelector::Class:
+        return identifierHash(selector.value(), ClassAttributeSalt);
+    case CSSSelector::Exact:
+    case CSSSelector::Set:
+        return identifierHash(selector.attribute().localName(), AttributeSalt);
+    default:
+        return 0;
+    }
+}
+
+void SelectorFilter::collectIdentifierHashes(const CSSSelector& selector, unsigned* identifierHashes, unsigned maximumIdentifierCount)
+{
+    unsigned* hash = identifierHashes;
+    unsigned* end = identifierHashes + maximumIdentifierCount;
+    for (const CSSSelector* current = &selector; current && hash != end; current = current->tagHistory()) {
+        if ((*hash = selectorIdentifierHash(*current)))
+            ++hash;
+    }
+    if (hash != end)
+        *hash = 0;
+}
+
+} // namespace blink
@@ -0,0 +1,81 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_ENGINE_CORE_CSS_SELECTORFILTER_H_
+#define SKY_ENGINE_CORE_CSS_SELECTORFILTER_H_
+
+#include "sky/engine/wtf/BloomFilter.h"
+#include "sky/engine/wtf/Noncopyable.h"
+#include "sky/engine/wtf/Vector.h"
+
+namespace blink {
+
+class CSSSelector;
+class Element;
+
+// Rejects rules that can't match an element without running the
+// SelectorChecker. While an element is being matched, the filter holds the
+// hashes of its tag name, id, classes and attribute names. A rule's compound
+// selector needs each of the identifiers it names to be present, so if the
+// filter is sure one of them is missing the rule can't match.
+class SelectorFilter {
+    WTF_MAKE_NONCOPYABLE(SelectorFilter);
+public:
+    SelectorFilter() { }
+
+    // Fills the filter with the identifiers of |element| for its lifetime.
+    class Scope {
+        STACK_ALLOCATED();
+        WTF_MAKE_NONCOPYABLE(Scope);
+    public:
+        Scope(SelectorFilter& filter, const Element& element)
+            : m_filter(filter)
+        {
+            m_filter.pushElement(element);
+        }
+        ~Scope() { m_filter.popElement(); }
+
+    private:
+        SelectorFilter& m_filter;
+    };
+
+    bool isActive() const { return !m_identifierHashes.isEmpty(); }
+
+    // |identifierHashes| is zero terminated unless all |maximumIdentifierCount|
+    // slots are used.
+    template <unsigned maximumIdentifierCount>
+    inline bool fastRejectSelector(const unsigned* identifierHashes) const;
+
+    // Stores the hashes of up to |maximumIdentifierCount| identifiers that
+    // |selector| requires of the element it matches, zero terminated if there
+    // are fewer.
+    static void collectIdentifierHashes(const CSSSelector&, unsigned* identifierHashes, unsigned maximumIdentifierCount);
+
+private:
+    void pushElement(const Element&);
+    void popElement();
+    void addIdentifierHash(unsigned);
+
+    // With only one element's identifiers in it, the filter stays very
+    // sparse and false positives are rare.
+    BloomFilter<12> m_filter;
+    // The hashes added for the current element, so they can be removed again
+    // without clearing the whole table.
+    Vector<unsigned, 16> m_identifierHashes;
+};
+
+template <unsigned maximumIdentifierCount>
+inline bool SelectorFilter::fastRejectSelector(const unsigned* identifierHashes) const
+{
+    ASSERT(isActive());
+    for (unsigned n = 0; n < maximumIdentifierCount && identifierHashes[n]; ++n) {
+        if (!m_filter.mayContain(identifierHashes[n]))
+            return true;
+    }
+    return false;
+}
+
+} // namespace blink
+
+#endif  // SKY_ENGINE_CORE_CSS_SELECTORFILTER_H_
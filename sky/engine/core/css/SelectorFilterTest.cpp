@@ -0,0 +1,133 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/core/css/SelectorFilter.h"
+
+#include <gtest/gtest.h>
+#include "gen/sky/core/HTMLNames.h"
+#include "sky/engine/bindings/exception_state_placeholder.h"
+#include "sky/engine/core/css/CSSSelectorList.h"
+#include "sky/engine/core/css/RuleSet.h"
+#include "sky/engine/core/css/StyleRule.h"
+#include "sky/engine/core/css/parser/BisonCSSParser.h"
+#include "sky/engine/core/dom/Document.h"
+#include "sky/engine/core/dom/Element.h"
+
+using namespace blink;
+
+namespace {
+
+class SelectorFilterTest : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        m_document = Document::create();
+        // <foo-bar id="main" class="first second" data-x="1">
+        m_element = m_document->createElement("foo-bar", ASSERT_NO_EXCEPTION);
+        m_element->setAttribute(HTMLNames::idAttr, "main");
+        m_element->setAttribute(HTMLNames::classAttr, "first second");
+        m_element->setAttribute("data-x", "1", ASSERT_NO_EXCEPTION);
+    }
+
+    // Whether the filter, holding the identifiers of m_element, rejects a rule
+    // with |selectorText| without running the SelectorChecker.
+    bool fastRejects(const String& selectorText)
+    {
+        CSSSelectorList selectorList;
+        BisonCSSParser(strictCSSParserContext()).parseSelector(selectorText, selectorList);
+        EXPECT_TRUE(selectorList.first()) << selectorText.utf8().data();
+        if (!selectorList.first())
+            return false;
+        RefPtr<StyleRule> rule = StyleRule::create();
+        rule->wrapperAdoptSelectorList(selectorList);
+        RuleData ruleData(rule.get(), 0, 0);
+
+        SelectorFilter filter;
+        SelectorFilter::Scope scope(filter, *m_element);
+        return filter.fastRejectSelector<RuleData::maximumIdentifierCount>(ruleData.identifierHashes());
+    }
+
+    RefPtr<Document> m_document;
+    RefPtr<Element> m_element;
+};
+
+TEST_F(SelectorFilterTest, AcceptsPresentIdentifiers)
+{
+    EXPECT_FALSE(fastRejects("foo-bar"));
+    EXPECT_FALSE(fastRejects("#main"));
+    EXPECT_FALSE(fastRejects(".first"));
+    EXPECT_FALSE(fastRejects(".second"));
+    EXPECT_FALSE(fastRejects("[data-x]"));
+    EXPECT_FALSE(fastRejects("[data-x=\"2\"]"));
+    EXPECT_FALSE(fastRejects("foo-bar#main.first.second[data-x]"));
+    EXPECT_FALSE(fastRejects("*"));
+    EXPECT_FALSE(fastRejects(":hover"));
+}
+
+TEST_F(SelectorFilterTest, RejectsMissingIdentifiers)
+{
+    EXPECT_TRUE(fastRejects("div"));
+    EXPECT_TRUE(fastRejects("#other"));
+    EXPECT_TRUE(fastRejects(".third"));
+    EXPECT_TRUE(fastRejects("[data-y]"));
+    EXPECT_TRUE(fastRejects("[data-y=\"1\"]"));
+
+    // One missing identifier is enough.
+    EXPECT_TRUE(fastRejects("foo-bar.first.third"));
+    EXPECT_TRUE(fastRejects("div#main"));
+    EXPECT_TRUE(fastRejects(".first:hover[data-y]"));
+}
+
+TEST_F(SelectorFilterTest, IdentifierKindsAreDistinct)
+{
+    // The same name as a different kind of identifier doesn't count.
+    EXPECT_TRUE(fastRejects("main"));
+    EXPECT_TRUE(fastRejects(".main"));
+    EXPECT_TRUE(fastRejects("#first"));
+    EXPECT_TRUE(fastRejects("first"));
+    EXPECT_TRUE(fastRejects(".data-x"));
+    EXPECT_TRUE(fastRejects("[first]"));
+}
+
+TEST_F(SelectorFilterTest, NeverRejectsHostArguments)
+{
+    // The argument of :host() isn't part of the compound selector's own
+    // identifiers, so it's left to the SelectorChecker.
+    EXPECT_FALSE(fastRejects(":host"));
+    EXPECT_FALSE(fastRejects(":host(.third)"));
+    EXPECT_FALSE(fastRejects(":host(div#other[data-y])"));
+    EXPECT_FALSE(fastRejects(":host(.first)"));
+}
+
+TEST_F(SelectorFilterTest, InlineStyleCountsAsStyleAttribute)
+{
+    EXPECT_TRUE(fastRejects("[style]"));
+    m_element->setAttribute(HTMLNames::styleAttr, "color: red");
+    EXPECT_FALSE(fastRejects("[style]"));
+}
+
+TEST_F(SelectorFilterTest, FilterIsEmptiedAfterEachElement)
+{
+    SelectorFilter filter;
+    EXPECT_FALSE(filter.isActive());
+    {
+        SelectorFilter::Scope scope(filter, *m_element);
+        EXPECT_TRUE(filter.isActive());
+    }
+    EXPECT_FALSE(filter.isActive());
+
+    // The next element's identifiers replace the previous one's.
+    RefPtr<Element> other = m_document->createElement("div", ASSERT_NO_EXCEPTION);
+    CSSSelectorList selectorList;
+    BisonCSSParser(strictCSSParserContext()).parseSelector("foo-bar", selectorList);
+    RefPtr<StyleRule> rule = StyleRule::create();
+    rule->wrapperAdoptSelectorList(selectorList);
+    RuleData ruleData(rule.get(), 0, 0);
+
+    SelectorFilter::Scope scope(filter, *other);
+    EXPECT_TRUE(filter.fastRejectSelector<RuleData::maximumIdentifierCount>(ruleData.identifierHashes()));
+}
+
+} // namespace
@@ -0,0 +1,153 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/core/css/resolver/ParallelRuleMatcher.h"
+
+#include <algorithm>
+#include "base/atomic_ref_count.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/threading/thread.h"
+#include "sky/engine/core/css/SelectorFilter.h"
+#include "sky/engine/core/css/resolver/ElementResolveContext.h"
+#include "sky/engine/core/css/resolver/StyleResolver.h"
+#include "sky/engine/core/dom/Element.h"
+#include "sky/engine/platform/TraceEvent.h"
+#include "sky/engine/wtf/PartitionAlloc.h"
+
+namespace blink {
+
+// More threads than this contend for memory bandwidth rather than speeding
+// matching up.
+static const unsigned maximumThreadCount = 7;
+
+// One matchRules() call. Each thread matches a contiguous range of the
+// elements and writes only to their results.
+class ParallelRuleMatcher::Job {
+    WTF_MAKE_NONCOPYABLE(Job);
+public:
+    Job(const Vector<Element*>& elements, Vector<OwnPtr<CollectedRules> >& results, int pendingRanges)
+        : m_elements(elements)
+        , m_results(results)
+        , m_pendingRanges(pendingRanges)
+        , m_done(false, false)
+    {
+    }
+
+    void matchRange(size_t begin, size_t end)
+    {
+        TRACE_EVENT1("blink", "ParallelRuleMatcher::matchRange", "elements", end - begin);
+        SelectorFilter filter;
+        for (size_t i = begin; i < end; ++i) {
+            Element& element = *m_elements[i];
+            SelectorFilter::Scope filterScope(filter, element);
+            ElementResolveContext context(element);
+            ElementRuleCollector collector(context, filter);
+            collector.setMatchingOffMainThread();
+            StyleResolver::collectMatchingRules(element, collector);
+            if (collector.needsMainThread())
+                m_results[i].clear();
+            else
+                collector.releaseCollectedRules(*m_results[i]);
+        }
+    }
+
+    void matchRangeOnWorker(size_t begin, size_t end)
+    {
+        matchRange(begin, end);
+        if (!base::AtomicRefCountDec(&m_pendingRanges))
+            m_done.Signal();
+        // The worker may sit idle until the next style recalc. Don't touch
+        // the job here, the main thread may have deleted it already.
+        partitionAllocFlushThreadCaches();
+    }
+
+    void wait() { m_done.Wait(); }
+
+private:
+    const Vector<Element*>& m_elements;
+    Vector<OwnPtr<CollectedRules> >& m_results;
+    base::AtomicRefCount m_pendingRanges;
+    base::WaitableEvent m_done;
+};
+
+PassOwnPtr<ParallelRuleMatcher> ParallelRuleMatcher::create()
+{
+    unsigned threadCount = std::min(static_cast<unsigned>(std::max(base::SysInfo::NumberOfProcessors() - 1, 0)), maximumThreadCount);
+    if (!threadCount)
+        return nullptr;
+    return adoptPtr(new ParallelRuleMatcher(threadCount));
+}
+
+PassOwnPtr<ParallelRuleMatcher> ParallelRuleMatcher::createForTesting(unsigned threadCount)
+{
+    return adoptPtr(new ParallelRuleMatcher(threadCount));
+}
+
+ParallelRuleMatcher::ParallelRuleMatcher(unsigned threadCount)
+{
+    for (unsigned i = 0; i < threadCount; ++i) {
+        OwnPtr<base::Thread> thread = adoptPtr(new base::Thread(base::StringPrintf("SkyStyleWorker%u", i + 1)));
+        CHECK(thread->Start());
+        m_threads.append(thread.release());
+    }
+}
+
+ParallelRuleMatcher::~ParallelRuleMatcher()
+{
+    // Joins the threads.
+    m_threads.clear();
+}
+
+void ParallelRuleMatcher::matchRules(const Vector<Element*>& elements)
+{
+    TRACE_EVENT1("blink", "ParallelRuleMatcher::matchRules", "elements", elements.size());
+    clear();
+
+    m_elements = elements;
+    m_results.reserveInitialCapacity(m_elements.size());
+    for (size_t i = 0; i < m_elements.size(); ++i) {
+        m_results.uncheckedAppend(adoptPtr(new CollectedRules));
+        m_resultIndices.add(m_elements[i], i);
+    }
+
+    // The calling thread takes the first range rather than sitting idle.
+    size_t rangeCount = m_threads.size() + 1;
+    size_t rangeSize = (m_elements.size() + rangeCount - 1) / rangeCount;
+    Job job(m_elements, m_results, static_cast<int>(m_threads.size()));
+    for (size_t i = 0; i < m_threads.size(); ++i) {
+        size_t begin = std::min((i + 1) * rangeSize, m_elements.size());
+        size_t end = std::min(begin + rangeSize, m_elements.size());
+        m_threads[i]->task_runner()->PostTask(FROM_HERE, base::Bind(&Job::matchRangeOnWorker, base::Unretained(&job), begin, end));
+    }
+    job.matchRange(0, std::min(rangeSize, m_elements.size()));
+    if (!m_threads.isEmpty())
+        job.wait();
+}
+
+bool ParallelRuleMatcher::takeMatchedRules(Element& element, ElementRuleCollector& collector)
+{
+    HashMap<Element*, size_t>::iterator it = m_resultIndices.find(&element);
+    if (it == m_resultIndices.end())
+        return false;
+    OwnPtr<CollectedRules> rules = m_results[it->value].release();
+    m_resultIndices.remove(it);
+    if (!rules)
+        return false;
+    collector.adoptCollectedRules(*rules);
+    return true;
+}
+
+void ParallelRuleMatcher::clear()
+{
+    m_elements.clear();
+    m_results.clear();
+    m_resultIndices.clear();
+}
+
+} // namespace blink
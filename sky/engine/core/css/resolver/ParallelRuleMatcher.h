@@ -0,0 +1,67 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_ENGINE_CORE_CSS_RESOLVER_PARALLELRULEMATCHER_H_
+#define SKY_ENGINE_CORE_CSS_RESOLVER_PARALLELRULEMATCHER_H_
+
+#include "sky/engine/core/css/ElementRuleCollector.h"
+#include "sky/engine/wtf/HashMap.h"
+#include "sky/engine/wtf/OwnPtr.h"
+#include "sky/engine/wtf/PassOwnPtr.h"
+#include "sky/engine/wtf/Vector.h"
+
+namespace base {
+class Thread;
+}
+
+namespace blink {
+
+class Element;
+
+// Matches rules for the elements a style recalc is about to resolve on a set
+// of worker threads, ahead of the recalc. The recalc then picks the matched
+// rules up element by element, in its usual order, and applies them on the
+// main thread as before.
+//
+// Only matching happens off the main thread: it reads the DOM and the rule
+// sets without touching any ref counts. Applying the matched properties
+// builds ref counted styles and values and stays on the main thread.
+class ParallelRuleMatcher {
+    WTF_MAKE_NONCOPYABLE(ParallelRuleMatcher);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    // Returns null if there's only one core to run on.
+    static PassOwnPtr<ParallelRuleMatcher> create();
+    // Uses |threadCount| workers however many cores there are.
+    static PassOwnPtr<ParallelRuleMatcher> createForTesting(unsigned threadCount);
+    ~ParallelRuleMatcher();
+
+    // Matches rules for |elements|, splitting them between the worker
+    // threads and the calling thread, and returns once all are matched. The
+    // rule sets the elements use must be compact, and the DOM mustn't change
+    // until the matched rules are taken or cleared.
+    void matchRules(const Vector<Element*>& elements);
+
+    // Hands the rules matched for |element| over to |collector|. Returns
+    // false if none were matched, in which case the caller matches itself.
+    bool takeMatchedRules(Element&, ElementRuleCollector&);
+
+    void clear();
+
+private:
+    class Job;
+
+    explicit ParallelRuleMatcher(unsigned threadCount);
+
+    Vector<OwnPtr<base::Thread> > m_threads;
+
+    Vector<Element*> m_elements;
+    // Null where the element needs the main thread to be matched.
+    Vector<OwnPtr<CollectedRules> > m_results;
+    HashMap<Element*, size_t> m_resultIndices;
+};
+
+} // namespace blink
+
+#endif  // SKY_ENGINE_CORE_CSS_RESOLVER_PARALLELRULEMATCHER_H_
@@ -0,0 +1,262 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/core/css/resolver/ParallelRuleMatcher.h"
+
+#include <gtest/gtest.h>
+#include "gen/sky/core/HTMLNames.h"
+#include "gen/sky/platform/RuntimeEnabledFeatures.h"
+#include "sky/engine/bindings/exception_state_placeholder.h"
+#include "sky/engine/core/css/SelectorFilter.h"
+#include "sky/engine/core/css/resolver/ElementResolveContext.h"
+#include "sky/engine/core/css/resolver/StyleResolver.h"
+#include "sky/engine/core/css/resolver/StyleResolverStats.h"
+#include "sky/engine/core/dom/Document.h"
+#include "sky/engine/core/dom/Element.h"
+#include "sky/engine/core/dom/ElementTraversal.h"
+#include "sky/engine/core/rendering/style/RenderStyle.h"
+#include "sky/engine/core/testing/DummyPageHolder.h"
+#include "sky/engine/platform/geometry/IntSize.h"
+#include "sky/engine/platform/graphics/Color.h"
+
+using namespace blink;
+
+namespace {
+
+const char styleSheet[] =
+    "div { color: red; }"
+    "span { color: red; }"
+    ".a { color: blue; }"
+    ".b { color: blue; }"
+    "#one { color: green; }"
+    "[data-x] { color: yellow; }"
+    "[data-x=\"2\"] { color: yellow; }"
+    "span.a[data-x] { color: orange; }"
+    "div:hover { color: purple; }"
+    ".b:focus { color: purple; }"
+    "span:hover.a { color: purple; }"
+    "p:lang(en) { color: black; }";
+
+// Matches |element| the way the main thread does when nothing was matched
+// ahead for it.
+PassOwnPtr<CollectedRules> matchOnMainThread(Element& element)
+{
+    SelectorFilter filter;
+    SelectorFilter::Scope filterScope(filter, element);
+    ElementResolveContext context(element);
+    ElementRuleCollector collector(context, filter);
+    StyleResolver::collectMatchingRules(element, collector);
+    EXPECT_FALSE(collector.needsMainThread());
+    OwnPtr<CollectedRules> rules = adoptPtr(new CollectedRules);
+    collector.releaseCollectedRules(*rules);
+    return rules.release();
+}
+
+// Returns the rules |matcher| matched for |element|, or null if it left the
+// element to the main thread.
+PassOwnPtr<CollectedRules> takeMatchedRules(ParallelRuleMatcher& matcher, Element& element)
+{
+    SelectorFilter filter;
+    ElementResolveContext context(element);
+    ElementRuleCollector collector(context, filter);
+    if (!matcher.takeMatchedRules(element, collector))
+        return nullptr;
+    OwnPtr<CollectedRules> rules = adoptPtr(new CollectedRules);
+    collector.releaseCollectedRules(*rules);
+    return rules.release();
+}
+
+size_t matchedRuleCount(const CollectedRules& rules)
+{
+    return rules.matchedRules ? rules.matchedRules->size() : 0;
+}
+
+void expectSameRules(const CollectedRules& expected, const CollectedRules& actual)
+{
+    ASSERT_EQ(matchedRuleCount(expected), matchedRuleCount(actual));
+    for (size_t i = 0; i < matchedRuleCount(expected); ++i) {
+        const MatchedRule& expectedRule = expected.matchedRules->at(i);
+        const MatchedRule& actualRule = actual.matchedRules->at(i);
+        EXPECT_EQ(expectedRule.ruleData(), actualRule.ruleData());
+        EXPECT_EQ(expectedRule.position(), actualRule.position());
+        EXPECT_EQ(expectedRule.parentStyleSheet(), actualRule.parentStyleSheet());
+    }
+    EXPECT_EQ(expected.matchedSelectorFlags, actual.matchedSelectorFlags);
+    EXPECT_EQ(expected.rulesTested, actual.rulesTested);
+    EXPECT_EQ(expected.rulesFastRejected, actual.rulesFastRejected);
+    EXPECT_EQ(expected.rulesMatched, actual.rulesMatched);
+}
+
+class ParallelRuleMatcherTest : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        m_pageHolder = DummyPageHolder::create(IntSize(800, 600));
+        Document& document = m_pageHolder->document();
+        m_root = document.createElement("root", ASSERT_NO_EXCEPTION);
+        document.appendChild(m_root);
+
+        RefPtr<Element> style = document.createElement("style", ASSERT_NO_EXCEPTION);
+        style->setTextContent(styleSheet);
+        m_root->appendChild(style);
+    }
+
+    Element* appendElement(const char* tagName)
+    {
+        RefPtr<Element> element = m_pageHolder->document().createElement(tagName, ASSERT_NO_EXCEPTION);
+        m_root->appendChild(element);
+        m_elements.append(element.get());
+        return element.get();
+    }
+
+    OwnPtr<DummyPageHolder> m_pageHolder;
+    RefPtr<Element> m_root;
+    Vector<Element*> m_elements;
+};
+
+TEST_F(ParallelRuleMatcherTest, MatchesLikeTheMainThread)
+{
+    // Enough elements that every worker gets some.
+    for (int i = 0; i < 40; ++i) {
+        Element* element = appendElement(i % 3 ? "div" : "span");
+        if (i % 2)
+            element->setAttribute(HTMLNames::classAttr, i % 4 == 1 ? "a" : "a b");
+        if (i == 7)
+            element->setAttribute(HTMLNames::idAttr, "one");
+        if (i % 5 == 0)
+            element->setAttribute("data-x", i % 10 ? "1" : "2", ASSERT_NO_EXCEPTION);
+        if (i % 6 == 0)
+            element->setHovered(true);
+    }
+
+    // Matching on the main thread first also makes the rule sets compact, as
+    // the parallel matcher requires.
+    Vector<OwnPtr<CollectedRules> > expected;
+    for (Element* element : m_elements)
+        expected.append(matchOnMainThread(*element));
+
+    OwnPtr<ParallelRuleMatcher> matcher = ParallelRuleMatcher::createForTesting(3);
+    matcher->matchRules(m_elements);
+
+    for (size_t i = 0; i < m_elements.size(); ++i) {
+        SCOPED_TRACE(i);
+        OwnPtr<CollectedRules> actual = takeMatchedRules(*matcher, *m_elements[i]);
+        ASSERT_TRUE(actual.get());
+        EXPECT_LT(0u, matchedRuleCount(*actual));
+        expectSameRules(*expected[i], *actual);
+    }
+
+    // Rules are handed over only once.
+    EXPECT_FALSE(takeMatchedRules(*matcher, *m_elements[0]).get());
+}
+
+TEST_F(ParallelRuleMatcherTest, LangFallsBackToTheMainThread)
+{
+    for (int i = 0; i < 8; ++i)
+        appendElement(i == 5 ? "p" : "div");
+
+    Vector<OwnPtr<CollectedRules> > expected;
+    for (Element* element : m_elements)
+        expected.append(matchOnMainThread(*element));
+
+    OwnPtr<ParallelRuleMatcher> matcher = ParallelRuleMatcher::createForTesting(3);
+    matcher->matchRules(m_elements);
+
+    for (size_t i = 0; i < m_elements.size(); ++i) {
+        SCOPED_TRACE(i);
+        OwnPtr<CollectedRules> actual = takeMatchedRules(*matcher, *m_elements[i]);
+        if (i == 5) {
+            // :lang() can't be checked off the main thread, so the element
+            // is left for the main thread to match.
+            EXPECT_FALSE(actual.get());
+            continue;
+        }
+        ASSERT_TRUE(actual.get());
+        expectSameRules(*expected[i], *actual);
+    }
+
+    // Elements that weren't part of the match aren't found either.
+    Element* other = appendElement("div");
+    EXPECT_FALSE(takeMatchedRules(*matcher, *other).get());
+
+    matcher->clear();
+    EXPECT_FALSE(takeMatchedRules(*matcher, *m_elements[0]).get());
+}
+
+// Builds a page with enough elements for a style recalc to match them ahead.
+// Every <p> is checked against the :lang() rule, so the recalc has to match
+// those itself.
+PassOwnPtr<DummyPageHolder> createPageForStyleRecalc()
+{
+    OwnPtr<DummyPageHolder> pageHolder = DummyPageHolder::create(IntSize(800, 600));
+    Document& document = pageHolder->document();
+    RefPtr<Element> root = document.createElement("root", ASSERT_NO_EXCEPTION);
+    document.appendChild(root);
+
+    RefPtr<Element> style = document.createElement("style", ASSERT_NO_EXCEPTION);
+    style->setTextContent(styleSheet);
+    root->appendChild(style);
+
+    for (int i = 0; i < 300; ++i) {
+        RefPtr<Element> element = document.createElement(i % 7 == 3 ? "p" : i % 3 ? "div" : "span", ASSERT_NO_EXCEPTION);
+        if (i % 2)
+            element->setAttribute(HTMLNames::classAttr, i % 4 == 1 ? "a" : "a b");
+        if (i == 7)
+            element->setAttribute(HTMLNames::idAttr, "one");
+        if (i % 5 == 0)
+            element->setAttribute("data-x", i % 10 ? "1" : "2", ASSERT_NO_EXCEPTION);
+        if (i % 14 == 3)
+            element->setAttribute(HTMLNames::langAttr, "en-US");
+        root->appendChild(element);
+    }
+    return pageHolder.release();
+}
+
+TEST(ParallelStyleRecalcTest, ComputesTheSameStylesAsTheSerialRecalc)
+{
+    bool wasEnabled = RuntimeEnabledFeatures::parallelStyleRecalcEnabled();
+
+    RuntimeEnabledFeatures::setParallelStyleRecalcEnabled(false);
+    OwnPtr<DummyPageHolder> serialPage = createPageForStyleRecalc();
+    serialPage->document().updateRenderTreeIfNeeded();
+
+    RuntimeEnabledFeatures::setParallelStyleRecalcEnabled(true);
+    OwnPtr<DummyPageHolder> parallelPage = createPageForStyleRecalc();
+    StyleResolver& resolver = parallelPage->document().styleResolver();
+    resolver.setParallelRuleMatcherForTesting(ParallelRuleMatcher::createForTesting(3));
+    resolver.enableStats();
+    parallelPage->document().updateRenderTreeIfNeeded();
+    RuntimeEnabledFeatures::setParallelStyleRecalcEnabled(wasEnabled);
+
+    // The recalc took most elements' rules from the workers, and matched
+    // the ones the workers left alone itself.
+    const StyleResolverStats& stats = *resolver.statsTotals();
+    EXPECT_LT(0u, stats.rulesMatchedAheadElements);
+    EXPECT_LT(stats.rulesMatchedAheadElements, stats.rulesMatchedElements);
+
+    Element* serialElement = ElementTraversal::firstWithin(serialPage->document());
+    Element* parallelElement = ElementTraversal::firstWithin(parallelPage->document());
+    size_t langMatches = 0;
+    for (size_t i = 0; serialElement && parallelElement; ++i) {
+        SCOPED_TRACE(i);
+        EXPECT_EQ(serialElement->tagQName(), parallelElement->tagQName());
+        RenderStyle* serialStyle = serialElement->computedStyle();
+        RenderStyle* parallelStyle = parallelElement->computedStyle();
+        ASSERT_TRUE(serialStyle);
+        ASSERT_TRUE(parallelStyle);
+        EXPECT_EQ(serialStyle->color(), parallelStyle->color());
+        if (parallelElement->hasAttribute(HTMLNames::langAttr)) {
+            EXPECT_EQ(Color(Color::black), parallelStyle->color());
+            ++langMatches;
+        }
+        serialElement = ElementTraversal::next(*serialElement);
+        parallelElement = ElementTraversal::next(*parallelElement);
+    }
+    EXPECT_FALSE(serialElement);
+    EXPECT_FALSE(parallelElement);
+    EXPECT_LT(0u, langMatches);
+}
+
+} // namespace
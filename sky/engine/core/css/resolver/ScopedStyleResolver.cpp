@@ -124,6 +124,12 @@ void ScopedStyleResolver::collectMatchingAuthorRules(ElementRuleCollector& colle
     }
 }
 
+void ScopedStyleResolver::ensureCompactRuleSets()
+{
+    for (size_t i = 0; i < m_authorStyleSheets.size(); ++i)
+        m_authorStyleSheets[i]->contents()->ensureRuleSet().compactRulesIfNeeded();
+}
+
 void ScopedStyleResolver::collectMatchingHostRules(ElementRuleCollector& collector, CascadeOrder cascadeOrder)
 {
     for (size_t i = 0; i < m_authorStyleSheets.size(); ++i) {
@@ -59,6 +59,10 @@ public:
     void collectMatchingAuthorRules(ElementRuleCollector&, CascadeOrder = ignoreCascadeOrder);
     void collectMatchingHostRules(ElementRuleCollector&, CascadeOrder = ignoreCascadeOrder);
 
+    // Builds and compacts the rule sets of the author style sheets, so that
+    // collecting rules from them doesn't modify anything.
+    void ensureCompactRuleSets();
+
     bool hasSelectorForId(const AtomicString& id) const;
     bool hasSelectorForClass(const AtomicString& className) const;
     bool hasSelectorForAttribute(const AtomicString& attributeName) const;
@@ -150,7 +150,7 @@ bool SharedStyleFinder::documentContainsValidCandidate() const
 
 inline Element* SharedStyleFinder::findElementForStyleSharing() const
 {
-    StyleSharingList& styleSharingList = m_styleResolver.styleSharingList();
+    StyleSharingList& styleSharingList = m_styleResolver.styleSharingList(element().localName());
     for (StyleSharingList::iterator it = styleSharingList.begin(); it != styleSharingList.end(); ++it) {
         Element& candidate = **it;
         // We shouldn't have elements in the style sharing list that don't
@@ -54,12 +54,14 @@
 #include "sky/engine/core/css/parser/BisonCSSParser.h"
 #include "sky/engine/core/css/resolver/AnimatedStyleBuilder.h"
 #include "sky/engine/core/css/resolver/MatchResult.h"
+#include "sky/engine/core/css/resolver/ParallelRuleMatcher.h"
 #include "sky/engine/core/css/resolver/SharedStyleFinder.h"
 #include "sky/engine/core/css/resolver/StyleAdjuster.h"
 #include "sky/engine/core/css/resolver/StyleBuilder.h"
 #include "sky/engine/core/css/resolver/StyleResolverState.h"
 #include "sky/engine/core/css/resolver/StyleResolverStats.h"
 #include "sky/engine/core/css/resolver/StyleResourceLoader.h"
+#include "sky/engine/core/dom/ElementTraversal.h"
 #include "sky/engine/core/dom/NodeRenderStyle.h"
 #include "sky/engine/core/dom/StyleEngine.h"
 #include "sky/engine/core/dom/Text.h"
@@ -68,6 +70,7 @@
 #include "sky/engine/core/frame/FrameView.h"
 #include "sky/engine/core/frame/LocalFrame.h"
 #include "sky/engine/core/rendering/RenderView.h"
+#include "sky/engine/wtf/HashSet.h"
 #include "sky/engine/wtf/LeakAnnotations.h"
 #include "sky/engine/wtf/StdLibExtras.h"
 
@@ -134,25 +137,94 @@ void StyleResolver::addToStyleSharingList(Element& element)
         return;
     ASSERT(element.supportsStyleSharing());
     INCREMENT_STYLE_STATS_COUNTER(*this, sharedStyleCandidates);
-    StyleSharingList& list = styleSharingList();
+    StyleSharingList& list = styleSharingList(element.localName());
     if (list.size() >= styleSharingListSize)
         list.removeLast();
     list.prepend(&element);
 }
 
+StyleSharingList& StyleResolver::styleSharingList(const AtomicString& localName)
+{
+    OwnPtr<StyleSharingList>& list = m_styleSharingLists.add(localName, nullptr).storedValue->value;
+    if (!list)
+        list = adoptPtr(new StyleSharingList);
+    return *list;
+}
+
 void StyleResolver::clearStyleSharingList()
 {
-    m_styleSharingList.clear();
+    m_styleSharingLists.clear();
 }
 
 StyleResolver::~StyleResolver()
 {
 }
 
-void StyleResolver::matchRules(Element& element, ElementRuleCollector& collector)
+// Below this many elements, handing them to the workers costs more than
+// matching them here.
+static const size_t minimumElementsForParallelMatching = 128;
+
+static void collectElementsForStyleRecalc(ContainerNode& parent, bool subtreeNeedsRecalc, Vector<Element*>& elements, HashSet<ScopedStyleResolver*>& resolvers)
 {
-    collector.clearMatchedRules();
+    for (Element* element = ElementTraversal::firstChild(parent); element; element = ElementTraversal::nextSibling(*element)) {
+        if (subtreeNeedsRecalc || element->needsStyleRecalc()) {
+            elements.append(element);
+            // Synchronizes a style attribute changed through the CSSOM, which
+            // matching [style] would otherwise do.
+            element->attributes();
+            resolvers.add(&element->treeScope().scopedStyleResolver());
+            if (ShadowRoot* root = element->shadowRoot())
+                resolvers.add(&root->scopedStyleResolver());
+        }
+        bool descendantsNeedRecalc = subtreeNeedsRecalc || element->styleChangeType() >= SubtreeStyleChange;
+        if (descendantsNeedRecalc || element->childNeedsStyleRecalc()) {
+            if (ShadowRoot* root = element->shadowRoot())
+                collectElementsForStyleRecalc(*root, descendantsNeedRecalc, elements, resolvers);
+            collectElementsForStyleRecalc(*element, descendantsNeedRecalc, elements, resolvers);
+        }
+    }
+}
+
+void StyleResolver::matchRulesForStyleRecalc(StyleRecalcChange change)
+{
+    if (!RuntimeEnabledFeatures::parallelStyleRecalcEnabled())
+        return;
+
+    // Elements whose ancestors' styles change may be resolved too, and
+    // elements that share a style won't be. Either way the recalc still gets
+    // the right rules, since it matches whatever wasn't matched here itself.
+    Vector<Element*> elements;
+    HashSet<ScopedStyleResolver*> resolvers;
+    collectElementsForStyleRecalc(m_document, change >= Inherit, elements, resolvers);
+    if (elements.size() < minimumElementsForParallelMatching)
+        return;
+
+    if (!m_parallelRuleMatcher) {
+        m_parallelRuleMatcher = ParallelRuleMatcher::create();
+        if (!m_parallelRuleMatcher)
+            return;
+    }
+
+    defaultStyles().compactRulesIfNeeded();
+    for (ScopedStyleResolver* resolver : resolvers)
+        resolver->ensureCompactRuleSets();
 
+    m_parallelRuleMatcher->matchRules(elements);
+}
+
+void StyleResolver::setParallelRuleMatcherForTesting(PassOwnPtr<ParallelRuleMatcher> matcher)
+{
+    m_parallelRuleMatcher = matcher;
+}
+
+void StyleResolver::clearRulesMatchedForStyleRecalc()
+{
+    if (m_parallelRuleMatcher)
+        m_parallelRuleMatcher->clear();
+}
+
+void StyleResolver::collectMatchingRules(Element& element, ElementRuleCollector& collector)
+{
     CascadeOrder cascadeOrder = 0;
 
     collector.collectMatchingRules(MatchRequest(&defaultStyles()), ++cascadeOrder);
@@ -162,9 +234,25 @@ void StyleResolver::matchRules(Element& element, ElementRuleCollector& collector
 
     ScopedStyleResolver& resolver = element.treeScope().scopedStyleResolver();
     resolver.collectMatchingAuthorRules(collector, ++cascadeOrder);
+}
+
+void StyleResolver::matchRules(Element& element, ElementRuleCollector& collector)
+{
+    collector.clearMatchedRules();
+
+    if (m_parallelRuleMatcher && m_parallelRuleMatcher->takeMatchedRules(element, collector)) {
+        INCREMENT_STYLE_STATS_COUNTER(*this, rulesMatchedAheadElements);
+    } else {
+        collectMatchingRules(element, collector);
+    }
 
     collector.sortAndTransferMatchedRules();
 
+    INCREMENT_STYLE_STATS_COUNTER(*this, rulesMatchedElements);
+    ADD_STYLE_STATS_COUNTER(*this, rulesTested, collector.rulesTested());
+    ADD_STYLE_STATS_COUNTER(*this, rulesFastRejected, collector.rulesFastRejected());
+    ADD_STYLE_STATS_COUNTER(*this, rulesMatched, collector.rulesMatched());
+
     if (const StylePropertySet* inlineStyle = element.inlineStyle()) {
         // Inline style is immutable as long as there is no CSSOM wrapper.
         bool isInlineStyleCacheable = !inlineStyle->isMutable();
@@ -224,7 +312,8 @@ PassRefPtr<RenderStyle> StyleResolver::styleForElement(Element* element, RenderS
     state.fontBuilder().initForStyleResolve(state.document(), state.style());
 
     {
-        ElementRuleCollector collector(state.elementContext(), state.style());
+        SelectorFilter::Scope filterScope(m_selectorFilter, *element);
+        ElementRuleCollector collector(state.elementContext(), m_selectorFilter, state.style());
 
         matchRules(*element, collector);
 
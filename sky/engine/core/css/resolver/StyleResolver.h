@@ -23,13 +23,17 @@
 #define SKY_ENGINE_CORE_CSS_RESOLVER_STYLERESOLVER_H_
 
 #include "sky/engine/core/css/MediaQueryEvaluator.h"
+#include "sky/engine/core/css/SelectorFilter.h"
 #include "sky/engine/core/css/resolver/MatchedPropertiesCache.h"
 #include "sky/engine/core/css/resolver/ScopedStyleResolver.h"
+#include "sky/engine/core/rendering/style/RenderStyleConstants.h"
 #include "sky/engine/platform/heap/Handle.h"
 #include "sky/engine/wtf/Deque.h"
 #include "sky/engine/wtf/HashMap.h"
+#include "sky/engine/wtf/OwnPtr.h"
 #include "sky/engine/wtf/RefPtr.h"
 #include "sky/engine/wtf/Vector.h"
+#include "sky/engine/wtf/text/AtomicStringHash.h"
 
 namespace blink {
 
@@ -39,12 +43,16 @@ class Document;
 class Element;
 class ElementRuleCollector;
 class Interpolation;
+class ParallelRuleMatcher;
 class StylePropertySet;
 class StyleResolverStats;
 class MatchResult;
 
+// Sharing candidates are kept per tag name, since only elements with the same
+// tag can share a style, so that runs of other elements don't push them out.
 const unsigned styleSharingListSize = 15;
 typedef Deque<Element*, styleSharingListSize> StyleSharingList;
+typedef HashMap<AtomicString, OwnPtr<StyleSharingList> > StyleSharingLists;
 
 struct CSSPropertyValue {
     STACK_ALLOCATED();
@@ -82,11 +90,23 @@ public:
 
     void notifyResizeForViewportUnits();
 
-    StyleSharingList& styleSharingList() { return m_styleSharingList; }
+    StyleSharingList& styleSharingList(const AtomicString& localName);
 
     void addToStyleSharingList(Element&);
     void clearStyleSharingList();
 
+    // With the ParallelStyleRecalc feature on, matches rules on worker threads
+    // for the elements that a recalc with |change| from the document is going
+    // to resolve, and keeps them until the recalc asks for them.
+    void matchRulesForStyleRecalc(StyleRecalcChange);
+    void clearRulesMatchedForStyleRecalc();
+    // Lets tests match ahead even on a single core.
+    void setParallelRuleMatcherForTesting(PassOwnPtr<ParallelRuleMatcher>);
+
+    // Collects the rules |element| matches without applying any. Safe to
+    // call off the main thread once the rule sets involved are compact.
+    static void collectMatchingRules(Element&, ElementRuleCollector&);
+
     StyleResolverStats* stats() { return m_styleResolverStats.get(); }
     StyleResolverStats* statsTotals() { return m_styleResolverStatsTotals.get(); }
     enum StatsReportType { ReportDefaultStats, ReportSlowStats };
@@ -126,7 +146,11 @@ private:
 
     Document& m_document;
 
-    StyleSharingList m_styleSharingList;
+    StyleSharingLists m_styleSharingLists;
+
+    SelectorFilter m_selectorFilter;
+
+    OwnPtr<ParallelRuleMatcher> m_parallelRuleMatcher;
 
     OwnPtr<StyleResolverStats> m_styleResolverStats;
     OwnPtr<StyleResolverStats> m_styleResolverStatsTotals;
@@ -35,6 +35,7 @@
 #include "sky/engine/wtf/text/StringBuilder.h"
 
 #define PERCENT(x, y) ((!y) ? 0 : (((x) * 100.0) / (y)))
+#define PER_ELEMENT(x, y) ((!y) ? 0 : (static_cast<double>(x) / (y)))
 
 namespace blink {
 
@@ -49,6 +50,11 @@ void StyleResolverStats::reset()
     matchedPropertyCacheHit = 0;
     matchedPropertyCacheInheritedHit = 0;
     matchedPropertyCacheAdded = 0;
+    rulesMatchedElements = 0;
+    rulesMatchedAheadElements = 0;
+    rulesTested = 0;
+    rulesFastRejected = 0;
+    rulesMatched = 0;
 }
 
 String StyleResolverStats::report() const
@@ -77,6 +83,16 @@ String StyleResolverStats::report() const
     output.append(String::format("  %u cache hits also shared the inherited style (%.2f%%).\n", matchedPropertyCacheInheritedHit, PERCENT(matchedPropertyCacheInheritedHit, matchedPropertyCacheHit)));
     output.append(String::format("  %u styles created in applyMatchedProperties were added to the cache (%.2f%%).\n", matchedPropertyCacheAdded, PERCENT(matchedPropertyCacheAdded, matchedPropertyApply)));
 
+    output.append('\n');
+
+    unsigned rulesChecked = rulesTested - rulesFastRejected;
+
+    output.appendLiteral("Rule matching:\n");
+    output.append(String::format("  %u elements were matched against %u candidate rules (%.2f per element).\n", rulesMatchedElements, rulesTested, PER_ELEMENT(rulesTested, rulesMatchedElements)));
+    output.append(String::format("  %u elements were matched ahead on worker threads (%.2f%%).\n", rulesMatchedAheadElements, PERCENT(rulesMatchedAheadElements, rulesMatchedElements)));
+    output.append(String::format("  %u rules were rejected by the selector filter (%.2f%%, %.2f per element).\n", rulesFastRejected, PERCENT(rulesFastRejected, rulesTested), PER_ELEMENT(rulesFastRejected, rulesMatchedElements)));
+    output.append(String::format("  %u rules were checked by the SelectorChecker (%.2f per element), %u matched (%.2f%%).\n", rulesChecked, PER_ELEMENT(rulesChecked, rulesMatchedElements), rulesMatched, PERCENT(rulesMatched, rulesChecked)));
+
     return output.toString();
 }
 
@@ -55,6 +55,11 @@ public:
     unsigned matchedPropertyCacheHit;
     unsigned matchedPropertyCacheInheritedHit;
     unsigned matchedPropertyCacheAdded;
+    unsigned rulesMatchedElements;
+    unsigned rulesMatchedAheadElements;
+    unsigned rulesTested;
+    unsigned rulesFastRejected;
+    unsigned rulesMatched;
 
     // We keep a separate flag for this since crawling the entire document to print
     // the number of missed candidates is very slow.
@@ -69,6 +74,7 @@ private:
 };
 
 #define INCREMENT_STYLE_STATS_COUNTER(resolver, counter) ((resolver).stats() && ++(resolver).stats()-> counter && (resolver).statsTotals()-> counter ++);
+#define ADD_STYLE_STATS_COUNTER(resolver, counter, amount) do { if ((resolver).stats()) { (resolver).stats()-> counter += (amount); (resolver).statsTotals()-> counter += (amount); } } while (0)
 
 } // namespace blink
 
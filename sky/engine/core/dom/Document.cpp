@@ -1012,15 +1012,16 @@ void Document::updateStyle(StyleRecalcChange change)
 
     clearNeedsStyleRecalc();
 
-    // Uncomment to enable printing of statistics about style sharing and the matched property cache.
     // Optionally pass StyleResolver::ReportSlowStats to print numbers that require crawling the
     // entire DOM (where collecting them is very slow).
-    // FIXME: Expose this as a runtime flag.
-    // styleResolver().enableStats(/*StyleResolver::ReportSlowStats*/);
+    if (RuntimeEnabledFeatures::styleResolverStatsEnabled())
+        styleResolver().enableStats(/*StyleResolver::ReportSlowStats*/);
 
     if (StyleResolverStats* stats = styleResolver().stats())
         stats->reset();
 
+    styleResolver().matchRulesForStyleRecalc(change);
+
     for (Element* element = ElementTraversal::firstChild(*this); element; element = ElementTraversal::nextSibling(*element)) {
         if (element->shouldCallRecalcStyle(change))
             element->recalcStyle(change);
@@ -1033,6 +1034,7 @@ void Document::updateStyle(StyleRecalcChange change)
     clearChildNeedsStyleRecalc();
 
     m_styleEngine->resolver().clearStyleSharingList();
+    m_styleEngine->resolver().clearRulesMatchedForStyleRecalc();
 
     ASSERT(!needsStyleRecalc());
     ASSERT(!childNeedsStyleRecalc());
@@ -1293,7 +1295,8 @@ void Document::checkCompleted()
     if (isDelayingLoadEvent())
         return;
 
-    // OK, completed.
+    // OK, completed. Anything preloaded that hasn't been used by now won't be.
+    fetcher()->clearPreloads();
     setReadyState(Complete);
     if (loadEventStillNeeded())
         implicitClose();
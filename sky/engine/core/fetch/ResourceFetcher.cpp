@@ -138,6 +138,8 @@ static WebURLRequest::RequestContext requestContextFromType(const ResourceFetche
 ResourceFetcher::ResourceFetcher(Document* document)
     : m_document(document)
     , m_requestCount(0)
+    , m_preloadCount(0)
+    , m_usedPreloadCount(0)
     , m_garbageCollectDocumentResourcesTimer(this, &ResourceFetcher::garbageCollectDocumentResourcesTimerFired)
     , m_autoLoadImages(true)
     , m_imagesEnabled(true)
@@ -149,6 +151,8 @@ ResourceFetcher::~ResourceFetcher()
 {
     m_document = nullptr;
 
+    clearPreloads();
+
     // Make sure no requests still point to this ResourceFetcher
     ASSERT(!m_requestCount);
 }
@@ -185,6 +189,42 @@ ResourcePtr<ImageResource> ResourceFetcher::fetchImage(FetchRequest& request)
     return resource && resource->type() == Resource::Image ? toImageResource(resource) : 0;
 }
 
+String ResourceFetcher::preloadKey(const KURL& url)
+{
+    return MemoryCache::removeFragmentIdentifierIfNeeded(url).string();
+}
+
+void ResourceFetcher::preloadImage(FetchRequest& request)
+{
+    String url = preloadKey(request.resourceRequest().url());
+    if (m_preloads.contains(url) || m_documentResources.contains(url))
+        return;
+
+    ResourcePtr<ImageResource> resource = fetchImage(request);
+    if (!resource)
+        return;
+
+    WTF_LOG(ResourceLoading, "ResourceFetcher::preloadImage '%s'", url.latin1().data());
+    m_preloads.set(url, resource);
+    ++m_preloadCount;
+}
+
+void ResourceFetcher::clearPreloads()
+{
+    if (!m_preloadCount)
+        return;
+
+    WTF_LOG(ResourceLoading, "ResourceFetcher::clearPreloads %d preloads, %d used", m_preloadCount, m_usedPreloadCount);
+    blink::Platform::current()->histogramCustomCounts(
+        "WebCore.ResourceFetcher.PreloadCount", m_preloadCount, 0, 1000, 50);
+    blink::Platform::current()->histogramCustomCounts(
+        "WebCore.ResourceFetcher.UsedPreloadCount", m_usedPreloadCount, 0, 1000, 50);
+
+    m_preloads.clear();
+    m_preloadCount = 0;
+    m_usedPreloadCount = 0;
+}
+
 ResourcePtr<FontResource> ResourceFetcher::fetchFont(FetchRequest& request)
 {
     ASSERT(request.resourceRequest().frameType() == WebURLRequest::FrameTypeNone);
@@ -241,6 +281,14 @@ ResourcePtr<Resource> ResourceFetcher::requestResource(Resource::Type type, Fetc
     if (!url.isValid())
         return 0;
 
+    if (!m_preloads.isEmpty()) {
+        DocumentResourceMap::iterator preload = m_preloads.find(preloadKey(url));
+        if (preload != m_preloads.end()) {
+            m_preloads.remove(preload);
+            ++m_usedPreloadCount;
+        }
+    }
+
     if (!canRequest(type, url, request.options(), request.originRestriction()))
         return 0;
 
@@ -78,6 +78,16 @@ public:
     ResourcePtr<ImageResource> fetchImage(FetchRequest&);
     ResourcePtr<FontResource> fetchFont(FetchRequest&);
 
+    // Starts loading an image the preload scanner found ahead of the element
+    // that uses it. Preloads are kept until the element fetches them for
+    // real or until clearPreloads(), which reports how many were used.
+    void preloadImage(FetchRequest&);
+    void clearPreloads();
+    // The key of a preload of |url|. URLs that only differ in a fragment
+    // identifier the memory cache ignores share a key, so <img src="a.png#b">
+    // uses a preload of a.png.
+    static String preloadKey(const KURL&);
+
     // Logs an access denied message to the console for the specified URL.
     void printAccessDeniedMessage(const KURL&) const;
 
@@ -163,9 +173,12 @@ private:
 
     HashSet<String> m_validatedURLs;
     mutable DocumentResourceMap m_documentResources;
+    DocumentResourceMap m_preloads;
     Document* m_document;
 
     int m_requestCount;
+    int m_preloadCount;
+    int m_usedPreloadCount;
 
     Timer<ResourceFetcher> m_garbageCollectDocumentResourcesTimer;
 
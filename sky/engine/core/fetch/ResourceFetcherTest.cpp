@@ -0,0 +1,35 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/core/fetch/ResourceFetcher.h"
+
+#include <gtest/gtest.h>
+#include "sky/engine/platform/weborigin/KURL.h"
+
+using namespace blink;
+
+namespace {
+
+TEST(ResourceFetcherTest, PreloadKeyIgnoresFragment)
+{
+    KURL url(ParsedURLString, "http://example.com/x.png");
+    KURL urlWithFragment(ParsedURLString, "http://example.com/x.png#frag");
+    KURL urlWithOtherFragment(ParsedURLString, "http://example.com/x.png#other");
+
+    EXPECT_EQ(ResourceFetcher::preloadKey(url), ResourceFetcher::preloadKey(urlWithFragment));
+    EXPECT_EQ(ResourceFetcher::preloadKey(urlWithFragment), ResourceFetcher::preloadKey(urlWithOtherFragment));
+    EXPECT_EQ(String("http://example.com/x.png"), ResourceFetcher::preloadKey(urlWithFragment));
+}
+
+TEST(ResourceFetcherTest, PreloadKeyKeepsFragmentOutsideHTTP)
+{
+    // The memory cache keeps these apart, so preloads have to as well.
+    KURL url(ParsedURLString, "file:///x.png");
+    KURL urlWithFragment(ParsedURLString, "file:///x.png#frag");
+
+    EXPECT_NE(ResourceFetcher::preloadKey(url), ResourceFetcher::preloadKey(urlWithFragment));
+}
+
+} // namespace
@@ -10,6 +10,7 @@
 #include "sky/engine/core/events/Event.h"
 #include "sky/engine/core/fetch/FetchRequest.h"
 #include "sky/engine/core/html/imports/HTMLImportChild.h"
+#include "sky/engine/core/html/imports/HTMLImportLoader.h"
 #include "sky/engine/core/html/imports/HTMLImportsController.h"
 
 namespace blink {
@@ -61,6 +62,11 @@ void HTMLImportElement::load()
 
 void HTMLImportElement::didFinish()
 {
+    // A failed import still finishes, so the scripts waiting on it can run.
+    if (m_child && m_child->loader()->hasError()) {
+        dispatchEvent(Event::create(EventTypeNames::error));
+        return;
+    }
     dispatchEvent(Event::create(EventTypeNames::load));
 }
 
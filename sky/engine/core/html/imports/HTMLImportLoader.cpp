@@ -88,6 +88,12 @@ void HTMLImportLoader::OnReceivedResponse(mojo::URLResponsePtr response)
         setState(StateError);
         return;
     }
+    // The preload scanner found this import before any element asked for it.
+    // Parsing waits until one does, since the import's document needs it.
+    if (m_imports.isEmpty()) {
+        m_pendingResponse = response.Pass();
+        return;
+    }
     setState(startWritingAndParsing(response.Pass()));
 }
 
@@ -165,6 +171,8 @@ void HTMLImportLoader::addImport(HTMLImportChild* import)
 
     m_imports.append(import);
     import->normalize();
+    if (!m_pendingResponse.is_null())
+        setState(startWritingAndParsing(m_pendingResponse.Pass()));
     if (isDone())
         import->didFinishLoading();
 }
@@ -109,6 +109,8 @@ private:
     RefPtr<Document> m_document;
 
     OwnPtr<MojoFetcher> m_fetcher;
+    // The response to a preload, kept until the first import is added.
+    mojo::URLResponsePtr m_pendingResponse;
 };
 
 } // namespace blink
@@ -38,6 +38,7 @@
 #include "sky/engine/core/html/imports/HTMLImportChildClient.h"
 #include "sky/engine/core/html/imports/HTMLImportLoader.h"
 #include "sky/engine/core/html/imports/HTMLImportTreeRoot.h"
+#include "sky/engine/public/platform/Platform.h"
 
 namespace blink {
 
@@ -62,11 +63,21 @@ void HTMLImportsController::removeFrom(Document& master)
 
 HTMLImportsController::HTMLImportsController(Document& master)
     : m_root(HTMLImportTreeRoot::create(&master))
+    , m_preloadCount(0)
+    , m_usedPreloadCount(0)
 {
 }
 
 HTMLImportsController::~HTMLImportsController()
 {
+    if (m_preloadCount) {
+        blink::Platform::current()->histogramCustomCounts(
+            "WebCore.HTMLImports.PreloadCount", m_preloadCount, 0, 1000, 50);
+        blink::Platform::current()->histogramCustomCounts(
+            "WebCore.HTMLImports.UsedPreloadCount", m_usedPreloadCount, 0, 1000, 50);
+    }
+    m_preloadedLoaders.clear();
+
 #if !ENABLE(OILPAN)
     m_root.clear();
 
@@ -110,6 +121,15 @@ HTMLImportChild* HTMLImportsController::load(HTMLImport* parent, HTMLImportChild
         return child;
     }
 
+    KURL urlWithoutFragment = request.url();
+    urlWithoutFragment.removeFragmentIdentifier();
+    if (HTMLImportLoader* loader = m_preloadedLoaders.take(urlWithoutFragment.string())) {
+        ++m_usedPreloadCount;
+        HTMLImportChild* child = createChild(request.url(), loader, parent, client);
+        child->didStartLoading();
+        return child;
+    }
+
     HTMLImportLoader* loader = createLoader();
     HTMLImportChild* child = createChild(request.url(), loader, parent, client);
     // We set resource after the import tree is built since
@@ -119,6 +139,19 @@ HTMLImportChild* HTMLImportsController::load(HTMLImport* parent, HTMLImportChild
     return child;
 }
 
+void HTMLImportsController::preload(const KURL& url)
+{
+    KURL urlWithoutFragment = url;
+    urlWithoutFragment.removeFragmentIdentifier();
+    if (root()->find(url) || m_preloadedLoaders.contains(urlWithoutFragment.string()))
+        return;
+
+    HTMLImportLoader* loader = createLoader();
+    loader->startLoading(url);
+    m_preloadedLoaders.add(urlWithoutFragment.string(), loader);
+    ++m_preloadCount;
+}
+
 Document* HTMLImportsController::master() const
 {
     return root()->document();
@@ -37,8 +37,10 @@
 #include "sky/engine/platform/Supplementable.h"
 #include "sky/engine/platform/Timer.h"
 #include "sky/engine/wtf/FastAllocBase.h"
+#include "sky/engine/wtf/HashMap.h"
 #include "sky/engine/wtf/PassOwnPtr.h"
 #include "sky/engine/wtf/Vector.h"
+#include "sky/engine/wtf/text/StringHash.h"
 
 namespace blink {
 
@@ -64,6 +66,9 @@ public:
 
     bool shouldBlockScriptExecution(const Document&) const;
     HTMLImportChild* load(HTMLImport* parent, HTMLImportChildClient*, FetchRequest);
+    // Starts fetching an import the preload scanner found. A later load() of
+    // the same URL picks the fetch up instead of starting another one.
+    void preload(const KURL&);
 
     Document* master() const;
 
@@ -80,6 +85,11 @@ private:
     OwnPtr<HTMLImportTreeRoot> m_root;
     typedef Vector<OwnPtr<HTMLImportLoader> > LoaderList;
     LoaderList m_loaders;
+
+    // Preloaded loaders no import has used yet, by URL without the fragment.
+    HashMap<String, HTMLImportLoader*> m_preloadedLoaders;
+    int m_preloadCount;
+    int m_usedPreloadCount;
 };
 
 } // namespace blink
@@ -65,6 +65,7 @@ BackgroundHTMLParser::BackgroundHTMLParser(PassOwnPtr<Configuration> config)
     , m_tokenizer(HTMLTokenizer::create())
     , m_parser(config->parser)
     , m_pendingTokens(adoptPtr(new CompactHTMLTokenStream))
+    , m_pendingPreloads(adoptPtr(new PreloadRequestStream))
     , m_decoder(TextResourceDecoder::create())
     , m_source(config->source.Pass())
     , m_weakFactory(this)
@@ -161,6 +162,7 @@ void BackgroundHTMLParser::pumpTokenizer()
             if (result ==  SendTokensExceptingLast)
                 sendTokensToMainThread();
 
+            m_preloadScanner.scan(token, *m_pendingPreloads);
             m_pendingTokens->append(token);
         }
 
@@ -182,10 +184,12 @@ void BackgroundHTMLParser::sendTokensToMainThread()
 
     OwnPtr<HTMLDocumentParser::ParsedChunk> chunk = adoptPtr(new HTMLDocumentParser::ParsedChunk);
     chunk->tokens = m_pendingTokens.release();
+    chunk->preloads = m_pendingPreloads.release();
     Platform::current()->mainThreadTaskRunner()->PostTask(FROM_HERE,
         base::Bind(&HTMLDocumentParser::didReceiveParsedChunkFromBackgroundParser, m_parser, chunk.release()));
 
     m_pendingTokens = adoptPtr(new CompactHTMLTokenStream);
+    m_pendingPreloads = adoptPtr(new PreloadRequestStream);
 }
 
 }
@@ -30,6 +30,7 @@
 #include "mojo/common/data_pipe_drainer.h"
 #include "mojo/public/cpp/system/core.h"
 #include "sky/engine/core/html/parser/CompactHTMLToken.h"
+#include "sky/engine/core/html/parser/HTMLPreloadScanner.h"
 #include "sky/engine/core/html/parser/HTMLTokenizer.h"
 #include "sky/engine/core/html/parser/TextResourceDecoder.h"
 #include "sky/engine/platform/text/SegmentedString.h"
@@ -87,6 +88,8 @@ private:
     base::WeakPtr<HTMLDocumentParser> m_parser;
 
     OwnPtr<CompactHTMLTokenStream> m_pendingTokens;
+    TokenPreloadScanner m_preloadScanner;
+    OwnPtr<PreloadRequestStream> m_pendingPreloads;
     OwnPtr<TextResourceDecoder> m_decoder;
 
     mojo::ScopedDataPipeConsumerHandle m_source;
@@ -30,10 +30,14 @@
 #include "gen/sky/core/HTMLNames.h"
 #include "sky/engine/core/css/MediaValuesCached.h"
 #include "sky/engine/core/dom/Element.h"
+#include "sky/engine/core/fetch/FetchRequest.h"
+#include "sky/engine/core/fetch/ResourceFetcher.h"
 #include "sky/engine/core/frame/LocalFrame.h"
 #include "sky/engine/core/html/HTMLScriptElement.h"
+#include "sky/engine/core/html/imports/HTMLImportsController.h"
 #include "sky/engine/core/html/parser/AtomicHTMLToken.h"
 #include "sky/engine/core/html/parser/BackgroundHTMLParser.h"
+#include "sky/engine/core/html/parser/HTMLParserIdioms.h"
 #include "sky/engine/core/html/parser/HTMLParserScheduler.h"
 #include "sky/engine/core/html/parser/HTMLParserThread.h"
 #include "sky/engine/core/html/parser/HTMLTreeBuilder.h"
@@ -174,6 +178,9 @@ void HTMLDocumentParser::didReceiveParsedChunkFromBackgroundParser(PassOwnPtr<Pa
     // Sky should not need nested parsers.
     ASSERT(document()->activeParserCount() == 0);
 
+    if (chunk->preloads)
+        preload(*chunk->preloads);
+
     if (isWaitingForScripts() || !m_pendingChunks.isEmpty() ||
         document()->activeParserCount() > 0) {
         m_pendingChunks.append(chunk);
@@ -247,6 +254,34 @@ void HTMLDocumentParser::processParsedChunkFromBackgroundParser(PassOwnPtr<Parse
         m_treeBuilder->flush();
 }
 
+void HTMLDocumentParser::preload(const PreloadRequestStream& requests)
+{
+    if (requests.isEmpty())
+        return;
+
+    TRACE_EVENT1("blink", "HTMLDocumentParser::preload", "requests", requests.size());
+
+    Document* document = this->document();
+    for (const PreloadRequest& request : requests) {
+        KURL url = document->completeURL(stripLeadingAndTrailingHTMLSpaces(request.url));
+        if (!url.isValid())
+            continue;
+
+        switch (request.type) {
+        case PreloadRequest::Import:
+            // Same as HTMLImportElement::shouldLoad().
+            if (document->frame() || document->importsController())
+                document->ensureImportsController().preload(url);
+            break;
+        case PreloadRequest::Image: {
+            FetchRequest fetchRequest(ResourceRequest(url), HTMLNames::imgTag.localName(), ResourceFetcher::defaultResourceOptions());
+            document->fetcher()->preloadImage(fetchRequest);
+            break;
+        }
+        }
+    }
+}
+
 void HTMLDocumentParser::pumpPendingChunks()
 {
     // FIXME: Share this constant with the parser scheduler.
@@ -32,6 +32,7 @@
 #include "sky/engine/core/fetch/ResourceClient.h"
 #include "sky/engine/core/html/parser/CompactHTMLToken.h"
 #include "sky/engine/core/html/parser/HTMLInputStream.h"
+#include "sky/engine/core/html/parser/HTMLPreloadScanner.h"
 #include "sky/engine/core/html/parser/HTMLScriptRunner.h"
 #include "sky/engine/core/html/parser/HTMLToken.h"
 #include "sky/engine/core/html/parser/HTMLTokenizer.h"
@@ -74,6 +75,9 @@ public:
 
     struct ParsedChunk {
         OwnPtr<CompactHTMLTokenStream> tokens;
+        // Subresources found in |tokens|, fetched as soon as the chunk
+        // arrives even if the chunk itself has to wait.
+        OwnPtr<PreloadRequestStream> preloads;
     };
     void didReceiveParsedChunkFromBackgroundParser(PassOwnPtr<ParsedChunk>);
 
@@ -97,6 +101,7 @@ private:
 
     void stopBackgroundParser();
     void processParsedChunkFromBackgroundParser(PassOwnPtr<ParsedChunk>);
+    void preload(const PreloadRequestStream&);
     void pumpPendingChunks();
 
     Document* contextForParsingSession();
@@ -5,13 +5,35 @@
 #include "sky/engine/config.h"
 #include "sky/engine/core/html/parser/HTMLParserThread.h"
 
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/message_loop/message_loop.h"
 #include "base/threading/thread.h"
 #include "sky/engine/wtf/Assertions.h"
+#include "sky/engine/wtf/PartitionAlloc.h"
 
 namespace blink {
 
+namespace {
+
+// The parser thread sits idle between documents, so it gives its allocator
+// caches back after each task rather than holding on to them.
+class TaskObserver : public base::MessageLoop::TaskObserver {
+public:
+    void WillProcessTask(const base::PendingTask& pending_task) override { }
+    void DidProcessTask(const base::PendingTask& pending_task) override { partitionAllocFlushThreadCaches(); }
+};
+
+void addTaskObserver(TaskObserver* observer)
+{
+    base::MessageLoop::current()->AddTaskObserver(observer);
+}
+
+} // namespace
+
 static base::Thread* s_thread = 0;
 static base::SingleThreadTaskRunner* s_taskRunner = 0;
+static TaskObserver* s_taskObserver = 0;
 
 void HTMLParserThread::start()
 {
@@ -19,6 +41,10 @@ void HTMLParserThread::start()
     s_thread = new base::Thread("HTMLParserThread");
     s_thread->Start();
     s_thread->task_runner().swap(&s_taskRunner);
+
+    ASSERT(!s_taskObserver);
+    s_taskObserver = new TaskObserver;
+    s_taskRunner->PostTask(FROM_HERE, base::Bind(&addTaskObserver, base::Unretained(s_taskObserver)));
 }
 
 void HTMLParserThread::stop()
@@ -32,6 +58,10 @@ void HTMLParserThread::stop()
 
     delete thread;
     taskRunner = nullptr;
+
+    // The thread's message loop is gone, so nothing refers to the observer.
+    delete s_taskObserver;
+    s_taskObserver = 0;
 }
 
 base::SingleThreadTaskRunner* HTMLParserThread::taskRunner()
@@ -0,0 +1,54 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/core/html/parser/HTMLPreloadScanner.h"
+
+#include "gen/sky/core/HTMLNames.h"
+#include "sky/engine/core/html/parser/HTMLParserIdioms.h"
+
+namespace blink {
+
+TokenPreloadScanner::TokenPreloadScanner()
+    : m_templateDepth(0)
+{
+}
+
+void TokenPreloadScanner::scan(const CompactHTMLToken& token, PreloadRequestStream& requests)
+{
+    if (token.type() == HTMLToken::EndTag) {
+        if (m_templateDepth && threadSafeMatch(token.data(), HTMLNames::templateTag))
+            --m_templateDepth;
+        return;
+    }
+
+    if (token.type() != HTMLToken::StartTag)
+        return;
+
+    const String& tagName = token.data();
+    if (threadSafeMatch(tagName, HTMLNames::templateTag)) {
+        if (!token.selfClosing())
+            ++m_templateDepth;
+        return;
+    }
+
+    if (m_templateDepth)
+        return;
+
+    PreloadRequest::Type type;
+    if (threadSafeMatch(tagName, HTMLNames::importTag))
+        type = PreloadRequest::Import;
+    else if (threadSafeMatch(tagName, HTMLNames::imgTag))
+        type = PreloadRequest::Image;
+    else
+        return;
+
+    const CompactHTMLToken::Attribute* src = token.getAttributeItem(HTMLNames::srcAttr);
+    if (!src || src->value.isEmpty())
+        return;
+    // The token keeps its own reference to the value.
+    requests.append(PreloadRequest(type, src->value.isolatedCopy()));
+}
+
+}
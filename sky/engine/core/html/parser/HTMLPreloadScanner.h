@@ -0,0 +1,53 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_ENGINE_CORE_HTML_PARSER_HTMLPRELOADSCANNER_H_
+#define SKY_ENGINE_CORE_HTML_PARSER_HTMLPRELOADSCANNER_H_
+
+#include "sky/engine/core/html/parser/CompactHTMLToken.h"
+#include "sky/engine/wtf/Noncopyable.h"
+#include "sky/engine/wtf/Vector.h"
+#include "sky/engine/wtf/text/WTFString.h"
+
+namespace blink {
+
+struct PreloadRequest {
+    enum Type {
+        Import,
+        Image,
+    };
+
+    PreloadRequest(Type type, const String& url)
+        : type(type)
+        , url(url)
+    {
+    }
+
+    Type type;
+    // The attribute value as written. It's resolved against the document's
+    // base URL on the main thread.
+    String url;
+};
+
+typedef Vector<PreloadRequest> PreloadRequestStream;
+
+// Finds the imports and images a document will load in the tokens the
+// background parser produces, so they can be fetched before the tree builder
+// reaches them. Scripts are always inline in Sky, so there's nothing to find
+// for them.
+class TokenPreloadScanner {
+    WTF_MAKE_NONCOPYABLE(TokenPreloadScanner);
+public:
+    TokenPreloadScanner();
+
+    void scan(const CompactHTMLToken&, PreloadRequestStream&);
+
+private:
+    // Nothing inside a <template> loads until the template is used.
+    unsigned m_templateDepth;
+};
+
+}
+
+#endif  // SKY_ENGINE_CORE_HTML_PARSER_HTMLPRELOADSCANNER_H_
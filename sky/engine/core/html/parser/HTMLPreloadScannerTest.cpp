@@ -0,0 +1,102 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/core/html/parser/HTMLPreloadScanner.h"
+
+#include <gtest/gtest.h>
+#include "sky/engine/core/html/parser/HTMLTokenizer.h"
+#include "sky/engine/core/html/parser/InputStreamPreprocessor.h"
+#include "sky/engine/platform/text/SegmentedString.h"
+
+using namespace blink;
+
+namespace {
+
+// Tokenizes |source| the way the background parser does and returns what the
+// scanner finds in it.
+PreloadRequestStream scan(const String& source)
+{
+    OwnPtr<HTMLTokenizer> tokenizer = HTMLTokenizer::create();
+    OwnPtr<HTMLToken> token = adoptPtr(new HTMLToken);
+    SegmentedString input(source);
+    input.append(SegmentedString(String(&kEndOfFileMarker, 1)));
+    input.close();
+
+    TokenPreloadScanner scanner;
+    PreloadRequestStream requests;
+    while (tokenizer->nextToken(input, *token)) {
+        CompactHTMLToken compactToken(token.get(), TextPosition(input.currentLine(), input.currentColumn()));
+        scanner.scan(compactToken, requests);
+        token->clear();
+    }
+    return requests;
+}
+
+void expectRequest(PreloadRequest::Type type, const char* url, const PreloadRequest& request)
+{
+    EXPECT_EQ(type, request.type);
+    EXPECT_EQ(String(url), request.url);
+}
+
+TEST(TokenPreloadScannerTest, FindsImportsAndImages)
+{
+    PreloadRequestStream requests = scan(
+        "<import src=\"a.sky\" />"
+        "<div><img src=\"b.png\"></div>"
+        "<import src='c.sky' as=\"c\">"
+        "<script src=\"d.js\"></script>"
+        "<iframe src=\"e.sky\"></iframe>"
+        "<img src=f.png>");
+    ASSERT_EQ(4u, requests.size());
+    expectRequest(PreloadRequest::Import, "a.sky", requests[0]);
+    expectRequest(PreloadRequest::Image, "b.png", requests[1]);
+    expectRequest(PreloadRequest::Import, "c.sky", requests[2]);
+    expectRequest(PreloadRequest::Image, "f.png", requests[3]);
+}
+
+TEST(TokenPreloadScannerTest, SkipsTemplateContents)
+{
+    PreloadRequestStream requests = scan(
+        "<template>"
+        "<import src=\"a.sky\" />"
+        "<template><img src=\"b.png\"></template>"
+        "<img src=\"c.png\">"
+        "</template>"
+        "<img src=\"d.png\">"
+        // A self-closing template has no contents to skip.
+        "<template />"
+        "<import src=\"e.sky\" />"
+        // Neither does an end tag without a start tag.
+        "</template>"
+        "<img src=\"f.png\">");
+    ASSERT_EQ(3u, requests.size());
+    expectRequest(PreloadRequest::Image, "d.png", requests[0]);
+    expectRequest(PreloadRequest::Import, "e.sky", requests[1]);
+    expectRequest(PreloadRequest::Image, "f.png", requests[2]);
+}
+
+TEST(TokenPreloadScannerTest, SkipsEmptyAndMissingSrc)
+{
+    PreloadRequestStream requests = scan(
+        "<import />"
+        "<import src=\"\" />"
+        "<img>"
+        "<img src>"
+        "<img href=\"a.png\">"
+        "<img src=\"b.png\">");
+    ASSERT_EQ(1u, requests.size());
+    expectRequest(PreloadRequest::Image, "b.png", requests[0]);
+}
+
+TEST(TokenPreloadScannerTest, KeepsFragmentIdentifiers)
+{
+    // ResourceFetcher::preloadKey() drops the fragment, so that the preload
+    // and the element's own request meet.
+    PreloadRequestStream requests = scan("<img src=\"x.png#frag\">");
+    ASSERT_EQ(1u, requests.size());
+    expectRequest(PreloadRequest::Image, "x.png#frag", requests[0]);
+}
+
+} // namespace
@@ -1519,6 +1519,9 @@ RootInlineBox* RenderParagraph::determineStartPosition(LineLayoutState& layoutSt
         }
         ASSERT(!firstLineBox() && !lastLineBox());
     } else {
+        // Lines before the first dirty one are kept as they are.
+        for (curr = firstRootBox(); curr && !curr->isDirty(); curr = curr->nextRootBox()) { }
+
         if (curr) {
             // We have a dirty line.
             if (RootInlineBox* prevRootBox = curr->prevRootBox()) {
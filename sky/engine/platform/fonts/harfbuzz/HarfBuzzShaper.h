@@ -47,6 +47,7 @@ namespace blink {
 
 class Font;
 class GlyphBuffer;
+class ShapeCacheEntry;
 class SimpleFontData;
 
 class HarfBuzzShaper final {
@@ -76,7 +77,7 @@ private:
             return adoptPtr(new HarfBuzzRun(fontData, startIndex, numCharacters, direction, script));
         }
 
-        void applyShapeResult(hb_buffer_t*);
+        void applyShapeResult(const ShapeCacheEntry&);
         void setGlyphAndPositions(unsigned index, uint16_t glyphId, float advance, float offsetX, float offsetY);
         void setWidth(float width) { m_width = width; }
 
@@ -131,7 +132,7 @@ private:
     bool fillGlyphBuffer(GlyphBuffer*);
     void fillGlyphBufferFromHarfBuzzRun(GlyphBuffer*, HarfBuzzRun*, float& carryAdvance);
     void fillGlyphBufferForTextEmphasis(GlyphBuffer*, HarfBuzzRun* currentRun);
-    void setGlyphPositionsForHarfBuzzRun(HarfBuzzRun*, hb_buffer_t*);
+    void setGlyphPositionsForHarfBuzzRun(HarfBuzzRun*, const ShapeCacheEntry&);
     void addHarfBuzzRun(unsigned startCharacter, unsigned endCharacter, const SimpleFontData*, UScriptCode);
 
     const Font* m_font;
@@ -156,8 +157,6 @@ private:
     float m_totalWidth;
     FloatBoxExtent m_glyphBoundingBox;
     HashSet<const SimpleFontData*>* m_fallbackFonts;
-
-    friend struct CachedShapingResults;
 };
 
 } // namespace blink
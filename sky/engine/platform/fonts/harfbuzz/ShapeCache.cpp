@@ -0,0 +1,184 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/platform/fonts/harfbuzz/ShapeCache.h"
+
+#include <limits>
+#include "sky/engine/platform/geometry/FloatPoint.h"
+#include "sky/engine/platform/geometry/FloatRect.h"
+#include "sky/engine/wtf/CPU.h"
+#include "sky/engine/wtf/StdLibExtras.h"
+#include "sky/engine/wtf/StringHasher.h"
+
+#if CPU(X86_64)
+#include <xmmintrin.h>
+#elif HAVE(ARM_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
+namespace blink {
+
+static inline float harfBuzzPositionToFloat(hb_position_t value)
+{
+    return static_cast<float>(value) / (1 << 16);
+}
+
+float sumAdvances(const float* advances, unsigned count)
+{
+    unsigned i = 0;
+    float sum = 0;
+#if CPU(X86_64)
+    __m128 sums = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+        sums = _mm_add_ps(sums, _mm_loadu_ps(advances + i));
+    float lanes[4];
+    _mm_storeu_ps(lanes, sums);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif HAVE(ARM_NEON_INTRINSICS)
+    float32x4_t sums = vdupq_n_f32(0);
+    for (; i + 4 <= count; i += 4)
+        sums = vaddq_f32(sums, vld1q_f32(advances + i));
+    float32x2_t pairs = vadd_f32(vget_low_f32(sums), vget_high_f32(sums));
+    sum = vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+#endif
+    for (; i < count; ++i)
+        sum += advances[i];
+    return sum;
+}
+
+ShapeCacheEntry::ShapeCacheEntry(const String& text, const SimpleFontData* fontData, hb_direction_t direction, hb_script_t script, const String& locale, bool smallCaps, const Vector<hb_feature_t, 4>& features, hb_buffer_t* harfBuzzBuffer)
+    : m_prev(0)
+    , m_next(0)
+    , m_text(text)
+    , m_fontData(const_cast<SimpleFontData*>(fontData))
+    , m_direction(direction)
+    , m_script(script)
+    , m_locale(locale)
+    , m_smallCaps(smallCaps)
+    , m_features(features)
+    , m_glyphBoundingBox(std::numeric_limits<float>::max(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::max())
+{
+    unsigned numGlyphs = hb_buffer_get_length(harfBuzzBuffer);
+    hb_glyph_info_t* glyphInfos = hb_buffer_get_glyph_infos(harfBuzzBuffer, 0);
+    hb_glyph_position_t* glyphPositions = hb_buffer_get_glyph_positions(harfBuzzBuffer, 0);
+
+    m_glyphs.reserveInitialCapacity(numGlyphs);
+    m_clusters.reserveInitialCapacity(numGlyphs);
+    m_advances.reserveInitialCapacity(numGlyphs);
+    m_offsets.reserveInitialCapacity(numGlyphs);
+
+    FloatPoint glyphOrigin;
+    for (unsigned i = 0; i < numGlyphs; ++i) {
+        uint16_t glyph = glyphInfos[i].codepoint;
+        m_glyphs.uncheckedAppend(glyph);
+        m_clusters.uncheckedAppend(glyphInfos[i].cluster);
+
+        if (fontData->isZeroWidthSpaceGlyph(glyph)) {
+            m_advances.uncheckedAppend(0);
+            m_offsets.uncheckedAppend(FloatSize());
+            continue;
+        }
+
+        float advance = harfBuzzPositionToFloat(glyphPositions[i].x_advance);
+        FloatSize offset(harfBuzzPositionToFloat(glyphPositions[i].x_offset), -harfBuzzPositionToFloat(glyphPositions[i].y_offset));
+        m_advances.uncheckedAppend(advance);
+        m_offsets.uncheckedAppend(offset);
+
+        FloatRect glyphBounds = fontData->boundsForGlyph(glyph);
+        glyphBounds.move(glyphOrigin.x(), glyphOrigin.y());
+        m_glyphBoundingBox.unite(glyphBounds);
+        glyphOrigin += FloatSize(advance + offset.width(), offset.height());
+    }
+}
+
+bool ShapeCacheEntry::matches(const SimpleFontData* fontData, hb_direction_t direction, hb_script_t script, const String& locale, bool smallCaps, const Vector<hb_feature_t, 4>& features) const
+{
+    if (m_fontData.get() != fontData || m_direction != direction || m_script != script || m_smallCaps != smallCaps || m_locale != locale)
+        return false;
+    if (m_features.size() != features.size())
+        return false;
+    for (size_t i = 0; i < features.size(); ++i) {
+        if (m_features[i].tag != features[i].tag || m_features[i].value != features[i].value
+            || m_features[i].start != features[i].start || m_features[i].end != features[i].end)
+            return false;
+    }
+    return true;
+}
+
+struct ShapeCacheTextTranslator {
+    struct Text {
+        const UChar* characters;
+        unsigned length;
+    };
+
+    static unsigned hash(const Text& text)
+    {
+        return StringHasher::computeHashAndMaskTop8Bits(text.characters, text.length);
+    }
+
+    static bool equal(const String& key, const Text& text)
+    {
+        return WTF::equal(key.impl(), text.characters, text.length);
+    }
+};
+
+ShapeCache& ShapeCache::shared()
+{
+    DEFINE_STATIC_LOCAL(ShapeCache, globalShapeCache, ());
+    return globalShapeCache;
+}
+
+ShapeCacheEntry* ShapeCache::find(const UChar* characters, unsigned length, const SimpleFontData* fontData, hb_direction_t direction, hb_script_t script, const String& locale, bool smallCaps, const Vector<hb_feature_t, 4>& features)
+{
+    ShapeCacheTextTranslator::Text text = { characters, length };
+    EntryMap::iterator it = m_entries.find<ShapeCacheTextTranslator>(text);
+    if (it == m_entries.end())
+        return 0;
+    for (ShapeCacheEntry* entry : *it->value) {
+        if (entry->matches(fontData, direction, script, locale, smallCaps, features)) {
+            m_lruList.remove(entry);
+            m_lruList.append(entry);
+            return entry;
+        }
+    }
+    return 0;
+}
+
+const ShapeCacheEntry& ShapeCache::add(PassOwnPtr<ShapeCacheEntry> passEntry)
+{
+    ShapeCacheEntry* entry = passEntry.leakPtr();
+    EntryMap::AddResult result = m_entries.add(entry->text(), nullptr);
+    if (result.isNewEntry)
+        result.storedValue->value = adoptPtr(new EntryList);
+    result.storedValue->value->append(entry);
+    m_lruList.append(entry);
+    m_byteCost += entry->byteCost();
+
+    while (m_byteCost > maximumByteCost && m_lruList.head() != entry)
+        remove(m_lruList.head());
+    return *entry;
+}
+
+void ShapeCache::clear()
+{
+    while (!m_lruList.isEmpty())
+        remove(m_lruList.head());
+}
+
+void ShapeCache::remove(ShapeCacheEntry* entry)
+{
+    m_lruList.remove(entry);
+    m_byteCost -= entry->byteCost();
+
+    EntryMap::iterator it = m_entries.find(entry->text());
+    ASSERT(it != m_entries.end());
+    EntryList& entries = *it->value;
+    entries.remove(entries.find(entry));
+    if (entries.isEmpty())
+        m_entries.remove(it);
+    delete entry;
+}
+
+} // namespace blink
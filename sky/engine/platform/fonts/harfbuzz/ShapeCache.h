@@ -0,0 +1,114 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_ENGINE_PLATFORM_FONTS_HARFBUZZ_SHAPECACHE_H_
+#define SKY_ENGINE_PLATFORM_FONTS_HARFBUZZ_SHAPECACHE_H_
+
+#include "hb.h"
+#include "sky/engine/platform/PlatformExport.h"
+#include "sky/engine/platform/fonts/SimpleFontData.h"
+#include "sky/engine/platform/geometry/FloatBoxExtent.h"
+#include "sky/engine/platform/geometry/FloatSize.h"
+#include "sky/engine/wtf/DoublyLinkedList.h"
+#include "sky/engine/wtf/HashMap.h"
+#include "sky/engine/wtf/OwnPtr.h"
+#include "sky/engine/wtf/PassOwnPtr.h"
+#include "sky/engine/wtf/RefPtr.h"
+#include "sky/engine/wtf/Vector.h"
+#include "sky/engine/wtf/text/StringHash.h"
+#include "sky/engine/wtf/text/WTFString.h"
+
+namespace blink {
+
+// Adds up glyph advances four at a time where the CPU allows it.
+PLATFORM_EXPORT float sumAdvances(const float* advances, unsigned count);
+
+// The glyphs HarfBuzz produced for one run of text, with the positions they
+// have when no letter or word spacing is added. Zero width space glyphs have
+// no advance and add nothing to the bounding box.
+class PLATFORM_EXPORT ShapeCacheEntry : public DoublyLinkedListNode<ShapeCacheEntry> {
+    WTF_MAKE_NONCOPYABLE(ShapeCacheEntry);
+    WTF_MAKE_FAST_ALLOCATED;
+    friend class WTF::DoublyLinkedListNode<ShapeCacheEntry>;
+public:
+    ShapeCacheEntry(const String& text, const SimpleFontData*, hb_direction_t, hb_script_t, const String& locale, bool smallCaps, const Vector<hb_feature_t, 4>& features, hb_buffer_t* harfBuzzBuffer);
+
+    bool matches(const SimpleFontData*, hb_direction_t, hb_script_t, const String& locale, bool smallCaps, const Vector<hb_feature_t, 4>& features) const;
+
+    const String& text() const { return m_text; }
+    unsigned numGlyphs() const { return m_glyphs.size(); }
+    const uint16_t* glyphs() const { return m_glyphs.data(); }
+    const uint16_t* clusters() const { return m_clusters.data(); }
+    const float* advances() const { return m_advances.data(); }
+    const FloatSize* offsets() const { return m_offsets.data(); }
+    const FloatBoxExtent& glyphBoundingBox() const { return m_glyphBoundingBox; }
+
+    size_t byteCost() const
+    {
+        return sizeof(ShapeCacheEntry) + m_text.length() * sizeof(UChar)
+            + numGlyphs() * (sizeof(uint16_t) * 2 + sizeof(float) + sizeof(FloatSize));
+    }
+
+private:
+    ShapeCacheEntry* m_prev;
+    ShapeCacheEntry* m_next;
+
+    String m_text;
+    // Keeps the font alive, so another font can't take its address while
+    // this entry is cached.
+    RefPtr<SimpleFontData> m_fontData;
+    hb_direction_t m_direction;
+    hb_script_t m_script;
+    String m_locale;
+    bool m_smallCaps;
+    Vector<hb_feature_t, 4> m_features;
+
+    Vector<uint16_t> m_glyphs;
+    Vector<uint16_t> m_clusters;
+    Vector<float> m_advances;
+    Vector<FloatSize> m_offsets;
+    FloatBoxExtent m_glyphBoundingBox;
+};
+
+// Shaping results shared by every font and every shaper, so the same word
+// is only shaped once across text boxes and layouts. Entries are looked up
+// by their text and then by everything else HarfBuzz shapes with, and the
+// least recently used ones are evicted once the cache outgrows its budget.
+class PLATFORM_EXPORT ShapeCache {
+    WTF_MAKE_NONCOPYABLE(ShapeCache);
+public:
+    // Enough for several screens of text in a few fonts.
+    static const size_t maximumByteCost = 2 * 1024 * 1024;
+
+    ShapeCache() : m_byteCost(0) { }
+    ~ShapeCache() { clear(); }
+
+    static ShapeCache& shared();
+
+    ShapeCacheEntry* find(const UChar* characters, unsigned length, const SimpleFontData*, hb_direction_t, hb_script_t, const String& locale, bool smallCaps, const Vector<hb_feature_t, 4>& features);
+
+    // Evicts least recently used entries until the cache is back within its
+    // budget, but never |entry| itself.
+    const ShapeCacheEntry& add(PassOwnPtr<ShapeCacheEntry>);
+
+    void clear();
+
+    // The number of entries. This is O(n).
+    size_t size() const { return m_lruList.size(); }
+    size_t byteCost() const { return m_byteCost; }
+
+private:
+    typedef Vector<ShapeCacheEntry*, 1> EntryList;
+    typedef HashMap<String, OwnPtr<EntryList> > EntryMap;
+
+    void remove(ShapeCacheEntry*);
+
+    EntryMap m_entries;
+    DoublyLinkedList<ShapeCacheEntry> m_lruList;
+    size_t m_byteCost;
+};
+
+} // namespace blink
+
+#endif // SKY_ENGINE_PLATFORM_FONTS_HARFBUZZ_SHAPECACHE_H_
@@ -0,0 +1,216 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/platform/fonts/harfbuzz/ShapeCache.h"
+
+#include <gtest/gtest.h>
+#include "sky/engine/wtf/StdLibExtras.h"
+
+using namespace blink;
+
+namespace {
+
+typedef Vector<hb_feature_t, 4> FeatureList;
+
+// A |length| character string that differs from those of other |index|es.
+String makeText(unsigned index, unsigned length)
+{
+    Vector<UChar> characters(length);
+    characters.fill('a');
+    characters[0] = 'A' + index % 26;
+    if (length > 1)
+        characters[1] = 'A' + index / 26;
+    return String(characters.data(), characters.size());
+}
+
+hb_feature_t makeFeature(hb_tag_t tag, uint32_t value)
+{
+    hb_feature_t feature = { tag, value, 0, static_cast<unsigned>(-1) };
+    return feature;
+}
+
+class ShapeCacheTest : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        m_font = SimpleFontData::create(nullptr, 10, false, false);
+        m_otherFont = SimpleFontData::create(nullptr, 10, false, false);
+        // Entries built from an empty buffer have no glyphs, so they don't
+        // need a real font and their cost only depends on their text.
+        m_buffer = hb_buffer_create();
+    }
+
+    virtual void TearDown()
+    {
+        hb_buffer_destroy(m_buffer);
+    }
+
+    const ShapeCacheEntry& add(const String& text, const SimpleFontData* font, hb_direction_t direction, hb_script_t script, const String& locale, bool smallCaps, const FeatureList& features)
+    {
+        return m_cache.add(adoptPtr(new ShapeCacheEntry(text, font, direction, script, locale, smallCaps, features, m_buffer)));
+    }
+
+    const ShapeCacheEntry& add(const String& text)
+    {
+        return add(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, FeatureList());
+    }
+
+    ShapeCacheEntry* find(const String& text, const SimpleFontData* font, hb_direction_t direction, hb_script_t script, const String& locale, bool smallCaps, const FeatureList& features)
+    {
+        return m_cache.find(text.characters16(), text.length(), font, direction, script, locale, smallCaps, features);
+    }
+
+    ShapeCacheEntry* find(const String& text)
+    {
+        return find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, FeatureList());
+    }
+
+    static size_t costOfText(unsigned length)
+    {
+        return sizeof(ShapeCacheEntry) + length * sizeof(UChar);
+    }
+
+    RefPtr<SimpleFontData> m_font;
+    RefPtr<SimpleFontData> m_otherFont;
+    hb_buffer_t* m_buffer;
+    ShapeCache m_cache;
+};
+
+TEST_F(ShapeCacheTest, KeysCoverEverythingShapedWith)
+{
+    const String text = makeText(0, 5);
+    FeatureList kerning;
+    kerning.append(makeFeature(HB_TAG('k', 'e', 'r', 'n'), 1));
+    FeatureList noKerning;
+    noKerning.append(makeFeature(HB_TAG('k', 'e', 'r', 'n'), 0));
+    FeatureList ligatures;
+    ligatures.append(makeFeature(HB_TAG('l', 'i', 'g', 'a'), 1));
+    FeatureList kerningAndLigatures = kerning;
+    kerningAndLigatures.append(ligatures[0]);
+    FeatureList partialKerning = kerning;
+    partialKerning[0].end = 2;
+
+    const ShapeCacheEntry* plain = &add(text);
+    const ShapeCacheEntry* otherFont = &add(text, m_otherFont.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, FeatureList());
+    const ShapeCacheEntry* rtl = &add(text, m_font.get(), HB_DIRECTION_RTL, HB_SCRIPT_LATIN, "en", false, FeatureList());
+    const ShapeCacheEntry* greek = &add(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_GREEK, "en", false, FeatureList());
+    const ShapeCacheEntry* turkish = &add(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "tr", false, FeatureList());
+    const ShapeCacheEntry* smallCaps = &add(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", true, FeatureList());
+    const ShapeCacheEntry* kerned = &add(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, kerning);
+    EXPECT_EQ(7u, m_cache.size());
+
+    // Each entry is only found with exactly what it was added with.
+    EXPECT_EQ(plain, find(text));
+    EXPECT_EQ(otherFont, find(text, m_otherFont.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, FeatureList()));
+    EXPECT_EQ(rtl, find(text, m_font.get(), HB_DIRECTION_RTL, HB_SCRIPT_LATIN, "en", false, FeatureList()));
+    EXPECT_EQ(greek, find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_GREEK, "en", false, FeatureList()));
+    EXPECT_EQ(turkish, find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "tr", false, FeatureList()));
+    EXPECT_EQ(smallCaps, find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", true, FeatureList()));
+    EXPECT_EQ(kerned, find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, kerning));
+
+    // Features differing in value, tag, count or range don't match.
+    EXPECT_FALSE(find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, noKerning));
+    EXPECT_FALSE(find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, ligatures));
+    EXPECT_FALSE(find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, kerningAndLigatures));
+    EXPECT_FALSE(find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, partialKerning));
+
+    EXPECT_FALSE(find(text, m_font.get(), HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "", false, FeatureList()));
+    EXPECT_FALSE(find(makeText(1, 5)));
+    EXPECT_FALSE(find(text.substring(0, 4)));
+}
+
+TEST_F(ShapeCacheTest, EntriesKeepTheirFontAlive)
+{
+    const String text = makeText(0, 5);
+    SimpleFontData* font = m_otherFont.get();
+    add(text, font, HB_DIRECTION_LTR, HB_SCRIPT_LATIN, "en", false, FeatureList());
+    EXPECT_FALSE(font->hasOneRef());
+    m_cache.clear();
+    EXPECT_TRUE(font->hasOneRef());
+    EXPECT_EQ(0u, m_cache.size());
+    EXPECT_EQ(0u, m_cache.byteCost());
+}
+
+TEST_F(ShapeCacheTest, EvictsLeastRecentlyUsedWithinBudget)
+{
+    const unsigned length = 16 * 1024;
+    const size_t cost = costOfText(length);
+    const unsigned capacity = ShapeCache::maximumByteCost / cost;
+    ASSERT_LT(2u, capacity);
+
+    for (unsigned i = 0; i < capacity; ++i) {
+        EXPECT_EQ(cost, add(makeText(i, length)).byteCost());
+        EXPECT_EQ(cost * (i + 1), m_cache.byteCost());
+    }
+    EXPECT_EQ(capacity, m_cache.size());
+
+    // Finding the oldest entry makes it the most recently used, so the next
+    // one is evicted in its place.
+    EXPECT_TRUE(find(makeText(0, length)));
+    add(makeText(capacity, length));
+    EXPECT_EQ(capacity, m_cache.size());
+    EXPECT_LE(m_cache.byteCost(), ShapeCache::maximumByteCost);
+    EXPECT_TRUE(find(makeText(0, length)));
+    EXPECT_FALSE(find(makeText(1, length)));
+    EXPECT_TRUE(find(makeText(2, length)));
+    EXPECT_TRUE(find(makeText(capacity, length)));
+
+    // A large entry evicts as many as it takes.
+    add(makeText(capacity + 1, length * 3));
+    EXPECT_EQ(capacity - 2, m_cache.size());
+    EXPECT_LE(m_cache.byteCost(), ShapeCache::maximumByteCost);
+    EXPECT_FALSE(find(makeText(3, length)));
+    EXPECT_FALSE(find(makeText(4, length)));
+    EXPECT_FALSE(find(makeText(5, length)));
+    EXPECT_TRUE(find(makeText(6, length)));
+
+    // An entry over the whole budget is still returned, but evicts
+    // everything else.
+    const unsigned hugeLength = ShapeCache::maximumByteCost / sizeof(UChar);
+    const ShapeCacheEntry& huge = add(makeText(capacity + 2, hugeLength));
+    EXPECT_EQ(hugeLength, huge.text().length());
+    EXPECT_EQ(1u, m_cache.size());
+    EXPECT_EQ(costOfText(hugeLength), m_cache.byteCost());
+
+    // And is evicted by the next one.
+    add(makeText(0, length));
+    EXPECT_EQ(1u, m_cache.size());
+    EXPECT_EQ(cost, m_cache.byteCost());
+}
+
+float sumAdvancesSlowly(const float* advances, unsigned count)
+{
+    float sum = 0;
+    for (unsigned i = 0; i < count; ++i)
+        sum += advances[i];
+    return sum;
+}
+
+TEST(ShapeCacheSumAdvancesTest, MatchesScalarSum)
+{
+    // Lengths on both sides of the vector width, with and without a tail,
+    // starting both aligned and not.
+    float advances[19];
+    for (unsigned i = 0; i < WTF_ARRAY_LENGTH(advances); ++i)
+        advances[i] = 3 + i % 5;
+
+    for (unsigned offset = 0; offset < 2; ++offset) {
+        for (unsigned count = 0; count <= 17; ++count) {
+            SCOPED_TRACE(count);
+            // Whole numbers add up exactly in any order.
+            EXPECT_EQ(sumAdvancesSlowly(advances + offset, count), sumAdvances(advances + offset, count));
+        }
+    }
+
+    float fractionalAdvances[17];
+    for (unsigned i = 0; i < WTF_ARRAY_LENGTH(fractionalAdvances); ++i)
+        fractionalAdvances[i] = 7.3f + i * 0.17f;
+    for (unsigned count = 0; count <= 17; ++count) {
+        SCOPED_TRACE(count);
+        EXPECT_FLOAT_EQ(sumAdvancesSlowly(fractionalAdvances, count), sumAdvances(fractionalAdvances, count));
+    }
+}
+
+} // namespace
@@ -26,7 +26,9 @@
 #include "sky/engine/config.h"
 #include "sky/engine/platform/graphics/DeferredImageDecoder.h"
 
+#include "gen/sky/platform/RuntimeEnabledFeatures.h"
 #include "sky/engine/platform/graphics/DecodingImageGenerator.h"
+#include "sky/engine/platform/graphics/ImageDecodeWorkerPool.h"
 #include "sky/engine/platform/graphics/ImageDecodingStore.h"
 #include "sky/engine/wtf/PassOwnPtr.h"
 #include "third_party/skia/include/core/SkImageInfo.h"
@@ -55,6 +57,9 @@ DeferredImageDecoder::DeferredImageDecoder(PassOwnPtr<ImageDecoder> actualDecode
 
 DeferredImageDecoder::~DeferredImageDecoder()
 {
+    // Don't decode an image that can't be painted anymore.
+    if (m_frameGenerator && RuntimeEnabledFeatures::imageDecodeAheadEnabled())
+        ImageDecodeWorkerPool::instance()->cancelDecode(m_frameGenerator.get());
 }
 
 PassOwnPtr<DeferredImageDecoder> DeferredImageDecoder::create(const SharedBuffer& data, ImageSource::AlphaOption alphaOption, ImageSource::GammaAndColorProfileOption gammaAndColorOption)
@@ -106,10 +111,12 @@ ImageFrame* DeferredImageDecoder::frameBufferAtIndex(size_t index)
 
 void DeferredImageDecoder::setData(SharedBuffer& data, bool allDataReceived)
 {
+    bool dataChanged = false;
     if (m_actualDecoder) {
         const bool firstData = !m_data;
         const bool moreData = data.size() > m_lastDataSize;
-        m_dataChanged = firstData || moreData;
+        dataChanged = firstData || moreData;
+        m_dataChanged = dataChanged;
         m_data = RefPtr<SharedBuffer>(data);
         m_lastDataSize = data.size();
         m_allDataReceived = allDataReceived;
@@ -117,8 +124,12 @@ void DeferredImageDecoder::setData(SharedBuffer& data, bool allDataReceived)
         prepareLazyDecodedFrames();
     }
 
-    if (m_frameGenerator)
+    if (m_frameGenerator) {
         m_frameGenerator->setData(&data, allDataReceived);
+        // Animated images are decoded a frame at a time as they play.
+        if (dataChanged && !m_frameGenerator->isMultiFrame() && RuntimeEnabledFeatures::imageDecodeAheadEnabled())
+            ImageDecodeWorkerPool::instance()->scheduleDecode(m_frameGenerator);
+    }
 }
 
 bool DeferredImageDecoder::isSizeAvailable()
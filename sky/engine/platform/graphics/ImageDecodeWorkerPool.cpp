@@ -0,0 +1,105 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/platform/graphics/ImageDecodeWorkerPool.h"
+
+#include <algorithm>
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
+#include "base/sys_info.h"
+#include "base/threading/thread.h"
+#include "sky/engine/platform/TraceEvent.h"
+#include "sky/engine/platform/graphics/ImageFrameGenerator.h"
+#include "sky/engine/wtf/PartitionAlloc.h"
+#include "sky/engine/wtf/Threading.h"
+
+namespace blink {
+
+// Decoding is mostly memory bound, and raster and the main thread need the
+// remaining cores.
+static const int maximumThreadCount = 2;
+
+ImageDecodeWorkerPool* ImageDecodeWorkerPool::instance()
+{
+    AtomicallyInitializedStatic(ImageDecodeWorkerPool*, pool = new ImageDecodeWorkerPool(nullptr));
+    return pool;
+}
+
+PassOwnPtr<ImageDecodeWorkerPool> ImageDecodeWorkerPool::createForTesting(scoped_refptr<base::SingleThreadTaskRunner> taskRunner)
+{
+    return adoptPtr(new ImageDecodeWorkerPool(taskRunner));
+}
+
+ImageDecodeWorkerPool::ImageDecodeWorkerPool(scoped_refptr<base::SingleThreadTaskRunner> taskRunnerForTesting)
+    : m_nextThread(0)
+    , m_taskRunnerForTesting(taskRunnerForTesting)
+{
+}
+
+ImageDecodeWorkerPool::~ImageDecodeWorkerPool()
+{
+}
+
+void ImageDecodeWorkerPool::scheduleDecode(PassRefPtr<ImageFrameGenerator> prpGenerator)
+{
+    RefPtr<ImageFrameGenerator> generator = prpGenerator;
+    ImageFrameGenerator* key = generator.get();
+
+    MutexLocker lock(m_mutex);
+    if (!m_pendingGenerators.add(key, generator.release()).isNewEntry)
+        return;
+
+    base::Closure task = base::Bind(&ImageDecodeWorkerPool::decode, base::Unretained(this), base::Unretained(key));
+    if (m_taskRunnerForTesting) {
+        m_taskRunnerForTesting->PostTask(FROM_HERE, task);
+        return;
+    }
+
+    if (m_threads.isEmpty()) {
+        int threadCount = std::max(std::min(base::SysInfo::NumberOfProcessors() - 1, maximumThreadCount), 1);
+        for (int i = 0; i < threadCount; ++i) {
+            OwnPtr<base::Thread> thread = adoptPtr(new base::Thread(base::StringPrintf("SkyImageDecoder%d", i + 1)));
+            CHECK(thread->Start());
+            m_threads.append(thread.release());
+        }
+    }
+
+    base::Thread* thread = m_threads[m_nextThread++ % m_threads.size()].get();
+    thread->task_runner()->PostTask(FROM_HERE, task);
+}
+
+void ImageDecodeWorkerPool::cancelDecode(ImageFrameGenerator* generator)
+{
+    // The generator may be the last reference, so release it outside the lock.
+    RefPtr<ImageFrameGenerator> canceled;
+    {
+        MutexLocker lock(m_mutex);
+        canceled = m_pendingGenerators.take(generator);
+    }
+}
+
+void ImageDecodeWorkerPool::decode(ImageFrameGenerator* key)
+{
+    RefPtr<ImageFrameGenerator> generator;
+    {
+        MutexLocker lock(m_mutex);
+        generator = m_pendingGenerators.take(key);
+    }
+    // The decode was canceled.
+    if (!generator)
+        return;
+
+    TRACE_EVENT1("blink", "ImageDecodeWorkerPool::decode", "generator", generator.get());
+    generator->decodeAhead(0);
+    generator.clear();
+
+    // Decoders allocate in bursts, and the worker may go idle for a long
+    // time after this.
+    partitionAllocFlushThreadCaches();
+}
+
+} // namespace blink
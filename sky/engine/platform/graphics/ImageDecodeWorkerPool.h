@@ -0,0 +1,74 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_ENGINE_PLATFORM_GRAPHICS_IMAGEDECODEWORKERPOOL_H_
+#define SKY_ENGINE_PLATFORM_GRAPHICS_IMAGEDECODEWORKERPOOL_H_
+
+#include "base/memory/ref_counted.h"
+#include "sky/engine/platform/PlatformExport.h"
+#include "sky/engine/wtf/HashMap.h"
+#include "sky/engine/wtf/Noncopyable.h"
+#include "sky/engine/wtf/OwnPtr.h"
+#include "sky/engine/wtf/PassRefPtr.h"
+#include "sky/engine/wtf/RefPtr.h"
+#include "sky/engine/wtf/ThreadingPrimitives.h"
+#include "sky/engine/wtf/Vector.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+class Thread;
+}
+
+namespace blink {
+
+class ImageFrameGenerator;
+
+// Decodes lazily decoded images on worker threads while their data streams
+// in, so that most of the decoding is done by the time the image is painted.
+// The decoders are kept in ImageDecodingStore and the decode at paint time
+// resumes them.
+//
+// An image scheduled again before a worker gets to it is decoded only once,
+// with all the data received by then. An image that goes away before a
+// worker gets to it is not decoded at all.
+//
+// All public methods can be used on any thread.
+class PLATFORM_EXPORT ImageDecodeWorkerPool {
+    WTF_MAKE_NONCOPYABLE(ImageDecodeWorkerPool);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    static ImageDecodeWorkerPool* instance();
+
+    // Runs the decodes on |taskRunner| instead of on worker threads.
+    static PassOwnPtr<ImageDecodeWorkerPool> createForTesting(scoped_refptr<base::SingleThreadTaskRunner>);
+
+    ~ImageDecodeWorkerPool();
+
+    // Decodes the first frame of |generator| on a worker thread.
+    void scheduleDecode(PassRefPtr<ImageFrameGenerator>);
+
+    // Drops the scheduled decode of |generator| if it hasn't started yet.
+    void cancelDecode(ImageFrameGenerator*);
+
+private:
+    explicit ImageDecodeWorkerPool(scoped_refptr<base::SingleThreadTaskRunner> taskRunnerForTesting);
+
+    void decode(ImageFrameGenerator*);
+
+    // Created on the first scheduleDecode().
+    Vector<OwnPtr<base::Thread> > m_threads;
+    size_t m_nextThread;
+
+    scoped_refptr<base::SingleThreadTaskRunner> m_taskRunnerForTesting;
+
+    // Generators that are scheduled but not being decoded yet.
+    HashMap<ImageFrameGenerator*, RefPtr<ImageFrameGenerator> > m_pendingGenerators;
+
+    // Protects m_threads, m_nextThread and m_pendingGenerators.
+    Mutex m_mutex;
+};
+
+} // namespace blink
+
+#endif  // SKY_ENGINE_PLATFORM_GRAPHICS_IMAGEDECODEWORKERPOOL_H_
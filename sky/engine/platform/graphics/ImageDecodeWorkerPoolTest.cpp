@@ -0,0 +1,101 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/platform/graphics/ImageDecodeWorkerPool.h"
+
+#include <gtest/gtest.h>
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "sky/engine/platform/SharedBuffer.h"
+#include "sky/engine/platform/graphics/ImageDecodingStore.h"
+#include "sky/engine/platform/graphics/ImageFrameGenerator.h"
+#include "sky/engine/platform/graphics/test/MockImageDecoder.h"
+
+namespace blink {
+
+class ImageDecodeWorkerPoolTest : public ::testing::Test, public MockImageDecoderClient {
+public:
+    virtual void SetUp() override
+    {
+        ImageDecodingStore::instance()->setCacheLimitInBytes(1024 * 1024);
+        // The decodes run on this thread when the test runs the message loop.
+        m_pool = ImageDecodeWorkerPool::createForTesting(base::MessageLoop::current()->task_runner());
+        m_data = SharedBuffer::create();
+        m_generator = ImageFrameGenerator::create(SkISize::Make(100, 100), m_data, false);
+        m_generator->setImageDecoderFactory(MockImageDecoderFactory::create(this, SkISize::Make(100, 100)));
+        m_frameBufferRequestCount = 0;
+    }
+
+    virtual void TearDown() override
+    {
+        m_pool.clear();
+        ImageDecodingStore::instance()->clear();
+    }
+
+    virtual void decoderBeingDestroyed() override { }
+    virtual void frameBufferRequested() override { ++m_frameBufferRequestCount; }
+    virtual ImageFrame::Status status() override { return ImageFrame::FramePartial; }
+    virtual size_t frameCount() override { return 1; }
+    virtual int repetitionCount() const override { return cAnimationNone; }
+    virtual float frameDuration() const override { return 0; }
+
+protected:
+    void runPendingDecodes()
+    {
+        base::RunLoop().RunUntilIdle();
+    }
+
+    OwnPtr<ImageDecodeWorkerPool> m_pool;
+    RefPtr<SharedBuffer> m_data;
+    RefPtr<ImageFrameGenerator> m_generator;
+    int m_frameBufferRequestCount;
+};
+
+TEST_F(ImageDecodeWorkerPoolTest, DuplicateRequestsDecodeOnce)
+{
+    m_pool->scheduleDecode(m_generator);
+    m_pool->scheduleDecode(m_generator);
+    m_pool->scheduleDecode(m_generator);
+    runPendingDecodes();
+
+    EXPECT_EQ(1, m_frameBufferRequestCount);
+    EXPECT_EQ(1, ImageDecodingStore::instance()->decoderCacheEntries());
+
+    // The generator can be scheduled again once its decode has run.
+    m_pool->scheduleDecode(m_generator);
+    runPendingDecodes();
+
+    EXPECT_EQ(2, m_frameBufferRequestCount);
+}
+
+TEST_F(ImageDecodeWorkerPoolTest, CanceledDecodeIsDropped)
+{
+    m_pool->scheduleDecode(m_generator);
+    m_pool->cancelDecode(m_generator.get());
+
+    // The pool doesn't keep the generator alive.
+    EXPECT_TRUE(m_generator->hasOneRef());
+
+    runPendingDecodes();
+
+    EXPECT_EQ(0, m_frameBufferRequestCount);
+    EXPECT_EQ(0, ImageDecodingStore::instance()->decoderCacheEntries());
+}
+
+TEST_F(ImageDecodeWorkerPoolTest, CancelOnlyDropsThatGenerator)
+{
+    RefPtr<ImageFrameGenerator> other = ImageFrameGenerator::create(SkISize::Make(100, 100), m_data, false);
+    other->setImageDecoderFactory(MockImageDecoderFactory::create(this, SkISize::Make(100, 100)));
+
+    m_pool->scheduleDecode(m_generator);
+    m_pool->scheduleDecode(other);
+    m_pool->cancelDecode(m_generator.get());
+    runPendingDecodes();
+
+    EXPECT_EQ(1, m_frameBufferRequestCount);
+    EXPECT_EQ(1, ImageDecodingStore::instance()->decoderCacheEntries());
+}
+
+} // namespace blink
@@ -34,12 +34,16 @@ namespace blink {
 namespace {
 
 static const size_t defaultMaxTotalSizeOfHeapEntries = 32 * 1024 * 1024;
+static const size_t defaultMaxSizeOfHeapEntriesPerGenerator = 8 * 1024 * 1024;
 
 } // namespace
 
 ImageDecodingStore::ImageDecodingStore()
     : m_heapLimitInBytes(defaultMaxTotalSizeOfHeapEntries)
+    , m_heapLimitPerGeneratorInBytes(defaultMaxSizeOfHeapEntriesPerGenerator)
     , m_heapMemoryUsageInBytes(0)
+    , m_decoderCacheHits(0)
+    , m_decoderCacheMisses(0)
 {
 }
 
@@ -65,8 +69,13 @@ bool ImageDecodingStore::lockDecoder(const ImageFrameGenerator* generator, const
 
     MutexLocker lock(m_mutex);
     DecoderCacheMap::iterator iter = m_decoderCacheMap.find(DecoderCacheEntry::makeCacheKey(generator, scaledSize));
-    if (iter == m_decoderCacheMap.end())
+    if (iter == m_decoderCacheMap.end()) {
+        ++m_decoderCacheMisses;
+        TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("blink.image_decoding"), "ImageDecodingStoreDecoderCache", "hits", m_decoderCacheHits, "misses", m_decoderCacheMisses);
         return false;
+    }
+    ++m_decoderCacheHits;
+    TRACE_COUNTER2(TRACE_DISABLED_BY_DEFAULT("blink.image_decoding"), "ImageDecodingStoreDecoderCache", "hits", m_decoderCacheHits, "misses", m_decoderCacheMisses);
 
     DecoderCacheEntry* cacheEntry = iter->value.get();
 
@@ -93,11 +102,12 @@ void ImageDecodingStore::unlockDecoder(const ImageFrameGenerator* generator, con
 
 void ImageDecodingStore::insertDecoder(const ImageFrameGenerator* generator, PassOwnPtr<ImageDecoder> decoder)
 {
+    OwnPtr<DecoderCacheEntry> newCacheEntry = DecoderCacheEntry::create(generator, decoder);
+
     // Prune old cache entries to give space for the new one.
+    pruneGenerator(generator, newCacheEntry->memoryUsageInBytes());
     prune();
 
-    OwnPtr<DecoderCacheEntry> newCacheEntry = DecoderCacheEntry::create(generator, decoder);
-
     MutexLocker lock(m_mutex);
     ASSERT(!m_decoderCacheMap.contains(newCacheEntry->cacheKey()));
     insertCacheInternal(newCacheEntry.release(), &m_decoderCacheMap, &m_decoderCacheKeyMap);
@@ -166,12 +176,24 @@ void ImageDecodingStore::setCacheLimitInBytes(size_t cacheLimit)
     prune();
 }
 
+void ImageDecodingStore::setCacheLimitPerGeneratorInBytes(size_t cacheLimit)
+{
+    MutexLocker lock(m_mutex);
+    m_heapLimitPerGeneratorInBytes = cacheLimit;
+}
+
 size_t ImageDecodingStore::memoryUsageInBytes()
 {
     MutexLocker lock(m_mutex);
     return m_heapMemoryUsageInBytes;
 }
 
+size_t ImageDecodingStore::memoryUsageInBytes(const ImageFrameGenerator* generator)
+{
+    MutexLocker lock(m_mutex);
+    return memoryUsageInBytesInternal(generator);
+}
+
 int ImageDecodingStore::cacheEntries()
 {
     MutexLocker lock(m_mutex);
@@ -184,6 +206,18 @@ int ImageDecodingStore::decoderCacheEntries()
     return m_decoderCacheMap.size();
 }
 
+unsigned ImageDecodingStore::decoderCacheHits()
+{
+    MutexLocker lock(m_mutex);
+    return m_decoderCacheHits;
+}
+
+unsigned ImageDecodingStore::decoderCacheMisses()
+{
+    MutexLocker lock(m_mutex);
+    return m_decoderCacheMisses;
+}
+
 void ImageDecodingStore::prune()
 {
     TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("blink.image_decoding"), "ImageDecodingStore::prune");
@@ -213,6 +247,44 @@ void ImageDecodingStore::prune()
     }
 }
 
+void ImageDecodingStore::pruneGenerator(const ImageFrameGenerator* generator, size_t incomingBytes)
+{
+    TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("blink.image_decoding"), "ImageDecodingStore::pruneGenerator");
+
+    Vector<OwnPtr<CacheEntry> > cacheEntriesToDelete;
+    {
+        MutexLocker lock(m_mutex);
+
+        size_t generatorMemoryUsageInBytes = memoryUsageInBytesInternal(generator);
+
+        // Walk the list of cache entries starting from the least recently used
+        // and keep the ones of |generator| for deletion later.
+        const CacheEntry* cacheEntry = m_orderedCacheList.head();
+        while (cacheEntry && generatorMemoryUsageInBytes + incomingBytes > m_heapLimitPerGeneratorInBytes) {
+            if (cacheEntry->generator() == generator && !cacheEntry->useCount()) {
+                generatorMemoryUsageInBytes -= cacheEntry->memoryUsageInBytes();
+                removeFromCacheInternal(cacheEntry, &cacheEntriesToDelete);
+            }
+            cacheEntry = cacheEntry->next();
+        }
+
+        // Remove from cache list as well.
+        removeFromCacheListInternal(cacheEntriesToDelete);
+    }
+}
+
+size_t ImageDecodingStore::memoryUsageInBytesInternal(const ImageFrameGenerator* generator) const
+{
+    DecoderCacheKeyMap::const_iterator iter = m_decoderCacheKeyMap.find(generator);
+    if (iter == m_decoderCacheKeyMap.end())
+        return 0;
+
+    size_t memoryUsageInBytes = 0;
+    for (DecoderCacheKeySet::const_iterator key = iter->value.begin(); key != iter->value.end(); ++key)
+        memoryUsageInBytes += m_decoderCacheMap.get(*key)->memoryUsageInBytes();
+    return memoryUsageInBytes;
+}
+
 template<class T, class U, class V>
 void ImageDecodingStore::insertCacheInternal(PassOwnPtr<T> cacheEntry, U* cacheMap, V* identifierMap)
 {
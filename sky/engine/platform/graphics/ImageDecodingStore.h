@@ -56,6 +56,13 @@ class ImageFrameGenerator;
 //   using an ImageDecoder. It contains encoded image data and is used to represent
 //   one image file. It is used to index image and decoder objects in the cache.
 //
+// BUDGETS
+//
+// All cached decoders share one byte limit and the least recently used ones
+// are evicted first. On top of that each ImageFrameGenerator gets a smaller
+// limit of its own, so a single large image can't evict the decoders of
+// every other image.
+//
 // THREAD SAFETY
 //
 // All public methods can be used on any thread.
@@ -79,10 +86,17 @@ public:
 
     void clear();
     void setCacheLimitInBytes(size_t);
+    void setCacheLimitPerGeneratorInBytes(size_t);
     size_t memoryUsageInBytes();
+    size_t memoryUsageInBytes(const ImageFrameGenerator*);
     int cacheEntries();
     int decoderCacheEntries();
 
+    // The number of lockDecoder() calls that found a cached decoder and
+    // that didn't.
+    unsigned decoderCacheHits();
+    unsigned decoderCacheMisses();
+
 private:
     // Decoder cache entry is identified by:
     // 1. Pointer to ImageFrameGenerator.
@@ -165,6 +179,9 @@ private:
     ImageDecodingStore();
 
     void prune();
+    // Evicts unused decoders of |generator| until |incomingBytes| more fit in
+    // its limit.
+    void pruneGenerator(const ImageFrameGenerator*, size_t incomingBytes);
 
     // These helper methods are called while m_mutex is locked.
     template<class T, class U, class V> void insertCacheInternal(PassOwnPtr<T> cacheEntry, U* cacheMap, V* identifierMap);
@@ -184,6 +201,8 @@ private:
     // Helper method to remove cache entry pointers from the LRU list.
     void removeFromCacheListInternal(const Vector<OwnPtr<CacheEntry> >& deletionList);
 
+    size_t memoryUsageInBytesInternal(const ImageFrameGenerator*) const;
+
     // A doubly linked list that maintains usage history of cache entries.
     // This is used for eviction of old entries.
     // Head of this list is the least recently used cache entry.
@@ -201,14 +220,21 @@ private:
     DecoderCacheKeyMap m_decoderCacheKeyMap;
 
     size_t m_heapLimitInBytes;
+    size_t m_heapLimitPerGeneratorInBytes;
     size_t m_heapMemoryUsageInBytes;
 
+    unsigned m_decoderCacheHits;
+    unsigned m_decoderCacheMisses;
+
     // Protect concurrent access to these members:
     //   m_orderedCacheList
     //   m_decoderCacheMap and all CacheEntrys stored in it
     //   m_decoderCacheKeyMap
     //   m_heapLimitInBytes
+    //   m_heapLimitPerGeneratorInBytes
     //   m_heapMemoryUsageInBytes
+    //   m_decoderCacheHits
+    //   m_decoderCacheMisses
     // This mutex also protects calls to underlying skBitmap's
     // lockPixels()/unlockPixels() as they are not threadsafe.
     Mutex m_mutex;
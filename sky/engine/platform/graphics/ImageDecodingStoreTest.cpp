@@ -41,6 +41,7 @@ public:
     void SetUp() override
     {
         ImageDecodingStore::instance()->setCacheLimitInBytes(1024 * 1024);
+        ImageDecodingStore::instance()->setCacheLimitPerGeneratorInBytes(1024 * 1024);
         m_data = SharedBuffer::create();
         m_generator = ImageFrameGenerator::create(SkISize::Make(100, 100), m_data, true);
         m_decodersDestroyed = 0;
@@ -179,4 +180,52 @@ TEST_F(ImageDecodingStoreTest, removeDecoder)
     EXPECT_FALSE(ImageDecodingStore::instance()->lockDecoder(m_generator.get(), size, &testDecoder));
 }
 
+TEST_F(ImageDecodingStoreTest, decoderCacheHitsAndMisses)
+{
+    const unsigned hits = ImageDecodingStore::instance()->decoderCacheHits();
+    const unsigned misses = ImageDecodingStore::instance()->decoderCacheMisses();
+
+    OwnPtr<ImageDecoder> decoder = MockImageDecoder::create(this);
+    decoder->setSize(1, 1);
+    ImageDecodingStore::instance()->insertDecoder(m_generator.get(), decoder.release());
+
+    ImageDecoder* testDecoder;
+    EXPECT_TRUE(ImageDecodingStore::instance()->lockDecoder(m_generator.get(), SkISize::Make(1, 1), &testDecoder));
+    ImageDecodingStore::instance()->unlockDecoder(m_generator.get(), testDecoder);
+    EXPECT_FALSE(ImageDecodingStore::instance()->lockDecoder(m_generator.get(), SkISize::Make(2, 2), &testDecoder));
+
+    EXPECT_EQ(hits + 1, ImageDecodingStore::instance()->decoderCacheHits());
+    EXPECT_EQ(misses + 1, ImageDecodingStore::instance()->decoderCacheMisses());
+}
+
+TEST_F(ImageDecodingStoreTest, evictDecoderOverGeneratorLimit)
+{
+    RefPtr<ImageFrameGenerator> otherGenerator = ImageFrameGenerator::create(SkISize::Make(100, 100), m_data, true);
+    ImageDecodingStore::instance()->setCacheLimitPerGeneratorInBytes(24);
+
+    OwnPtr<ImageDecoder> decoder1 = MockImageDecoder::create(this);
+    OwnPtr<ImageDecoder> decoder2 = MockImageDecoder::create(this);
+    OwnPtr<ImageDecoder> decoder3 = MockImageDecoder::create(this);
+    OwnPtr<ImageDecoder> otherDecoder = MockImageDecoder::create(this);
+    decoder1->setSize(1, 1);
+    decoder2->setSize(2, 2);
+    decoder3->setSize(1, 2);
+    otherDecoder->setSize(2, 2);
+    ImageDecodingStore::instance()->insertDecoder(otherGenerator.get(), otherDecoder.release());
+    ImageDecodingStore::instance()->insertDecoder(m_generator.get(), decoder1.release());
+    ImageDecodingStore::instance()->insertDecoder(m_generator.get(), decoder2.release());
+    EXPECT_EQ(3, ImageDecodingStore::instance()->cacheEntries());
+    EXPECT_EQ(20u, ImageDecodingStore::instance()->memoryUsageInBytes(m_generator.get()));
+
+    // Only the least recently used decoder of the same generator is evicted.
+    ImageDecodingStore::instance()->insertDecoder(m_generator.get(), decoder3.release());
+    EXPECT_EQ(1, m_decodersDestroyed);
+    EXPECT_EQ(3, ImageDecodingStore::instance()->cacheEntries());
+    EXPECT_EQ(24u, ImageDecodingStore::instance()->memoryUsageInBytes(m_generator.get()));
+    EXPECT_EQ(16u, ImageDecodingStore::instance()->memoryUsageInBytes(otherGenerator.get()));
+
+    ImageDecoder* testDecoder;
+    EXPECT_FALSE(ImageDecodingStore::instance()->lockDecoder(m_generator.get(), SkISize::Make(1, 1), &testDecoder));
+}
+
 } // namespace
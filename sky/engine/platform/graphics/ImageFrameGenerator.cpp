@@ -115,13 +115,14 @@ bool ImageFrameGenerator::decodeAndScale(const SkImageInfo& info, size_t index,
     m_externalAllocator = adoptPtr(new ExternalMemoryAllocator(info, pixels, rowBytes));
 
     SkBitmap bitmap = tryToResumeDecode(scaledSize, index);
-    if (bitmap.isNull())
-        return false;
 
     // Don't keep the allocator because it contains a pointer to memory
     // that we do not own.
     m_externalAllocator.clear();
 
+    if (bitmap.isNull())
+        return false;
+
     ASSERT(bitmap.width() == scaledSize.width());
     ASSERT(bitmap.height() == scaledSize.height());
 
@@ -133,6 +134,45 @@ bool ImageFrameGenerator::decodeAndScale(const SkImageInfo& info, size_t index,
     return result;
 }
 
+void ImageFrameGenerator::decodeAhead(size_t index)
+{
+    // Prevents concurrent decode or scale operations on the same image data.
+    MutexLocker lock(m_decodeMutex);
+
+    if (m_decodeFailedAndEmpty)
+        return;
+
+    TRACE_EVENT2("blink", "ImageFrameGenerator::decodeAhead", "generator", this, "decodeCount", m_decodeCount);
+
+    ImageDecoder* decoder = 0;
+    const bool resumeDecoding = ImageDecodingStore::instance()->lockDecoder(this, m_fullSize, &decoder);
+    ASSERT(!resumeDecoding || decoder);
+
+    // There's no memory to decode into yet, so the decoder allocates its own.
+    ASSERT(!m_externalAllocator);
+    SkBitmap fullSizeImage;
+    decode(index, &decoder, &fullSizeImage);
+
+    if (!decoder)
+        return;
+
+    if (fullSizeImage.isNull() && decoder->failed()) {
+        m_decodeFailedAndEmpty = !m_isMultiFrame;
+        if (resumeDecoding)
+            ImageDecodingStore::instance()->removeDecoder(this, decoder);
+        else
+            delete decoder;
+        return;
+    }
+
+    // Keep the decoder even if the frame is complete: decodeAndScale() takes
+    // the decoded frame from it instead of decoding again.
+    if (resumeDecoding)
+        ImageDecodingStore::instance()->unlockDecoder(this, decoder);
+    else
+        ImageDecodingStore::instance()->insertDecoder(this, adoptPtr(decoder));
+}
+
 bool ImageFrameGenerator::decodeToYUV(void* planes[3], size_t rowBytes[3])
 {
     // This method is called to populate a discardable memory owned by Skia.
@@ -254,10 +294,9 @@ bool ImageFrameGenerator::decode(size_t index, ImageDecoder** decoder, SkBitmap*
             return false;
     }
 
-    if (!m_isMultiFrame && newDecoder && allDataReceived) {
+    if (!m_isMultiFrame && newDecoder && allDataReceived && m_externalAllocator) {
         // If we're using an external memory allocator that means we're decoding
         // directly into the output memory and we can save one memcpy.
-        ASSERT(m_externalAllocator.get());
         (*decoder)->setMemoryAllocator(m_externalAllocator.get());
     }
     (*decoder)->setData(data, allDataReceived);
@@ -71,6 +71,12 @@ public:
     // Returns true if decoding was successful.
     bool decodeAndScale(const SkImageInfo&, size_t index, void* pixels, size_t rowBytes);
 
+    // Decodes as much of the frame indicated by |index| as the data received
+    // so far allows and leaves the decoder in ImageDecodingStore, so that a
+    // later decodeAndScale() resumes from it or copies the finished frame.
+    // Meant to run on a worker thread while the data is still streaming in.
+    void decodeAhead(size_t index);
+
     // Decodes YUV components directly into the provided memory planes.
     bool decodeToYUV(void* planes[3], size_t rowBytes[3]);
 
@@ -150,6 +150,30 @@ static void decodeThreadMain(ImageFrameGenerator* generator)
     generator->decodeAndScale(imageInfo(), 0, buffer, 100 * 4);
 }
 
+TEST_F(ImageFrameGeneratorTest, decodeAheadIsResumedByDecodeAndScale)
+{
+    setFrameStatus(ImageFrame::FramePartial);
+
+    m_generator->decodeAhead(0);
+    EXPECT_EQ(1, m_frameBufferRequestCount);
+    EXPECT_EQ(1, ImageDecodingStore::instance()->decoderCacheEntries());
+
+    setFrameStatus(ImageFrame::FrameComplete);
+    addNewData();
+
+    // The decoder is kept even though the frame is now complete.
+    m_generator->decodeAhead(0);
+    EXPECT_EQ(2, m_frameBufferRequestCount);
+    EXPECT_EQ(0, m_decodersDestroyed);
+    EXPECT_EQ(1, ImageDecodingStore::instance()->decoderCacheEntries());
+
+    char buffer[100 * 100 * 4];
+    m_generator->decodeAndScale(imageInfo(), 0, buffer, 100 * 4);
+    EXPECT_EQ(3, m_frameBufferRequestCount);
+    EXPECT_EQ(1, m_decodersDestroyed);
+    EXPECT_EQ(0, ImageDecodingStore::instance()->decoderCacheEntries());
+}
+
 TEST_F(ImageFrameGeneratorTest, incompleteDecodeBecomesCompleteMultiThreaded)
 {
     setFrameStatus(ImageFrame::FramePartial);
@@ -54,6 +54,11 @@ BLINK_EXPORT bool layoutTestMode();
 BLINK_EXPORT void setFontAntialiasingEnabledForTest(bool);
 BLINK_EXPORT bool fontAntialiasingEnabledForTest();
 
+// Gives the memory the calling thread has cached in the engine's allocators
+// back to them. Embedder threads that run engine code, such as raster
+// workers, should call this when they run out of work.
+BLINK_EXPORT void flushThreadCaches();
+
 // Enables the named log channel. See WebCore/platform/Logging.h for details.
 BLINK_EXPORT void enableLogChannel(const char*);
 
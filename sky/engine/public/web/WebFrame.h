@@ -211,6 +211,11 @@ public:
     // to support layout tests.
     virtual WebString renderTreeAsText(RenderAsTextControls toShow = RenderAsTextNormal) const = 0;
 
+    // Returns the style resolver statistics summed over all the style
+    // recalcs so far, or an empty string if the StyleResolverStats runtime
+    // feature is off. This method is used to support benchmarks.
+    virtual WebString styleResolverStatsAsText() const = 0;
+
     // Only for testing purpose:
     // Returns true if selection.anchorNode has a marker on range from |from| with |length|.
     virtual bool selectionStartHasSpellingMarkerFor(int from, int length) const = 0;
@@ -94,6 +94,12 @@ public:
 
     BLINK_EXPORT static void enableLaxMixedContentChecking(bool);
 
+    BLINK_EXPORT static void enableStyleResolverStats(bool);
+
+    BLINK_EXPORT static void enableParallelStyleRecalc(bool);
+
+    BLINK_EXPORT static void enableImageDecodeAhead(bool);
+
 private:
     WebRuntimeFeatures();
 };
@@ -47,6 +47,7 @@
 #include "sky/engine/wtf/Assertions.h"
 #include "sky/engine/wtf/CryptographicallyRandomNumber.h"
 #include "sky/engine/wtf/MainThread.h"
+#include "sky/engine/wtf/PartitionAlloc.h"
 #include "sky/engine/wtf/text/AtomicString.h"
 #include "sky/engine/wtf/text/TextEncoding.h"
 #include "sky/engine/wtf/WTF.h"
@@ -178,6 +179,11 @@ bool fontAntialiasingEnabledForTest()
     return LayoutTestSupport::isFontAntialiasingEnabledForTest();
 }
 
+void flushThreadCaches()
+{
+    partitionAllocFlushThreadCaches();
+}
+
 void enableLogChannel(const char* name)
 {
 #if !LOG_DISABLED
@@ -78,6 +78,8 @@
 #include "mojo/public/cpp/system/data_pipe.h"
 #include "sky/engine/bindings/exception_state.h"
 #include "sky/engine/bindings/exception_state_placeholder.h"
+#include "sky/engine/core/css/resolver/StyleResolver.h"
+#include "sky/engine/core/css/resolver/StyleResolverStats.h"
 #include "sky/engine/core/dom/Document.h"
 #include "sky/engine/core/dom/Node.h"
 #include "sky/engine/core/dom/NodeTraversal.h"
@@ -522,6 +524,16 @@ WebString WebLocalFrameImpl::renderTreeAsText(RenderAsTextControls toShow) const
     return externalRepresentation(frame(), behavior);
 }
 
+WebString WebLocalFrameImpl::styleResolverStatsAsText() const
+{
+    if (!frame() || !frame()->document())
+        return WebString();
+    StyleResolverStats* stats = frame()->document()->styleResolver().statsTotals();
+    if (!stats)
+        return WebString();
+    return stats->report();
+}
+
 bool WebLocalFrameImpl::selectionStartHasSpellingMarkerFor(int from, int length) const
 {
     if (!frame())
@@ -102,6 +102,7 @@ public:
 
     virtual WebString contentAsText(size_t maxChars) const override;
     virtual WebString renderTreeAsText(RenderAsTextControls toShow = RenderAsTextNormal) const override;
+    virtual WebString styleResolverStatsAsText() const override;
 
     virtual bool selectionStartHasSpellingMarkerFor(int from, int length) const override;
 
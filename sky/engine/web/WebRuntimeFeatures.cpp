@@ -176,4 +176,19 @@ void WebRuntimeFeatures::enableLaxMixedContentChecking(bool enable)
     RuntimeEnabledFeatures::setLaxMixedContentCheckingEnabled(enable);
 }
 
+void WebRuntimeFeatures::enableStyleResolverStats(bool enable)
+{
+    RuntimeEnabledFeatures::setStyleResolverStatsEnabled(enable);
+}
+
+void WebRuntimeFeatures::enableParallelStyleRecalc(bool enable)
+{
+    RuntimeEnabledFeatures::setParallelStyleRecalcEnabled(enable);
+}
+
+void WebRuntimeFeatures::enableImageDecodeAhead(bool enable)
+{
+    RuntimeEnabledFeatures::setImageDecodeAheadEnabled(enable);
+}
+
 } // namespace blink
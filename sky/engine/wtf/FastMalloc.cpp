@@ -66,8 +66,9 @@ void* fastMalloc(size_t n)
     if (UNLIKELY(!gInitialized)) {
         spinLockLock(&gLock);
         if (!gInitialized) {
-            gInitialized = true;
             gPartition.init();
+            gPartition.enableThreadCache();
+            gInitialized = true;
         }
         spinLockUnlock(&gLock);
     }
@@ -0,0 +1,748 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SKY_ENGINE_WTF_GROUPPROBINGHASHTABLE_H_
+#define SKY_ENGINE_WTF_GROUPPROBINGHASHTABLE_H_
+
+#include <limits>
+#include <stdint.h>
+#include <string.h>
+#include "sky/engine/wtf/CPU.h"
+#include "sky/engine/wtf/Compiler.h"
+#include "sky/engine/wtf/HashTable.h"
+
+#if CPU(X86_64)
+#include <emmintrin.h>
+#define WTF_GROUP_PROBING_USE_SSE2 1
+#endif
+
+namespace WTF {
+
+    // An open addressing hash table that keeps one control byte per slot next
+    // to the slots. A full slot's control byte holds the low 7 bits of its
+    // key's hash; empty and deleted slots have the top bit set. Lookups probe
+    // a group of control bytes at a time, comparing all of them against the
+    // hash in a few instructions, and only compare keys whose hash bits match.
+    // Unlike HashTable, it never compares keys to the empty or deleted values,
+    // so a miss touches the control bytes and nothing else.
+    //
+    // HashMap and HashSet use it in place of HashTable when their key traits
+    // say useGroupProbing; see GroupProbingHashTraits. It doesn't support
+    // garbage collected backings.
+
+    typedef int8_t HashTableControlByte;
+
+    static const HashTableControlByte hashTableControlEmpty = -128;
+    static const HashTableControlByte hashTableControlDeleted = -2;
+
+    // A set of slots in a group, as a bit mask.
+    class HashTableControlMask {
+    public:
+#if WTF_GROUP_PROBING_USE_SSE2
+        typedef uint32_t MaskType;
+        static const unsigned bitsPerSlot = 1;
+#else
+        typedef uint64_t MaskType;
+        static const unsigned bitsPerSlot = 8;
+#endif
+
+        explicit HashTableControlMask(MaskType mask) : m_mask(mask) { }
+
+        bool isEmpty() const { return !m_mask; }
+
+        unsigned lowestIndex() const
+        {
+            ASSERT(m_mask);
+#if WTF_GROUP_PROBING_USE_SSE2
+            return __builtin_ctz(m_mask);
+#else
+            return __builtin_ctzll(m_mask) / bitsPerSlot;
+#endif
+        }
+
+        void removeLowest() { m_mask &= m_mask - 1; }
+
+    private:
+        MaskType m_mask;
+    };
+
+    // The control bytes of one group of slots.
+    class HashTableControlGroup {
+    public:
+#if WTF_GROUP_PROBING_USE_SSE2
+        static const unsigned width = 16;
+
+        explicit HashTableControlGroup(const HashTableControlByte* control)
+            : m_control(_mm_loadu_si128(reinterpret_cast<const __m128i*>(control)))
+        {
+        }
+
+        HashTableControlMask match(HashTableControlByte hash) const
+        {
+            return HashTableControlMask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), m_control))));
+        }
+
+        HashTableControlMask matchEmpty() const { return match(hashTableControlEmpty); }
+
+        HashTableControlMask matchEmptyOrDeleted() const
+        {
+            return HashTableControlMask(static_cast<uint32_t>(_mm_movemask_epi8(m_control)));
+        }
+
+    private:
+        __m128i m_control;
+#else
+        // Without SSE2 the group is a 64 bit word, and each match sets the top
+        // bit of the matching bytes.
+        static const unsigned width = 8;
+
+        explicit HashTableControlGroup(const HashTableControlByte* control)
+        {
+            memcpy(&m_control, control, sizeof(m_control));
+#if CPU(BIG_ENDIAN)
+            m_control = __builtin_bswap64(m_control);
+#endif
+        }
+
+        // May also match a full slot whose hash differs from |hash| in the
+        // lowest bit only. That's harmless as the keys get compared anyway.
+        HashTableControlMask match(HashTableControlByte hash) const
+        {
+            uint64_t x = m_control ^ (lsbs * static_cast<uint8_t>(hash));
+            return HashTableControlMask((x - lsbs) & ~x & msbs);
+        }
+
+        HashTableControlMask matchEmpty() const
+        {
+            // Empty is the only control byte with the top bit set and the
+            // second lowest bit clear.
+            return HashTableControlMask(m_control & (~m_control << 6) & msbs);
+        }
+
+        HashTableControlMask matchEmptyOrDeleted() const { return HashTableControlMask(m_control & msbs); }
+
+    private:
+        static const uint64_t lsbs = 0x0101010101010101ULL;
+        static const uint64_t msbs = 0x8080808080808080ULL;
+
+        uint64_t m_control;
+#endif
+    };
+
+    // Calls add()'s translator with or without the hash code, as the add
+    // variant asks.
+    template<bool passHashCode> struct GroupProbingHashTableTranslator;
+
+    template<> struct GroupProbingHashTableTranslator<false> {
+        template<typename HashTranslator, typename Value, typename T, typename Extra> static void translate(Value& location, const T& key, const Extra& extra, unsigned)
+        {
+            HashTranslator::translate(location, key, extra);
+        }
+    };
+
+    template<> struct GroupProbingHashTableTranslator<true> {
+        template<typename HashTranslator, typename Value, typename T, typename Extra> static void translate(Value& location, const T& key, const Extra& extra, unsigned hash)
+        {
+            HashTranslator::translate(location, key, extra, hash);
+        }
+    };
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    class GroupProbingHashTable;
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    class GroupProbingHashTableIterator;
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    class GroupProbingHashTableConstIterator {
+    private:
+        typedef GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> HashTableType;
+        typedef GroupProbingHashTableIterator<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> iterator;
+        typedef GroupProbingHashTableConstIterator<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> const_iterator;
+        typedef Value ValueType;
+        typedef typename Traits::IteratorConstGetType GetType;
+        typedef const ValueType* PointerType;
+
+        friend class GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>;
+        friend class GroupProbingHashTableIterator<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>;
+
+        void skipEmptyBuckets()
+        {
+            while (m_position != m_endPosition && *m_control < 0) {
+                ++m_position;
+                ++m_control;
+            }
+        }
+
+        GroupProbingHashTableConstIterator(PointerType position, PointerType endPosition, const HashTableControlByte* control, const HashTableType* container)
+            : m_position(position)
+            , m_endPosition(endPosition)
+            , m_control(control)
+#if ENABLE(ASSERT)
+            , m_container(container)
+            , m_containerModifications(container->modifications())
+#endif
+        {
+            skipEmptyBuckets();
+        }
+
+        GroupProbingHashTableConstIterator(PointerType position, PointerType endPosition, const HashTableControlByte* control, const HashTableType* container, HashItemKnownGoodTag)
+            : m_position(position)
+            , m_endPosition(endPosition)
+            , m_control(control)
+#if ENABLE(ASSERT)
+            , m_container(container)
+            , m_containerModifications(container->modifications())
+#endif
+        {
+        }
+
+        void checkModifications() const
+        {
+            // Like HashTable, this doesn't support modifications while there
+            // is an iterator in use.
+            ASSERT(m_containerModifications == m_container->modifications());
+        }
+
+    public:
+        GroupProbingHashTableConstIterator()
+        {
+        }
+
+        GetType get() const
+        {
+            checkModifications();
+            return m_position;
+        }
+        typename Traits::IteratorConstReferenceType operator*() const { return Traits::getToReferenceConstConversion(get()); }
+        GetType operator->() const { return get(); }
+
+        const_iterator& operator++()
+        {
+            ASSERT(m_position != m_endPosition);
+            checkModifications();
+            ++m_position;
+            ++m_control;
+            skipEmptyBuckets();
+            return *this;
+        }
+
+        // postfix ++ intentionally omitted
+
+        // Comparison.
+        bool operator==(const const_iterator& other) const
+        {
+            return m_position == other.m_position;
+        }
+        bool operator!=(const const_iterator& other) const
+        {
+            return m_position != other.m_position;
+        }
+        bool operator==(const iterator& other) const
+        {
+            return *this == static_cast<const_iterator>(other);
+        }
+        bool operator!=(const iterator& other) const
+        {
+            return *this != static_cast<const_iterator>(other);
+        }
+
+    private:
+        PointerType m_position;
+        PointerType m_endPosition;
+        const HashTableControlByte* m_control;
+#if ENABLE(ASSERT)
+        const HashTableType* m_container;
+        int64_t m_containerModifications;
+#endif
+    };
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    class GroupProbingHashTableIterator {
+    private:
+        typedef GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> HashTableType;
+        typedef GroupProbingHashTableIterator<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> iterator;
+        typedef GroupProbingHashTableConstIterator<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> const_iterator;
+        typedef Value ValueType;
+        typedef typename Traits::IteratorGetType GetType;
+        typedef ValueType* PointerType;
+
+        friend class GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>;
+
+        GroupProbingHashTableIterator(PointerType pos, PointerType end, const HashTableControlByte* control, const HashTableType* container) : m_iterator(pos, end, control, container) { }
+        GroupProbingHashTableIterator(PointerType pos, PointerType end, const HashTableControlByte* control, const HashTableType* container, HashItemKnownGoodTag tag) : m_iterator(pos, end, control, container, tag) { }
+
+    public:
+        GroupProbingHashTableIterator() { }
+
+        // default copy, assignment and destructor are OK
+
+        GetType get() const { return const_cast<GetType>(m_iterator.get()); }
+        typename Traits::IteratorReferenceType operator*() const { return Traits::getToReferenceConversion(get()); }
+        GetType operator->() const { return get(); }
+
+        iterator& operator++() { ++m_iterator; return *this; }
+
+        // postfix ++ intentionally omitted
+
+        // Comparison.
+        bool operator==(const iterator& other) const { return m_iterator == other.m_iterator; }
+        bool operator!=(const iterator& other) const { return m_iterator != other.m_iterator; }
+        bool operator==(const const_iterator& other) const { return m_iterator == other; }
+        bool operator!=(const const_iterator& other) const { return m_iterator != other; }
+
+        operator const_iterator() const { return m_iterator; }
+
+    private:
+        const_iterator m_iterator;
+    };
+
+    // Note: like HashTable, empty or deleted key values are not allowed as
+    // keys, even though the table never stores them.
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    class GroupProbingHashTable {
+        COMPILE_ASSERT(!Allocator::isGarbageCollected, GroupProbingHashTableDoesNotSupportGarbageCollection);
+    public:
+        typedef GroupProbingHashTableIterator<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> iterator;
+        typedef GroupProbingHashTableConstIterator<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> const_iterator;
+        typedef Traits ValueTraits;
+        typedef Key KeyType;
+        typedef typename KeyTraits::PeekInType KeyPeekInType;
+        typedef typename KeyTraits::PassInType KeyPassInType;
+        typedef Value ValueType;
+        typedef Extractor ExtractorType;
+        typedef KeyTraits KeyTraitsType;
+        typedef typename Traits::PassInType ValuePassInType;
+        typedef IdentityHashTranslator<HashFunctions> IdentityTranslatorType;
+        typedef HashTableAddResult<GroupProbingHashTable, ValueType> AddResult;
+
+        GroupProbingHashTable();
+        ~GroupProbingHashTable()
+        {
+            if (LIKELY(!m_table))
+                return;
+            deleteAllBucketsAndDeallocate(m_table, m_control, m_tableSize);
+        }
+
+        GroupProbingHashTable(const GroupProbingHashTable&);
+        void swap(GroupProbingHashTable&);
+        GroupProbingHashTable& operator=(const GroupProbingHashTable&);
+
+        iterator begin() { return isEmpty() ? end() : makeIterator(m_table); }
+        iterator end() { return makeKnownGoodIterator(m_table + m_tableSize); }
+        const_iterator begin() const { return isEmpty() ? end() : makeConstIterator(m_table); }
+        const_iterator end() const { return makeKnownGoodConstIterator(m_table + m_tableSize); }
+
+        unsigned size() const { return m_keyCount; }
+        unsigned capacity() const { return m_tableSize; }
+        bool isEmpty() const { return !m_keyCount; }
+
+        AddResult add(ValuePassInType value)
+        {
+            return add<IdentityTranslatorType>(Extractor::extract(value), value);
+        }
+
+        template<typename HashTranslator, typename T, typename Extra> AddResult add(const T& key, const Extra& extra)
+        {
+            return addWithHash<HashTranslator, false>(key, extra, HashTranslator::hash(key));
+        }
+        template<typename HashTranslator, typename T, typename Extra> AddResult addPassingHashCode(const T& key, const Extra& extra)
+        {
+            return addWithHash<HashTranslator, true>(key, extra, HashTranslator::hash(key));
+        }
+
+        iterator find(KeyPeekInType key) { return find<IdentityTranslatorType>(key); }
+        const_iterator find(KeyPeekInType key) const { return find<IdentityTranslatorType>(key); }
+        bool contains(KeyPeekInType key) const { return contains<IdentityTranslatorType>(key); }
+
+        template<typename HashTranslator, typename T> iterator find(const T&);
+        template<typename HashTranslator, typename T> const_iterator find(const T&) const;
+        template<typename HashTranslator, typename T> bool contains(const T& key) const { return lookup<HashTranslator>(key); }
+
+        void remove(KeyPeekInType key) { remove(find(key)); }
+        void remove(iterator it)
+        {
+            if (it == end())
+                return;
+            removeAt(it.m_iterator.m_position - m_table);
+        }
+        void remove(const_iterator it)
+        {
+            if (it == end())
+                return;
+            removeAt(it.m_position - m_table);
+        }
+        void clear();
+
+        ValueType* lookup(KeyPeekInType key) { return lookup<IdentityTranslatorType>(key); }
+        template<typename HashTranslator, typename T> ValueType* lookup(const T& key)
+        {
+            return const_cast<ValueType*>(const_cast<const GroupProbingHashTable*>(this)->lookup<HashTranslator>(key));
+        }
+        template<typename HashTranslator, typename T> const ValueType* lookup(const T&) const;
+
+#if ENABLE(ASSERT)
+        int64_t modifications() const { return m_modifications; }
+        void registerModification() { m_modifications++; }
+        void checkModifications(int64_t mods) const { ASSERT(mods == m_modifications); }
+#else
+        int64_t modifications() const { return 0; }
+        void registerModification() { }
+        void checkModifications(int64_t mods) const { }
+#endif
+
+        // The smallest capacity, which is also the number of slots
+        // add() allocates first.
+        static unsigned minimumCapacity()
+        {
+            unsigned capacity = HashTableControlGroup::width;
+            while (capacity < KeyTraits::minimumTableSize)
+                capacity *= 2;
+            return capacity;
+        }
+
+    private:
+        static ValueType* allocateTable(unsigned size, HashTableControlByte*& control);
+        static void deleteAllBucketsAndDeallocate(ValueType* table, HashTableControlByte* control, unsigned size);
+
+        template<typename HashTranslator, bool passHashCode, typename T, typename Extra> AddResult addWithHash(const T&, const Extra&, unsigned hash);
+        template<typename HashTranslator, typename T> const ValueType* lookupWithHash(const T&, unsigned hash) const;
+
+        // The low 7 bits of the hash go in the control byte, and the rest pick
+        // the group to start probing at.
+        static HashTableControlByte controlHash(unsigned hash) { return hash & 0x7F; }
+        size_t probeStart(unsigned hash) const { return (hash >> 7) & groupMask(); }
+        size_t groupMask() const
+        {
+            size_t groupCount = m_tableSize / HashTableControlGroup::width;
+            ASSERT(!(groupCount & (groupCount - 1)));
+            return groupCount - 1;
+        }
+
+        size_t findInsertIndex(unsigned hash) const;
+        void removeAt(size_t index);
+
+        // Deleted slots count towards the load: they lengthen probes just as
+        // full ones do. With at most 7/8 of the slots in use there's always
+        // an empty slot to end a probe at.
+        bool shouldExpand() const { return (m_keyCount + m_deletedCount + 1) * 8 > m_tableSize * 7; }
+        bool mustRehashInPlace() const { return m_keyCount * 16 < m_tableSize * 7; }
+        bool shouldShrink() const
+        {
+            return m_keyCount * m_minLoad < m_tableSize
+                && m_tableSize > minimumCapacity()
+                && Allocator::isAllocationAllowed();
+        }
+        void expand();
+        void shrink() { rehash(m_tableSize / 2); }
+        void rehash(unsigned newTableSize);
+
+        static void initializeBucket(ValueType& bucket);
+
+        iterator makeIterator(ValueType* pos) { return iterator(pos, m_table + m_tableSize, controlFor(pos), this); }
+        const_iterator makeConstIterator(ValueType* pos) const { return const_iterator(pos, m_table + m_tableSize, controlFor(pos), this); }
+        iterator makeKnownGoodIterator(ValueType* pos) { return iterator(pos, m_table + m_tableSize, controlFor(pos), this, HashItemKnownGood); }
+        const_iterator makeKnownGoodConstIterator(ValueType* pos) const { return const_iterator(pos, m_table + m_tableSize, controlFor(pos), this, HashItemKnownGood); }
+        const HashTableControlByte* controlFor(const ValueType* pos) const { return m_control + (pos - m_table); }
+
+        static const unsigned m_minLoad = 6;
+
+        // The backing holds the slots followed by their control bytes. Only
+        // full slots hold a constructed value.
+        ValueType* m_table;
+        HashTableControlByte* m_control;
+        unsigned m_tableSize;
+        unsigned m_keyCount;
+        unsigned m_deletedCount;
+#if ENABLE(ASSERT)
+        unsigned m_modifications;
+#endif
+    };
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    inline GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::GroupProbingHashTable()
+        : m_table(0)
+        , m_control(0)
+        , m_tableSize(0)
+        , m_keyCount(0)
+        , m_deletedCount(0)
+#if ENABLE(ASSERT)
+        , m_modifications(0)
+#endif
+    {
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    template<typename HashTranslator, typename T>
+    inline const Value* GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::lookup(const T& key) const
+    {
+        ASSERT((HashTableKeyChecker<HashTranslator, KeyTraits, HashFunctions::safeToCompareToEmptyOrDeleted>::checkKey(key)));
+        if (!m_table)
+            return 0;
+        return lookupWithHash<HashTranslator>(key, HashTranslator::hash(key));
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    template<typename HashTranslator, typename T>
+    ALWAYS_INLINE const Value* GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::lookupWithHash(const T& key, unsigned hash) const
+    {
+        ASSERT(m_table);
+        HashTableControlByte h2 = controlHash(hash);
+        size_t mask = groupMask();
+        size_t group = probeStart(hash);
+        // Triangular steps visit every group once when the group count is a
+        // power of two.
+        for (size_t step = 1; ; ++step) {
+            size_t first = group * HashTableControlGroup::width;
+            HashTableControlGroup controlGroup(m_control + first);
+            for (HashTableControlMask match = controlGroup.match(h2); !match.isEmpty(); match.removeLowest()) {
+                const ValueType* entry = m_table + first + match.lowestIndex();
+                if (HashTranslator::equal(Extractor::extract(*entry), key))
+                    return entry;
+            }
+            // Adds fill the first group with room on the probe sequence, so
+            // the key can't be any further along.
+            if (!controlGroup.matchEmpty().isEmpty())
+                return 0;
+            ASSERT(step <= mask);
+            group = (group + step) & mask;
+        }
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    size_t GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::findInsertIndex(unsigned hash) const
+    {
+        size_t mask = groupMask();
+        size_t group = probeStart(hash);
+        for (size_t step = 1; ; ++step) {
+            size_t first = group * HashTableControlGroup::width;
+            HashTableControlMask available = HashTableControlGroup(m_control + first).matchEmptyOrDeleted();
+            if (!available.isEmpty())
+                return first + available.lowestIndex();
+            ASSERT(step <= mask);
+            group = (group + step) & mask;
+        }
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    inline void GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::initializeBucket(ValueType& bucket)
+    {
+        // Translators assign to a bucket holding the empty value, as they do
+        // in HashTable.
+        HashTableBucketInitializer<Traits::emptyValueIsZero>::template initialize<Traits>(bucket);
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    template<typename HashTranslator, bool passHashCode, typename T, typename Extra>
+    typename GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::AddResult GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::addWithHash(const T& key, const Extra& extra, unsigned hash)
+    {
+        ASSERT(Allocator::isAllocationAllowed());
+        ASSERT((HashTableKeyChecker<HashTranslator, KeyTraits, HashFunctions::safeToCompareToEmptyOrDeleted>::checkKey(key)));
+        if (!m_table)
+            expand();
+
+        if (const ValueType* entry = lookupWithHash<HashTranslator>(key, hash))
+            return AddResult(this, const_cast<ValueType*>(entry), false);
+
+        registerModification();
+
+        // Grow before inserting, so the new entry never moves.
+        if (shouldExpand())
+            expand();
+
+        size_t index = findInsertIndex(hash);
+        if (m_control[index] == hashTableControlDeleted)
+            --m_deletedCount;
+        m_control[index] = controlHash(hash);
+
+        ValueType* entry = m_table + index;
+        initializeBucket(*entry);
+        GroupProbingHashTableTranslator<passHashCode>::template translate<HashTranslator>(*entry, key, extra, hash);
+        ++m_keyCount;
+
+        return AddResult(this, entry, true);
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    template <typename HashTranslator, typename T>
+    inline typename GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::iterator GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::find(const T& key)
+    {
+        ValueType* entry = lookup<HashTranslator>(key);
+        if (!entry)
+            return end();
+
+        return makeKnownGoodIterator(entry);
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    template <typename HashTranslator, typename T>
+    inline typename GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::const_iterator GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::find(const T& key) const
+    {
+        const ValueType* entry = lookup<HashTranslator>(key);
+        if (!entry)
+            return end();
+
+        return makeKnownGoodConstIterator(const_cast<ValueType*>(entry));
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    void GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::removeAt(size_t index)
+    {
+        ASSERT(index < m_tableSize);
+        ASSERT(m_control[index] >= 0);
+        registerModification();
+
+        m_table[index].~ValueType();
+        --m_keyCount;
+
+        // Probes stop at the first group with an empty slot. If this slot's
+        // group already has one, no probe goes past it and the slot can be
+        // empty again; otherwise it has to stay in the way as a tombstone.
+        size_t first = index & ~static_cast<size_t>(HashTableControlGroup::width - 1);
+        if (!HashTableControlGroup(m_control + first).matchEmpty().isEmpty()) {
+            m_control[index] = hashTableControlEmpty;
+        } else {
+            m_control[index] = hashTableControlDeleted;
+            ++m_deletedCount;
+        }
+
+        if (shouldShrink())
+            shrink();
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    Value* GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::allocateTable(unsigned size, HashTableControlByte*& control)
+    {
+        typedef typename Allocator::template HashTableBackingHelper<GroupProbingHashTable>::Type HashTableBacking;
+
+        ASSERT(size >= HashTableControlGroup::width);
+        ASSERT(!(size & (size - 1)));
+        RELEASE_ASSERT(size <= std::numeric_limits<size_t>::max() / (sizeof(ValueType) + 1));
+        ValueType* result = Allocator::template backingMalloc<ValueType*, HashTableBacking>(size * (sizeof(ValueType) + 1));
+        control = reinterpret_cast<HashTableControlByte*>(result + size);
+        memset(control, hashTableControlEmpty, size);
+        return result;
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    void GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::deleteAllBucketsAndDeallocate(ValueType* table, HashTableControlByte* control, unsigned size)
+    {
+        if (Traits::needsDestruction) {
+            for (unsigned i = 0; i < size; ++i) {
+                if (control[i] >= 0)
+                    table[i].~ValueType();
+            }
+        }
+        Allocator::backingFree(table);
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    void GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::expand()
+    {
+        unsigned newSize;
+        if (!m_tableSize) {
+            newSize = minimumCapacity();
+        } else if (mustRehashInPlace()) {
+            // Mostly tombstones: dropping them frees enough room.
+            newSize = m_tableSize;
+        } else {
+            newSize = m_tableSize * 2;
+            RELEASE_ASSERT(newSize > m_tableSize);
+        }
+
+        rehash(newSize);
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    void GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::rehash(unsigned newTableSize)
+    {
+        unsigned oldTableSize = m_tableSize;
+        ValueType* oldTable = m_table;
+        HashTableControlByte* oldControl = m_control;
+
+        registerModification();
+        m_table = allocateTable(newTableSize, m_control);
+        m_tableSize = newTableSize;
+        m_deletedCount = 0;
+
+        for (unsigned i = 0; i != oldTableSize; ++i) {
+            if (oldControl[i] < 0)
+                continue;
+
+            unsigned hash = HashFunctions::hash(Extractor::extract(oldTable[i]));
+            size_t index = findInsertIndex(hash);
+            m_control[index] = controlHash(hash);
+            initializeBucket(m_table[index]);
+            Mover<ValueType, Allocator, Traits::needsDestruction>::move(oldTable[i], m_table[index]);
+        }
+
+        if (oldTable)
+            deleteAllBucketsAndDeallocate(oldTable, oldControl, oldTableSize);
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    void GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::clear()
+    {
+        registerModification();
+        if (!m_table)
+            return;
+
+        deleteAllBucketsAndDeallocate(m_table, m_control, m_tableSize);
+        m_table = 0;
+        m_control = 0;
+        m_tableSize = 0;
+        m_keyCount = 0;
+        m_deletedCount = 0;
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::GroupProbingHashTable(const GroupProbingHashTable& other)
+        : m_table(0)
+        , m_control(0)
+        , m_tableSize(0)
+        , m_keyCount(0)
+        , m_deletedCount(0)
+#if ENABLE(ASSERT)
+        , m_modifications(0)
+#endif
+    {
+        const_iterator end = other.end();
+        for (const_iterator it = other.begin(); it != end; ++it)
+            add(*it);
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    void GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::swap(GroupProbingHashTable& other)
+    {
+        std::swap(m_table, other.m_table);
+        std::swap(m_control, other.m_control);
+        std::swap(m_tableSize, other.m_tableSize);
+        std::swap(m_keyCount, other.m_keyCount);
+        std::swap(m_deletedCount, other.m_deletedCount);
+#if ENABLE(ASSERT)
+        std::swap(m_modifications, other.m_modifications);
+#endif
+    }
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>& GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::operator=(const GroupProbingHashTable& other)
+    {
+        GroupProbingHashTable tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    // Picks the table HashMap and HashSet use for the given key traits.
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator, bool useGroupProbing = KeyTraits::useGroupProbing>
+    struct HashTableForTraits {
+        typedef HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> Type;
+    };
+
+    template<typename Key, typename Value, typename Extractor, typename HashFunctions, typename Traits, typename KeyTraits, typename Allocator>
+    struct HashTableForTraits<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator, true> {
+        typedef GroupProbingHashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator> Type;
+    };
+
+} // namespace WTF
+
+#endif  // SKY_ENGINE_WTF_GROUPPROBINGHASHTABLE_H_
@@ -0,0 +1,248 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+
+#include <gtest/gtest.h>
+#include "sky/engine/wtf/HashMap.h"
+#include "sky/engine/wtf/HashSet.h"
+#include "sky/engine/wtf/OwnPtr.h"
+#include "sky/engine/wtf/PassOwnPtr.h"
+#include "sky/engine/wtf/text/StringHash.h"
+#include "sky/engine/wtf/text/WTFString.h"
+
+namespace {
+
+typedef GroupProbingHashTraits<HashTraits<int> > IntTraits;
+typedef HashMap<int, int, DefaultHash<int>::Hash, IntTraits> IntHashMap;
+typedef HashSet<int, DefaultHash<int>::Hash, IntTraits> IntHashSet;
+
+// Puts every key in the same group, with the same control byte.
+struct CollidingIntHash : IntHash<unsigned> {
+    static unsigned hash(int) { return 42; }
+};
+
+typedef HashSet<int, CollidingIntHash, IntTraits> CollidingIntHashSet;
+
+TEST(GroupProbingHashTableTest, UsesGroupProbing)
+{
+    IntHashSet set;
+    EXPECT_EQ(0u, set.capacity());
+    set.add(1);
+    // The group probing table rounds the minimum size up to a whole group.
+    typedef WTF::GroupProbingHashTable<int, int, WTF::IdentityExtractor, IntHash<unsigned>, IntTraits, IntTraits, DefaultAllocator> TableType;
+    EXPECT_EQ(TableType::minimumCapacity(), set.capacity());
+}
+
+TEST(GroupProbingHashTableTest, AddFindRemove)
+{
+    IntHashMap map;
+    for (int i = 1; i <= 1000; ++i) {
+        IntHashMap::AddResult result = map.add(i, i * 2);
+        EXPECT_TRUE(result.isNewEntry);
+    }
+    EXPECT_EQ(1000u, map.size());
+    EXPECT_FALSE(map.add(500, 0).isNewEntry);
+    EXPECT_EQ(1000, map.get(500));
+
+    for (int i = 1; i <= 1000; ++i)
+        EXPECT_EQ(i * 2, map.get(i));
+    for (int i = 1001; i <= 2000; ++i)
+        EXPECT_FALSE(map.contains(i));
+
+    for (int i = 1; i <= 1000; i += 2)
+        map.remove(i);
+    EXPECT_EQ(500u, map.size());
+    for (int i = 1; i <= 1000; ++i)
+        EXPECT_EQ(i % 2 ? 0 : i * 2, map.get(i));
+
+    map.set(2, 7);
+    EXPECT_EQ(7, map.get(2));
+    EXPECT_EQ(7, map.take(2));
+    EXPECT_FALSE(map.contains(2));
+    EXPECT_EQ(499u, map.size());
+}
+
+TEST(GroupProbingHashTableTest, Iteration)
+{
+    IntHashSet set;
+    for (int i = 1; i <= 100; ++i)
+        set.add(i);
+    set.remove(50);
+
+    int count = 0;
+    int sum = 0;
+    for (IntHashSet::iterator it = set.begin(); it != set.end(); ++it) {
+        ++count;
+        sum += *it;
+    }
+    EXPECT_EQ(99, count);
+    EXPECT_EQ(5050 - 50, sum);
+
+    IntHashSet empty;
+    EXPECT_TRUE(empty.begin() == empty.end());
+}
+
+TEST(GroupProbingHashTableTest, IteratorComparison)
+{
+    IntHashMap map;
+    map.add(1, 2);
+    EXPECT_TRUE(map.begin() != map.end());
+
+    IntHashMap::const_iterator begin = map.begin();
+    EXPECT_TRUE(begin == map.begin());
+    EXPECT_TRUE(map.begin() == begin);
+    EXPECT_TRUE(begin != map.end());
+    EXPECT_TRUE(map.find(1) == begin);
+    EXPECT_TRUE(map.find(2) == map.end());
+}
+
+TEST(GroupProbingHashTableTest, Collisions)
+{
+    // With every key hashing alike, lookups have to probe past full groups
+    // and tombstones.
+    CollidingIntHashSet set;
+    for (int i = 1; i <= 100; ++i)
+        set.add(i);
+    for (int i = 1; i <= 100; ++i)
+        EXPECT_TRUE(set.contains(i));
+    EXPECT_FALSE(set.contains(101));
+
+    for (int i = 1; i <= 100; i += 3)
+        set.remove(i);
+    for (int i = 1; i <= 100; ++i)
+        EXPECT_EQ(!!((i - 1) % 3), set.contains(i));
+
+    for (int i = 1; i <= 100; i += 3)
+        EXPECT_TRUE(set.add(i).isNewEntry);
+    EXPECT_EQ(100u, set.size());
+}
+
+TEST(GroupProbingHashTableTest, TombstonesDoNotGrowTheTable)
+{
+    IntHashSet set;
+    for (int i = 1; i <= 4; ++i)
+        set.add(i);
+    for (int i = 5; i <= 1000; ++i) {
+        set.add(i);
+        set.remove(i - 4);
+    }
+    unsigned capacity = set.capacity();
+
+    // Churning through keys leaves tombstones behind. Rehashing drops them
+    // rather than growing the table.
+    for (int i = 1001; i <= 10000; ++i) {
+        set.add(i);
+        set.remove(i - 4);
+    }
+    EXPECT_EQ(4u, set.size());
+    EXPECT_EQ(capacity, set.capacity());
+    for (int i = 10000 - 3; i <= 10000; ++i)
+        EXPECT_TRUE(set.contains(i));
+}
+
+TEST(GroupProbingHashTableTest, Shrink)
+{
+    IntHashSet set;
+    for (int i = 1; i <= 1000; ++i)
+        set.add(i);
+    unsigned capacity = set.capacity();
+    for (int i = 1; i <= 990; ++i)
+        set.remove(i);
+    EXPECT_LT(set.capacity(), capacity);
+    for (int i = 991; i <= 1000; ++i)
+        EXPECT_TRUE(set.contains(i));
+
+    set.clear();
+    EXPECT_TRUE(set.isEmpty());
+    EXPECT_EQ(0u, set.capacity());
+    EXPECT_FALSE(set.contains(991));
+}
+
+TEST(GroupProbingHashTableTest, CopyAndSwap)
+{
+    IntHashMap map;
+    for (int i = 1; i <= 100; ++i)
+        map.add(i, -i);
+
+    IntHashMap copy(map);
+    EXPECT_EQ(100u, copy.size());
+    EXPECT_TRUE(copy == map);
+
+    IntHashMap other;
+    other.add(1000, 1);
+    other.swap(copy);
+    EXPECT_EQ(100u, other.size());
+    EXPECT_EQ(-50, other.get(50));
+    EXPECT_EQ(1u, copy.size());
+    EXPECT_EQ(1, copy.get(1000));
+
+    copy = map;
+    EXPECT_TRUE(copy == map);
+}
+
+class DestructCounter {
+public:
+    explicit DestructCounter(int i, int* destructNumber)
+        : m_i(i)
+        , m_destructNumber(destructNumber)
+    { }
+
+    ~DestructCounter() { ++(*m_destructNumber); }
+    int get() const { return m_i; }
+
+private:
+    int m_i;
+    int* m_destructNumber;
+};
+
+typedef HashMap<int, OwnPtr<DestructCounter>, DefaultHash<int>::Hash, IntTraits> OwnPtrHashMap;
+
+TEST(GroupProbingHashTableTest, OwnPtrAsValue)
+{
+    int destructNumber = 0;
+    {
+        OwnPtrHashMap map;
+        for (int i = 1; i <= 100; ++i)
+            map.add(i, adoptPtr(new DestructCounter(i, &destructNumber)));
+        // Growing the table moves the values without destroying them.
+        EXPECT_EQ(0, destructNumber);
+        EXPECT_EQ(42, map.get(42)->get());
+
+        map.remove(42);
+        EXPECT_EQ(1, destructNumber);
+
+        OwnPtr<DestructCounter> taken = map.take(43);
+        EXPECT_EQ(43, taken->get());
+        EXPECT_EQ(1, destructNumber);
+    }
+    EXPECT_EQ(100, destructNumber);
+}
+
+typedef HashSet<String, StringHash, GroupProbingHashTraits<HashTraits<String> > > StringHashSet;
+
+struct CStringTranslator {
+    static unsigned hash(const char* key) { return StringHash::hash(String(key)); }
+    static bool equal(const String& a, const char* b) { return a == b; }
+    static void translate(String& location, const char* key, unsigned) { location = String(key); }
+};
+
+TEST(GroupProbingHashTableTest, StringKeys)
+{
+    StringHashSet set;
+    for (int i = 0; i < 200; ++i)
+        set.add(String::number(i));
+    for (int i = 0; i < 200; ++i)
+        EXPECT_TRUE(set.contains(String::number(i)));
+    EXPECT_FALSE(set.contains("200"));
+
+    // Adding and looking up by another type goes through a translator.
+    EXPECT_TRUE(set.add<CStringTranslator>("div").isNewEntry);
+    EXPECT_FALSE(set.add<CStringTranslator>("div").isNewEntry);
+    EXPECT_TRUE(set.contains<CStringTranslator>("div"));
+    EXPECT_FALSE(set.contains<CStringTranslator>("span"));
+    EXPECT_TRUE(set.contains("div"));
+}
+
+} // namespace
@@ -22,7 +22,7 @@
 #define SKY_ENGINE_WTF_HASHMAP_H_
 
 #include "sky/engine/wtf/DefaultAllocator.h"
-#include "sky/engine/wtf/HashTable.h"
+#include "sky/engine/wtf/GroupProbingHashTable.h"
 
 namespace WTF {
 
@@ -72,8 +72,8 @@ namespace WTF {
 
         typedef HashArg HashFunctions;
 
-        typedef HashTable<KeyType, ValueType, KeyValuePairKeyExtractor,
-            HashFunctions, ValueTraits, KeyTraits, Allocator> HashTableType;
+        typedef typename HashTableForTraits<KeyType, ValueType, KeyValuePairKeyExtractor,
+            HashFunctions, ValueTraits, KeyTraits, Allocator>::Type HashTableType;
 
         class HashMapKeysProxy;
         class HashMapValuesProxy;
@@ -22,7 +22,7 @@
 #define SKY_ENGINE_WTF_HASHSET_H_
 
 #include "sky/engine/wtf/DefaultAllocator.h"
-#include "sky/engine/wtf/HashTable.h"
+#include "sky/engine/wtf/GroupProbingHashTable.h"
 
 namespace WTF {
 
@@ -47,8 +47,8 @@ namespace WTF {
         typedef typename ValueTraits::TraitType ValueType;
 
     private:
-        typedef HashTable<ValueType, ValueType, IdentityExtractor,
-            HashFunctions, ValueTraits, ValueTraits, Allocator> HashTableType;
+        typedef typename HashTableForTraits<ValueType, ValueType, IdentityExtractor,
+            HashFunctions, ValueTraits, ValueTraits, Allocator>::Type HashTableType;
 
     public:
         typedef HashTableConstIteratorAdapter<HashTableType, ValueTraits> iterator;
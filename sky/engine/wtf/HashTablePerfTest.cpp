@@ -0,0 +1,131 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+
+#include <gtest/gtest.h>
+#include "base/time/time.h"
+#include "sky/engine/wtf/HashMap.h"
+#include "sky/engine/wtf/HashSet.h"
+#include "sky/engine/wtf/Vector.h"
+#include "sky/engine/wtf/text/StringHash.h"
+#include "sky/engine/wtf/text/WTFString.h"
+#include "testing/perf/perf_test.h"
+
+namespace {
+
+// Each measurement does about this many operations.
+static const int kOperations = 2000000;
+
+typedef HashMap<int, int> IntMap;
+typedef HashMap<int, int, DefaultHash<int>::Hash, GroupProbingHashTraits<HashTraits<int> > > GroupProbingIntMap;
+typedef HashSet<String> StringSet;
+typedef HashSet<String, StringHash, GroupProbingHashTraits<HashTraits<String> > > GroupProbingStringSet;
+
+// Returns operations per millisecond.
+static double perMs(size_t operations, base::TimeTicks start)
+{
+    return operations / (base::TimeTicks::Now() - start).InMillisecondsF();
+}
+
+static const char* tableName(bool groupProbing)
+{
+    return groupProbing ? "group_probing" : "hash_table";
+}
+
+template<typename Map>
+static void measureIntMap(const char* size, int keyCount, bool groupProbing)
+{
+    // Spread the keys out, the way pointers and ids are. The keys present
+    // are odd and the missing ones even.
+    Vector<int> keys;
+    Vector<int> missingKeys;
+    for (int i = 1; i <= keyCount; ++i) {
+        int key = static_cast<int>((i * 2654435761u) >> 3) * 2;
+        keys.append(key + 1);
+        missingKeys.append(key + 2);
+    }
+
+    int rounds = kOperations / keyCount;
+    int checksum = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int round = 0; round < rounds; ++round) {
+        Map map;
+        for (int i = 0; i < keyCount; ++i)
+            map.add(keys[i], i);
+        checksum += map.size();
+    }
+    perf_test::PrintResult("hash_table_int_insert", size, tableName(groupProbing), perMs(rounds * keyCount, start), "inserts/ms", true);
+
+    Map map;
+    for (int i = 0; i < keyCount; ++i)
+        map.add(keys[i], i);
+
+    start = base::TimeTicks::Now();
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 0; i < keyCount; ++i)
+            checksum += map.get(keys[i]);
+    }
+    perf_test::PrintResult("hash_table_int_hit", size, tableName(groupProbing), perMs(rounds * keyCount, start), "lookups/ms", true);
+
+    start = base::TimeTicks::Now();
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 0; i < keyCount; ++i)
+            checksum += map.contains(missingKeys[i]);
+    }
+    perf_test::PrintResult("hash_table_int_miss", size, tableName(groupProbing), perMs(rounds * keyCount, start), "lookups/ms", true);
+
+    EXPECT_NE(0, checksum);
+}
+
+template<typename Set>
+static void measureStringSet(const char* size, int keyCount, bool groupProbing)
+{
+    Vector<String> keys;
+    Vector<String> missingKeys;
+    for (int i = 0; i < keyCount; ++i) {
+        keys.append(String("element-" + String::number(i)));
+        missingKeys.append(String("attribute-" + String::number(i)));
+    }
+
+    int rounds = kOperations / keyCount;
+    int checksum = 0;
+    Set set;
+    for (int i = 0; i < keyCount; ++i)
+        set.add(keys[i]);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 0; i < keyCount; ++i)
+            checksum += set.contains(keys[i]);
+    }
+    perf_test::PrintResult("hash_table_string_hit", size, tableName(groupProbing), perMs(rounds * keyCount, start), "lookups/ms", true);
+
+    start = base::TimeTicks::Now();
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 0; i < keyCount; ++i)
+            checksum += set.contains(missingKeys[i]);
+    }
+    perf_test::PrintResult("hash_table_string_miss", size, tableName(groupProbing), perMs(rounds * keyCount, start), "lookups/ms", true);
+
+    EXPECT_EQ(rounds * keyCount, checksum);
+}
+
+TEST(HashTablePerfTest, IntKeys)
+{
+    measureIntMap<IntMap>("_small", 100, false);
+    measureIntMap<GroupProbingIntMap>("_small", 100, true);
+    measureIntMap<IntMap>("_large", 1000000, false);
+    measureIntMap<GroupProbingIntMap>("_large", 1000000, true);
+}
+
+TEST(HashTablePerfTest, StringKeys)
+{
+    measureStringSet<StringSet>("_small", 100, false);
+    measureStringSet<GroupProbingStringSet>("_small", 100, true);
+    measureStringSet<StringSet>("_large", 100000, false);
+    measureStringSet<GroupProbingStringSet>("_large", 100000, true);
+}
+
+} // namespace
@@ -65,6 +65,10 @@ namespace WTF {
         static const unsigned minimumTableSize = 8;
 #endif
         static const WeakHandlingFlag weakHandlingFlag = IsWeak<T>::value ? WeakHandlingInCollections : NoWeakHandlingInCollections;
+
+        // The useGroupProbing flag makes HashMap and HashSet keep these keys
+        // in a GroupProbingHashTable instead of a HashTable.
+        static const bool useGroupProbing = false;
     };
 
     // Default integer traits disallow both 0 and -1 as keys (max value instead of -1 for unsigned).
@@ -303,6 +307,14 @@ namespace WTF {
         static T emptyValue() { return reinterpret_cast<T>(1); }
     };
 
+    // Use these traits for keys that are mostly looked up, especially ones
+    // that are often missing: their tables probe a group of slots at a time,
+    // by hash bits, rather than comparing keys slot by slot.
+    template<typename Traits>
+    struct GroupProbingHashTraits : Traits {
+        static const bool useGroupProbing = true;
+    };
+
     // This is for tracing inside collections that have special support for weak
     // pointers. The trait has a trace method which returns true if there are weak
     // pointers to things that have not (yet) been marked live. Returning true
@@ -315,6 +327,7 @@ namespace WTF {
 
 } // namespace WTF
 
+using WTF::GroupProbingHashTraits;
 using WTF::HashTraits;
 using WTF::PairHashTraits;
 using WTF::NullableHashTraits;
@@ -33,6 +33,10 @@
 
 #include <string.h>
 
+#if ENABLE(PARTITION_THREAD_CACHE)
+#include <stdlib.h>
+#endif
+
 #ifndef NDEBUG
 #include <stdio.h>
 #endif
@@ -60,6 +64,17 @@ bool PartitionRootBase::gInitialized = false;
 PartitionPage PartitionRootBase::gSeedPage;
 PartitionBucket PartitionRootBase::gPagedBucket;
 
+#if ENABLE(PARTITION_THREAD_CACHE)
+pthread_key_t PartitionRootGeneric::gThreadCacheKey;
+PartitionRootGeneric* PartitionRootGeneric::gThreadCacheRoots[kMaxThreadCachedPartitions];
+unsigned PartitionRootGeneric::gThreadCacheGeneration = 0;
+static bool gThreadCacheKeyCreated = false;
+// Stands in for a thread's caches once its thread exit callback has run. All
+// of its entries are null, so partitionThreadCacheGet() falls through to
+// partitionThreadCacheCreate(), which declines to create a cache.
+static PartitionThreadCache* gThreadCachesTornDown[kMaxThreadCachedPartitions];
+#endif
+
 static size_t partitionBucketNumSystemPages(size_t size)
 {
     // This works out reasonably for the current bucket sizes of the generic
@@ -157,6 +172,8 @@ void partitionAllocGenericInit(PartitionRootGeneric* root)
     parititonAllocBaseInit(root);
 
     root->lock = 0;
+    root->threadCacheIndex = -1;
+    root->threadCacheGeneration = 0;
 
     // Precalculate some shift and mask constants used in the hot path.
     // Example: malloc(41) == 101001 binary.
@@ -288,6 +305,17 @@ bool partitionAllocShutdown(PartitionRoot* root)
 
 bool partitionAllocGenericShutdown(PartitionRootGeneric* root)
 {
+#if ENABLE(PARTITION_THREAD_CACHE)
+    // Slots still cached by other threads show up as leaks.
+    if (root->threadCacheIndex >= 0) {
+        partitionAllocGenericFlushThreadCache(root);
+        spinLockLock(&PartitionRootBase::gInitializedLock);
+        PartitionRootGeneric::gThreadCacheRoots[root->threadCacheIndex] = 0;
+        spinLockUnlock(&PartitionRootBase::gInitializedLock);
+        root->threadCacheIndex = -1;
+    }
+#endif
+
     bool noLeaks = true;
     size_t i;
     for (i = 0; i < kGenericNumBucketedOrders * kGenericNumBucketsPerOrder; ++i) {
@@ -921,6 +949,239 @@ void* partitionReallocGeneric(PartitionRootGeneric* root, void* ptr, size_t newS
 #endif
 }
 
+#if ENABLE(PARTITION_THREAD_CACHE)
+
+static PartitionThreadCache** partitionThreadCaches()
+{
+    return static_cast<PartitionThreadCache**>(pthread_getspecific(PartitionRootGeneric::gThreadCacheKey));
+}
+
+// Gives the oldest |count| slots cached in |cacheBucket| back to the
+// partition. The newest ones are the likeliest to still be in the CPU cache.
+static void partitionThreadCacheReleaseSlots(PartitionRootGeneric* root, PartitionThreadCache* cache, PartitionThreadCacheBucket* cacheBucket, size_t count)
+{
+    ASSERT(count <= cacheBucket->numSlots);
+    if (!count)
+        return;
+
+    size_t numKeptSlots = cacheBucket->numSlots - count;
+    PartitionFreelistEntry* lastKept = 0;
+    PartitionFreelistEntry* entry = cacheBucket->freelistHead;
+    for (size_t i = 0; i < numKeptSlots; ++i) {
+        lastKept = entry;
+        entry = partitionFreelistMask(entry->next);
+    }
+    if (lastKept)
+        lastKept->next = partitionFreelistMask(0);
+    else
+        cacheBucket->freelistHead = 0;
+
+    spinLockLock(&root->lock);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT(entry);
+        PartitionFreelistEntry* next = partitionFreelistMask(entry->next);
+        partitionFreeSlot(entry, partitionPointerToPage(entry));
+        entry = next;
+    }
+    spinLockUnlock(&root->lock);
+    ASSERT(!entry);
+
+    cacheBucket->numSlots = static_cast<uint16_t>(numKeptSlots);
+    if (cacheBucket->lowWaterMark > numKeptSlots)
+        cacheBucket->lowWaterMark = cacheBucket->numSlots;
+    cache->numBytes -= count * root->buckets[cacheBucket - cache->buckets].slotSize;
+}
+
+static void partitionThreadCacheReleaseAll(PartitionRootGeneric* root, PartitionThreadCache* cache)
+{
+    for (size_t i = 0; i < kGenericNumBucketedOrders * kGenericNumBucketsPerOrder; ++i) {
+        PartitionThreadCacheBucket* cacheBucket = &cache->buckets[i];
+        partitionThreadCacheReleaseSlots(root, cache, cacheBucket, cacheBucket->numSlots);
+    }
+    ASSERT(!cache->numBytes);
+}
+
+static void partitionThreadCacheScavenge(PartitionRootGeneric* root, PartitionThreadCache* cache)
+{
+    // Half of what a bucket didn't need since the last scavenge goes back,
+    // rounding up so that an unused bucket drains to nothing.
+    for (size_t i = 0; i < kGenericNumBucketedOrders * kGenericNumBucketsPerOrder; ++i) {
+        PartitionThreadCacheBucket* cacheBucket = &cache->buckets[i];
+        partitionThreadCacheReleaseSlots(root, cache, cacheBucket, (cacheBucket->lowWaterMark + 1) / 2);
+        cacheBucket->lowWaterMark = cacheBucket->numSlots;
+    }
+    // If every bucket is busy the cache can still be over budget. Start over.
+    if (cache->numBytes > kThreadCacheMaxBytes)
+        partitionThreadCacheReleaseAll(root, cache);
+    cache->freesUntilScavenge = kThreadCacheScavengeInterval;
+}
+
+// Gives the slots in |caches| back to their partitions.
+static void partitionThreadCachesReleaseAll(PartitionThreadCache** caches)
+{
+    for (size_t i = 0; i < kMaxThreadCachedPartitions; ++i) {
+        PartitionThreadCache* cache = caches[i];
+        if (!cache || !cache->numBytes)
+            continue;
+        // Holding the lock keeps the partition from being shut down under us.
+        spinLockLock(&PartitionRootBase::gInitializedLock);
+        PartitionRootGeneric* root = PartitionRootGeneric::gThreadCacheRoots[i];
+        if (root && root->threadCacheGeneration == cache->generation)
+            partitionThreadCacheReleaseAll(root, cache);
+        spinLockUnlock(&PartitionRootBase::gInitializedLock);
+    }
+}
+
+// Thread exit callback for PartitionRootGeneric::gThreadCacheKey.
+static void partitionThreadCacheDestroy(void* value)
+{
+    PartitionThreadCache** caches = static_cast<PartitionThreadCache**>(value);
+    if (caches != gThreadCachesTornDown) {
+        partitionThreadCachesReleaseAll(caches);
+        for (size_t i = 0; i < kMaxThreadCachedPartitions; ++i)
+            free(caches[i]);
+        free(caches);
+    }
+    // Other thread exit callbacks can still free memory after this one. Their
+    // frees go straight to the partition, instead of creating a new cache
+    // that nothing would flush. Setting the key makes pthreads run this
+    // callback again on its next pass, which keeps the marker in place.
+    pthread_setspecific(PartitionRootGeneric::gThreadCacheKey, gThreadCachesTornDown);
+}
+
+#endif // ENABLE(PARTITION_THREAD_CACHE)
+
+void partitionAllocGenericEnableThreadCache(PartitionRootGeneric* root)
+{
+#if ENABLE(PARTITION_THREAD_CACHE)
+    ASSERT(root->initialized);
+    ASSERT(root->threadCacheIndex < 0);
+    spinLockLock(&PartitionRootBase::gInitializedLock);
+    if (!gThreadCacheKeyCreated)
+        gThreadCacheKeyCreated = !pthread_key_create(&PartitionRootGeneric::gThreadCacheKey, partitionThreadCacheDestroy);
+    for (size_t i = 0; gThreadCacheKeyCreated && i < kMaxThreadCachedPartitions; ++i) {
+        if (PartitionRootGeneric::gThreadCacheRoots[i])
+            continue;
+        PartitionRootGeneric::gThreadCacheRoots[i] = root;
+        root->threadCacheGeneration = ++PartitionRootGeneric::gThreadCacheGeneration;
+        root->threadCacheIndex = static_cast<int>(i);
+        break;
+    }
+    spinLockUnlock(&PartitionRootBase::gInitializedLock);
+#endif
+}
+
+void partitionAllocGenericFlushThreadCache(PartitionRootGeneric* root)
+{
+#if ENABLE(PARTITION_THREAD_CACHE)
+    if (root->threadCacheIndex < 0)
+        return;
+    PartitionThreadCache** caches = partitionThreadCaches();
+    if (!caches)
+        return;
+    PartitionThreadCache* cache = caches[root->threadCacheIndex];
+    if (cache && cache->generation == root->threadCacheGeneration)
+        partitionThreadCacheReleaseAll(root, cache);
+#endif
+}
+
+void partitionAllocFlushThreadCaches()
+{
+#if ENABLE(PARTITION_THREAD_CACHE)
+    if (!gThreadCacheKeyCreated)
+        return;
+    if (PartitionThreadCache** caches = partitionThreadCaches())
+        partitionThreadCachesReleaseAll(caches);
+#endif
+}
+
+#if ENABLE(PARTITION_THREAD_CACHE)
+
+PartitionThreadCache* partitionThreadCacheCreate(PartitionRootGeneric* root)
+{
+    ASSERT(root->threadCacheIndex >= 0);
+    // The caches come from the system allocator rather than a partition: they
+    // can outlive the partitions they cache for, and creating one mustn't
+    // recurse into the partition it's for.
+    PartitionThreadCache** caches = partitionThreadCaches();
+    if (caches == gThreadCachesTornDown)
+        return 0;
+    if (!caches) {
+        caches = static_cast<PartitionThreadCache**>(calloc(kMaxThreadCachedPartitions, sizeof(PartitionThreadCache*)));
+        if (!caches)
+            return 0;
+        if (pthread_setspecific(PartitionRootGeneric::gThreadCacheKey, caches)) {
+            free(caches);
+            return 0;
+        }
+    }
+
+    PartitionThreadCache* cache = caches[root->threadCacheIndex];
+    if (!cache) {
+        cache = static_cast<PartitionThreadCache*>(malloc(sizeof(PartitionThreadCache)));
+        if (!cache)
+            return 0;
+        caches[root->threadCacheIndex] = cache;
+    }
+    // A cache left over from an earlier partition with the same index holds
+    // slots from pages that are gone by now. Forget them.
+    memset(cache, 0, sizeof(PartitionThreadCache));
+    cache->generation = root->threadCacheGeneration;
+    cache->freesUntilScavenge = kThreadCacheScavengeInterval;
+    for (size_t i = 0; i < kGenericNumBucketedOrders * kGenericNumBucketsPerOrder; ++i) {
+        size_t slotSize = root->buckets[i].slotSize;
+        size_t maxSlots = kThreadCacheMaxBucketBytes / slotSize;
+        if (maxSlots < kThreadCacheMinBucketSlots)
+            maxSlots = kThreadCacheMinBucketSlots;
+        else if (maxSlots > kThreadCacheMaxBucketSlots)
+            maxSlots = kThreadCacheMaxBucketSlots;
+        cache->buckets[i].maxSlots = static_cast<uint16_t>(maxSlots);
+    }
+    return cache;
+}
+
+void* partitionThreadCacheRefill(PartitionRootGeneric* root, PartitionThreadCache* cache, int flags, PartitionBucket* bucket)
+{
+    PartitionThreadCacheBucket* cacheBucket = partitionThreadCacheBucket(root, cache, bucket);
+    ASSERT(!cacheBucket->freelistHead);
+    ASSERT(!cacheBucket->numSlots);
+
+    spinLockLock(&root->lock);
+    void* ret = partitionBucketAllocSlot(root, flags, bucket->slotSize, bucket);
+    // While we hold the lock, take up to half a bucket's worth more from the
+    // active page, so the next few allocations don't need the lock. Slots
+    // the page hasn't provisioned yet are left alone.
+    if (ret) {
+        PartitionPage* page = bucket->activePagesHead;
+        size_t numSlots = cacheBucket->maxSlots / 2;
+        while (cacheBucket->numSlots < numSlots && page->freelistHead) {
+            PartitionFreelistEntry* entry = page->freelistHead;
+            ASSERT(partitionPointerIsValid(entry));
+            page->freelistHead = partitionFreelistMask(entry->next);
+            page->numAllocatedSlots++;
+            entry->next = partitionFreelistMask(cacheBucket->freelistHead);
+            cacheBucket->freelistHead = entry;
+            ++cacheBucket->numSlots;
+        }
+    }
+    spinLockUnlock(&root->lock);
+
+    cache->numBytes += cacheBucket->numSlots * bucket->slotSize;
+    return ret;
+}
+
+void partitionThreadCacheFreeSlowPath(PartitionRootGeneric* root, PartitionThreadCache* cache, PartitionThreadCacheBucket* cacheBucket)
+{
+    // A full bucket goes down to half, so that a run of frees doesn't come
+    // straight back here.
+    if (cacheBucket->numSlots > cacheBucket->maxSlots)
+        partitionThreadCacheReleaseSlots(root, cache, cacheBucket, cacheBucket->numSlots - cacheBucket->maxSlots / 2);
+    if (!cache->freesUntilScavenge || cache->numBytes > kThreadCacheMaxBytes)
+        partitionThreadCacheScavenge(root, cache);
+}
+
+#endif // ENABLE(PARTITION_THREAD_CACHE)
+
 #ifndef NDEBUG
 
 void partitionDumpStats(const PartitionRoot& root)
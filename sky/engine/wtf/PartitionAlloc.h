@@ -73,6 +73,8 @@
 // metadata structure which allows fast mapping of free() address to an
 // underlying bucket.
 // - Supports a lock-free API for fast performance in single-threaded cases.
+// - Generic partitions can put a small per-thread cache in front of their
+// lock, so threads allocating at the same time don't contend for it.
 // - The freelist for a given bucket is split across a number of partition
 // pages, enabling various simple tricks to try and minimize fragmentation.
 // - Fine-grained bucket sizes leading to less waste and better packing.
@@ -109,6 +111,13 @@
 #include <stdlib.h>
 #endif
 
+#if USE(PTHREADS) && !defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
+#define ENABLE_PARTITION_THREAD_CACHE 1
+#include <pthread.h>
+#else
+#define ENABLE_PARTITION_THREAD_CACHE 0
+#endif
+
 #if ENABLE(ASSERT)
 #include <string.h>
 #endif
@@ -198,6 +207,22 @@ static const uint32_t kCookieValue = 0xDEADBEEFu;
 static const size_t kCookieSize = 16; // Handles alignment up to XMM instructions on Intel.
 #endif
 
+// Constants for the per-thread caches of generic partitions. A thread caches
+// at most kThreadCacheMaxBucketBytes of a bucket's slots (but no fewer than
+// kThreadCacheMinBucketSlots and no more than kThreadCacheMaxBucketSlots),
+// and at most kThreadCacheMaxBytes in all. Every kThreadCacheScavengeInterval
+// of its own frees, it gives back about half of the slots it didn't need since
+// the last time. Scavenging only happens on the owning thread's frees, so a
+// thread that stops freeing keeps its cache until it calls
+// partitionAllocFlushThreadCaches() or exits.
+static const size_t kMaxThreadCachedPartitions = 4;
+static const size_t kThreadCacheMaxSlotSize = 4096; // Larger slots always take the lock.
+static const size_t kThreadCacheMaxBucketBytes = 32 * 1024;
+static const size_t kThreadCacheMinBucketSlots = 4;
+static const size_t kThreadCacheMaxBucketSlots = 128;
+static const size_t kThreadCacheMaxBytes = 256 * 1024;
+static const unsigned kThreadCacheScavengeInterval = 8192;
+
 struct PartitionBucket;
 struct PartitionRootBase;
 
@@ -282,8 +307,13 @@ struct PartitionRoot : public PartitionRootBase {
 };
 
 // Never instantiate a PartitionRootGeneric directly, instead use PartitionAllocatorGeneric.
-struct PartitionRootGeneric : public PartitionRootBase {
+struct WTF_EXPORT PartitionRootGeneric : public PartitionRootBase {
     int lock;
+    // Index into each thread's caches, or -1 if the partition has none.
+    int threadCacheIndex;
+    // Tells a thread's cache for this partition from one left over from an
+    // earlier partition that had the same index.
+    unsigned threadCacheGeneration;
     // Some pre-computed constants.
     size_t orderIndexShifts[kBitsPerSizet + 1];
     size_t orderSubIndexMasks[kBitsPerSizet + 1];
@@ -293,6 +323,32 @@ struct PartitionRootGeneric : public PartitionRootBase {
     // need to index array[blah][max+1] which risks undefined behavior.
     PartitionBucket* bucketLookups[((kBitsPerSizet + 1) * kGenericNumBucketsPerOrder) + 1];
     PartitionBucket buckets[kGenericNumBucketedOrders * kGenericNumBucketsPerOrder];
+
+#if ENABLE(PARTITION_THREAD_CACHE)
+    // Points at an array of kMaxThreadCachedPartitions PartitionThreadCache
+    // pointers, one array per thread.
+    static pthread_key_t gThreadCacheKey;
+    static PartitionRootGeneric* gThreadCacheRoots[kMaxThreadCachedPartitions];
+    static unsigned gThreadCacheGeneration;
+#endif
+};
+
+// A thread's cache of free slots for one generic partition. The slots are
+// allocated as far as the partition is concerned, so only the owning thread
+// touches them and no lock is needed. A bucket's freelist is a LIFO, masked
+// like the freelists of partition pages.
+struct PartitionThreadCacheBucket {
+    PartitionFreelistEntry* freelistHead;
+    uint16_t numSlots;
+    uint16_t maxSlots;
+    uint16_t lowWaterMark; // Fewest slots cached since the last scavenge.
+};
+
+struct PartitionThreadCache {
+    unsigned generation;
+    unsigned freesUntilScavenge;
+    size_t numBytes;
+    PartitionThreadCacheBucket buckets[kGenericNumBucketedOrders * kGenericNumBucketsPerOrder];
 };
 
 // Flags for partitionAllocGenericFlags.
@@ -304,10 +360,24 @@ WTF_EXPORT void partitionAllocInit(PartitionRoot*, size_t numBuckets, size_t max
 WTF_EXPORT bool partitionAllocShutdown(PartitionRoot*);
 WTF_EXPORT void partitionAllocGenericInit(PartitionRootGeneric*);
 WTF_EXPORT bool partitionAllocGenericShutdown(PartitionRootGeneric*);
+// Puts per-thread caches in front of an initialized generic partition. Only
+// kMaxThreadCachedPartitions partitions can have them at once; past that the
+// partition keeps taking its lock for every allocation.
+WTF_EXPORT void partitionAllocGenericEnableThreadCache(PartitionRootGeneric*);
+// Gives the calling thread's cached slots back to the partition. Threads do
+// this on exit, and shutting a partition down does it for the calling thread.
+WTF_EXPORT void partitionAllocGenericFlushThreadCache(PartitionRootGeneric*);
+// Gives the calling thread's cached slots back to every partition. Long-lived
+// worker threads call this when they run out of work, so that an idle worker
+// doesn't hold on to memory it may never need again.
+WTF_EXPORT void partitionAllocFlushThreadCaches();
 
 WTF_EXPORT NEVER_INLINE void* partitionAllocSlowPath(PartitionRootBase*, int, size_t, PartitionBucket*);
 WTF_EXPORT NEVER_INLINE void partitionFreeSlowPath(PartitionPage*);
 WTF_EXPORT NEVER_INLINE void* partitionReallocGeneric(PartitionRootGeneric*, void*, size_t);
+WTF_EXPORT NEVER_INLINE PartitionThreadCache* partitionThreadCacheCreate(PartitionRootGeneric*);
+WTF_EXPORT NEVER_INLINE void* partitionThreadCacheRefill(PartitionRootGeneric*, PartitionThreadCache*, int, PartitionBucket*);
+WTF_EXPORT NEVER_INLINE void partitionThreadCacheFreeSlowPath(PartitionRootGeneric*, PartitionThreadCache*, PartitionThreadCacheBucket*);
 
 #ifndef NDEBUG
 WTF_EXPORT void partitionDumpStats(const PartitionRoot&);
@@ -438,7 +508,8 @@ ALWAYS_INLINE bool partitionPointerIsValid(void* ptr)
     return root->invertedSelf == ~reinterpret_cast<uintptr_t>(root);
 }
 
-ALWAYS_INLINE void* partitionBucketAlloc(PartitionRootBase* root, int flags, size_t size, PartitionBucket* bucket)
+// Takes a slot from the bucket without preparing it for the caller.
+ALWAYS_INLINE void* partitionBucketAllocSlot(PartitionRootBase* root, int flags, size_t size, PartitionBucket* bucket)
 {
     PartitionPage* page = bucket->activePagesHead;
     ASSERT(page->numAllocatedSlots >= 0);
@@ -453,11 +524,16 @@ ALWAYS_INLINE void* partitionBucketAlloc(PartitionRootBase* root, int flags, siz
     } else {
         ret = partitionAllocSlowPath(root, flags, size, bucket);
     }
+    return ret;
+}
+
+ALWAYS_INLINE void* partitionSlotPrepareForUse(void* ret)
+{
 #if ENABLE(ASSERT)
     if (!ret)
         return 0;
     // Fill the uninitialized pattern. and write the cookies.
-    page = partitionPointerToPage(ret);
+    PartitionPage* page = partitionPointerToPage(ret);
     size_t bucketSize = page->bucket->slotSize;
     memset(ret, kUninitializedByte, bucketSize);
     partitionCookieWriteValue(ret);
@@ -468,6 +544,11 @@ ALWAYS_INLINE void* partitionBucketAlloc(PartitionRootBase* root, int flags, siz
     return ret;
 }
 
+ALWAYS_INLINE void* partitionBucketAlloc(PartitionRootBase* root, int flags, size_t size, PartitionBucket* bucket)
+{
+    return partitionSlotPrepareForUse(partitionBucketAllocSlot(root, flags, size, bucket));
+}
+
 ALWAYS_INLINE void* partitionAlloc(PartitionRoot* root, size_t size)
 {
 #if defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
@@ -485,7 +566,7 @@ ALWAYS_INLINE void* partitionAlloc(PartitionRoot* root, size_t size)
 #endif // defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
 }
 
-ALWAYS_INLINE void partitionFreeWithPage(void* ptr, PartitionPage* page)
+ALWAYS_INLINE void partitionSlotPrepareForFree(void* ptr, PartitionPage* page)
 {
     // If these asserts fire, you probably corrupted memory.
 #if ENABLE(ASSERT)
@@ -494,6 +575,11 @@ ALWAYS_INLINE void partitionFreeWithPage(void* ptr, PartitionPage* page)
     partitionCookieCheckValue(reinterpret_cast<char*>(ptr) + bucketSize - kCookieSize);
     memset(ptr, kFreedByte, bucketSize);
 #endif
+}
+
+// Returns a slot that's already been prepared for free to its page.
+ALWAYS_INLINE void partitionFreeSlot(void* ptr, PartitionPage* page)
+{
     ASSERT(page->numAllocatedSlots);
     PartitionFreelistEntry* freelistHead = page->freelistHead;
     ASSERT(!freelistHead || partitionPointerIsValid(freelistHead));
@@ -507,6 +593,12 @@ ALWAYS_INLINE void partitionFreeWithPage(void* ptr, PartitionPage* page)
         partitionFreeSlowPath(page);
 }
 
+ALWAYS_INLINE void partitionFreeWithPage(void* ptr, PartitionPage* page)
+{
+    partitionSlotPrepareForFree(ptr, page);
+    partitionFreeSlot(ptr, page);
+}
+
 ALWAYS_INLINE void partitionFree(void* ptr)
 {
 #if defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
@@ -519,6 +611,11 @@ ALWAYS_INLINE void partitionFree(void* ptr)
 #endif
 }
 
+ALWAYS_INLINE bool partitionBucketIsDirectMapped(PartitionBucket* bucket)
+{
+    return !bucket->numSystemPagesPerSlotSpan;
+}
+
 ALWAYS_INLINE PartitionBucket* partitionGenericSizeToBucket(PartitionRootGeneric* root, size_t size)
 {
     size_t order = kBitsPerSizet - countLeadingZerosSizet(size);
@@ -532,6 +629,62 @@ ALWAYS_INLINE PartitionBucket* partitionGenericSizeToBucket(PartitionRootGeneric
     return bucket;
 }
 
+#if ENABLE(PARTITION_THREAD_CACHE)
+// Returns the calling thread's cache for |bucket|'s slots, or null if they
+// aren't cached.
+ALWAYS_INLINE PartitionThreadCache* partitionThreadCacheGet(PartitionRootGeneric* root, PartitionBucket* bucket)
+{
+    if (root->threadCacheIndex < 0 || bucket->slotSize > kThreadCacheMaxSlotSize || partitionBucketIsDirectMapped(bucket))
+        return 0;
+    PartitionThreadCache** caches = static_cast<PartitionThreadCache**>(pthread_getspecific(PartitionRootGeneric::gThreadCacheKey));
+    if (LIKELY(caches != 0)) {
+        PartitionThreadCache* cache = caches[root->threadCacheIndex];
+        if (LIKELY(cache && cache->generation == root->threadCacheGeneration))
+            return cache;
+    }
+    return partitionThreadCacheCreate(root);
+}
+
+ALWAYS_INLINE PartitionThreadCacheBucket* partitionThreadCacheBucket(PartitionRootGeneric* root, PartitionThreadCache* cache, PartitionBucket* bucket)
+{
+    ASSERT(bucket >= root->buckets && bucket < root->buckets + kGenericNumBucketedOrders * kGenericNumBucketsPerOrder);
+    return &cache->buckets[bucket - root->buckets];
+}
+
+// Returns an unprepared slot, like partitionBucketAllocSlot().
+ALWAYS_INLINE void* partitionThreadCacheAlloc(PartitionRootGeneric* root, PartitionThreadCache* cache, int flags, PartitionBucket* bucket)
+{
+    PartitionThreadCacheBucket* cacheBucket = partitionThreadCacheBucket(root, cache, bucket);
+    PartitionFreelistEntry* ret = cacheBucket->freelistHead;
+    if (UNLIKELY(!ret))
+        return partitionThreadCacheRefill(root, cache, flags, bucket);
+    // If this assert fires, you probably corrupted memory.
+    ASSERT(partitionPointerIsValid(ret));
+    cacheBucket->freelistHead = partitionFreelistMask(ret->next);
+    if (--cacheBucket->numSlots < cacheBucket->lowWaterMark)
+        cacheBucket->lowWaterMark = cacheBucket->numSlots;
+    cache->numBytes -= bucket->slotSize;
+    return ret;
+}
+
+// Takes a slot that's already been prepared for free.
+ALWAYS_INLINE void partitionThreadCacheFree(PartitionRootGeneric* root, PartitionThreadCache* cache, void* ptr, PartitionPage* page)
+{
+    PartitionBucket* bucket = page->bucket;
+    PartitionThreadCacheBucket* cacheBucket = partitionThreadCacheBucket(root, cache, bucket);
+    PartitionFreelistEntry* freelistHead = cacheBucket->freelistHead;
+    RELEASE_ASSERT(ptr != freelistHead); // Catches an immediate double free.
+    ASSERT(!freelistHead || ptr != partitionFreelistMask(freelistHead->next)); // Look for double free one level deeper in debug.
+    PartitionFreelistEntry* entry = static_cast<PartitionFreelistEntry*>(ptr);
+    entry->next = partitionFreelistMask(freelistHead);
+    cacheBucket->freelistHead = entry;
+    ++cacheBucket->numSlots;
+    cache->numBytes += bucket->slotSize;
+    if (UNLIKELY(cacheBucket->numSlots > cacheBucket->maxSlots || cache->numBytes > kThreadCacheMaxBytes || !--cache->freesUntilScavenge))
+        partitionThreadCacheFreeSlowPath(root, cache, cacheBucket);
+}
+#endif // ENABLE(PARTITION_THREAD_CACHE)
+
 ALWAYS_INLINE void* partitionAllocGenericFlags(PartitionRootGeneric* root, int flags, size_t size)
 {
 #if defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
@@ -542,6 +695,10 @@ ALWAYS_INLINE void* partitionAllocGenericFlags(PartitionRootGeneric* root, int f
     ASSERT(root->initialized);
     size = partitionCookieSizeAdjustAdd(size);
     PartitionBucket* bucket = partitionGenericSizeToBucket(root, size);
+#if ENABLE(PARTITION_THREAD_CACHE)
+    if (PartitionThreadCache* cache = partitionThreadCacheGet(root, bucket))
+        return partitionSlotPrepareForUse(partitionThreadCacheAlloc(root, cache, flags, bucket));
+#endif
     spinLockLock(&root->lock);
     void* ret = partitionBucketAlloc(root, flags, size, bucket);
     spinLockUnlock(&root->lock);
@@ -567,17 +724,19 @@ ALWAYS_INLINE void partitionFreeGeneric(PartitionRootGeneric* root, void* ptr)
     ptr = partitionCookieFreePointerAdjust(ptr);
     ASSERT(partitionPointerIsValid(ptr));
     PartitionPage* page = partitionPointerToPage(ptr);
+#if ENABLE(PARTITION_THREAD_CACHE)
+    if (PartitionThreadCache* cache = partitionThreadCacheGet(root, page->bucket)) {
+        partitionSlotPrepareForFree(ptr, page);
+        partitionThreadCacheFree(root, cache, ptr, page);
+        return;
+    }
+#endif
     spinLockLock(&root->lock);
     partitionFreeWithPage(ptr, page);
     spinLockUnlock(&root->lock);
 #endif
 }
 
-ALWAYS_INLINE bool partitionBucketIsDirectMapped(PartitionBucket* bucket)
-{
-    return !bucket->numSystemPagesPerSlotSpan;
-}
-
 ALWAYS_INLINE size_t partitionDirectMapSize(size_t size)
 {
     // Caller must check that the size is not above the kGenericMaxDirectMapped
@@ -647,6 +806,8 @@ private:
 class PartitionAllocatorGeneric {
 public:
     void init() { partitionAllocGenericInit(&m_partitionRoot); }
+    void enableThreadCache() { partitionAllocGenericEnableThreadCache(&m_partitionRoot); }
+    void flushThreadCache() { partitionAllocGenericFlushThreadCache(&m_partitionRoot); }
     bool shutdown() { return partitionAllocGenericShutdown(&m_partitionRoot); }
     ALWAYS_INLINE PartitionRootGeneric* root() { return &m_partitionRoot; }
 private:
@@ -668,5 +829,6 @@ using WTF::partitionReallocGeneric;
 using WTF::partitionAllocActualSize;
 using WTF::partitionAllocSupportsGetSize;
 using WTF::partitionAllocGetSize;
+using WTF::partitionAllocFlushThreadCaches;
 
 #endif  // SKY_ENGINE_WTF_PARTITIONALLOC_H_
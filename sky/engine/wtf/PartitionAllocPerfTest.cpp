@@ -0,0 +1,88 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sky/engine/config.h"
+#include "sky/engine/wtf/PartitionAlloc.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include "base/strings/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "testing/perf/perf_test.h"
+
+#if !defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
+
+namespace {
+
+static const size_t kIterations = 1000000;
+static const size_t kLiveAllocations = 64;
+static const size_t kMaxThreads = 4;
+
+// Frees and allocates a spread of small sizes, keeping a few dozen
+// allocations alive at once, the way building strings and DOM nodes does.
+static void Churn(WTF::PartitionRootGeneric* root)
+{
+    void* live[kLiveAllocations] = { 0 };
+    for (size_t i = 0; i < kIterations; ++i) {
+        size_t index = i % kLiveAllocations;
+        partitionFreeGeneric(root, live[index]);
+        live[index] = partitionAllocGeneric(root, 8 + (i * 24) % 1024);
+    }
+    for (size_t i = 0; i < kLiveAllocations; ++i)
+        partitionFreeGeneric(root, live[i]);
+}
+
+class ChurnThread : public base::PlatformThread::Delegate {
+public:
+    explicit ChurnThread(WTF::PartitionRootGeneric* root) : m_root(root) { }
+    virtual void ThreadMain() override { Churn(m_root); }
+
+private:
+    WTF::PartitionRootGeneric* m_root;
+};
+
+// Returns the number of allocations per millisecond across |numThreads|
+// threads, counting the calling thread.
+static double MeasureChurn(WTF::PartitionRootGeneric* root, size_t numThreads)
+{
+    ChurnThread delegate(root);
+    base::PlatformThreadHandle threads[kMaxThreads];
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (size_t i = 1; i < numThreads; ++i)
+        EXPECT_TRUE(base::PlatformThread::Create(0, &delegate, &threads[i]));
+    Churn(root);
+    for (size_t i = 1; i < numThreads; ++i)
+        base::PlatformThread::Join(threads[i]);
+    double elapsed = (base::TimeTicks::Now() - start).InMillisecondsF();
+    return numThreads * kIterations / elapsed;
+}
+
+static void RunChurn(size_t numThreads, bool threadCache)
+{
+    PartitionAllocatorGeneric allocator;
+    allocator.init();
+    if (threadCache)
+        allocator.enableThreadCache();
+    double allocsPerMs = MeasureChurn(allocator.root(), numThreads);
+    // Exiting threads give their caches back, so nothing should leak.
+    EXPECT_TRUE(allocator.shutdown());
+    perf_test::PrintResult("partition_alloc_churn", base::StringPrintf("_%d_threads", static_cast<int>(numThreads)), threadCache ? "thread_cache" : "lock", allocsPerMs, "allocs/ms", true);
+}
+
+TEST(PartitionAllocPerfTest, SingleThreadedChurn)
+{
+    RunChurn(1, false);
+    RunChurn(1, true);
+}
+
+TEST(PartitionAllocPerfTest, MultiThreadedChurn)
+{
+    RunChurn(kMaxThreads, false);
+    RunChurn(kMaxThreads, true);
+}
+
+} // namespace
+
+#endif // !defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
@@ -1097,6 +1097,265 @@ TEST(PartitionAllocTest, LostFreePagesBug)
     TestShutdown();
 }
 
+#if ENABLE(PARTITION_THREAD_CACHE)
+
+static PartitionAllocatorGeneric threadCachedAllocator;
+
+static void ThreadCacheSetup()
+{
+    threadCachedAllocator.init();
+    threadCachedAllocator.enableThreadCache();
+    EXPECT_LE(0, threadCachedAllocator.root()->threadCacheIndex);
+}
+
+static void ThreadCacheShutdown()
+{
+    // Shutting down flushes this thread's cache, so nothing should leak.
+    EXPECT_TRUE(threadCachedAllocator.shutdown());
+}
+
+static WTF::PartitionThreadCache* GetThreadCache()
+{
+    WTF::PartitionRootGeneric* root = threadCachedAllocator.root();
+    WTF::PartitionThreadCache** caches = static_cast<WTF::PartitionThreadCache**>(pthread_getspecific(WTF::PartitionRootGeneric::gThreadCacheKey));
+    if (!caches || !caches[root->threadCacheIndex] || caches[root->threadCacheIndex]->generation != root->threadCacheGeneration)
+        return 0;
+    return caches[root->threadCacheIndex];
+}
+
+static WTF::PartitionThreadCacheBucket* GetThreadCacheBucket(void* ptr)
+{
+    WTF::PartitionPage* page = WTF::partitionPointerToPage(WTF::partitionCookieFreePointerAdjust(ptr));
+    WTF::PartitionThreadCache* cache = GetThreadCache();
+    EXPECT_TRUE(cache);
+    return &cache->buckets[page->bucket - threadCachedAllocator.root()->buckets];
+}
+
+// Check that frees go to the cache, that allocations come from it, and that
+// a flush gives the cached slots back to the partition.
+TEST(PartitionAllocTest, ThreadCacheAllocFree)
+{
+    ThreadCacheSetup();
+
+    void* ptr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    EXPECT_TRUE(ptr);
+    WTF::PartitionPage* page = WTF::partitionPointerToPage(WTF::partitionCookieFreePointerAdjust(ptr));
+    // The first allocation also took a batch of slots for the cache.
+    WTF::PartitionThreadCacheBucket* cacheBucket = GetThreadCacheBucket(ptr);
+    EXPECT_EQ(WTF::kThreadCacheMaxBucketSlots, cacheBucket->maxSlots);
+    EXPECT_EQ(WTF::kThreadCacheMaxBucketSlots / 2, cacheBucket->numSlots);
+    EXPECT_EQ(cacheBucket->numSlots + 1u, static_cast<size_t>(page->numAllocatedSlots));
+
+    // Cached slots still count as allocated.
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+    EXPECT_EQ(WTF::kThreadCacheMaxBucketSlots / 2 + 1, cacheBucket->numSlots);
+    EXPECT_EQ(cacheBucket->numSlots, static_cast<size_t>(page->numAllocatedSlots));
+
+    // The cache hands the last freed slot out first.
+    void* ptr2 = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    EXPECT_EQ(ptr, ptr2);
+#if ENABLE(ASSERT)
+    EXPECT_EQ(WTF::kUninitializedByte, *static_cast<unsigned char*>(ptr2));
+#endif
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr2);
+
+    threadCachedAllocator.flushThreadCache();
+    EXPECT_EQ(0u, cacheBucket->numSlots);
+    EXPECT_FALSE(cacheBucket->freelistHead);
+    EXPECT_EQ(0u, GetThreadCache()->numBytes);
+    EXPECT_EQ(0, page->numAllocatedSlots);
+
+    // Sizes too large for the cache go straight to the partition.
+    size_t bigSize = WTF::kThreadCacheMaxSlotSize * 2;
+    ptr = partitionAllocGeneric(threadCachedAllocator.root(), bigSize);
+    EXPECT_TRUE(ptr);
+    page = WTF::partitionPointerToPage(WTF::partitionCookieFreePointerAdjust(ptr));
+    EXPECT_EQ(1, page->numAllocatedSlots);
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+    EXPECT_EQ(0, page->numAllocatedSlots);
+
+    ThreadCacheShutdown();
+}
+
+// Check that a bucket and the cache as a whole stay within their limits.
+TEST(PartitionAllocTest, ThreadCacheBounds)
+{
+    ThreadCacheSetup();
+
+    const size_t numAllocs = WTF::kThreadCacheMaxBucketSlots * 8;
+    void* ptrs[numAllocs];
+    for (size_t i = 0; i < numAllocs; ++i)
+        ptrs[i] = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    WTF::PartitionThreadCacheBucket* cacheBucket = GetThreadCacheBucket(ptrs[0]);
+    for (size_t i = 0; i < numAllocs; ++i) {
+        partitionFreeGeneric(threadCachedAllocator.root(), ptrs[i]);
+        EXPECT_LE(cacheBucket->numSlots, cacheBucket->maxSlots);
+    }
+    EXPECT_LT(0u, cacheBucket->numSlots);
+
+    // Free a little of many sizes, more than the cache holds in all.
+    const size_t numSizes = (WTF::kThreadCacheMaxSlotSize - kExtraAllocSize) / 64;
+    const size_t allocsPerSize = 8;
+    size_t freedBytes = 0;
+    void* sizedPtrs[numSizes][allocsPerSize];
+    for (size_t i = 0; i < numSizes; ++i) {
+        for (size_t j = 0; j < allocsPerSize; ++j) {
+            sizedPtrs[i][j] = partitionAllocGeneric(threadCachedAllocator.root(), (i + 1) * 64);
+            freedBytes += (i + 1) * 64;
+        }
+    }
+    EXPECT_LT(WTF::kThreadCacheMaxBytes, freedBytes);
+    for (size_t i = 0; i < numSizes; ++i) {
+        for (size_t j = 0; j < allocsPerSize; ++j) {
+            partitionFreeGeneric(threadCachedAllocator.root(), sizedPtrs[i][j]);
+            EXPECT_GE(WTF::kThreadCacheMaxBytes, GetThreadCache()->numBytes);
+        }
+    }
+
+    ThreadCacheShutdown();
+}
+
+// Check that slots a bucket doesn't need any more go back to the partition
+// over time, even if the thread keeps allocating other sizes.
+TEST(PartitionAllocTest, ThreadCacheScavenge)
+{
+    ThreadCacheSetup();
+
+    void* ptr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    WTF::PartitionPage* page = WTF::partitionPointerToPage(WTF::partitionCookieFreePointerAdjust(ptr));
+    WTF::PartitionThreadCacheBucket* cacheBucket = GetThreadCacheBucket(ptr);
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+    EXPECT_LT(0u, cacheBucket->numSlots);
+
+    // Each scavenge halves what an idle bucket holds.
+    for (size_t i = 0; i < WTF::kThreadCacheScavengeInterval * 16; ++i) {
+        void* otherPtr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize * 4);
+        partitionFreeGeneric(threadCachedAllocator.root(), otherPtr);
+    }
+    EXPECT_EQ(0u, cacheBucket->numSlots);
+    EXPECT_EQ(0, page->numAllocatedSlots);
+
+    ThreadCacheShutdown();
+}
+
+static void* AllocAndFreeOnThread(void* arg)
+{
+    void** ptrs = static_cast<void**>(arg);
+    // Keep the even allocations for the main thread to free, and free the
+    // odd ones here, into this thread's cache.
+    for (size_t i = 0; i < WTF::kThreadCacheMaxBucketSlots; ++i)
+        ptrs[i] = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    for (size_t i = 1; i < WTF::kThreadCacheMaxBucketSlots; i += 2)
+        partitionFreeGeneric(threadCachedAllocator.root(), ptrs[i]);
+    EXPECT_TRUE(GetThreadCache());
+    EXPECT_LT(0u, GetThreadCache()->numBytes);
+    return 0;
+}
+
+// Check that a thread's cache is given back when it exits, and that slots
+// can be freed on another thread than the one that allocated them.
+TEST(PartitionAllocTest, ThreadCacheThreadExit)
+{
+    ThreadCacheSetup();
+
+    void* ptrs[WTF::kThreadCacheMaxBucketSlots];
+    pthread_t thread;
+    EXPECT_EQ(0, pthread_create(&thread, 0, AllocAndFreeOnThread, ptrs));
+    EXPECT_EQ(0, pthread_join(thread, 0));
+
+    WTF::PartitionPage* page = WTF::partitionPointerToPage(WTF::partitionCookieFreePointerAdjust(ptrs[0]));
+    EXPECT_EQ(WTF::kThreadCacheMaxBucketSlots / 2, static_cast<size_t>(page->numAllocatedSlots));
+    for (size_t i = 0; i < WTF::kThreadCacheMaxBucketSlots; i += 2)
+        partitionFreeGeneric(threadCachedAllocator.root(), ptrs[i]);
+    threadCachedAllocator.flushThreadCache();
+    EXPECT_EQ(0, page->numAllocatedSlots);
+
+    ThreadCacheShutdown();
+}
+
+// Check that a thread can give its cached slots back without exiting.
+TEST(PartitionAllocTest, ThreadCacheFlushAll)
+{
+    ThreadCacheSetup();
+
+    void* ptr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    WTF::PartitionPage* page = WTF::partitionPointerToPage(WTF::partitionCookieFreePointerAdjust(ptr));
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+    EXPECT_LT(0u, GetThreadCache()->numBytes);
+    EXPECT_LT(0, page->numAllocatedSlots);
+
+    partitionAllocFlushThreadCaches();
+    EXPECT_EQ(0u, GetThreadCache()->numBytes);
+    EXPECT_EQ(0, page->numAllocatedSlots);
+
+    ThreadCacheShutdown();
+}
+
+static pthread_key_t lateFreeKey;
+static bool lateFreeBypassedCache = false;
+
+static void LateFree(void* ptr)
+{
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+    lateFreeBypassedCache = !GetThreadCache();
+}
+
+static void* AllocForLateFreeOnThread(void* arg)
+{
+    void** ptr = static_cast<void**>(arg);
+    *ptr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    EXPECT_TRUE(GetThreadCache());
+    pthread_setspecific(lateFreeKey, *ptr);
+    return 0;
+}
+
+// Check that a free from a thread exit callback that runs after the cache's
+// own one goes straight to the partition instead of creating a new cache.
+// This relies on exit callbacks running in the order their keys were
+// created, which glibc does.
+TEST(PartitionAllocTest, ThreadCacheFreeAfterThreadExit)
+{
+    ThreadCacheSetup();
+    EXPECT_EQ(0, pthread_key_create(&lateFreeKey, LateFree));
+    lateFreeBypassedCache = false;
+
+    void* ptr = 0;
+    pthread_t thread;
+    EXPECT_EQ(0, pthread_create(&thread, 0, AllocForLateFreeOnThread, &ptr));
+    EXPECT_EQ(0, pthread_join(thread, 0));
+
+    EXPECT_TRUE(lateFreeBypassedCache);
+    WTF::PartitionPage* page = WTF::partitionPointerToPage(WTF::partitionCookieFreePointerAdjust(ptr));
+    EXPECT_EQ(0, page->numAllocatedSlots);
+
+    EXPECT_EQ(0, pthread_key_delete(lateFreeKey));
+    ThreadCacheShutdown();
+}
+
+// Check that a cache left over from a partition that was shut down isn't
+// used for the next one.
+TEST(PartitionAllocTest, ThreadCacheReinit)
+{
+    ThreadCacheSetup();
+    void* ptr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    WTF::PartitionThreadCache* cache = GetThreadCache();
+    unsigned generation = cache->generation;
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+    ThreadCacheShutdown();
+    EXPECT_EQ(-1, threadCachedAllocator.root()->threadCacheIndex);
+
+    ThreadCacheSetup();
+    EXPECT_NE(generation, threadCachedAllocator.root()->threadCacheGeneration);
+    EXPECT_FALSE(GetThreadCache());
+    ptr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    EXPECT_TRUE(ptr);
+    EXPECT_EQ(threadCachedAllocator.root()->threadCacheGeneration, GetThreadCache()->generation);
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+    ThreadCacheShutdown();
+}
+
+#endif // ENABLE(PARTITION_THREAD_CACHE)
+
 #if !OS(ANDROID)
 
 // Make sure that malloc(-1) dies.
@@ -1146,6 +1405,24 @@ TEST(PartitionAllocDeathTest, RefcountDoubleFree)
     TestShutdown();
 }
 
+#if ENABLE(PARTITION_THREAD_CACHE)
+
+// Check that the immediate double-free detection also covers the cache.
+TEST(PartitionAllocDeathTest, ThreadCacheImmediateDoubleFree)
+{
+    ThreadCacheSetup();
+
+    void* ptr = partitionAllocGeneric(threadCachedAllocator.root(), kTestAllocSize);
+    EXPECT_TRUE(ptr);
+    partitionFreeGeneric(threadCachedAllocator.root(), ptr);
+
+    EXPECT_DEATH(partitionFreeGeneric(threadCachedAllocator.root(), ptr), "");
+
+    ThreadCacheShutdown();
+}
+
+#endif // ENABLE(PARTITION_THREAD_CACHE)
+
 // Check that guard pages are present where expected.
 TEST(PartitionAllocDeathTest, GuardPages)
 {
@@ -74,6 +74,8 @@ void Partitions::initialize()
     spinLockLock(&lock);
     if (!s_initialized) {
         m_bufferAllocator.init();
+        // Strings and buffers are built on the parser and decoder threads too.
+        m_bufferAllocator.enableThreadCache();
         s_initialized = true;
     }
     spinLockUnlock(&lock);
@@ -52,6 +52,9 @@ void ConfigureSettings(blink::WebSettings* settings) {
   settings->setDefaultFixedFontSize(13);
   settings->setDefaultFontSize(16);
   settings->setLoadsImagesAutomatically(true);
+  // Decoding ahead needs the decode to be deferred until paint to begin with.
+  if (RuntimeFlags::Get().image_decode_ahead())
+    settings->setDeferredImageDecodingEnabled(true);
 }
 
 mojo::Target WebNavigationPolicyToNavigationTarget(
@@ -179,14 +182,17 @@ scoped_ptr<Rasterizer> DocumentView::CreateRasterizer() {
   // TODO(abarth): If we have more than one layer, we'll need to re-think how
   // we capture pixels for testing;
   DCHECK(!bitmap_rasterizer_);
-  bitmap_rasterizer_ = new RasterizerBitmap(layer_host_.get());
+  // The raster workers run image decoders, which allocate from the engine.
+  bitmap_rasterizer_ = new RasterizerBitmap(
+      layer_host_.get(), base::Bind(&blink::flushThreadCaches));
   return make_scoped_ptr(bitmap_rasterizer_);
 }
 
-void DocumentView::GetPixelsForTesting(std::vector<unsigned char>* pixels) {
+void DocumentView::GetPixelsForTesting(
+    const RasterizerBitmap::PixelsCallback& callback) {
   DCHECK(RuntimeFlags::Get().testing()) << "Requires testing runtime flag";
   DCHECK(root_layer_) << "The root layer owns the rasterizer";
-  return bitmap_rasterizer_->GetPixelsForTesting(pixels);
+  bitmap_rasterizer_->GetPixelsForTesting(callback);
 }
 
 TestHarnessPtr DocumentView::TakeTestHarness() {
@@ -221,6 +227,9 @@ void DocumentView::BeginFrame(base::TimeTicks frame_time) {
   float device_pixel_ratio = GetDevicePixelRatio();
   root_layer_->SetSize(gfx::Size(size.width * device_pixel_ratio,
                                  size.height * device_pixel_ratio));
+  // The engine doesn't report what it invalidated, so the layer works out
+  // which tiles changed from what it records.
+  root_layer_->SetContentsMayHaveChanged();
 }
 
 void DocumentView::OnSurfaceIdAvailable(mojo::SurfaceIdPtr surface_id) {
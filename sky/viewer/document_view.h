@@ -21,6 +21,7 @@
 #include "mojo/services/view_manager/public/cpp/view_observer.h"
 #include "sky/compositor/layer_client.h"
 #include "sky/compositor/layer_host_client.h"
+#include "sky/compositor/rasterizer_bitmap.h"
 #include "sky/engine/public/platform/ServiceProvider.h"
 #include "sky/engine/public/web/WebFrameClient.h"
 #include "sky/engine/public/web/WebViewClient.h"
@@ -34,7 +35,6 @@ class View;
 
 namespace sky {
 class Rasterizer;
-class RasterizerBitmap;
 class Layer;
 class LayerHost;
 
@@ -68,7 +68,8 @@ class DocumentView : public blink::ServiceProvider,
 
   void StartDebuggerInspectorBackend();
 
-  void GetPixelsForTesting(std::vector<unsigned char>* pixels);
+  void GetPixelsForTesting(
+      const RasterizerBitmap::PixelsCallback& callback);
 
   TestHarnessPtr TakeTestHarness();
   mojo::ScopedMessagePipeHandle TakeServicesProvidedToEmbedder();
@@ -5,6 +5,7 @@
 #include "sky/engine/config.h"
 #include "sky/viewer/internals.h"
 
+#include "base/bind.h"
 #include "mojo/public/cpp/application/connect.h"
 #include "mojo/public/cpp/bindings/array.h"
 #include "sky/engine/public/web/WebDocument.h"
@@ -44,6 +45,11 @@ void RenderTreeAsText(Dart_NativeArguments args) {
   Dart_SetReturnValue(args, result);
 }
 
+void StyleResolverStats(Dart_NativeArguments args) {
+  Dart_Handle result = StdStringToDart(GetInternals()->StyleResolverStats());
+  Dart_SetReturnValue(args, result);
+}
+
 void TakeShellProxyHandle(Dart_NativeArguments args) {
   Dart_SetIntegerReturnValue(args,
       GetInternals()->TakeShellProxyHandle().value());
@@ -68,6 +74,7 @@ const DartBuiltin::Natives kNativeFunctions[] = {
     {"contentAsText", ContentAsText, 0},
     {"notifyTestComplete", NotifyTestComplete, 1},
     {"renderTreeAsText", RenderTreeAsText, 0},
+    {"styleResolverStats", StyleResolverStats, 0},
     {"takeShellProxyHandle", TakeShellProxyHandle, 0},
     {"takeServicesProvidedByEmbedder", TakeServicesProvidedByEmbedder, 0},
     {"takeServicesProvidedToEmbedder", TakeServicesProvidedToEmbedder, 0},
@@ -95,6 +102,7 @@ const char kLibrarySource[] = R"DART(
 String contentAsText() native "contentAsText";
 void notifyTestComplete(String test_result) native "notifyTestComplete";
 String renderTreeAsText() native "renderTreeAsText";
+String styleResolverStats() native "styleResolverStats";
 int takeShellProxyHandle() native "takeShellProxyHandle";
 int takeServicesProvidedByEmbedder() native "takeServicesProvidedByEmbedder";
 int takeServicesProvidedToEmbedder() native "takeServicesProvidedToEmbedder";
@@ -116,7 +124,8 @@ void Internals::Create(Dart_Isolate isolate, DocumentView* document_view) {
 
 Internals::Internals(DocumentView* document_view)
   : document_view_(document_view->GetWeakPtr()),
-    shell_binding_(this) {
+    shell_binding_(this),
+    weak_factory_(this) {
   test_harness_ = document_view_->TakeTestHarness();
 }
 
@@ -136,11 +145,24 @@ std::string Internals::ContentAsText() {
       1024*1024).utf8();
 }
 
+std::string Internals::StyleResolverStats() {
+  if (!document_view_)
+    return std::string();
+  return document_view_->web_view()->mainFrame()->styleResolverStatsAsText()
+      .utf8();
+}
+
 void Internals::NotifyTestComplete(const std::string& test_result) {
   if (!RuntimeFlags::Get().testing())
     return;
-  std::vector<unsigned char> pixels;
-  document_view_->GetPixelsForTesting(&pixels);
+  // The pixels come back once any raster in flight has finished.
+  document_view_->GetPixelsForTesting(
+      base::Bind(&Internals::DidGetPixels, weak_factory_.GetWeakPtr(),
+                 test_result));
+}
+
+void Internals::DidGetPixels(const std::string& test_result,
+                             const std::vector<unsigned char>& pixels) {
   if (test_harness_) {
     test_harness_->OnTestComplete(test_result,
         mojo::Array<uint8_t>::From(pixels));
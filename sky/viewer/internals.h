@@ -5,6 +5,8 @@
 #ifndef SKY_VIEWER_INTERNALS_H_
 #define SKY_VIEWER_INTERNALS_H_
 
+#include <vector>
+
 #include "base/memory/weak_ptr.h"
 #include "base/supports_user_data.h"
 #include "dart/runtime/include/dart_api.h"
@@ -29,6 +31,7 @@ class Internals : public base::SupportsUserData::Data,
 
   std::string RenderTreeAsText();
   std::string ContentAsText();
+  std::string StyleResolverStats();
   void NotifyTestComplete(const std::string& test_result);
 
   mojo::Handle TakeShellProxyHandle();
@@ -39,10 +42,15 @@ class Internals : public base::SupportsUserData::Data,
  private:
   explicit Internals(DocumentView* document_view);
 
+  void DidGetPixels(const std::string& test_result,
+                    const std::vector<unsigned char>& pixels);
+
   base::WeakPtr<DocumentView> document_view_;
   mojo::Binding<mojo::Shell> shell_binding_;
   TestHarnessPtr test_harness_;
 
+  base::WeakPtrFactory<Internals> weak_factory_;
+
   MOJO_DISALLOW_COPY_AND_ASSIGN(Internals);
 };
 
@@ -16,11 +16,23 @@ RuntimeFlags flags;
 // Load the viewer in testing mode so we can dump pixels.
 const char kTesting[] = "--testing";
 
+// Collect rule matching and style sharing statistics on every style recalc.
+const char kStyleResolverStats[] = "--style-resolver-stats";
+
+// Match style rules on worker threads.
+const char kParallelStyleRecalc[] = "--parallel-style-recalc";
+
+// Decode images lazily, on worker threads as their data arrives.
+const char kImageDecodeAhead[] = "--image-decode-ahead";
+
 }  // namespace
 
 void RuntimeFlags::Initialize(mojo::ApplicationImpl* app) {
   DCHECK(!initialized);
   flags.testing_ = app->HasArg(kTesting);
+  flags.style_resolver_stats_ = app->HasArg(kStyleResolverStats);
+  flags.parallel_style_recalc_ = app->HasArg(kParallelStyleRecalc);
+  flags.image_decode_ahead_ = app->HasArg(kImageDecodeAhead);
   initialized = true;
 }
 
@@ -17,9 +17,15 @@ class RuntimeFlags {
   static const RuntimeFlags& Get();
 
   bool testing() const { return testing_; }
+  bool style_resolver_stats() const { return style_resolver_stats_; }
+  bool parallel_style_recalc() const { return parallel_style_recalc_; }
+  bool image_decode_ahead() const { return image_decode_ahead_; }
 
  private:
   bool testing_;
+  bool style_resolver_stats_;
+  bool parallel_style_recalc_;
+  bool image_decode_ahead_;
 };
 
 }  // namespace sky
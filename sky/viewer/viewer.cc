@@ -15,6 +15,7 @@
 #include "mojo/public/cpp/application/interface_factory_impl.h"
 #include "mojo/services/content_handler/public/interfaces/content_handler.mojom.h"
 #include "sky/engine/public/web/Sky.h"
+#include "sky/engine/public/web/WebRuntimeFeatures.h"
 #include "sky/services/platform/platform_impl.h"
 #include "sky/viewer/content_handler_impl.h"
 #include "sky/viewer/document_view.h"
@@ -38,6 +39,12 @@ class Viewer : public mojo::ApplicationDelegate,
     app->ConnectToService("mojo:network_service", &network_service);
     platform_impl_.reset(new PlatformImpl(network_service.Pass()));
     blink::initialize(platform_impl_.get());
+    blink::WebRuntimeFeatures::enableStyleResolverStats(
+        RuntimeFlags::Get().style_resolver_stats());
+    blink::WebRuntimeFeatures::enableParallelStyleRecalc(
+        RuntimeFlags::Get().parallel_style_recalc());
+    blink::WebRuntimeFeatures::enableImageDecodeAhead(
+        RuntimeFlags::Get().image_decode_ahead());
 
     mojo::icu::Initialize(app);
     tracing_.Initialize(app);